@@ -2,12 +2,18 @@ const minify = require('html-minifier').minify;
 const fs = require('fs');
 const path = require('path');
 const htmlInlineExternal = require('html-inline-external')
+const crypto = require('crypto');
 
 console.log('Running prod...');
 
 //const index = fs.readFileSync('index.html', 'utf8');
 const prod_path = path.resolve('../main/wwwroot/index.html');
 
+// Sources stamped into the bundle, host/tests/check_bundle.cmake compares them
+const sources = ['index.html', 'script.js', 'style.css'];
+const sha256 = data => crypto.createHash('sha256').update(data).digest('hex');
+const digest = sha256(sources.map(file => sha256(fs.readFileSync(file))).join(''));
+
 htmlInlineExternal({src: 'index.html'})
     .then(output => {
 
@@ -27,7 +33,9 @@ htmlInlineExternal({src: 'index.html'})
             sortClassName: true
         });
 
-        fs.writeFileSync(prod_path, index_min, 'utf8');
+        const stamped = index_min + '<!--dev_html:' + digest + '-->';
+
+        fs.writeFileSync(prod_path, stamped, 'utf8');
 
-        console.log("Bytes: " + index_min.length)
+        console.log("Bytes: " + stamped.length)
     })
\ No newline at end of file
@@ -12,6 +12,10 @@ class RCPClient {
     // RCP Protocol constants
     this.RCP_HEADER_SIZE = 3;      // [len_lo][len_hi][port]
     this.RCP_MAX_BODY_SIZE = 256;  // Same limit as firmware
+    this.RCP_BATCH_RECORD_HEADER_SIZE = 2; // [port][len]
+    this.RCP_VERSION_MAJOR = 2;            // Highest protocol major this client speaks
+    this.RCP_HEADER_V2_SIZE = 9;           // [len_lo][len_hi|0x80][port][seq_lo][seq_hi][ts x4]
+    this.RCP_HEADER_V2_FLAG = 0x80;        // Set in len_hi when seq/timestamp follow
         
         // Port definitions
         this.RCP_PORTS = {
@@ -20,6 +24,8 @@ class RCPClient {
             SERVO: 0x02,        // Servo steering control
             HORN: 0x03,         // Horn on/off
             LIGHT: 0x04,        // Light on/off
+            DRIVE: 0x05,        // Combined speed/steering/light/horn setpoint
+            BATCH: 0x0F,        // Several control records in one frame
             
             // System Commands (0x10-0x1F)
             SYSTEM: 0x10,       // System commands
@@ -29,6 +35,12 @@ class RCPClient {
             // Response Commands (0x80-0xFF)
             BATTERY: 0x80,      // Battery status response
             TELEMETRY: 0x81,    // Telemetry data response
+            VERSION: 0x82,      // Protocol version response
+            PONG: 0x83,         // Ping reply with device timestamps
+            TELEMETRY_DELTA: 0x84, // Changed telemetry fields only
+            LOG: 0x85,          // Console log line (text)
+            METRICS: 0x86,      // Metrics registry snapshot
+            TASKS: 0x87,        // Page of per-task CPU and stack figures
             ACK: 0xFF           // Acknowledgment
         };
         
@@ -37,16 +49,209 @@ class RCPClient {
             PING: 0x01,         // Ping request
             RESET: 0x02,        // Reset system
             STATUS: 0x03,       // Request status
-            CONFIG: 0x04        // Configuration request
+            CONFIG: 0x04,       // Configuration request
+            HELLO: 0x05,        // Version negotiation
+            TELEMETRY: 0x06,    // Telemetry subscription (param = rate in Hz, 0 = off)
+            TELEMETRY_DELTA: 0x07, // Delta telemetry subscription (param = rate in Hz)
+            TELEMETRY_KEYFRAME: 0x08, // Request a full telemetry frame
+            ROLE: 0x09,         // Set client role (param = RCP_ROLES value)
+            LOG: 0x0A,          // Console log subscription (param = 1 on, 0 off)
+            LOG_LEVEL: 0x0B,    // Set a tag log level ([cmd][level][tag...])
+            METRICS: 0x0C,      // Request a metrics snapshot
+            TASKS: 0x0D         // Request task stats (param = first task index)
         };
         
+        // Client roles
+        this.RCP_ROLES = {
+            CONTROL: 0x00,      // May drive (default)
+            MONITOR: 0x01       // Data only, control commands are rejected
+        };
+        
+        // Delta telemetry field mask, in body order (same bits as RCP_TELEMETRY_FIELD_*)
+        this.RCP_TELEMETRY_FIELDS = [
+            { bit: 0x01, name: 'speed', signed: true },
+            { bit: 0x02, name: 'angle', signed: true },
+            { bit: 0x04, name: 'horn', signed: false },
+            { bit: 0x08, name: 'light', signed: false },
+            { bit: 0x10, name: 'flags', signed: false },
+            { bit: 0x20, name: 'linkRtt', signed: false }
+        ];
+        this.telemetryState = null; // Last full state, null until a keyframe arrives
+        
+        // Telemetry flags (same bits as firmware RCP_TELEMETRY_FLAG_*)
+        this.RCP_TELEMETRY_FLAGS = {
+            MOTOR_ENABLED: 0x01,
+            MOTOR_BRAKE: 0x02,
+            SERVO_READY: 0x04,
+            FAILSAFE: 0x08      // Link-loss failsafe holds the outputs
+        };
+        
+        // Drive flags (same bits as firmware RCP_DRIVE_FLAG_*)
+        this.RCP_DRIVE_FLAGS = {
+            LIGHT: 0x01,
+            HORN: 0x02
+        };
+        this.RCP_DRIVE_BODY_SIZE = 5; // speed, steering, flags, sequence (uint16 LE)
+        this.driveSequence = 0;
+        
+        // Header version agreed with the firmware (v1 until HELLO is answered)
+        this.headerVersion = 1;
+        this.txSequence = 0;
+        
         // Simple command statistics
         this.stats = {
             commandsSent: 0,
-            errors: 0
+            errors: 0,
+            connectionStartTime: Date.now(),
+            latencyHistory: []
         };
         
-        console.log('RCP Client v1.0 initialized');
+        // Ping/pong link measurements (microseconds)
+        this.RCP_PING_BODY_SIZE = 10;  // command, id, client_time_us, last_rtt_us
+        this.RCP_LOG_TAG_MAX = 31;     // Same limit as firmware
+        this.RCP_LOG_HISTORY = 200;    // Device log lines kept in deviceLog
+        this.RCP_LATENCY_HISTORY = 32; // RTT samples kept for averages
+        this.ping = {
+            nextId: 0,
+            sent: 0,
+            received: 0,
+            lastRttUs: 0,
+            minRttUs: 0,
+            jitterUs: 0,
+            uplinkUs: 0,
+            downlinkUs: 0,
+            deviceProcessingUs: 0,
+            clockOffsetUs: 0
+        };
+        this.deviceLog = [];           // Last device log lines (subscribeLogs)
+        this.metrics = null;           // Last metrics snapshot, by metric id (requestMetrics)
+        this.taskStats = null;         // Last complete task list (requestTaskStats)
+        this.taskStatsPending = [];    // Pages received so far
+        
+        console.log('RCP Client v2.0 initialized');
+    }
+    
+    /**
+     * Send a ping carrying the local clock and the previous RTT measurement
+     */
+    sendPing() {
+        const body = new Uint8Array(this.RCP_PING_BODY_SIZE);
+        const view = new DataView(body.buffer);
+
+        view.setUint8(0, this.RCP_SYS_COMMANDS.PING);
+        view.setUint8(1, this.ping.nextId);
+        view.setUint32(2, this.nowMicros(), true);
+        view.setUint32(6, this.ping.lastRttUs, true);
+        this.ping.nextId = (this.ping.nextId + 1) & 0xFF;
+
+        if (this.sendCommand(this.RCP_PORTS.SYSTEM, body)) {
+            this.ping.sent++;
+            return true;
+        }
+        return false;
+    }
+    
+    /**
+     * Local monotonic clock, microseconds modulo 2^32
+     */
+    nowMicros() {
+        return Math.floor(performance.now() * 1000) >>> 0;
+    }
+    
+    /**
+     * Subscribe to the periodic telemetry stream
+     * @param {number} rateHz - Requested rate (firmware clamps to 10-100 Hz)
+     */
+    subscribeTelemetry(rateHz, delta = true) {
+        const rate = Math.max(0, Math.min(255, Math.round(rateHz)));
+        const command = (delta && rate > 0)
+            ? this.RCP_SYS_COMMANDS.TELEMETRY_DELTA
+            : this.RCP_SYS_COMMANDS.TELEMETRY;
+        this.telemetryState = null;
+        return this.sendCommand(this.RCP_PORTS.SYSTEM, new Uint8Array([command, rate]));
+    }
+    
+    /**
+     * Ask for a full telemetry frame (after a gap or a bad delta)
+     */
+    requestTelemetryKeyframe() {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.TELEMETRY_KEYFRAME, 0]));
+    }
+    
+    /**
+     * Stop the periodic telemetry stream
+     */
+    unsubscribeTelemetry() {
+        return this.subscribeTelemetry(0);
+    }
+    
+    /**
+     * Start or stop receiving the device console log on the LOG port
+     * @param {boolean} enabled - true to subscribe
+     */
+    subscribeLogs(enabled = true) {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.LOG, enabled ? 1 : 0]));
+    }
+    
+    /**
+     * Change the runtime log level of a firmware tag
+     * @param {string} tag - Log tag (e.g. "rcp_protocol"), "*" for all
+     * @param {number} level - 0 none, 1 error, 2 warn, 3 info, 4 debug, 5 verbose
+     */
+    setLogLevel(tag, level) {
+        const tagBytes = new TextEncoder().encode(tag).subarray(0, this.RCP_LOG_TAG_MAX);
+        const body = new Uint8Array(2 + tagBytes.length);
+        body[0] = this.RCP_SYS_COMMANDS.LOG_LEVEL;
+        body[1] = Math.max(0, Math.min(5, level));
+        body.set(tagBytes, 2);
+        return this.sendCommand(this.RCP_PORTS.SYSTEM, body);
+    }
+    
+    /**
+     * Request a metrics registry snapshot, answered on the METRICS port
+     */
+    requestMetrics() {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.METRICS, 0]));
+    }
+    
+    /**
+     * Request per-task CPU and stack figures, the remaining pages are
+     * requested as each one arrives
+     * @param {number} first - Index of the first task
+     */
+    requestTaskStats(first = 0) {
+        if (first === 0) {
+            this.taskStatsPending = [];
+        }
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.TASKS, first]));
+    }
+    
+    /**
+     * Request a single telemetry frame
+     */
+    requestStatus() {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.STATUS, 0]));
+    }
+    
+    /**
+     * Set the role of this connection (RCP_ROLES value)
+     */
+    setRole(role) {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.ROLE, role]));
+    }
+    
+    /**
+     * Announce the protocol version; the firmware answers on the VERSION port
+     */
+    sendHello() {
+        return this.sendCommand(this.RCP_PORTS.SYSTEM,
+            new Uint8Array([this.RCP_SYS_COMMANDS.HELLO, this.RCP_VERSION_MAJOR]));
     }
     
 
@@ -79,7 +284,8 @@ class RCPClient {
         }
         
         // Validate specific command structures
-        if (port === this.RCP_PORTS.SYSTEM && payload.length !== 2) {
+        if (port === this.RCP_PORTS.SYSTEM && payload.length !== 2 &&
+            !(payload[0] === this.RCP_SYS_COMMANDS.PING && payload.length === this.RCP_PING_BODY_SIZE)) {
             console.error('RCP: System command requires 2 bytes payload (command + param), got:', payload.length);
             return false;
         }
@@ -99,6 +305,16 @@ class RCPClient {
             return false;
         }
         
+        if (port === this.RCP_PORTS.DRIVE && payload.length !== this.RCP_DRIVE_BODY_SIZE) {
+            console.error(`RCP: Drive command requires ${this.RCP_DRIVE_BODY_SIZE} bytes payload, got:`, payload.length);
+            return false;
+        }
+        
+        if (port === this.RCP_PORTS.BATCH && payload.length < this.RCP_BATCH_RECORD_HEADER_SIZE) {
+            console.error('RCP: Batch command requires at least one record, got:', payload.length, 'bytes');
+            return false;
+        }
+        
         return true;
     }
 
@@ -120,19 +336,28 @@ class RCPClient {
             return false;
         }
         
-        // Create message buffer: [len_lo][len_hi][port][payload]
-        const messageSize = this.RCP_HEADER_SIZE + payload.length;
+        // Create message buffer: [len_lo][len_hi][port]([seq][timestamp])[payload]
+        const headerSize = this.headerVersion >= 2 ? this.RCP_HEADER_V2_SIZE : this.RCP_HEADER_SIZE;
+        const messageSize = headerSize + payload.length;
         const buffer = new ArrayBuffer(messageSize);
         const data = new Uint8Array(buffer);
+        const header = new DataView(buffer);
         
         // Fill header
         data[0] = payload.length & 0xFF;
         data[1] = (payload.length >> 8) & 0xFF;
         data[2] = port;
         
+        if (this.headerVersion >= 2) {
+            data[1] |= this.RCP_HEADER_V2_FLAG;
+            header.setUint16(3, this.txSequence, true);
+            header.setUint32(5, Math.floor(performance.now()) >>> 0, true);
+            this.txSequence = (this.txSequence + 1) & 0xFFFF;
+        }
+        
         // Copy payload
         if (payload.length > 0) {
-            data.set(payload, this.RCP_HEADER_SIZE);
+            data.set(payload, headerSize);
         }
         
 
@@ -190,7 +415,7 @@ class RCPClient {
             
             // Always verify critical aspects even in non-DEBUG mode
             const verifyData = new Uint8Array(buffer);
-            const encodedLength = verifyData[0] | (verifyData[1] << 8);
+            const encodedLength = verifyData[0] | ((verifyData[1] & ~this.RCP_HEADER_V2_FLAG) << 8);
             if (encodedLength !== payload.length) {
                 console.error('RCP: CRITICAL - Length encoding incorrect!', encodedLength, 'expected:', payload.length);
             }
@@ -264,6 +489,27 @@ class RCPClient {
         return this.sendCommand(this.RCP_PORTS.LIGHT, payload);
     }
     
+    /**
+     * Send the complete control state in one drive frame
+     * @param {number} speed - Motor speed (-100 to +100)
+     * @param {number} steering - Servo position (-100 to +100)
+     * @param {boolean} horn - Horn state
+     * @param {boolean} light - Light state
+     */
+    sendDriveCommand(speed, steering, horn, light) {
+        const payload = new Uint8Array(this.RCP_DRIVE_BODY_SIZE);
+        const view = new DataView(payload.buffer);
+        
+        view.setInt8(0, Math.max(-100, Math.min(100, Math.round(speed))));
+        view.setInt8(1, Math.max(-100, Math.min(100, Math.round(steering))));
+        view.setUint8(2, (light ? this.RCP_DRIVE_FLAGS.LIGHT : 0) | (horn ? this.RCP_DRIVE_FLAGS.HORN : 0));
+        view.setUint16(3, this.driveSequence, true);
+        this.driveSequence = (this.driveSequence + 1) & 0xFFFF;
+        
+        if (DEBUG) console.log(`RCP: Sending drive command: speed=${speed}, steering=${steering}, horn=${horn}, light=${light}`);
+        return this.sendCommand(this.RCP_PORTS.DRIVE, payload);
+    }
+    
     /**
      * Process incoming RCP response
      * @param {ArrayBuffer} data - Response data
@@ -300,6 +546,30 @@ class RCPClient {
                 this.processTelemetryResponse(bodyView, bodyArray);
                 break;
 
+            case this.RCP_PORTS.VERSION:
+                this.processVersionResponse(bodyArray);
+                break;
+
+            case this.RCP_PORTS.TELEMETRY_DELTA:
+                this.processTelemetryDelta(bodyArray);
+                break;
+
+            case this.RCP_PORTS.PONG:
+                this.processPongResponse(bodyView, bodyArray);
+                break;
+
+            case this.RCP_PORTS.LOG:
+                this.processLogLine(bodyArray);
+                break;
+
+            case this.RCP_PORTS.METRICS:
+                this.processMetricsSnapshot(bodyView, bodyArray);
+                break;
+
+            case this.RCP_PORTS.TASKS:
+                this.processTaskStats(bodyView, bodyArray);
+                break;
+
             case this.RCP_PORTS.ACK:
                 if (DEBUG) console.log('RCP: Acknowledgment received');
                 break;
@@ -310,6 +580,213 @@ class RCPClient {
         }
     }
     
+    /**
+     * Process pong response
+     *
+     * RTT is measured on the local clock only. The device rx/tx stamps give
+     * its processing time, which is removed before splitting the network
+     * time. The device clock offset is unknown, so each direction is
+     * estimated relative to the fastest exchange seen: the offset that
+     * exchange implies is assumed symmetric and reused for later pongs.
+     * @param {DataView} view - Response data view
+     * @param {Uint8Array} data - Response data
+     */
+    processPongResponse(view, data) {
+        if (data.length !== 13) {
+            console.warn('RCP: Invalid pong response length:', data.length);
+            this.stats.errors++;
+            return;
+        }
+
+        const now = this.nowMicros();
+        const clientTime = view.getUint32(1, true);
+        const deviceRx = view.getUint32(5, true);
+        const deviceTx = view.getUint32(9, true);
+
+        if (clientTime === 0) {
+            return; // Reply to a legacy ping without timestamp
+        }
+
+        const rtt = (now - clientTime) >>> 0;
+        const processing = (deviceTx - deviceRx) >>> 0;
+        const network = Math.max(0, rtt - processing);
+        const p = this.ping;
+
+        // Interarrival jitter as in RFC 3550: smoothed RTT variation
+        if (p.received > 0) {
+            p.jitterUs += (Math.abs(rtt - p.lastRttUs) - p.jitterUs) / 16;
+        }
+
+        if (p.received === 0 || rtt < p.minRttUs) {
+            p.minRttUs = rtt;
+            // device clock - client clock, assuming a symmetric fastest path
+            p.clockOffsetUs = ((deviceRx - clientTime) >>> 0) - network / 2;
+        }
+
+        const up = (((deviceRx - clientTime) >>> 0) - p.clockOffsetUs) | 0;
+        p.uplinkUs = Math.max(0, up);
+        p.downlinkUs = Math.max(0, network - p.uplinkUs);
+        p.deviceProcessingUs = processing;
+        p.lastRttUs = rtt;
+        p.received++;
+
+        this.stats.latencyHistory.push(rtt / 1000);
+        if (this.stats.latencyHistory.length > this.RCP_LATENCY_HISTORY) {
+            this.stats.latencyHistory.shift();
+        }
+
+        if (DEBUG) console.log(`RCP: Pong id=${data[0]} rtt=${(rtt / 1000).toFixed(1)}ms jitter=${(p.jitterUs / 1000).toFixed(1)}ms`);
+    }
+    
+    /**
+     * Get link latency estimates from ping/pong exchanges
+     * @returns {Object} Latency statistics in milliseconds
+     */
+    getLatencyStats() {
+        const p = this.ping;
+        const history = this.stats.latencyHistory;
+        const avg = history.length > 0 ? history.reduce((a, b) => a + b, 0) / history.length : 0;
+
+        return {
+            pingsSent: p.sent,
+            pongsReceived: p.received,
+            lossRate: p.sent > 0 ? (1 - p.received / p.sent) : 0,
+            rttMs: p.lastRttUs / 1000,
+            rttMinMs: p.minRttUs / 1000,
+            rttAvgMs: avg,
+            jitterMs: p.jitterUs / 1000,
+            uplinkMs: p.uplinkUs / 1000,
+            downlinkMs: p.downlinkUs / 1000,
+            deviceProcessingMs: p.deviceProcessingUs / 1000,
+            serverRttMs: this.telemetryState ? this.telemetryState.linkRtt : 0 // Firmware heartbeat view
+        };
+    }
+    
+    /**
+     * Process a device console log line
+     * @param {Uint8Array} data - UTF-8 text without newline
+     */
+    processLogLine(data) {
+        const line = new TextDecoder().decode(data);
+        this.deviceLog.push(line);
+        if (this.deviceLog.length > this.RCP_LOG_HISTORY) {
+            this.deviceLog.shift();
+        }
+        console.log(`[device] ${line}`);
+    }
+    
+    /**
+     * Process a metrics snapshot: [version][count] then per entry [id][type]
+     * and a u32 value, or [count u32][sum u32][n][bucket u32 x n] for histograms
+     * @param {DataView} view - Data view over body
+     * @param {Uint8Array} data - Body data array
+     */
+    processMetricsSnapshot(view, data) {
+        if (data.length < 2 || data[0] !== 1) {
+            console.warn('RCP: Unsupported metrics snapshot');
+            this.stats.errors++;
+            return;
+        }
+
+        const metrics = {};
+        let offset = 2;
+        for (let i = 0; i < data[1]; i++) {
+            if (offset + 6 > data.length) {
+                console.warn('RCP: Truncated metrics snapshot');
+                this.stats.errors++;
+                return;
+            }
+            const id = data[offset];
+            const type = data[offset + 1];
+            offset += 2;
+
+            if (type !== 2) {
+                metrics[id] = { type: type, value: view.getUint32(offset, true) };
+                offset += 4;
+                continue;
+            }
+
+            const count = view.getUint32(offset, true);
+            const sum = view.getUint32(offset + 4, true);
+            const bucketCount = data[offset + 8];
+            offset += 9;
+            if (offset + bucketCount * 4 > data.length) {
+                console.warn('RCP: Truncated metrics histogram');
+                this.stats.errors++;
+                return;
+            }
+            const buckets = [];
+            for (let b = 0; b < bucketCount; b++) {
+                buckets.push(view.getUint32(offset, true));
+                offset += 4;
+            }
+            metrics[id] = { type: type, count: count, sum: sum, buckets: buckets };
+        }
+
+        this.metrics = metrics;
+        if (DEBUG) console.log('RCP: Metrics snapshot', metrics);
+    }
+    
+    /**
+     * Process a task stats page: [total][first][count] then 24-byte entries
+     * [priority][core][cpu permille u16][stack free u32][name 16]
+     * @param {DataView} view - Data view over body
+     * @param {Uint8Array} data - Body data array
+     */
+    processTaskStats(view, data) {
+        const ENTRY_SIZE = 24;
+        if (data.length < 3 || data.length !== 3 + data[2] * ENTRY_SIZE) {
+            console.warn('RCP: Invalid task stats page');
+            this.stats.errors++;
+            return;
+        }
+
+        const total = data[0];
+        const first = data[1];
+        const count = data[2];
+        if (first !== this.taskStatsPending.length) {
+            return;     // Task list changed under a paged read, wait for the next request
+        }
+
+        const decoder = new TextDecoder();
+        for (let i = 0; i < count; i++) {
+            const offset = 3 + i * ENTRY_SIZE;
+            const name = data.subarray(offset + 8, offset + ENTRY_SIZE);
+            const end = name.indexOf(0);
+            this.taskStatsPending.push({
+                name: decoder.decode(end >= 0 ? name.subarray(0, end) : name),
+                priority: data[offset],
+                core: view.getInt8(offset + 1),
+                cpuPercent: view.getUint16(offset + 2, true) / 10,
+                stackFreeMin: view.getUint32(offset + 4, true)
+            });
+        }
+
+        if (count > 0 && first + count < total) {
+            this.requestTaskStats(first + count);
+            return;
+        }
+
+        this.taskStats = this.taskStatsPending;
+        this.taskStatsPending = [];
+        if (DEBUG) console.table(this.taskStats);
+    }
+    
+    /**
+     * Process protocol version response
+     * @param {Uint8Array} data - [major][minor][header_version]
+     */
+    processVersionResponse(data) {
+        if (data.length !== 3) {
+            console.warn('RCP: Invalid version response length:', data.length);
+            this.stats.errors++;
+            return;
+        }
+
+        this.headerVersion = data[2];
+        console.log(`RCP: Firmware protocol v${data[0]}.${data[1]}, using header v${this.headerVersion}`);
+    }
+    
     /**
      * Process battery status response
      * @param {DataView} view - Data view over body
@@ -353,7 +830,8 @@ class RCPClient {
      * @param {Uint8Array} data - Body data array
      */
     processTelemetryResponse(view, data) {
-        if (data.length !== 5) {
+        // 6 bytes since the link RTT field, 5 from older firmware
+        if (data.length !== 5 && data.length !== 6) {
             console.warn('RCP: Invalid telemetry response size');
             this.stats.errors++;
             return;
@@ -364,8 +842,72 @@ class RCPClient {
         const hornState = view.getUint8(2);
         const lightState = view.getUint8(3);
         const flags = view.getUint8(4);
+        const linkRtt = data.length > 5 ? view.getUint8(5) : 0;  // ms, 0 = unknown
         
         if (DEBUG) console.log(`RCP: Telemetry - Speed: ${speed}, Angle: ${angle}, Horn: ${hornState ? 'ON' : 'OFF'}, Light: ${lightState ? 'ON' : 'OFF'}, Flags: 0x${flags.toString(16)}`);
+        
+        this.telemetryState = {
+            speed: speed,
+            angle: angle,
+            horn: hornState,
+            light: lightState,
+            flags: flags,
+            linkRtt: linkRtt
+        };
+        this.applyTelemetryState();
+    }
+    
+    /**
+     * Process delta telemetry: [mask][changed fields in body order]
+     * @param {Uint8Array} data - Response data
+     */
+    processTelemetryDelta(data) {
+        if (data.length < 1) {
+            console.warn('RCP: Empty telemetry delta');
+            this.stats.errors++;
+            return;
+        }
+
+        if (this.telemetryState === null) {
+            // Delta against a state we never received
+            this.requestTelemetryKeyframe();
+            return;
+        }
+
+        const mask = data[0];
+        const next = Object.assign({}, this.telemetryState);
+        let offset = 1;
+
+        for (const field of this.RCP_TELEMETRY_FIELDS) {
+            if (!(mask & field.bit)) {
+                continue;
+            }
+            if (offset >= data.length) {
+                console.warn('RCP: Truncated telemetry delta, mask:', mask);
+                this.stats.errors++;
+                this.requestTelemetryKeyframe();
+                return;
+            }
+            const value = data[offset++];
+            next[field.name] = field.signed && value > 127 ? value - 256 : value;
+        }
+
+        this.telemetryState = next;
+        this.applyTelemetryState();
+    }
+    
+    /**
+     * Show what the device actually applied
+     */
+    applyTelemetryState() {
+        const state = this.telemetryState;
+        updateActuatorState({
+            speed: state.speed,
+            angle: state.angle,
+            horn: state.horn !== 0,
+            light: state.light !== 0,
+            flags: state.flags
+        });
     }
     
     /**
@@ -443,9 +985,12 @@ class RCPClient {
     }
 }
 
+// MJPEG is served by a separate server so streaming never blocks /ws
+const VIDEO_SERVER_PORT = 81;
+
 function makeView() {
     const img = document.getElementsByTagName('img')[0];
-    img.src = '/video?' + new Date().getTime();
+    img.src = `${location.protocol}//${location.hostname}:${VIDEO_SERVER_PORT}/video?` + new Date().getTime();
 }
 
 // WebSocket connection for sending commands
@@ -467,9 +1012,14 @@ let steeringPreviewTimerId = null;
 // Command buffering and periodic flush
 // Buffer holds the most-recent requested value and is flushed periodically
 const COMMAND_SEND_INTERVAL_MS = 20; // Flush interval in ms (20ms -> 50Hz)
+const COMMAND_KEEPALIVE_MS = 50;     // Repeat the drive state while idle, firmware failsafe trips after 150ms
+const PING_INTERVAL_MS = 1000;       // RCP ping period for RTT measurement
+const TELEMETRY_RATE_HZ = 20;        // Requested actuator telemetry rate
 let commandBuffer = { speed: null, wheels: null, horn: null, light: null };
 let lastSent = { speed: null, wheels: null, horn: null, light: null };
+let lastDriveSentAt = 0;
 let commandFlushIntervalId = null;
+let pingIntervalId = null;
 
 // Multi-touch monitoring
 let activeControls = new Set();
@@ -540,15 +1090,27 @@ function flushBufferedCommands() {
         return;
     }
 
-    Object.entries(commandBuffer).forEach(([type, value]) => {
-        if (value === null || lastSent[type] === value) {
-            return;
-        }
+    // Send the whole control state of this tick as one drive frame so
+    // steering and throttle reach the hardware together
+    const changed = Object.keys(commandBuffer).some(type =>
+        commandBuffer[type] !== null && lastSent[type] !== commandBuffer[type]);
 
-        if (sendControlCommand(type, value)) {
-            lastSent[type] = value;
-        }
+    // Unchanged state is still repeated now and then, silence means link loss to the firmware
+    const keepalive = lastDriveSentAt > 0 && performance.now() - lastDriveSentAt >= COMMAND_KEEPALIVE_MS;
+
+    if (!changed && !keepalive) {
+        return;
+    }
+
+    const state = {};
+    Object.keys(commandBuffer).forEach(type => {
+        state[type] = commandBuffer[type] !== null ? commandBuffer[type] : 0;
     });
+
+    if (rcpClient.sendDriveCommand(state.speed, state.wheels, state.horn, state.light)) {
+        Object.assign(lastSent, state);
+        lastDriveSentAt = performance.now();
+    }
 }
 
 function startCommandFlush() {
@@ -559,6 +1121,27 @@ function startCommandFlush() {
     commandFlushIntervalId = setInterval(flushBufferedCommands, COMMAND_SEND_INTERVAL_MS);
 }
 
+function startPing() {
+    if (pingIntervalId !== null) {
+        return;
+    }
+
+    pingIntervalId = setInterval(() => {
+        if (rcpClient && ws && ws.readyState === WebSocket.OPEN) {
+            rcpClient.sendPing();
+        }
+    }, PING_INTERVAL_MS);
+}
+
+function stopPing() {
+    if (pingIntervalId === null) {
+        return;
+    }
+
+    clearInterval(pingIntervalId);
+    pingIntervalId = null;
+}
+
 function stopCommandFlush() {
     if (commandFlushIntervalId === null) {
         return;
@@ -662,6 +1245,8 @@ function initWebSocket() {
             
             // Initialize RCP client
             rcpClient = new RCPClient(ws);
+            rcpClient.sendHello();
+            rcpClient.subscribeTelemetry(TELEMETRY_RATE_HZ);
             console.log('RCP Client initialized and ready');
             
             // Reset command cache to ensure fresh state after reconnection
@@ -669,6 +1254,7 @@ function initWebSocket() {
 
             startCommandFlush();
             flushBufferedCommands();
+            startPing();
 
         };
         
@@ -802,6 +1388,7 @@ function initWebSocket() {
             // Clear RCP client on disconnect
             rcpClient = null;
             stopCommandFlush();
+            stopPing();
             
             // Use recovery strategy from error handler or determine from close code
             let recoveryStrategy = ws._recoveryStrategy || {
@@ -2124,6 +2711,40 @@ function updateBatteryLevel(level) {
     }
 }
 
+// Actual actuator state reported by the device telemetry
+function updateActuatorState(state) {
+    const speedActual = document.getElementById('speedActual');
+    if (speedActual) {
+        // Same mapping as the speed control: zero at 66.67%, forward above
+        const zero = 66.67;
+        const top = state.speed >= 0
+            ? zero - (state.speed / 100) * zero
+            : zero + (-state.speed / 100) * (100 - zero);
+        speedActual.style.top = top + '%';
+    }
+
+    const wheelsActual = document.getElementById('wheelsActual');
+    if (wheelsActual) {
+        wheelsActual.style.left = (50 + state.angle / 2) + '%';
+    }
+
+    // Markers turn red while the firmware failsafe holds the car
+    const failsafe = rcpClient !== null && (state.flags & rcpClient.RCP_TELEMETRY_FLAGS.FAILSAFE) !== 0;
+    document.querySelectorAll('.control-actual').forEach(marker => {
+        marker.classList.toggle('failsafe', failsafe);
+    });
+
+    const hornBtn = document.getElementById('btnHorn');
+    if (hornBtn) {
+        hornBtn.classList.toggle('device-on', state.horn);
+    }
+
+    const lightBtn = document.getElementById('btnLight');
+    if (lightBtn) {
+        lightBtn.classList.toggle('device-on', state.light);
+    }
+}
+
 function startBatteryDebugLoop() {
     if (DEBUG) {
         setInterval(() => {
@@ -0,0 +1,400 @@
+/**
+ * @file bench_rcp.c
+ * @brief Host micro-benchmark of the RCP hot paths
+ *
+ * Times rcp_process_message() per port, the servo and DRV8833 output math,
+ * the battery report conversion and the rcp_send_response() broadcast, all
+ * from the firmware_core sources. Logs are off and the HAL stand-ins do not
+ * record, so the figures are the cost of the firmware code itself.
+ *
+ * Results go to stdout (or -o file) as one JSON document, so runs of two
+ * commits can be compared with any JSON tool; a table goes to stderr.
+ *
+ * Build and run from v1_esp32/host:
+ *   cmake -S . -B build && cmake --build build -j
+ *   ./build/bench_rcp [-n iterations] [-r repeats] [-f filter] [-o out.json]
+ */
+
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "host_hal.h"
+#include "host_httpd.h"
+#include "project_config.h"
+#include "config.h"
+#include "http_server.h"
+#include "rcp_protocol.h"
+#include "dlog.h"
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+#include "battery_monitor.h"
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#include "motor_drv8833.h"
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS    200000u
+#define BENCH_DEFAULT_REPEATS       5
+#define BENCH_MAX_REPEATS           32
+#define BENCH_MAX_WS_CLIENTS        5       // Broadcast fan-out of the largest case
+
+typedef esp_err_t (*bench_fn_t)(uint32_t i);
+
+typedef struct {
+    const char *name;
+    bench_fn_t fn;
+    int ws_clients;                 // Injected /ws sessions open during the case
+} bench_case_t;
+
+typedef struct {
+    double ns_median;
+    double ns_min;
+    uint32_t errors;
+} bench_result_t;
+
+static uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+static int repeats = BENCH_DEFAULT_REPEATS;
+
+static int ws_fds[BENCH_MAX_WS_CLIENTS];
+static int ws_open_count = 0;
+static volatile uint64_t ws_frames_out = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Keeps stdout for the JSON document
+static int log_to_stderr(const char *format, va_list args)
+{
+    return vfprintf(stderr, format, args);
+}
+
+// Frames reach the sink from the outbox task; only counted
+static void ws_count_sink(void *ctx, int fd, httpd_ws_type_t type, const uint8_t *data, size_t len)
+{
+    ws_frames_out++;
+}
+
+// =============================================================================
+// CASES
+// =============================================================================
+
+static esp_err_t bench_msg_motor(uint32_t i)
+{
+    uint8_t body = (uint8_t)(int8_t)(i % 201 - 100);
+    return rcp_process_message(RCP_PORT_MOTOR, &body, sizeof(body));
+}
+
+static esp_err_t bench_msg_servo(uint32_t i)
+{
+    uint8_t body = (uint8_t)(int8_t)(i % 201 - 100);
+    return rcp_process_message(RCP_PORT_SERVO, &body, sizeof(body));
+}
+
+static esp_err_t bench_msg_horn(uint32_t i)
+{
+    uint8_t body = (uint8_t)(i & 1);
+    return rcp_process_message(RCP_PORT_HORN, &body, sizeof(body));
+}
+
+static esp_err_t bench_msg_light(uint32_t i)
+{
+    uint8_t body = (uint8_t)(i & 1);
+    return rcp_process_message(RCP_PORT_LIGHT, &body, sizeof(body));
+}
+
+static esp_err_t bench_msg_drive(uint32_t i)
+{
+    // A new sequence every frame, so none is dropped as stale
+    rcp_drive_body_t body = {
+        .speed = (int8_t)(i % 201 - 100),
+        .steering = (int8_t)(i % 101 - 50),
+        .flags = (uint8_t)(i & RCP_DRIVE_FLAGS_MASK),
+        .sequence = (uint16_t)i,
+    };
+    return rcp_process_message(RCP_PORT_DRIVE, (const uint8_t *)&body, sizeof(body));
+}
+
+static esp_err_t bench_msg_batch(uint32_t i)
+{
+    // Motor and servo records, as a client that batches one input tick
+    uint8_t body[] = {
+        RCP_PORT_MOTOR, 1, (uint8_t)(int8_t)(i % 201 - 100),
+        RCP_PORT_SERVO, 1, (uint8_t)(int8_t)(i % 101 - 50),
+    };
+    return rcp_process_message(RCP_PORT_BATCH, body, sizeof(body));
+}
+
+static esp_err_t bench_msg_ping(uint32_t i)
+{
+    rcp_ping_body_t body = {
+        .command = RCP_SYS_PING,
+        .id = (uint8_t)i,
+        .client_time_us = i,
+        .last_rtt_us = 0,
+    };
+    return rcp_process_message(RCP_PORT_SYSTEM, (const uint8_t *)&body, sizeof(body));
+}
+
+static esp_err_t bench_msg_invalid(uint32_t i)
+{
+    uint8_t body = 0;
+    // The rejection path, expected to fail
+    return rcp_process_message(RCP_PORT_INVALID, &body, sizeof(body)) == ESP_OK ? ESP_FAIL : ESP_OK;
+}
+
+#if ENABLE_SERVO_CONTROL
+static esp_err_t bench_servo_position(uint32_t i)
+{
+    return servo_control_set_position((int)(i % 201) - 100);
+}
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+static esp_err_t bench_drv8833_speed(uint32_t i)
+{
+    return drv8833_set_speed((int)(i % 201) - 100);
+}
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+static esp_err_t bench_battery_report(uint32_t i)
+{
+    return battery_send_voltage(3.0f + (float)(i % 1200) / 1000.0f);
+}
+#endif
+
+static esp_err_t bench_send_response(uint32_t i)
+{
+    rcp_battery_body_t body = {
+        .voltage_mv = (uint16_t)(3000 + i % 1200),
+        .level = (uint8_t)(i % 101),
+        .type = 1,
+    };
+    return rcp_send_response(RCP_PORT_BATTERY, &body, sizeof(body));
+}
+
+static const bench_case_t bench_cases[] = {
+    { "rcp_process_message/motor",     bench_msg_motor,       0 },
+    { "rcp_process_message/servo",     bench_msg_servo,       0 },
+    { "rcp_process_message/horn",      bench_msg_horn,        0 },
+    { "rcp_process_message/light",     bench_msg_light,       0 },
+    { "rcp_process_message/drive",     bench_msg_drive,       0 },
+    { "rcp_process_message/batch",     bench_msg_batch,       0 },
+    { "rcp_process_message/ping",      bench_msg_ping,        1 },
+    { "rcp_process_message/invalid",   bench_msg_invalid,     0 },
+#if ENABLE_SERVO_CONTROL
+    { "servo_control_set_position",    bench_servo_position,  0 },
+#endif
+#if ENABLE_MOTOR_CONTROL
+    { "drv8833_set_speed",             bench_drv8833_speed,   0 },
+#endif
+#if ENABLE_BATTERY_MONITORING
+    { "battery_send_voltage/clients=1", bench_battery_report, 1 },
+#endif
+    { "rcp_send_response/clients=0",   bench_send_response,   0 },
+    { "rcp_send_response/clients=1",   bench_send_response,   1 },
+    { "rcp_send_response/clients=5",   bench_send_response,   BENCH_MAX_WS_CLIENTS },
+};
+
+// =============================================================================
+// RUNNER
+// =============================================================================
+
+// Open or close injected /ws sessions until @p count are open
+static void bench_set_ws_clients(int count)
+{
+    httpd_handle_t server = http_server_get_handle();
+
+    while (ws_open_count > count) {
+        host_httpd_close(server, ws_fds[--ws_open_count]);
+    }
+    while (ws_open_count < count) {
+        if (host_httpd_ws_open(server, "/ws", &ws_fds[ws_open_count]) != ESP_OK) {
+            fprintf(stderr, "bench_rcp: /ws session %d refused\n", ws_open_count);
+            return;
+        }
+        ws_open_count++;
+    }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static bench_result_t bench_run(const bench_case_t *bench)
+{
+    double samples[BENCH_MAX_REPEATS];
+    bench_result_t result = { 0 };
+
+    bench_set_ws_clients(bench->ws_clients);
+
+    // Warm caches, branch predictors and the control mailbox
+    uint32_t warmup = iterations / 10 + 1;
+    for (uint32_t i = 0; i < warmup; i++) {
+        bench->fn(i);
+    }
+
+    for (int r = 0; r < repeats; r++) {
+        uint64_t start = now_ns();
+        for (uint32_t i = 0; i < iterations; i++) {
+            if (bench->fn(i) != ESP_OK) {
+                result.errors++;
+            }
+        }
+        samples[r] = (double)(now_ns() - start) / iterations;
+    }
+
+    qsort(samples, (size_t)repeats, sizeof(samples[0]), compare_double);
+    result.ns_median = samples[repeats / 2];
+    result.ns_min = samples[0];
+    return result;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-n iterations] [-r repeats] [-f filter] [-o file]\n"
+            "  -n iterations  Calls per repeat (default %u)\n"
+            "  -r repeats     Timed repeats, the median is reported (default %d, max %d)\n"
+            "  -f filter      Run only the cases whose name contains filter\n"
+            "  -o file        Write the JSON results to file instead of stdout\n",
+            program, BENCH_DEFAULT_ITERATIONS, BENCH_DEFAULT_REPEATS, BENCH_MAX_REPEATS);
+}
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    const char *out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:f:o:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'o':
+                out_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (iterations == 0 || repeats <= 0 || repeats > BENCH_MAX_REPEATS) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *out = stdout;
+    if (out_path != NULL) {
+        out = fopen(out_path, "w");
+        if (out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    // Init messages stay visible, the timed loops run without logging
+    esp_log_set_vprintf(log_to_stderr);
+
+#if ENABLE_DLOG
+    dlog_start();
+#endif
+
+    config_init();
+
+#if ENABLE_LED_CONTROL
+    led_control_init();
+#endif
+
+#if ENABLE_SERVO_CONTROL
+    servo_control_init();
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+    battery_monitor_init();
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+    motor_control_init();
+#endif
+
+    // No listen port: broadcasts reach the injected sessions only
+    http_server_start();
+    host_httpd_set_ws_sink(http_server_get_handle(), ws_count_sink, NULL);
+
+    esp_log_level_set("*", ESP_LOG_NONE);
+    host_hal_set_recording(false);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"bench_rcp\",\n");
+    fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(out, "  \"iterations\": %u,\n", iterations);
+    fprintf(out, "  \"repeats\": %d,\n", repeats);
+    fprintf(out, "  \"results\": [");
+
+    fprintf(stderr, "%-34s %12s %12s %14s %8s\n", "case", "ns/op", "min ns/op", "ops/s", "errors");
+
+    uint32_t total_errors = 0;
+    bool first = true;
+    for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++) {
+        const bench_case_t *bench = &bench_cases[c];
+        if (filter != NULL && strstr(bench->name, filter) == NULL) {
+            continue;
+        }
+
+        bench_result_t result = bench_run(bench);
+        double ops_per_sec = 1e9 / result.ns_median;
+        total_errors += result.errors;
+
+        fprintf(out, "%s\n    { \"name\": \"%s\", \"ws_clients\": %d, \"ns_per_op\": %.2f, "
+                     "\"ns_per_op_min\": %.2f, \"ops_per_sec\": %.0f, \"errors\": %u }",
+                first ? "" : ",", bench->name, bench->ws_clients, result.ns_median,
+                result.ns_min, ops_per_sec, result.errors);
+        first = false;
+
+        fprintf(stderr, "%-34s %12.1f %12.1f %14.0f %8u\n", bench->name, result.ns_median,
+                result.ns_min, ops_per_sec, result.errors);
+    }
+
+    fprintf(out, "\n  ],\n");
+    fprintf(out, "  \"ws_frames_out\": %llu\n", (unsigned long long)ws_frames_out);
+    fprintf(out, "}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    bench_set_ws_clients(0);
+
+    // Errors mean a case stopped measuring what it names
+    return total_errors == 0 ? 0 : 1;
+}
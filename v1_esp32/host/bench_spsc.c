@@ -0,0 +1,209 @@
+/**
+ * @file bench_spsc.c
+ * @brief Host throughput benchmark for spsc_ring and mailbox
+ *
+ * Runs a producer and a consumer thread on the host to measure the
+ * cross-thread cost of the primitives used between firmware tasks. Waiting
+ * threads yield, so it also gives sane numbers on a single core.
+ *
+ * Build and run from v1_esp32:
+ *   gcc -O2 -std=gnu11 -pthread -Imain/inc host/bench_spsc.c \
+ *       main/src/spsc_ring.c main/src/mailbox.c -o bench_spsc
+ *   ./bench_spsc [items]
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mailbox.h"
+#include "spsc_ring.h"
+
+#define BENCH_DEFAULT_ITEMS     10000000u
+#define BENCH_RING_CAPACITY     64      // Same order as the firmware queues
+
+typedef struct {
+    uint32_t seq;
+    int8_t speed;
+    int8_t steering;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t check;                     // ~seq, detects torn mailbox reads
+} bench_item_t;
+
+SPSC_RING_DEFINE(bench_ring, bench_item_t, BENCH_RING_CAPACITY);
+MAILBOX_DEFINE(bench_mailbox, bench_item_t);
+
+static uint32_t item_count = BENCH_DEFAULT_ITEMS;
+static volatile int writer_done = 0;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bench_item_t make_item(uint32_t seq)
+{
+    bench_item_t item = {
+        .seq = seq,
+        .speed = (int8_t)(seq % 201 - 100),
+        .steering = (int8_t)(seq % 101 - 50),
+        .flags = (uint8_t)(seq & 0x03),
+        .check = ~seq,
+    };
+    return item;
+}
+
+// =============================================================================
+// SPSC RING
+// =============================================================================
+
+static uint64_t ring_full_spins = 0;
+static uint64_t ring_empty_spins = 0;
+
+static void *ring_producer(void *arg)
+{
+    for (uint32_t i = 0; i < item_count; i++) {
+        bench_item_t item = make_item(i);
+        while (!spsc_ring_push(&bench_ring, &item)) {
+            ring_full_spins++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *ring_consumer(void *arg)
+{
+    uint32_t *errors = arg;
+    bench_item_t item;
+
+    for (uint32_t i = 0; i < item_count; i++) {
+        while (!spsc_ring_pop(&bench_ring, &item)) {
+            ring_empty_spins++;
+            sched_yield();
+        }
+        if (item.seq != i || item.check != ~i) {
+            (*errors)++;
+        }
+    }
+    return NULL;
+}
+
+static int bench_ring_run(void)
+{
+    pthread_t producer;
+    pthread_t consumer;
+    uint32_t errors = 0;
+
+    double start = now_seconds();
+    pthread_create(&consumer, NULL, ring_consumer, &errors);
+    pthread_create(&producer, NULL, ring_producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    double elapsed = now_seconds() - start;
+
+    printf("spsc_ring: %u items of %zu bytes in %.3f s, %.1f Mitems/s, %.1f ns/item\n",
+           item_count, sizeof(bench_item_t), elapsed, item_count / elapsed / 1e6,
+           elapsed * 1e9 / item_count);
+    printf("  full spins %llu, empty spins %llu, order errors %u\n",
+           (unsigned long long)ring_full_spins, (unsigned long long)ring_empty_spins, errors);
+
+    return errors == 0 ? 0 : 1;
+}
+
+// =============================================================================
+// MAILBOX
+// =============================================================================
+
+typedef struct {
+    uint64_t reads;
+    uint64_t busy;
+    uint64_t torn;
+    uint64_t backwards;
+    uint64_t distinct;
+} mailbox_reader_stats_t;
+
+static void *mailbox_writer(void *arg)
+{
+    for (uint32_t i = 0; i < item_count; i++) {
+        bench_item_t item = make_item(i);
+        mailbox_write(&bench_mailbox, &item);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static void *mailbox_reader(void *arg)
+{
+    mailbox_reader_stats_t *stats = arg;
+    uint32_t last_seq = 0;
+    bool have_last = false;
+    bench_item_t item;
+
+    while (!writer_done) {
+        uint32_t seq;
+        if (!mailbox_read(&bench_mailbox, &item, &seq)) {
+            stats->busy++;
+            sched_yield();
+            continue;
+        }
+        if (seq == 0) {
+            continue;
+        }
+        stats->reads++;
+        if (item.check != ~item.seq) {
+            stats->torn++;
+        }
+        if (have_last && item.seq < last_seq) {
+            stats->backwards++;
+        }
+        if (!have_last || item.seq != last_seq) {
+            stats->distinct++;
+        }
+        last_seq = item.seq;
+        have_last = true;
+        sched_yield();
+    }
+    return NULL;
+}
+
+static int bench_mailbox_run(void)
+{
+    pthread_t writer;
+    pthread_t reader;
+    mailbox_reader_stats_t stats = { 0 };
+
+    writer_done = 0;
+    double start = now_seconds();
+    pthread_create(&reader, NULL, mailbox_reader, &stats);
+    pthread_create(&writer, NULL, mailbox_writer, NULL);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+    double elapsed = now_seconds() - start;
+
+    printf("mailbox:   %u writes in %.3f s, %.1f Mwrites/s, %.1f ns/write\n",
+           item_count, elapsed, item_count / elapsed / 1e6, elapsed * 1e9 / item_count);
+    printf("  reads %llu (%llu distinct), busy %llu, torn %llu, backwards %llu\n",
+           (unsigned long long)stats.reads, (unsigned long long)stats.distinct,
+           (unsigned long long)stats.busy, (unsigned long long)stats.torn,
+           (unsigned long long)stats.backwards);
+
+    return (stats.torn == 0 && stats.backwards == 0) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        item_count = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    int failed = bench_ring_run();
+    failed |= bench_mailbox_run();
+
+    return failed;
+}
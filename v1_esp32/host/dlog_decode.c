@@ -0,0 +1,173 @@
+/**
+ * @file dlog_decode.c
+ * @brief Host decoder for the deferred log binary output
+ *
+ * Reads a console capture of firmware built with DLOG_OUTPUT_BINARY set to 1
+ * and prints it as text: regular console output is passed through unchanged
+ * and every dlog frame becomes one ESP_LOGx style line. Must be built from
+ * the same dlog_formats.h as the firmware.
+ *
+ * Build and run from v1_esp32:
+ *   gcc -O2 -std=gnu11 -Imain/inc host/dlog_decode.c -o dlog_decode
+ *   ./dlog_decode [capture.bin]         (stdin when no file is given)
+ *
+ * Live, with the serial port in raw mode:
+ *   stty -F /dev/ttyUSB0 115200 raw && ./dlog_decode < /dev/ttyUSB0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dlog_formats.h"
+
+typedef struct {
+    char level;
+    const char *tag;
+    const char *format;
+} dlog_format_t;
+
+#define DLOG_FORMAT_ENTRY(id, level, tag, format)   [id] = { (#level)[0], tag, format },
+
+static const dlog_format_t dlog_formats[DLOG_FORMAT_COUNT] = {
+    DLOG_FORMATS(DLOG_FORMAT_ENTRY)
+};
+
+static unsigned long frames_ok = 0;
+static unsigned long frames_bad = 0;
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Decode the frame at the start of buf
+ *
+ * Undoes the escaping of line ending bytes while reading, see dlog_formats.h.
+ *
+ * @return Bytes of buf taken by the frame when decoded, 0 if more bytes are
+ *         needed, -1 if the bytes at buf are not a valid frame
+ */
+static int decode_frame(const uint8_t *buf, size_t len, FILE *out)
+{
+    uint8_t frame[DLOG_FRAME_MAX_SIZE];
+    size_t frame_len = DLOG_FRAME_HEADER_SIZE;     // Until the count is read
+    size_t n = 2;
+    size_t pos = 2;
+
+    while (n < frame_len) {
+        if (pos >= len) {
+            return 0;
+        }
+        uint8_t byte = buf[pos++];
+        if (byte == DLOG_FRAME_ESCAPE) {
+            if (pos >= len) {
+                return 0;
+            }
+            byte = buf[pos++] ^ DLOG_FRAME_ESCAPE_XOR;
+        } else if (byte == 0x0A || byte == 0x0D) {
+            return -1;      // Never sent unescaped: this was console text
+        }
+        frame[n++] = byte;
+
+        if (n == DLOG_FRAME_HEADER_SIZE) {
+            uint16_t id = (uint16_t)(frame[6] | (frame[7] << 8));
+            uint8_t argc = frame[8];
+            if (id >= DLOG_FORMAT_COUNT || argc > DLOG_MAX_ARGS) {
+                return -1;
+            }
+            frame_len = DLOG_FRAME_HEADER_SIZE + argc * 4u + 1;
+        }
+    }
+
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < frame_len - 1; i++) {
+        checksum ^= frame[i];
+    }
+    if (checksum != frame[frame_len - 1]) {
+        return -1;
+    }
+
+    uint32_t timestamp = read_u32(&frame[2]);
+    uint16_t id = (uint16_t)(frame[6] | (frame[7] << 8));
+    uint8_t argc = frame[8];
+    uint32_t args[DLOG_MAX_ARGS] = { 0 };
+    for (int a = 0; a < argc; a++) {
+        args[a] = read_u32(&frame[DLOG_FRAME_HEADER_SIZE + a * 4]);
+    }
+
+    const dlog_format_t *format = &dlog_formats[id];
+    char text[256];
+    dlog_format_text(text, sizeof(text), format->format, args);
+    fprintf(out, "%c (%u) %s: %s\n", format->level, (unsigned int)timestamp, format->tag, text);
+
+    return (int)pos;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    if (argc > 1) {
+        in = fopen(argv[1], "rb");
+        if (in == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    uint8_t buf[4096];
+    size_t len = 0;
+    int eof = 0;
+
+    while (!eof || len > 0) {
+        if (!eof && len < sizeof(buf)) {
+            size_t n = fread(buf + len, 1, sizeof(buf) - len, in);
+            if (n == 0) {
+                eof = 1;
+            }
+            len += n;
+        }
+
+        size_t pos = 0;
+        while (pos < len) {
+            if (buf[pos] != DLOG_FRAME_MAGIC0) {
+                fputc(buf[pos++], stdout);
+                continue;
+            }
+            if (len - pos < 2) {
+                if (eof) {
+                    fputc(buf[pos++], stdout);
+                }
+                break;
+            }
+            if (buf[pos + 1] != DLOG_FRAME_MAGIC1) {
+                fputc(buf[pos++], stdout);
+                continue;
+            }
+
+            int ret = decode_frame(&buf[pos], len - pos, stdout);
+            if (ret > 0) {
+                frames_ok++;
+                pos += (size_t)ret;
+            } else if (ret < 0 || eof) {
+                // Corrupt or cut off: resync on the next byte
+                frames_bad++;
+                fputc(buf[pos++], stdout);
+            } else {
+                break;      // Wait for the rest of the frame
+            }
+        }
+
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+        fflush(stdout);
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    fprintf(stderr, "dlog_decode: %lu frames decoded, %lu bad\n", frames_ok, frames_bad);
+    return 0;
+}
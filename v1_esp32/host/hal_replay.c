@@ -0,0 +1,144 @@
+/**
+ * @file hal_replay.c
+ * @brief Feed RCP frames to the host build and print the resulting outputs
+ *
+ * Brings up the actuator modules as app_main() does, then reads one frame
+ * per input line as hex bytes (spaces optional, '#' starts a comment) and
+ * hands it to rcp_process_frame() as if a WebSocket client had sent it.
+ * Frames are REPLAY_FRAME_INTERVAL_MS apart, so the control task applies
+ * each one. Every LEDC duty and GPIO level written on the way is printed
+ * afterwards.
+ *
+ * Build and run from v1_esp32/host:
+ *   cmake -S . -B build && cmake --build build -j
+ *   echo "010001 32" | ./build/hal_replay      (motor speed 50)
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_hal.h"
+#include "project_config.h"
+#include "config.h"
+#include "rcp_protocol.h"
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+#include "battery_monitor.h"
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#define REPLAY_FRAME_INTERVAL_MS    10      // Below CONTROL_FAILSAFE_TIMEOUT_MS
+#define REPLAY_LINE_MAX             1024
+#define REPLAY_CLIENT_ID            1000    // Not a real fd, replies have nowhere to go
+
+static const char *TAG = "hal_replay";
+
+/**
+ * @brief Parse hex bytes, returns the frame length or -1
+ */
+static int parse_hex_line(const char *line, uint8_t *frame, size_t max_len)
+{
+    size_t len = 0;
+    int high = -1;
+
+    for (const char *p = line; *p != '\0' && *p != '#'; p++) {
+        if (isspace((unsigned char)*p)) {
+            continue;
+        }
+        if (!isxdigit((unsigned char)*p)) {
+            return -1;
+        }
+
+        int nibble = isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10;
+        if (high < 0) {
+            high = nibble;
+            continue;
+        }
+        if (len >= max_len) {
+            return -1;
+        }
+        frame[len++] = (uint8_t)((high << 4) | nibble);
+        high = -1;
+    }
+
+    return high < 0 ? (int)len : -1;
+}
+
+int main(void)
+{
+    config_init();
+
+#if ENABLE_LED_CONTROL
+    led_control_init();
+#endif
+
+#if ENABLE_SERVO_CONTROL
+    servo_control_init();
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+    battery_monitor_init();
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+    motor_control_init();
+#endif
+
+#if ENABLE_CONTROL_TASK
+    control_task_start();
+#endif
+
+    // Only what the frames cause is of interest
+    host_hal_reset();
+
+    rcp_session_t session;
+    rcp_session_init(&session, REPLAY_CLIENT_ID);
+
+    char line[REPLAY_LINE_MAX];
+    uint8_t frame[RCP_HEADER_V2_SIZE + RCP_MAX_BODY_SIZE];
+    int line_number = 0;
+    int failed = 0;
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line_number++;
+
+        int len = parse_hex_line(line, frame, sizeof(frame));
+        if (len < 0) {
+            ESP_LOGE(TAG, "line %d: not a hex frame", line_number);
+            failed++;
+            continue;
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        esp_err_t ret = rcp_process_frame(&session, frame, (size_t)len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "line %d: %s", line_number, esp_err_to_name(ret));
+            failed++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(REPLAY_FRAME_INTERVAL_MS));
+    }
+
+    host_hal_dump(stdout);
+    return failed == 0 ? 0 : 1;
+}
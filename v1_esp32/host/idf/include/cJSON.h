@@ -0,0 +1,38 @@
+/**
+ * @file cJSON.h
+ * @brief Host stand-in for the cJSON subset the firmware uses
+ *
+ * Parses one flat object of numbers, booleans, strings and null; nested
+ * values are rejected. Enough for the JSON bodies of the REST handlers.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#define cJSON_Invalid   (0)
+#define cJSON_False     (1 << 0)
+#define cJSON_True      (1 << 1)
+#define cJSON_NULL      (1 << 2)
+#define cJSON_Number    (1 << 3)
+#define cJSON_String    (1 << 4)
+#define cJSON_Object    (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
+bool cJSON_IsNumber(const cJSON *item);
+bool cJSON_IsTrue(const cJSON *item);
+bool cJSON_IsFalse(const cJSON *item);
+bool cJSON_IsBool(const cJSON *item);
+bool cJSON_IsString(const cJSON *item);
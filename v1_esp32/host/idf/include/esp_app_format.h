@@ -0,0 +1,7 @@
+/**
+ * @file esp_app_format.h
+ * @brief Host stand-in, image headers are not checked on the host
+ */
+#pragma once
+
+#include <stdint.h>
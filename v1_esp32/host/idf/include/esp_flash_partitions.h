@@ -0,0 +1,7 @@
+/**
+ * @file esp_flash_partitions.h
+ * @brief Host stand-in, see esp_partition.h
+ */
+#pragma once
+
+#include "esp_partition.h"
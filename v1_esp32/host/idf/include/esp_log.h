@@ -0,0 +1,50 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for esp_log
+ *
+ * Same line format as the firmware ("I (1234) tag: message"), per-tag
+ * levels and the esp_log_set_vprintf() hook. Output goes to stdout.
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+typedef int (*vprintf_like_t)(const char *, va_list);
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL CONFIG_LOG_MAXIMUM_LEVEL
+#endif
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char *tag);
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define LOG_FORMAT(letter, format)  #letter " (%lu) %s: " format "\n"
+
+#define ESP_LOG_LEVEL_LOCAL(level, letter, tag, format, ...) do {                               \
+        if (LOG_LOCAL_LEVEL >= (level) && esp_log_level_get(tag) >= (level)) {                  \
+            esp_log_write((level), (tag), LOG_FORMAT(letter, format),                           \
+                          (unsigned long)esp_log_timestamp(), (tag), ##__VA_ARGS__);            \
+        }                                                                                       \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR,   E, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN,    W, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO,    I, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG,   D, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, V, tag, format, ##__VA_ARGS__)
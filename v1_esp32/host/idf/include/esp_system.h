@@ -0,0 +1,17 @@
+/**
+ * @file esp_system.h
+ * @brief Host stand-in for esp_system
+ *
+ * esp_restart() exits the process with HOST_RESTART_EXIT_CODE so a wrapper
+ * script can start it again. Heap figures come from mallinfo2().
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define HOST_RESTART_EXIT_CODE  75
+
+void esp_restart(void) __attribute__((noreturn));
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
@@ -0,0 +1,58 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS kernel, tasks run as pthreads
+ *
+ * Every task is a real thread, so priorities and core pinning are recorded
+ * but not enforced. Critical sections share one recursive mutex, which is
+ * what a single core port amounts to.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>             // As the IDF portmacro.h
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdFAIL                      pdFALSE
+#define pdPASS                      pdTRUE
+
+#define portMAX_DELAY               ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define configTICK_RATE_HZ          CONFIG_FREERTOS_HZ
+#define configNUMBER_OF_CORES       CONFIG_FREERTOS_NUMBER_OF_CORES
+#define configMAX_PRIORITIES        25
+#define configMAX_TASK_NAME_LEN     16
+#define configUSE_TRACE_FACILITY    CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+
+// =============================================================================
+// CRITICAL SECTIONS
+// =============================================================================
+
+typedef struct {
+    uint32_t owner;                 // Unused, every mux maps to the same lock
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+BaseType_t xPortGetCoreID(void);
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portYIELD_FROM_ISR(woken)       ((void)(woken))
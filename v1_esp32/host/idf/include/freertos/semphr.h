@@ -0,0 +1,18 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS semaphores, queues of empty items as in FreeRTOS
+ */
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+
+#define xSemaphoreCreateBinary()        xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreCreateMutex()         xSemaphoreCreateCounting(1, 1)
+#define vSemaphoreDelete(sem)           vQueueDelete(sem)
+#define xSemaphoreTake(sem, ticks)      xQueueReceive((sem), NULL, (ticks))
+#define xSemaphoreGive(sem)             xQueueSend((sem), NULL, 0)
+#define uxSemaphoreGetCount(sem)        uxQueueMessagesWaiting(sem)
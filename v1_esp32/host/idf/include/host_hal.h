@@ -0,0 +1,98 @@
+/**
+ * @file host_hal.h
+ * @brief Recording of the simulated actuator outputs
+ *
+ * The LEDC and GPIO stand-ins append every duty update and level write to
+ * an event log with its esp_timer timestamp, so the sequence the firmware
+ * drives onto the pins can be checked or replayed after the fact. The log
+ * keeps the last HOST_HAL_LOG_SIZE events.
+ *
+ * Duty becomes visible on ledc_update_duty(), as on the hardware; a
+ * ledc_set_duty() alone is not recorded.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HOST_HAL_LOG_SIZE           65536   // Events kept, power of two
+#define HOST_HAL_LEDC_CHANNELS      8
+#define HOST_HAL_ADC_CHANNELS       10
+
+typedef enum {
+    HOST_HAL_LEDC_DUTY,             // unit = LEDC channel, value = duty
+    HOST_HAL_LEDC_STOP,             // unit = LEDC channel, value = idle level
+    HOST_HAL_GPIO_LEVEL,            // unit = GPIO number, value = level
+} host_hal_kind_t;
+
+/**
+ * @brief One recorded output change
+ */
+typedef struct {
+    int64_t time_us;                // esp_timer_get_time() at the write
+    uint8_t kind;                   // host_hal_kind_t
+    uint8_t unit;
+    int16_t gpio;                   // Pin the channel drives, -1 if never configured
+    uint32_t value;
+} host_hal_event_t;
+
+/**
+ * @brief Forget every recorded event, outputs keep their state
+ */
+void host_hal_reset(void);
+
+/**
+ * @brief Turn recording on or off, on at start
+ *
+ * Outputs still change while recording is off, for benchmarks that only
+ * want the cost of the driver code.
+ */
+void host_hal_set_recording(bool enabled);
+
+/**
+ * @brief Events recorded since the last reset, including overwritten ones
+ */
+uint64_t host_hal_event_count(void);
+
+/**
+ * @brief Copy recorded events
+ *
+ * @param first Event number to start at, counted since the last reset
+ * @param[out] events Destination
+ * @param max_events Size of events
+ * @return Events copied, fewer than asked when @p first was overwritten or
+ *         not recorded yet
+ */
+size_t host_hal_events(uint64_t first, host_hal_event_t *events, size_t max_events);
+
+/**
+ * @brief Print the recorded events, one per line
+ */
+void host_hal_dump(FILE *out);
+
+/**
+ * @brief Last duty applied on a LEDC channel
+ */
+uint32_t host_hal_ledc_duty(int channel);
+
+/**
+ * @brief Timer resolution of a LEDC channel in bits, 0 if never configured
+ */
+int host_hal_ledc_resolution(int channel);
+
+/**
+ * @brief Last level written to a GPIO, -1 if never written
+ */
+int host_hal_gpio_level(int gpio);
+
+/**
+ * @brief Raw value returned by adc_oneshot_read() on a channel
+ */
+void host_hal_set_adc_raw(int channel, int raw);
+
+/**
+ * @brief Raw value that the ADC calibration turns into @p mv at the pin
+ */
+void host_hal_set_adc_mv(int channel, int mv);
@@ -0,0 +1,104 @@
+/**
+ * @file host_httpd.h
+ * @brief Request injection and TCP front end of the esp_http_server stand-in
+ *
+ * Injected requests run on the httpd task like a request arriving on a
+ * socket, and each call returns once the handler is done, async handlers
+ * included. They must not be called from the httpd task itself.
+ *
+ * Injected WebSocket sessions get a socketpair fd, so code that select()s
+ * on the session fd behaves as on the device. Frames the server sends to
+ * them go to the sink set with host_httpd_set_ws_sink().
+ *
+ * With host_httpd_set_listen_port() set before httpd_start(), the server
+ * also accepts HTTP/1.1 and WebSocket clients on a real TCP port.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+/**
+ * @brief Response collected from a handler
+ */
+typedef struct {
+    int status;                     // 200, 404, ...
+    char status_line[48];           // "200 OK"
+    char content_type[64];
+    char *headers;                  // "Field: value\r\n" per header set by the handler
+    char *body;                     // NUL terminated, body_len excludes the NUL
+    size_t body_len;
+    bool chunked;                   // Sent with httpd_resp_send_chunk()
+} host_httpd_response_t;
+
+/**
+ * @brief Receiver of the frames the server sends, called on the sending task
+ */
+typedef void (*host_httpd_ws_sink_t)(void *ctx, int fd, httpd_ws_type_t type, const uint8_t *data, size_t len);
+
+/**
+ * @brief Server started last, for code that keeps its handle private
+ */
+httpd_handle_t host_httpd_instance(void);
+
+/**
+ * @brief Run one HTTP request through the registered handlers
+ *
+ * @param hd Server
+ * @param method HTTP_GET, HTTP_POST, ...
+ * @param uri Path with optional query string
+ * @param body Request body, may be NULL
+ * @param body_len Body length
+ * @param[out] resp Response, release with host_httpd_response_free()
+ * @return ESP_OK when a response was produced, 404 and 405 included
+ */
+esp_err_t host_httpd_request(httpd_handle_t hd, httpd_method_t method, const char *uri,
+                             const void *body, size_t body_len, host_httpd_response_t *resp);
+
+/**
+ * @brief Release a response
+ */
+void host_httpd_response_free(host_httpd_response_t *resp);
+
+/**
+ * @brief Open a WebSocket session and run its handshake
+ *
+ * @param hd Server
+ * @param uri WebSocket URI, e.g. "/ws"
+ * @param[out] out_fd Session fd, as seen by httpd_req_to_sockfd()
+ * @return ESP_OK, or ESP_FAIL when the handler refused the session
+ */
+esp_err_t host_httpd_ws_open(httpd_handle_t hd, const char *uri, int *out_fd);
+
+/**
+ * @brief Deliver one WebSocket frame to the session handler
+ */
+esp_err_t host_httpd_ws_send(httpd_handle_t hd, int fd, httpd_ws_type_t type, const void *data, size_t len);
+
+/**
+ * @brief Close a session as if the peer went away
+ */
+esp_err_t host_httpd_close(httpd_handle_t hd, int fd);
+
+/**
+ * @brief Set the receiver of outgoing WebSocket frames, NULL drops them
+ */
+void host_httpd_set_ws_sink(httpd_handle_t hd, host_httpd_ws_sink_t sink, void *ctx);
+
+/**
+ * @brief Accept TCP clients on @p port in the servers started from now on
+ *
+ * Replaces config->server_port, so the firmware keeps its port 80 config
+ * and no root is needed. 0, the default, starts servers without a socket.
+ */
+void host_httpd_set_listen_port(uint16_t port);
+
+/**
+ * @brief Serve files from @p dir ahead of the URI handlers, NULL to stop
+ *
+ * GET requests naming a file below @p dir get that file, "/" gets
+ * index.html; everything else goes to the handlers as before. Used to run
+ * the unminified dev_html page against the firmware handlers.
+ */
+void host_httpd_set_www_root(const char *dir);
@@ -0,0 +1,10 @@
+/**
+ * @file nvs_flash.h
+ * @brief Host stand-in for NVS init, see nvs.h
+ */
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
@@ -0,0 +1,19 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host stand-in for the generated sdkconfig.h
+ *
+ * Only the options the firmware sources test, with the values of
+ * v1_esp32/sdkconfig.
+ */
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32                     1
+#define CONFIG_FREERTOS_HZ                          100
+#define CONFIG_FREERTOS_NUMBER_OF_CORES             2
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY          1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS     1
+#define CONFIG_LOG_DEFAULT_LEVEL                    3
+#define CONFIG_LOG_MAXIMUM_LEVEL                    3
+#define CONFIG_HTTPD_MAX_REQ_HDR_LEN                1024
+#define CONFIG_HTTPD_MAX_URI_LEN                    512
+#define CONFIG_HTTPD_WS_SUPPORT                     1
@@ -0,0 +1,5 @@
+/**
+ * @file soc.h
+ * @brief Host stand-in, nothing the firmware uses lives here
+ */
+#pragma once
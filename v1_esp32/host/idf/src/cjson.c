@@ -0,0 +1,232 @@
+/**
+ * @file cjson.c
+ * @brief Flat-object subset of cJSON, see cJSON.h
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static const char *skip_space(const char *p)
+{
+    while (*p != '\0' && isspace((unsigned char)*p)) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Parse a string literal, simple escapes only
+ *
+ * @return Heap copy, *end past the closing quote, NULL on error
+ */
+static char *parse_string(const char *p, const char **end)
+{
+    if (*p != '"') {
+        return NULL;
+    }
+    p++;
+
+    char *out = malloc(strlen(p) + 1);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    size_t len = 0;
+    while (*p != '"') {
+        if (*p == '\0') {
+            free(out);
+            return NULL;
+        }
+        if (*p == '\\') {
+            p++;
+            switch (*p) {
+                case '"':  out[len++] = '"';  break;
+                case '\\': out[len++] = '\\'; break;
+                case '/':  out[len++] = '/';  break;
+                case 'n':  out[len++] = '\n'; break;
+                case 't':  out[len++] = '\t'; break;
+                case 'r':  out[len++] = '\r'; break;
+                default:
+                    free(out);
+                    return NULL;
+            }
+            p++;
+            continue;
+        }
+        out[len++] = *p++;
+    }
+    out[len] = '\0';
+
+    *end = p + 1;
+    return out;
+}
+
+static bool parse_value(cJSON *item, const char *p, const char **end)
+{
+    if (*p == '"') {
+        item->valuestring = parse_string(p, end);
+        item->type = cJSON_String;
+        return item->valuestring != NULL;
+    }
+    if (strncmp(p, "true", 4) == 0) {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        *end = p + 4;
+        return true;
+    }
+    if (strncmp(p, "false", 5) == 0) {
+        item->type = cJSON_False;
+        *end = p + 5;
+        return true;
+    }
+    if (strncmp(p, "null", 4) == 0) {
+        item->type = cJSON_NULL;
+        *end = p + 4;
+        return true;
+    }
+
+    char *number_end = NULL;
+    double number = strtod(p, &number_end);
+    if (number_end == p) {
+        return false;   // Objects and arrays land here too
+    }
+    item->type = cJSON_Number;
+    item->valuedouble = number;
+    // Saturated like cJSON
+    item->valueint = number >= 2147483647.0 ? 2147483647 : number <= -2147483648.0 ? -2147483647 - 1 : (int)number;
+    *end = number_end;
+    return true;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+cJSON *cJSON_Parse(const char *value)
+{
+    if (value == NULL) {
+        return NULL;
+    }
+
+    cJSON *object = calloc(1, sizeof(cJSON));
+    if (object == NULL) {
+        return NULL;
+    }
+    object->type = cJSON_Object;
+
+    const char *p = skip_space(value);
+    if (*p++ != '{') {
+        cJSON_Delete(object);
+        return NULL;
+    }
+
+    cJSON *last = NULL;
+    p = skip_space(p);
+    if (*p == '}') {
+        p++;
+    } else {
+        while (1) {
+            cJSON *item = calloc(1, sizeof(cJSON));
+            if (item == NULL) {
+                cJSON_Delete(object);
+                return NULL;
+            }
+            if (last == NULL) {
+                object->child = item;
+            } else {
+                last->next = item;
+                item->prev = last;
+            }
+            last = item;
+
+            item->string = parse_string(p, &p);
+            if (item->string == NULL) {
+                cJSON_Delete(object);
+                return NULL;
+            }
+            p = skip_space(p);
+            if (*p++ != ':') {
+                cJSON_Delete(object);
+                return NULL;
+            }
+            if (!parse_value(item, skip_space(p), &p)) {
+                cJSON_Delete(object);
+                return NULL;
+            }
+
+            p = skip_space(p);
+            if (*p == ',') {
+                p = skip_space(p + 1);
+                continue;
+            }
+            if (*p++ != '}') {
+                cJSON_Delete(object);
+                return NULL;
+            }
+            break;
+        }
+    }
+
+    if (*skip_space(p) != '\0') {
+        cJSON_Delete(object);
+        return NULL;
+    }
+    return object;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    while (item != NULL) {
+        cJSON *next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    if (object == NULL || string == NULL) {
+        return NULL;
+    }
+    for (cJSON *item = object->child; item != NULL; item = item->next) {
+        if (item->string != NULL && strcmp(item->string, string) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+bool cJSON_IsNumber(const cJSON *item)
+{
+    return item != NULL && item->type == cJSON_Number;
+}
+
+bool cJSON_IsTrue(const cJSON *item)
+{
+    return item != NULL && item->type == cJSON_True;
+}
+
+bool cJSON_IsFalse(const cJSON *item)
+{
+    return item != NULL && item->type == cJSON_False;
+}
+
+bool cJSON_IsBool(const cJSON *item)
+{
+    return cJSON_IsTrue(item) || cJSON_IsFalse(item);
+}
+
+bool cJSON_IsString(const cJSON *item)
+{
+    return item != NULL && item->type == cJSON_String;
+}
@@ -0,0 +1,1281 @@
+/**
+ * @file esp_http_server.c
+ * @brief esp_http_server stand-in: handlers, sessions and the httpd task
+ *
+ * Everything the IDF server runs on its task runs here on the "httpd" task
+ * too: URI handlers, session open/close callbacks and httpd_queue_work()
+ * items. The task sleeps in httpd_sock_poll() until a socket or the work
+ * queue needs it. Requests come from host_httpd.h calls, which post to the
+ * work queue and wait, or from TCP clients through httpd_sock.c.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "httpd_internal.h"
+
+#define HTTPD_WORK_QUEUE_LEN        64
+#define HTTPD_FILE_CHUNK_SIZE       4096
+#define HTTPD_WWW_PATH_MAX          512
+
+static const char *TAG = "httpd";
+
+typedef struct {
+    httpd_work_fn_t fn;             // NULL stops the server task
+    void *arg;
+} httpd_work_t;
+
+/**
+ * @brief One host_httpd_*() call waiting for the httpd task
+ */
+typedef struct {
+    httpd_server_t *server;
+    SemaphoreHandle_t done;
+    esp_err_t result;
+    // Inputs and outputs, depending on the call
+    httpd_method_t method;
+    const char *uri;
+    const void *data;
+    size_t len;
+    httpd_ws_type_t ws_type;
+    int fd;
+    host_httpd_response_t *resp;
+} host_call_t;
+
+static httpd_server_t *last_server = NULL;
+static uint16_t listen_port = 0;
+static char www_root[HTTPD_WWW_PATH_MAX] = "";
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static bool on_httpd_task(httpd_server_t *server)
+{
+    return xTaskGetCurrentTaskHandle() == server->task;
+}
+
+static size_t uri_path_len(const char *uri)
+{
+    const char *query = strchr(uri, '?');
+    return query != NULL ? (size_t)(query - uri) : strlen(uri);
+}
+
+static bool uri_matches(httpd_server_t *server, const httpd_uri_t *handler, const char *uri)
+{
+    size_t len = uri_path_len(uri);
+    if (server->config.uri_match_fn != NULL) {
+        return server->config.uri_match_fn(handler->uri, uri, len);
+    }
+    return strlen(handler->uri) == len && strncmp(handler->uri, uri, len) == 0;
+}
+
+/**
+ * @brief Handler for a request, *uri_found tells 404 from 405 when NULL
+ */
+static const httpd_uri_t *find_handler(httpd_server_t *server, httpd_method_t method, const char *uri,
+                                       bool *uri_found)
+{
+    *uri_found = false;
+    for (int i = 0; i < server->handler_count; i++) {
+        if (!uri_matches(server, &server->handlers[i], uri)) {
+            continue;
+        }
+        *uri_found = true;
+        if (server->handlers[i].method == method) {
+            return &server->handlers[i];
+        }
+    }
+    return NULL;
+}
+
+static httpd_session_t *session_find(httpd_server_t *server, int fd)
+{
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->sessions[i].used && server->sessions[i].fd == fd) {
+            return &server->sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void response_init(host_httpd_response_t *resp)
+{
+    memset(resp, 0, sizeof(*resp));
+    snprintf(resp->status_line, sizeof(resp->status_line), "200 OK");
+    snprintf(resp->content_type, sizeof(resp->content_type), "text/html");
+}
+
+static esp_err_t response_append(httpd_conn_t *conn, const char *data, size_t len)
+{
+    host_httpd_response_t *resp = conn->resp;
+
+    if (resp->body_len + len + 1 > conn->resp_cap) {
+        size_t cap = conn->resp_cap == 0 ? 1024 : conn->resp_cap;
+        while (cap < resp->body_len + len + 1) {
+            cap *= 2;
+        }
+        char *body = realloc(resp->body, cap);
+        if (body == NULL) {
+            return ESP_ERR_HTTPD_ALLOC_MEM;
+        }
+        resp->body = body;
+        conn->resp_cap = cap;
+    }
+
+    memcpy(resp->body + resp->body_len, data, len);
+    resp->body_len += len;
+    resp->body[resp->body_len] = '\0';
+    return ESP_OK;
+}
+
+static bool conn_is_socket(const httpd_conn_t *conn)
+{
+    return conn->session != NULL && conn->session->socket;
+}
+
+static void request_init(httpd_req_t *req, httpd_conn_t *conn, const httpd_uri_t *handler, const char *uri)
+{
+    memset(req, 0, sizeof(*req));
+    req->handle = conn->server;
+    req->method = conn->method;
+    snprintf((char *)req->uri, sizeof(req->uri), "%s", uri);
+    req->content_len = conn->content_len;
+    req->aux = conn;
+    req->user_ctx = handler != NULL ? handler->user_ctx : NULL;
+    req->sess_ctx = conn->session->ctx;
+    req->free_ctx = conn->session->free_ctx;
+}
+
+/**
+ * @brief Run a handler, keeping what it stored on the session
+ *
+ * The request lives on the stack, as IDF reuses one per server: handling a
+ * request or frame does not allocate.
+ */
+static esp_err_t request_run(httpd_conn_t *conn, const httpd_uri_t *handler, const char *uri)
+{
+    httpd_req_t req;
+    request_init(&req, conn, handler, uri);
+
+    esp_err_t ret = handler->handler(&req);
+
+    if (!req.ignore_sess_ctx_changes) {
+        conn->session->ctx = req.sess_ctx;
+        conn->session->free_ctx = req.free_ctx;
+    }
+    return ret;
+}
+
+static const char *file_content_type(const char *path)
+{
+    static const struct {
+        const char *extension;
+        const char *type;
+    } types[] = {
+        { ".html", "text/html" },
+        { ".js", "application/javascript" },
+        { ".css", "text/css" },
+        { ".json", "application/json" },
+        { ".png", "image/png" },
+        { ".svg", "image/svg+xml" },
+        { ".ico", "image/x-icon" },
+    };
+
+    const char *dot = strrchr(path, '.');
+    for (size_t i = 0; dot != NULL && i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcmp(dot, types[i].extension) == 0) {
+            return types[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+/**
+ * @brief Answer a GET from the www root, false when no such file
+ */
+static bool serve_www_file(httpd_conn_t *conn, const char *uri)
+{
+    size_t len = uri_path_len(uri);
+    if (www_root[0] == '\0' || conn->method != HTTP_GET || uri[0] != '/' ||
+        memmem(uri, len, "..", 2) != NULL) {
+        return false;
+    }
+
+    char path[HTTPD_WWW_PATH_MAX + HTTPD_MAX_URI_LEN + 16];
+    snprintf(path, sizeof(path), "%s%.*s%s", www_root, (int)len, uri, len == 1 ? "index.html" : "");
+
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    httpd_req_t req = { .handle = conn->server, .method = conn->method, .aux = conn };
+    char chunk[HTTPD_FILE_CHUNK_SIZE];
+    size_t read_len;
+
+    httpd_resp_set_type(&req, file_content_type(path));
+    httpd_resp_set_hdr(&req, "Cache-Control", "no-cache");
+    while ((read_len = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        if (httpd_resp_send_chunk(&req, chunk, (ssize_t)read_len) != ESP_OK) {
+            break;
+        }
+    }
+    httpd_resp_send_chunk(&req, NULL, 0);
+    fclose(file);
+    return true;
+}
+
+static void call_finish(host_call_t *call, esp_err_t result)
+{
+    call->result = result;
+    xSemaphoreGive(call->done);
+}
+
+/**
+ * @brief Done with an injected HTTP request: answer the caller, drop the session
+ */
+static void injected_request_finish(httpd_conn_t *conn)
+{
+    host_call_t *call = conn->finish_ctx;
+
+    httpd_session_close(conn->server, conn->session);
+    esp_err_t result = conn->sent ? ESP_OK : ESP_FAIL;
+    free(conn);
+    call_finish(call, result);
+}
+
+static void request_work(void *arg)
+{
+    host_call_t *call = arg;
+
+    httpd_conn_t *conn = calloc(1, sizeof(httpd_conn_t));
+    if (conn == NULL) {
+        call_finish(call, ESP_ERR_NO_MEM);
+        return;
+    }
+    conn->server = call->server;
+    conn->method = call->method;
+    conn->body = call->data;
+    conn->body_len = call->len;
+    conn->content_len = call->len;
+    conn->resp = call->resp;
+    conn->finish = injected_request_finish;
+    conn->finish_ctx = call;
+
+    conn->session = httpd_session_open(call->server, -1);
+    if (conn->session == NULL) {
+        free(conn);
+        call_finish(call, ESP_ERR_NO_MEM);
+        return;
+    }
+
+    httpd_dispatch_request(conn, call->uri);
+}
+
+static void async_finish_work(void *arg)
+{
+    httpd_conn_t *conn = arg;
+
+    conn->session->busy = false;
+    conn->finish(conn);
+}
+
+static void ws_open_work(void *arg)
+{
+    host_call_t *call = arg;
+    httpd_server_t *server = call->server;
+
+    const httpd_uri_t *handler = httpd_find_ws_handler(server, call->uri);
+    if (handler == NULL) {
+        call_finish(call, ESP_ERR_NOT_FOUND);
+        return;
+    }
+
+    httpd_session_t *session = httpd_session_open(server, -1);
+    if (session == NULL) {
+        call_finish(call, ESP_ERR_NO_MEM);
+        return;
+    }
+
+    int fd = session->fd;
+    if (httpd_ws_accept(server, session, handler, call->uri) != ESP_OK) {
+        call_finish(call, ESP_FAIL);
+        return;
+    }
+
+    call->fd = fd;
+    call_finish(call, ESP_OK);
+}
+
+static esp_err_t ws_send_to_session(httpd_server_t *server, int fd, httpd_ws_type_t type,
+                                    const uint8_t *data, size_t len)
+{
+    pthread_mutex_lock(&server->lock);
+    httpd_session_t *session = session_find(server, fd);
+    if (session == NULL || !session->websocket) {
+        pthread_mutex_unlock(&server->lock);
+        return ESP_FAIL;
+    }
+
+    if (session->socket) {
+        // Taken before the table lock is released, so the close waits for the frame
+        pthread_mutex_t *send_lock = &server->send_locks[session - server->sessions];
+        pthread_mutex_lock(send_lock);
+        pthread_mutex_unlock(&server->lock);
+
+        esp_err_t ret = httpd_sock_ws_send(server, fd, type, data, len);
+        pthread_mutex_unlock(send_lock);
+        return ret;
+    }
+
+    host_httpd_ws_sink_t sink = server->ws_sink;
+    void *sink_ctx = server->ws_sink_ctx;
+    pthread_mutex_unlock(&server->lock);
+
+    if (sink != NULL) {
+        sink(sink_ctx, fd, type, data, len);
+    }
+    return ESP_OK;
+}
+
+static void ws_frame_work(void *arg)
+{
+    host_call_t *call = arg;
+
+    httpd_session_t *session = session_find(call->server, call->fd);
+    if (session == NULL || !session->websocket || session->socket) {
+        call_finish(call, ESP_ERR_NOT_FOUND);
+        return;
+    }
+    call_finish(call, httpd_ws_deliver(call->server, session, call->ws_type, call->data, call->len));
+}
+
+static void close_work(void *arg)
+{
+    host_call_t *call = arg;
+
+    httpd_session_t *session = session_find(call->server, call->fd);
+    if (session != NULL && !session->busy) {
+        httpd_session_close(call->server, session);
+    } else {
+        session = NULL;     // Closed when its async request completes
+    }
+    if (call->done != NULL) {
+        call_finish(call, session != NULL ? ESP_OK : ESP_ERR_NOT_FOUND);
+    } else {
+        free(call);     // From httpd_sess_trigger_close(), nobody waits
+    }
+}
+
+/**
+ * @brief Post a call to the httpd task and wait for it
+ */
+static esp_err_t host_call_run(host_call_t *call, httpd_work_fn_t fn)
+{
+    if (call->server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (on_httpd_task(call->server)) {
+        ESP_LOGE(TAG, "host_httpd calls would deadlock on the httpd task");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    call->done = xSemaphoreCreateBinary();
+    if (call->done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = httpd_queue_work(call->server, fn, call);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(call->done, portMAX_DELAY);
+        ret = call->result;
+    }
+    vSemaphoreDelete(call->done);
+    return ret;
+}
+
+static void httpd_server_task(void *pvParameters)
+{
+    httpd_server_t *server = pvParameters;
+    httpd_work_t work;
+
+    for (;;) {
+        httpd_sock_poll(server);
+
+        while (xQueueReceive(server->work_queue, &work, 0) == pdTRUE) {
+            if (work.fn == NULL) {
+                xSemaphoreGive(server->stopped);
+                vTaskDelete(NULL);
+                return;
+            }
+            work.fn(work.arg);
+        }
+    }
+}
+
+static void server_free(httpd_server_t *server)
+{
+    if (server->send_locks != NULL) {
+        for (int i = 0; i < server->config.max_open_sockets; i++) {
+            pthread_mutex_destroy(&server->send_locks[i]);
+        }
+    }
+    if (server->work_queue != NULL) {
+        vQueueDelete(server->work_queue);
+    }
+    if (server->stopped != NULL) {
+        vSemaphoreDelete(server->stopped);
+    }
+    if (server->wake_fd >= 0) {
+        close(server->wake_fd);
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+    }
+    pthread_mutex_destroy(&server->lock);
+    free(server->send_locks);
+    free(server->handlers);
+    free(server->sessions);
+    free(server);
+}
+
+// =============================================================================
+// SESSIONS AND DISPATCH, SHARED WITH httpd_sock.c
+// =============================================================================
+
+httpd_session_t *httpd_session_open(httpd_server_t *server, int fd)
+{
+    int peer_fd = -1;
+    if (fd < 0) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            return NULL;
+        }
+        fd = fds[0];
+        peer_fd = fds[1];
+    }
+
+    httpd_session_t *session = NULL;
+    pthread_mutex_lock(&server->lock);
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        if (!server->sessions[i].used) {
+            session = &server->sessions[i];
+            memset(session, 0, sizeof(*session));
+            session->used = true;
+            session->socket = peer_fd < 0;
+            session->fd = fd;
+            session->peer_fd = peer_fd;
+            session->lru = ++server->lru_counter;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    if (session == NULL) {
+        ESP_LOGW(TAG, "No free session, max_open_sockets is %u", server->config.max_open_sockets);
+    } else if (server->config.open_fn != NULL && server->config.open_fn(server, fd) != ESP_OK) {
+        pthread_mutex_lock(&server->lock);
+        session->used = false;
+        pthread_mutex_unlock(&server->lock);
+        session = NULL;
+    }
+
+    if (session == NULL) {
+        close(fd);
+        if (peer_fd >= 0) {
+            close(peer_fd);
+        }
+    }
+    return session;
+}
+
+void httpd_session_close(httpd_server_t *server, httpd_session_t *session)
+{
+    if (server->config.close_fn != NULL) {
+        server->config.close_fn(server, session->fd);
+    }
+    if (session->free_ctx != NULL) {
+        session->free_ctx(session->ctx);
+    } else {
+        free(session->ctx);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    session->used = false;
+    session->websocket = false;
+    pthread_mutex_unlock(&server->lock);
+
+    // A frame still going out holds the send lock, wait for it
+    pthread_mutex_t *send_lock = &server->send_locks[session - server->sessions];
+    pthread_mutex_lock(send_lock);
+    pthread_mutex_unlock(send_lock);
+
+    close(session->fd);
+    if (session->peer_fd >= 0) {
+        close(session->peer_fd);
+    }
+    free(session->rx);
+    memset(session, 0, sizeof(*session));
+}
+
+httpd_session_t *httpd_session_lru(httpd_server_t *server)
+{
+    httpd_session_t *oldest = NULL;
+
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        httpd_session_t *session = &server->sessions[i];
+        if (session->used && !session->busy && (oldest == NULL || session->lru < oldest->lru)) {
+            oldest = session;
+        }
+    }
+    return oldest;
+}
+
+void httpd_dispatch_request(httpd_conn_t *conn, const char *uri)
+{
+    httpd_server_t *server = conn->server;
+    conn->session->lru = ++server->lru_counter;
+
+    if (serve_www_file(conn, uri)) {
+        conn->finish(conn);
+        return;
+    }
+
+    bool uri_found;
+    const httpd_uri_t *handler = find_handler(server, conn->method, uri, &uri_found);
+    if (handler == NULL || handler->is_websocket) {
+        httpd_req_t req = { .handle = server, .method = conn->method, .aux = conn };
+        if (uri_found) {
+            httpd_resp_send_err(&req, HTTPD_405_METHOD_NOT_ALLOWED, "Request method for this URI is not handled by server");
+        } else {
+            httpd_resp_send_err(&req, HTTPD_404_NOT_FOUND, "Nothing matches the given URI");
+        }
+        conn->finish(conn);
+        return;
+    }
+
+    esp_err_t ret = request_run(conn, handler, uri);
+
+    // A detached request finishes in httpd_req_async_handler_complete()
+    if (ret == ESP_OK && conn->detached) {
+        conn->session->busy = true;
+        return;
+    }
+    conn->failed = ret != ESP_OK;
+    conn->finish(conn);
+}
+
+const httpd_uri_t *httpd_find_ws_handler(httpd_server_t *server, const char *uri)
+{
+    bool uri_found;
+    const httpd_uri_t *handler = find_handler(server, HTTP_GET, uri, &uri_found);
+    return (handler != NULL && handler->is_websocket) ? handler : NULL;
+}
+
+esp_err_t httpd_ws_accept(httpd_server_t *server, httpd_session_t *session, const httpd_uri_t *handler,
+                          const char *uri)
+{
+    // The 101 is out before the handler runs, it may already send frames
+    pthread_mutex_lock(&server->lock);
+    session->websocket = true;
+    session->ws_handler = handler;
+    pthread_mutex_unlock(&server->lock);
+
+    httpd_conn_t conn = {
+        .server = server,
+        .session = session,
+        .method = HTTP_GET,
+    };
+    response_init(&conn.own_resp);
+    conn.resp = &conn.own_resp;
+
+    esp_err_t ret = request_run(&conn, handler, uri);
+    host_httpd_response_free(&conn.own_resp);
+
+    if (ret != ESP_OK) {
+        httpd_session_close(server, session);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_deliver(httpd_server_t *server, httpd_session_t *session, httpd_ws_type_t type,
+                           const uint8_t *data, size_t len)
+{
+    const httpd_uri_t *handler = session->ws_handler;
+    bool control = type == HTTPD_WS_TYPE_PING || type == HTTPD_WS_TYPE_PONG || type == HTTPD_WS_TYPE_CLOSE;
+
+    session->lru = ++server->lru_counter;
+
+    // What httpd does with control frames the handler did not ask for
+    if (control && !handler->handle_ws_control_frames) {
+        if (type == HTTPD_WS_TYPE_PING) {
+            ws_send_to_session(server, session->fd, HTTPD_WS_TYPE_PONG, data, len);
+        } else if (type == HTTPD_WS_TYPE_CLOSE) {
+            ws_send_to_session(server, session->fd, HTTPD_WS_TYPE_CLOSE, NULL, 0);
+            httpd_session_close(server, session);
+        }
+        return ESP_OK;
+    }
+
+    httpd_conn_t conn = {
+        .server = server,
+        .session = session,
+        .method = HTTPD_WS_METHOD,
+        .ws_type = type,
+        .ws_data = data,
+        .ws_len = len,
+    };
+    response_init(&conn.own_resp);
+    conn.resp = &conn.own_resp;
+
+    esp_err_t ret = request_run(&conn, handler, handler->uri);
+    host_httpd_response_free(&conn.own_resp);
+
+    // A failing handler closes the socket
+    if (ret != ESP_OK) {
+        httpd_session_close(server, session);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// =============================================================================
+// SERVER
+// =============================================================================
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    if (handle == NULL || config == NULL || config->max_open_sockets == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_server_t *server = calloc(1, sizeof(httpd_server_t));
+    if (server == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    server->config = *config;
+    server->wake_fd = -1;
+    server->listen_fd = -1;
+    pthread_mutex_init(&server->lock, NULL);
+
+    server->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    server->sessions = calloc(config->max_open_sockets, sizeof(httpd_session_t));
+    server->send_locks = calloc(config->max_open_sockets, sizeof(pthread_mutex_t));
+    server->work_queue = xQueueCreate(HTTPD_WORK_QUEUE_LEN, sizeof(httpd_work_t));
+    server->stopped = xSemaphoreCreateBinary();
+    server->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (server->handlers == NULL || server->sessions == NULL || server->send_locks == NULL ||
+        server->work_queue == NULL || server->stopped == NULL || server->wake_fd < 0) {
+        server_free(server);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    for (int i = 0; i < config->max_open_sockets; i++) {
+        pthread_mutex_init(&server->send_locks[i], NULL);
+    }
+
+    if (listen_port != 0) {
+        esp_err_t ret = httpd_sock_listen(server, listen_port);
+        if (ret != ESP_OK) {
+            server_free(server);
+            return ret;
+        }
+    }
+
+    if (xTaskCreate(httpd_server_task,          // Task function
+                    "httpd",                    // Task name
+                    config->stack_size,         // Stack size
+                    server,                     // Parameters
+                    config->task_priority,      // Priority
+                    &server->task) != pdPASS) { // Task handle
+        server_free(server);
+        return ESP_ERR_HTTPD_TASK;
+    }
+
+    last_server = server;
+    *handle = server;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    httpd_server_t *server = handle;
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_work_t stop = { NULL, NULL };
+    xQueueSend(server->work_queue, &stop, portMAX_DELAY);
+    eventfd_write(server->wake_fd, 1);
+    xSemaphoreTake(server->stopped, portMAX_DELAY);
+
+    // The task is gone, the callbacks run here instead
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        if (server->sessions[i].used) {
+            httpd_session_close(server, &server->sessions[i]);
+        }
+    }
+    if (server->config.global_user_ctx_free_fn != NULL) {
+        server->config.global_user_ctx_free_fn(server->config.global_user_ctx);
+    }
+
+    if (last_server == server) {
+        last_server = NULL;
+    }
+    server_free(server);
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    httpd_server_t *server = handle;
+    if (server == NULL || uri_handler == NULL || uri_handler->uri == NULL || uri_handler->handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < server->handler_count; i++) {
+        if (server->handlers[i].method == uri_handler->method &&
+            strcmp(server->handlers[i].uri, uri_handler->uri) == 0) {
+            ESP_LOGW(TAG, "handler %s already registered", uri_handler->uri);
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (server->handler_count >= server->config.max_uri_handlers) {
+        ESP_LOGW(TAG, "no slots left for registering handler");
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+
+    // The URI string is referenced, not copied, as in IDF
+    server->handlers[server->handler_count++] = *uri_handler;
+    return ESP_OK;
+}
+
+bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match, size_t match_upto)
+{
+    size_t tpl_len = strlen(uri_template);
+    char last = tpl_len > 0 ? uri_template[tpl_len - 1] : '\0';
+    char prev = tpl_len > 1 ? uri_template[tpl_len - 2] : '\0';
+    bool asterisk = last == '*' || (prev == '*' && last == '?');
+    bool quest = last == '?' || (prev == '?' && last == '*');
+
+    // Characters before the wildcards, the last of them optional with '?'
+    size_t exact = tpl_len - asterisk - quest;
+
+    if (!asterisk && !quest) {
+        return match_upto == exact && strncmp(uri_template, uri_to_match, match_upto) == 0;
+    }
+    if (quest && exact == 0) {
+        return false;
+    }
+
+    size_t required = quest ? exact - 1 : exact;
+    if (match_upto < required || strncmp(uri_template, uri_to_match, required) != 0) {
+        return false;
+    }
+    if (asterisk) {
+        // Anything after, the optional character included when present
+        return !quest || match_upto == required || uri_to_match[required] == uri_template[required];
+    }
+    return match_upto == required ||
+           (match_upto == exact && uri_to_match[required] == uri_template[required]);
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg)
+{
+    httpd_server_t *server = handle;
+    if (server == NULL || work == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_work_t item = { work, arg };
+    // The httpd task cannot wait on its own queue
+    TickType_t wait = on_httpd_task(server) ? 0 : portMAX_DELAY;
+    if (xQueueSend(server->work_queue, &item, wait) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    eventfd_write(server->wake_fd, 1);
+    return ESP_OK;
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    httpd_server_t *server = handle;
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    bool found = session_find(server, sockfd) != NULL;
+    pthread_mutex_unlock(&server->lock);
+    if (!found) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    host_call_t *call = calloc(1, sizeof(host_call_t));
+    if (call == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    call->server = server;
+    call->fd = sockfd;
+    if (httpd_queue_work(server, close_work, call) != ESP_OK) {
+        free(call);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void *httpd_get_global_user_ctx(httpd_handle_t handle)
+{
+    httpd_server_t *server = handle;
+    return server != NULL ? server->config.global_user_ctx : NULL;
+}
+
+// =============================================================================
+// REQUESTS
+// =============================================================================
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    if (r == NULL || r->aux == NULL || buf == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    size_t remaining = conn->content_len - conn->body_read;
+    size_t len = buf_len < remaining ? buf_len : remaining;
+    if (len == 0) {
+        return 0;
+    }
+
+    // Buffered bytes first, then the socket
+    if (conn->body_read < conn->body_len) {
+        size_t buffered = conn->body_len - conn->body_read;
+        len = len < buffered ? len : buffered;
+        memcpy(buf, conn->body + conn->body_read, len);
+        conn->body_read += len;
+        return (int)len;
+    }
+
+    int received = httpd_sock_recv_body(conn, buf, len);
+    if (received > 0) {
+        conn->body_read += (size_t)received;
+    }
+    return received;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r)
+{
+    if (r == NULL || r->aux == NULL) {
+        return -1;
+    }
+    httpd_conn_t *conn = r->aux;
+    return conn->session != NULL ? conn->session->fd : -1;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r)
+{
+    const char *query = (r != NULL) ? strchr(r->uri, '?') : NULL;
+    return query != NULL ? strlen(query + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    if (r == NULL || buf == NULL || buf_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *query = strchr(r->uri, '?');
+    if (query == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t len = strlen(query + 1);
+    snprintf(buf, buf_len, "%s", query + 1);
+    return len < buf_len ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+    if (qry == NULL || key == NULL || val == NULL || val_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t key_len = strlen(key);
+    const char *p = qry;
+
+    while (*p != '\0') {
+        const char *end = strchr(p, '&');
+        size_t pair_len = end != NULL ? (size_t)(end - p) : strlen(p);
+
+        if (pair_len > key_len && strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            size_t value_len = pair_len - key_len - 1;
+            size_t copy_len = value_len < val_size - 1 ? value_len : val_size - 1;
+            memcpy(val, p + key_len + 1, copy_len);
+            val[copy_len] = '\0';
+            return copy_len == value_len ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+        }
+
+        p += pair_len;
+        if (*p == '&') {
+            p++;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
+{
+    if (r == NULL || r->aux == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    if (conn->method == HTTPD_WS_METHOD || conn->finish == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;  // Frames and handshakes are gone once the handler returns
+    }
+
+    httpd_req_t *copy = malloc(sizeof(httpd_req_t));
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, r, sizeof(httpd_req_t));
+    conn->detached = true;
+
+    *out = copy;
+    return ESP_OK;
+}
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r)
+{
+    if (r == NULL || r->aux == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    free(r);
+
+    // The session is released on the httpd task, as for synchronous handlers
+    return httpd_queue_work(conn->server, async_finish_work, conn);
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    if (r == NULL || r->aux == NULL || status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_conn_t *conn = r->aux;
+    snprintf(conn->resp->status_line, sizeof(conn->resp->status_line), "%s", status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    if (r == NULL || r->aux == NULL || type == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_conn_t *conn = r->aux;
+    snprintf(conn->resp->content_type, sizeof(conn->resp->content_type), "%s", type);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    if (r == NULL || r->aux == NULL || field == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    host_httpd_response_t *resp = conn->resp;
+    size_t old_len = resp->headers != NULL ? strlen(resp->headers) : 0;
+    size_t add_len = strlen(field) + strlen(value) + 4;
+
+    char *headers = realloc(resp->headers, old_len + add_len + 1);
+    if (headers == NULL) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    snprintf(headers + old_len, add_len + 1, "%s: %s\r\n", field, value);
+    resp->headers = headers;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (r == NULL || r->aux == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    if (conn->sent || conn->head_sent) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = (buf != NULL) ? (ssize_t)strlen(buf) : 0;
+    }
+    if (buf == NULL) {
+        buf_len = 0;
+    }
+
+    conn->resp->status = atoi(conn->resp->status_line);
+    conn->sent = true;
+
+    if (conn_is_socket(conn)) {
+        esp_err_t ret = httpd_sock_send_head(conn, false, (size_t)buf_len);
+        if (ret == ESP_OK && buf_len > 0) {
+            ret = httpd_sock_write(conn->server, conn->session->fd, buf, (size_t)buf_len);
+        }
+        return ret;
+    }
+    return buf_len > 0 ? response_append(conn, buf, (size_t)buf_len) : ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (r == NULL || r->aux == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = r->aux;
+    if (conn->sent) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = (buf != NULL) ? (ssize_t)strlen(buf) : 0;
+    }
+    if (buf == NULL) {
+        buf_len = 0;
+    }
+
+    conn->resp->chunked = true;
+    conn->resp->status = atoi(conn->resp->status_line);
+    conn->sent = buf_len == 0;     // Terminating chunk
+
+    if (!conn_is_socket(conn)) {
+        return buf_len > 0 ? response_append(conn, buf, (size_t)buf_len) : ESP_OK;
+    }
+
+    if (!conn->head_sent) {
+        esp_err_t ret = httpd_sock_send_head(conn, true, 0);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    char size_line[24];
+    int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", (size_t)buf_len);
+    int fd = conn->session->fd;
+    if (httpd_sock_write(conn->server, fd, size_line, (size_t)size_len) != ESP_OK ||
+        (buf_len > 0 && httpd_sock_write(conn->server, fd, buf, (size_t)buf_len) != ESP_OK) ||
+        httpd_sock_write(conn->server, fd, "\r\n", 2) != ESP_OK) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    static const struct {
+        const char *status;
+        const char *message;
+    } errors[HTTPD_ERR_CODE_MAX] = {
+        [HTTPD_500_INTERNAL_SERVER_ERROR]    = { "500 Internal Server Error", "Server has encountered an unexpected error" },
+        [HTTPD_501_METHOD_NOT_IMPLEMENTED]   = { "501 Method Not Implemented", "Server does not support this method" },
+        [HTTPD_505_VERSION_NOT_SUPPORTED]    = { "505 Version Not Supported", "HTTP version not supported by server" },
+        [HTTPD_400_BAD_REQUEST]              = { "400 Bad Request", "Bad request syntax" },
+        [HTTPD_401_UNAUTHORIZED]             = { "401 Unauthorized", "No permission -- see authorization schemes" },
+        [HTTPD_403_FORBIDDEN]                = { "403 Forbidden", "Request forbidden -- authorization will not help" },
+        [HTTPD_404_NOT_FOUND]                = { "404 Not Found", "This URI does not exist" },
+        [HTTPD_405_METHOD_NOT_ALLOWED]       = { "405 Method Not Allowed", "Request method for this URI is not handled by server" },
+        [HTTPD_408_REQ_TIMEOUT]              = { "408 Request Timeout", "Server closed this connection" },
+        [HTTPD_411_LENGTH_REQUIRED]          = { "411 Length Required", "Client must specify Content-Length" },
+        [HTTPD_414_URI_TOO_LONG]             = { "414 URI Too Long", "URI is too long" },
+        [HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE] = { "431 Request Header Fields Too Large", "Header fields are too long" },
+        [HTTPD_503_SERVICE_UNAVAILABLE]      = { "503 Service Unavailable", "Server is busy" },
+    };
+
+    if (req == NULL || req->aux == NULL || error < 0 || error >= HTTPD_ERR_CODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_resp_set_status(req, errors[error].status);
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_send(req, msg != NULL ? msg : errors[error].message, HTTPD_RESP_USE_STRLEN);
+}
+
+// =============================================================================
+// WEBSOCKET
+// =============================================================================
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len)
+{
+    if (req == NULL || req->aux == NULL || pkt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    httpd_conn_t *conn = req->aux;
+    if (conn->session == NULL || !conn->session->websocket || conn->method != HTTPD_WS_METHOD) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pkt->type = conn->ws_type;
+    pkt->final = true;
+    pkt->fragmented = false;
+    pkt->len = conn->ws_len;
+
+    // max_len 0 only asks for the length, the payload stays for the next call
+    if (max_len == 0 || conn->ws_len == 0) {
+        return ESP_OK;
+    }
+    if (pkt->payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (conn->ws_len > max_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(pkt->payload, conn->ws_data, conn->ws_len);
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *pkt)
+{
+    if (req == NULL || req->aux == NULL || pkt == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), pkt);
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (hd == NULL || frame == NULL || (frame->payload == NULL && frame->len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ws_send_to_session(hd, fd, frame->type, frame->payload, frame->len);
+}
+
+// =============================================================================
+// HOST API
+// =============================================================================
+
+httpd_handle_t host_httpd_instance(void)
+{
+    return last_server;
+}
+
+esp_err_t host_httpd_request(httpd_handle_t hd, httpd_method_t method, const char *uri,
+                             const void *body, size_t body_len, host_httpd_response_t *resp)
+{
+    if (uri == NULL || resp == NULL || (body == NULL && body_len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    response_init(resp);
+    host_call_t call = {
+        .server = hd,
+        .method = method,
+        .uri = uri,
+        .data = body,
+        .len = body_len,
+        .resp = resp,
+    };
+    esp_err_t ret = host_call_run(&call, request_work);
+    if (ret != ESP_OK && ret != ESP_FAIL) {
+        host_httpd_response_free(resp);
+    }
+    return ret;
+}
+
+void host_httpd_response_free(host_httpd_response_t *resp)
+{
+    if (resp == NULL) {
+        return;
+    }
+    free(resp->headers);
+    free(resp->body);
+    resp->headers = NULL;
+    resp->body = NULL;
+    resp->body_len = 0;
+}
+
+esp_err_t host_httpd_ws_open(httpd_handle_t hd, const char *uri, int *out_fd)
+{
+    if (uri == NULL || out_fd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_call_t call = {
+        .server = hd,
+        .uri = uri,
+        .fd = -1,
+    };
+    esp_err_t ret = host_call_run(&call, ws_open_work);
+    *out_fd = call.fd;
+    return ret;
+}
+
+esp_err_t host_httpd_ws_send(httpd_handle_t hd, int fd, httpd_ws_type_t type, const void *data, size_t len)
+{
+    if (data == NULL && len > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_call_t call = {
+        .server = hd,
+        .fd = fd,
+        .ws_type = type,
+        .data = data,
+        .len = len,
+    };
+    return host_call_run(&call, ws_frame_work);
+}
+
+esp_err_t host_httpd_close(httpd_handle_t hd, int fd)
+{
+    host_call_t call = {
+        .server = hd,
+        .fd = fd,
+    };
+    return host_call_run(&call, close_work);
+}
+
+void host_httpd_set_ws_sink(httpd_handle_t hd, host_httpd_ws_sink_t sink, void *ctx)
+{
+    httpd_server_t *server = hd;
+    if (server == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->ws_sink = sink;
+    server->ws_sink_ctx = ctx;
+    pthread_mutex_unlock(&server->lock);
+}
+
+void host_httpd_set_listen_port(uint16_t port)
+{
+    listen_port = port;
+}
+
+void host_httpd_set_www_root(const char *dir)
+{
+    snprintf(www_root, sizeof(www_root), "%s", dir != NULL ? dir : "");
+
+    // Request paths start with '/'
+    size_t len = strlen(www_root);
+    if (len > 0 && www_root[len - 1] == '/') {
+        www_root[len - 1] = '\0';
+    }
+}
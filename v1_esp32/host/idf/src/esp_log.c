@@ -0,0 +1,99 @@
+/**
+ * @file esp_log.c
+ * @brief esp_log with per-tag levels and a replaceable vprintf
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define ESP_LOG_MAX_TAGS            64
+
+typedef struct {
+    char name[32];                  // Copied, tags set at run time may be temporary
+    esp_log_level_t level;
+} log_tag_level_t;
+
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static log_tag_level_t tag_levels[ESP_LOG_MAX_TAGS];
+static int tag_level_count = 0;
+static esp_log_level_t default_level = (esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+static vprintf_like_t log_vprintf = vprintf;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_mutex_lock(&log_lock);
+
+    if (strcmp(tag, "*") == 0) {
+        // As in IDF, "*" resets every tag to the new default
+        default_level = level;
+        tag_level_count = 0;
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].name, tag) == 0) {
+            tag_levels[i].level = level;
+            pthread_mutex_unlock(&log_lock);
+            return;
+        }
+    }
+    if (tag_level_count < ESP_LOG_MAX_TAGS) {
+        log_tag_level_t *entry = &tag_levels[tag_level_count++];
+        snprintf(entry->name, sizeof(entry->name), "%s", tag);
+        entry->level = level;
+    }
+
+    pthread_mutex_unlock(&log_lock);
+}
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    pthread_mutex_lock(&log_lock);
+
+    esp_log_level_t level = default_level;
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].name, tag) == 0) {
+            level = tag_levels[i].level;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&log_lock);
+    return level;
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+{
+    pthread_mutex_lock(&log_lock);
+    vprintf_like_t previous = log_vprintf;
+    log_vprintf = func;
+    pthread_mutex_unlock(&log_lock);
+    return previous;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    // As in IDF, the runtime tag level applies to direct callers too
+    if (level > esp_log_level_get(tag)) {
+        return;
+    }
+
+    pthread_mutex_lock(&log_lock);
+    vprintf_like_t func = log_vprintf;
+    pthread_mutex_unlock(&log_lock);
+
+    va_list args;
+    va_start(args, format);
+    func(format, args);
+    va_end(args);
+}
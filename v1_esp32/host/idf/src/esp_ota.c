@@ -0,0 +1,194 @@
+/**
+ * @file esp_ota.c
+ * @brief Partition table and OTA updates without flash
+ *
+ * The table mirrors partitions.csv and the board runs the factory app, as
+ * after a serial flash. Images are checked for the ESP image magic byte and
+ * otherwise discarded; a successful update only moves the boot partition.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+
+#define ESP_IMAGE_HEADER_MAGIC      0xE9
+#define HOST_OTA_HANDLE             1       // One update at a time
+
+static const esp_partition_t partitions[] = {
+    { .type = ESP_PARTITION_TYPE_APP, .subtype = ESP_PARTITION_SUBTYPE_APP_FACTORY,
+      .address = 0x010000, .size = 0x100000, .erase_size = 4096, .label = "factory" },
+    { .type = ESP_PARTITION_TYPE_APP, .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_0,
+      .address = 0x110000, .size = 0x100000, .erase_size = 4096, .label = "ota_0" },
+    { .type = ESP_PARTITION_TYPE_APP, .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1,
+      .address = 0x210000, .size = 0x100000, .erase_size = 4096, .label = "ota_1" },
+};
+
+#define PARTITION_COUNT             (sizeof(partitions) / sizeof(partitions[0]))
+#define RUNNING_PARTITION           (&partitions[0])
+
+static pthread_mutex_t ota_lock = PTHREAD_MUTEX_INITIALIZER;
+static const esp_partition_t *boot_partition = RUNNING_PARTITION;
+static const esp_partition_t *ota_partition = NULL;    // Update in progress
+static size_t ota_written = 0;
+static bool ota_magic_ok = false;
+
+// =============================================================================
+// PARTITIONS
+// =============================================================================
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (size_t i = 0; i < PARTITION_COUNT; i++) {
+        const esp_partition_t *partition = &partitions[i];
+        if (partition->type == type &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || partition->subtype == subtype) &&
+            (label == NULL || strcmp(partition->label, label) == 0)) {
+            return partition;
+        }
+    }
+    return NULL;
+}
+
+// =============================================================================
+// OTA
+// =============================================================================
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return RUNNING_PARTITION;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    pthread_mutex_lock(&ota_lock);
+    const esp_partition_t *partition = boot_partition;
+    pthread_mutex_unlock(&ota_lock);
+    return partition;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    if (start_from == NULL) {
+        start_from = RUNNING_PARTITION;
+    }
+    // The OTA slot after start_from, never the factory app
+    for (size_t i = 1; i <= PARTITION_COUNT; i++) {
+        const esp_partition_t *candidate = &partitions[((start_from - partitions) + i) % PARTITION_COUNT];
+        if (candidate->subtype != ESP_PARTITION_SUBTYPE_APP_FACTORY && candidate != start_from) {
+            return candidate;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state)
+{
+    if (partition == NULL || ota_state == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The factory app has no OTA state, like on the device
+    if (partition->subtype == ESP_PARTITION_SUBTYPE_APP_FACTORY) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    *ota_state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    if (partition == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == RUNNING_PARTITION) {
+        return ESP_ERR_OTA_PARTITION_CONFLICT;
+    }
+    if (image_size != OTA_SIZE_UNKNOWN && image_size != OTA_WITH_SEQUENTIAL_WRITES && image_size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pthread_mutex_lock(&ota_lock);
+    if (ota_partition != NULL) {
+        pthread_mutex_unlock(&ota_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ota_partition = partition;
+    ota_written = 0;
+    ota_magic_ok = false;
+    pthread_mutex_unlock(&ota_lock);
+
+    *out_handle = HOST_OTA_HANDLE;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != HOST_OTA_HANDLE || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&ota_lock);
+    if (ota_partition == NULL) {
+        pthread_mutex_unlock(&ota_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ota_written == 0 && size > 0) {
+        ota_magic_ok = ((const uint8_t *)data)[0] == ESP_IMAGE_HEADER_MAGIC;
+    }
+    if (ota_written + size > ota_partition->size) {
+        pthread_mutex_unlock(&ota_lock);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    ota_written += size;
+    pthread_mutex_unlock(&ota_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != HOST_OTA_HANDLE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    pthread_mutex_lock(&ota_lock);
+    bool valid = ota_partition != NULL && ota_written > 0 && ota_magic_ok;
+    // The handle is released either way, as in IDF
+    if (!valid) {
+        ota_partition = NULL;
+    }
+    pthread_mutex_unlock(&ota_lock);
+
+    return valid ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    pthread_mutex_lock(&ota_lock);
+    ota_partition = NULL;
+    pthread_mutex_unlock(&ota_lock);
+    return handle == HOST_OTA_HANDLE ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    if (partition == NULL || partition->type != ESP_PARTITION_TYPE_APP) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&ota_lock);
+    boot_partition = partition;
+    if (ota_partition == partition) {
+        ota_partition = NULL;
+    }
+    pthread_mutex_unlock(&ota_lock);
+    return ESP_OK;
+}
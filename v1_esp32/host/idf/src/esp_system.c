@@ -0,0 +1,130 @@
+/**
+ * @file esp_system.c
+ * @brief System, heap, chip and error name queries
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_chip_info.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "soc/rtc.h"
+
+// Heap the figures are reported against, the free DRAM of a running ESP32
+#define HOST_HEAP_SIZE              (300 * 1024)
+
+static size_t heap_min_free = HOST_HEAP_SIZE;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Simulated free heap: the device heap minus what the process allocated
+ */
+static size_t host_heap_free(void)
+{
+    struct mallinfo2 info = mallinfo2();
+    size_t used = info.uordblks + info.hblkhd;
+    size_t free_size = used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0;
+
+    if (free_size < heap_min_free) {
+        heap_min_free = free_size;
+    }
+    return free_size;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void esp_restart(void)
+{
+    fflush(stdout);
+    exit(HOST_RESTART_EXIT_CODE);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return (uint32_t)host_heap_free();
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    host_heap_free();
+    return (uint32_t)heap_min_free;
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return host_heap_free();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return esp_get_minimum_free_heap_size();
+}
+
+void esp_chip_info(esp_chip_info_t *out_info)
+{
+    out_info->model = CHIP_ESP32;
+    out_info->features = CHIP_FEATURE_WIFI_BGN | CHIP_FEATURE_BT | CHIP_FEATURE_BLE;
+    out_info->revision = 300;
+    out_info->cores = 2;
+}
+
+void rtc_clk_cpu_freq_get_config(rtc_cpu_freq_config_t *out_config)
+{
+    out_config->source_freq_mhz = 480;
+    out_config->div = 2;
+    out_config->freq_mhz = 240;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                        return "ESP_OK";
+        case ESP_FAIL:                      return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:      return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:           return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:       return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_INVALID_MAC:           return "ESP_ERR_INVALID_MAC";
+        case ESP_ERR_NOT_FINISHED:          return "ESP_ERR_NOT_FINISHED";
+        case ESP_ERR_NOT_ALLOWED:           return "ESP_ERR_NOT_ALLOWED";
+        case ESP_ERR_NVS_NOT_INITIALIZED:   return "ESP_ERR_NVS_NOT_INITIALIZED";
+        case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_READ_ONLY:         return "ESP_ERR_NVS_READ_ONLY";
+        case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+        case ESP_ERR_NVS_NO_FREE_PAGES:     return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        case ESP_ERR_OTA_PARTITION_CONFLICT: return "ESP_ERR_OTA_PARTITION_CONFLICT";
+        case ESP_ERR_OTA_VALIDATE_FAILED:   return "ESP_ERR_OTA_VALIDATE_FAILED";
+        default:                            return "UNKNOWN ERROR";
+    }
+}
+
+void _esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *expression)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nexpression: %s\n",
+            rc, esp_err_to_name(rc), file, line, expression);
+    abort();
+}
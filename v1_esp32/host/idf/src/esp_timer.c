@@ -0,0 +1,241 @@
+/**
+ * @file esp_timer.c
+ * @brief esp_timer on CLOCK_MONOTONIC with a dispatcher task
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_internal.h"
+
+#define ESP_TIMER_TASK_PRIORITY     22      // CONFIG_ESP_TIMER_TASK_PRIORITY
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    bool skip_unhandled_events;
+    bool active;
+    bool deleted;                   // Freed by the dispatcher once its callback returns
+    uint64_t period_us;             // 0 for one-shot timers
+    int64_t alarm_us;
+    struct esp_timer *next;
+};
+
+static struct timespec time_base;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static struct esp_timer *timer_list = NULL;
+static struct esp_timer *running_timer = NULL;
+static TaskHandle_t timer_task_handle = NULL;
+
+__attribute__((constructor))
+static void esp_timer_init_base(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &time_base);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static struct timespec time_to_timespec(int64_t time_us)
+{
+    int64_t ns = time_base.tv_nsec + (time_us % 1000000) * 1000;
+    struct timespec ts = {
+        .tv_sec = time_base.tv_sec + time_us / 1000000 + ns / 1000000000,
+        .tv_nsec = ns % 1000000000,
+    };
+    return ts;
+}
+
+static void timer_unlink_locked(struct esp_timer *timer)
+{
+    for (struct esp_timer **link = &timer_list; *link != NULL; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Dispatcher task, runs the callbacks one at a time in alarm order
+ */
+static void esp_timer_task(void *pvParameters)
+{
+    pthread_mutex_lock(&timer_lock);
+
+    while (1) {
+        struct esp_timer *due = NULL;
+        for (struct esp_timer *timer = timer_list; timer != NULL; timer = timer->next) {
+            if (timer->active && (due == NULL || timer->alarm_us < due->alarm_us)) {
+                due = timer;
+            }
+        }
+
+        if (due == NULL) {
+            pthread_cond_wait(&timer_cond, &timer_lock);
+            continue;
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (due->alarm_us > now) {
+            struct timespec deadline = time_to_timespec(due->alarm_us);
+            pthread_cond_timedwait(&timer_cond, &timer_lock, &deadline);
+            continue;   // The list may have changed meanwhile
+        }
+
+        if (due->period_us == 0) {
+            due->active = false;
+        } else {
+            due->alarm_us += due->period_us;
+            if (due->alarm_us <= now && due->skip_unhandled_events) {
+                due->alarm_us = now + due->period_us;
+            }
+        }
+
+        running_timer = due;
+        pthread_mutex_unlock(&timer_lock);
+        due->callback(due->arg);
+        pthread_mutex_lock(&timer_lock);
+        running_timer = NULL;
+
+        if (due->deleted) {
+            free(due);
+        }
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - time_base.tv_sec) * 1000000 + (now.tv_nsec - time_base.tv_nsec) / 1000;
+}
+
+void host_sleep_until_us(int64_t time_us)
+{
+    struct timespec deadline = time_to_timespec(time_us);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct esp_timer *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+    timer->skip_unhandled_events = create_args->skip_unhandled_events;
+
+    pthread_mutex_lock(&timer_lock);
+    if (timer_task_handle == NULL &&
+        xTaskCreate(esp_timer_task, "esp_timer", 4096, NULL, ESP_TIMER_TASK_PRIORITY, &timer_task_handle) != pdPASS) {
+        pthread_mutex_unlock(&timer_lock);
+        free(timer);
+        return ESP_ERR_NO_MEM;
+    }
+    timer->next = timer_list;
+    timer_list = timer;
+    pthread_mutex_unlock(&timer_lock);
+
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t esp_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&timer_lock);
+    if (timer->active) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = period_us;
+    timer->alarm_us = esp_timer_get_time() + timeout_us;
+    timer->active = true;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return esp_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return esp_timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&timer_lock);
+    bool was_active = timer->active;
+    timer->active = false;
+    pthread_mutex_unlock(&timer_lock);
+
+    return was_active ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&timer_lock);
+    if (timer->active) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer_unlink_locked(timer);
+    if (timer == running_timer) {
+        timer->deleted = true;
+    } else {
+        free(timer);
+    }
+    pthread_mutex_unlock(&timer_lock);
+
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    bool active = timer != NULL && timer->active;
+    pthread_mutex_unlock(&timer_lock);
+    return active;
+}
@@ -0,0 +1,498 @@
+/**
+ * @file freertos.c
+ * @brief FreeRTOS tasks, queues and critical sections on pthreads
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "host_internal.h"
+
+/**
+ * @brief Task control block, never freed so stale handles stay readable
+ */
+struct tskTaskControlBlock {
+    pthread_t thread;
+    clockid_t cpu_clock;
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t number;
+    UBaseType_t priority;
+    BaseType_t core_id;
+    uint32_t stack_depth;
+    TaskFunction_t code;
+    void *parameters;
+    bool deleted;
+    uint32_t notify_count;          // Guarded by kernel_lock
+    pthread_cond_t notify_cond;
+    struct tskTaskControlBlock *next;
+};
+
+struct QueueDefinition {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;          // 0 for semaphores
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t storage[];
+};
+
+static pthread_mutex_t kernel_lock = PTHREAD_MUTEX_INITIALIZER;    // Task list and notifications
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static struct tskTaskControlBlock *task_list = NULL;
+static UBaseType_t task_count = 0;
+static UBaseType_t next_task_number = 1;
+static __thread struct tskTaskControlBlock *current_task = NULL;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static struct timespec deadline_after_ticks(TickType_t ticks)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    uint64_t ns = (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ) + deadline.tv_nsec;
+    deadline.tv_sec += ns / 1000000000ull;
+    deadline.tv_nsec = ns % 1000000000ull;
+    return deadline;
+}
+
+/**
+ * @brief Wait on a condition until woken or the tick timeout expires
+ *
+ * @return false on timeout
+ */
+static bool cond_wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock, const struct timespec *deadline)
+{
+    if (deadline == NULL) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static void cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief Add a task control block to the task list, kernel_lock held
+ */
+static void task_register_locked(struct tskTaskControlBlock *task)
+{
+    task->number = next_task_number++;
+    task->next = task_list;
+    task_list = task;
+    task_count++;
+}
+
+/**
+ * @brief Task of the calling thread, adopted on first use when not created here
+ */
+static struct tskTaskControlBlock *task_current(void)
+{
+    if (current_task != NULL) {
+        return current_task;
+    }
+
+    struct tskTaskControlBlock *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        abort();
+    }
+    task->thread = pthread_self();
+    pthread_getcpuclockid(task->thread, &task->cpu_clock);
+    if (pthread_getname_np(task->thread, task->name, sizeof(task->name)) != 0 || task->name[0] == '\0') {
+        strcpy(task->name, "main");
+    }
+    task->priority = 1;
+    task->core_id = tskNO_AFFINITY;
+    cond_init_monotonic(&task->notify_cond);
+
+    pthread_mutex_lock(&kernel_lock);
+    task_register_locked(task);
+    pthread_mutex_unlock(&kernel_lock);
+
+    current_task = task;
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    struct tskTaskControlBlock *task = arg;
+
+    current_task = task;
+    pthread_getcpuclockid(pthread_self(), &task->cpu_clock);
+    task->code(task->parameters);
+
+    // Returning from a task function is a bug on FreeRTOS, end it quietly here
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+// =============================================================================
+// CRITICAL SECTIONS
+// =============================================================================
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_mutex_lock(&critical_lock);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_mutex_unlock(&critical_lock);
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+// =============================================================================
+// TASKS
+// =============================================================================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task_code, const char *name, uint32_t stack_depth,
+                                   void *parameters, UBaseType_t priority, TaskHandle_t *created_task,
+                                   BaseType_t core_id)
+{
+    struct tskTaskControlBlock *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+
+    snprintf(task->name, sizeof(task->name), "%s", name != NULL ? name : "");
+    task->priority = priority;
+    task->core_id = core_id;
+    task->stack_depth = stack_depth;
+    task->code = task_code;
+    task->parameters = parameters;
+    cond_init_monotonic(&task->notify_cond);
+
+    // Handle first: the task may run and use it before pthread_create returns
+    pthread_mutex_lock(&kernel_lock);
+    task_register_locked(task);
+    pthread_mutex_unlock(&kernel_lock);
+    if (created_task != NULL) {
+        *created_task = task;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int ret = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        pthread_mutex_lock(&kernel_lock);
+        task->deleted = true;
+        task_count--;
+        pthread_mutex_unlock(&kernel_lock);
+        if (created_task != NULL) {
+            *created_task = NULL;
+        }
+        return pdFAIL;
+    }
+
+    pthread_setname_np(task->thread, task->name);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name, uint32_t stack_depth,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created_task)
+{
+    return xTaskCreatePinnedToCore(task_code, name, stack_depth, parameters, priority, created_task,
+                                   tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    struct tskTaskControlBlock *self = task_current();
+
+    if (task != NULL && task != self) {
+        // Threads cannot be stopped from outside, the firmware only deletes itself
+        fprintf(stderr, "vTaskDelete: deleting another task is not supported on the host\n");
+        abort();
+    }
+
+    pthread_mutex_lock(&kernel_lock);
+    if (!self->deleted) {
+        self->deleted = true;
+        task_count--;
+    }
+    pthread_mutex_unlock(&kernel_lock);
+
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec deadline = deadline_after_ticks(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake_time, TickType_t time_increment)
+{
+    *previous_wake_time += time_increment;
+
+    TickType_t remaining = *previous_wake_time - xTaskGetTickCount();
+    // A wake time already in the past returns at once, as on FreeRTOS
+    if (remaining > 0 && remaining <= time_increment) {
+        host_sleep_until_us((int64_t)*previous_wake_time * (1000000 / configTICK_RATE_HZ));
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return task_current();
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = task_current();
+    }
+    return task->core_id;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = task_current();
+    }
+    // Thread stacks are megabytes, report the requested size as untouched
+    return task->stack_depth;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    pthread_mutex_lock(&kernel_lock);
+    UBaseType_t count = task_count;
+    pthread_mutex_unlock(&kernel_lock);
+    return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *task_status_array, UBaseType_t array_size,
+                                 configRUN_TIME_COUNTER_TYPE *total_run_time)
+{
+    UBaseType_t count = 0;
+    struct tskTaskControlBlock *self = task_current();
+
+    pthread_mutex_lock(&kernel_lock);
+    if (array_size < task_count) {
+        pthread_mutex_unlock(&kernel_lock);
+        return 0;
+    }
+
+    for (struct tskTaskControlBlock *task = task_list; task != NULL; task = task->next) {
+        if (task->deleted) {
+            continue;
+        }
+
+        struct timespec cpu = { 0, 0 };
+        clock_gettime(task->cpu_clock, &cpu);
+
+        TaskStatus_t *status = &task_status_array[count++];
+        status->xHandle = task;
+        status->pcTaskName = task->name;
+        status->xTaskNumber = task->number;
+        status->eCurrentState = (task == self) ? eRunning : eBlocked;
+        status->uxCurrentPriority = task->priority;
+        status->uxBasePriority = task->priority;
+        status->ulRunTimeCounter = (configRUN_TIME_COUNTER_TYPE)(cpu.tv_sec * 1000000ll + cpu.tv_nsec / 1000);
+        status->pxStackBase = NULL;
+        status->usStackHighWaterMark = task->stack_depth;
+        status->xCoreID = task->core_id;
+    }
+    pthread_mutex_unlock(&kernel_lock);
+
+    if (total_run_time != NULL) {
+        *total_run_time = (configRUN_TIME_COUNTER_TYPE)esp_timer_get_time();
+    }
+    return count;
+}
+
+// =============================================================================
+// TASK NOTIFICATIONS
+// =============================================================================
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    struct tskTaskControlBlock *self = task_current();
+    struct timespec deadline = deadline_after_ticks(ticks_to_wait);
+    const struct timespec *timeout = (ticks_to_wait == portMAX_DELAY) ? NULL : &deadline;
+
+    pthread_mutex_lock(&kernel_lock);
+    while (self->notify_count == 0 && ticks_to_wait > 0) {
+        if (!cond_wait_ticks(&self->notify_cond, &kernel_lock, timeout)) {
+            break;
+        }
+    }
+
+    uint32_t value = self->notify_count;
+    if (value > 0) {
+        self->notify_count = clear_count_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&kernel_lock);
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&kernel_lock);
+    task->notify_count++;
+    pthread_cond_signal(&task->notify_cond);
+    pthread_mutex_unlock(&kernel_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != NULL) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+// =============================================================================
+// QUEUES
+// =============================================================================
+
+QueueHandle_t xQueueCreate(UBaseType_t queue_length, UBaseType_t item_size)
+{
+    if (queue_length == 0) {
+        return NULL;
+    }
+
+    struct QueueDefinition *queue = calloc(1, sizeof(*queue) + (size_t)queue_length * item_size);
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init_monotonic(&queue->not_empty);
+    cond_init_monotonic(&queue->not_full);
+    queue->length = queue_length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    if (initial_count > max_count) {
+        return NULL;
+    }
+
+    QueueHandle_t queue = xQueueCreate(max_count, 0);
+    if (queue != NULL) {
+        queue->count = initial_count;
+    }
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = deadline_after_ticks(ticks_to_wait);
+    const struct timespec *timeout = (ticks_to_wait == portMAX_DELAY) ? NULL : &deadline;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (ticks_to_wait == 0 || !cond_wait_ticks(&queue->not_full, &queue->lock, timeout)) {
+            if (queue->count == queue->length) {
+                pthread_mutex_unlock(&queue->lock);
+                return pdFAIL;  // errQUEUE_FULL
+            }
+        }
+    }
+
+    if (queue->item_size > 0) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(&queue->storage[(size_t)tail * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = deadline_after_ticks(ticks_to_wait);
+    const struct timespec *timeout = (ticks_to_wait == portMAX_DELAY) ? NULL : &deadline;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (ticks_to_wait == 0 || !cond_wait_ticks(&queue->not_empty, &queue->lock, timeout)) {
+            if (queue->count == 0) {
+                pthread_mutex_unlock(&queue->lock);
+                return pdFALSE;
+            }
+        }
+    }
+
+    if (queue->item_size > 0) {
+        memcpy(buffer, &queue->storage[(size_t)queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
@@ -0,0 +1,389 @@
+/**
+ * @file hal.c
+ * @brief LEDC, GPIO and ADC stand-ins with output recording
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_timer.h"
+#include "host_hal.h"
+
+_Static_assert((HOST_HAL_LOG_SIZE & (HOST_HAL_LOG_SIZE - 1)) == 0, "HOST_HAL_LOG_SIZE must be a power of two");
+
+#define HOST_ADC_FULL_SCALE_MV      3100    // ADC_ATTEN_DB_12 range on the ESP32
+#define HOST_ADC_MAX_RAW            4095
+
+/**
+ * @brief State of one LEDC channel
+ */
+typedef struct {
+    bool configured;
+    int gpio;
+    ledc_timer_t timer;
+    uint32_t pending_duty;          // Set by ledc_set_duty()
+    uint32_t duty;                  // Applied by ledc_update_duty()
+} ledc_channel_state_t;
+
+struct adc_oneshot_unit_ctx_t {
+    adc_unit_t unit;
+};
+
+struct adc_cali_scheme_t {
+    adc_atten_t atten;
+};
+
+static pthread_mutex_t hal_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_hal_event_t event_log[HOST_HAL_LOG_SIZE];
+static uint64_t event_count = 0;    // Since the last reset
+static bool recording = true;
+
+static ledc_timer_bit_t timer_resolution[LEDC_TIMER_MAX];
+static ledc_channel_state_t ledc_channels[HOST_HAL_LEDC_CHANNELS];
+static int gpio_levels[GPIO_NUM_MAX];
+static bool gpio_written[GPIO_NUM_MAX];
+static int adc_raw[HOST_HAL_ADC_CHANNELS];
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Append an event, hal_lock held
+ */
+static void hal_record_locked(host_hal_kind_t kind, int unit, int gpio, uint32_t value)
+{
+    if (!recording) {
+        return;
+    }
+
+    host_hal_event_t *event = &event_log[event_count & (HOST_HAL_LOG_SIZE - 1)];
+    event->time_us = esp_timer_get_time();
+    event->kind = (uint8_t)kind;
+    event->unit = (uint8_t)unit;
+    event->gpio = (int16_t)gpio;
+    event->value = value;
+    event_count++;
+}
+
+static bool ledc_channel_valid(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    return speed_mode < LEDC_SPEED_MODE_MAX && channel >= 0 && channel < HOST_HAL_LEDC_CHANNELS;
+}
+
+// =============================================================================
+// LEDC
+// =============================================================================
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    if (timer_conf == NULL || timer_conf->timer_num >= LEDC_TIMER_MAX || timer_conf->freq_hz == 0 ||
+        timer_conf->duty_resolution < LEDC_TIMER_1_BIT || timer_conf->duty_resolution > 20) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    timer_resolution[timer_conf->timer_num] = timer_conf->duty_resolution;
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    if (ledc_conf == NULL || !ledc_channel_valid(ledc_conf->speed_mode, ledc_conf->channel) ||
+        ledc_conf->timer_sel >= LEDC_TIMER_MAX || ledc_conf->gpio_num < 0 || ledc_conf->gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    ledc_channel_state_t *state = &ledc_channels[ledc_conf->channel];
+    state->configured = true;
+    state->gpio = ledc_conf->gpio_num;
+    state->timer = ledc_conf->timer_sel;
+    state->pending_duty = ledc_conf->duty;
+    state->duty = ledc_conf->duty;
+    // The channel drives its pin from here on, with the configured duty
+    hal_record_locked(HOST_HAL_LEDC_DUTY, ledc_conf->channel, state->gpio, state->duty);
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    if (!ledc_channel_valid(speed_mode, channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    ledc_channel_state_t *state = &ledc_channels[channel];
+    if (!state->configured) {
+        pthread_mutex_unlock(&hal_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    state->pending_duty = duty;
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (!ledc_channel_valid(speed_mode, channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    ledc_channel_state_t *state = &ledc_channels[channel];
+    if (!state->configured) {
+        pthread_mutex_unlock(&hal_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    state->duty = state->pending_duty;
+    hal_record_locked(HOST_HAL_LEDC_DUTY, channel, state->gpio, state->duty);
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    return ledc_channel_valid(speed_mode, channel) ? host_hal_ledc_duty(channel) : 0;
+}
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t idle_level)
+{
+    if (!ledc_channel_valid(speed_mode, channel)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    ledc_channel_state_t *state = &ledc_channels[channel];
+    state->duty = 0;
+    hal_record_locked(HOST_HAL_LEDC_STOP, channel, state->configured ? state->gpio : -1, idle_level);
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+// =============================================================================
+// GPIO
+// =============================================================================
+
+esp_err_t gpio_config(const gpio_config_t *pGPIOConfig)
+{
+    if (pGPIOConfig == NULL || pGPIOConfig->pin_bit_mask == 0 ||
+        (pGPIOConfig->pin_bit_mask >> GPIO_NUM_MAX) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    gpio_written[gpio_num] = true;
+    hal_record_locked(HOST_HAL_GPIO_LEVEL, gpio_num, gpio_num, level ? 1 : 0);
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    int level = host_hal_gpio_level(gpio_num);
+    return level < 0 ? 0 : level;
+}
+
+// =============================================================================
+// ADC
+// =============================================================================
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    if (init_config == NULL || ret_unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct adc_oneshot_unit_ctx_t *unit = calloc(1, sizeof(*unit));
+    if (unit == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    unit->unit = init_config->unit_id;
+    *ret_unit = unit;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *config)
+{
+    if (handle == NULL || config == NULL || channel < 0 || channel >= HOST_HAL_ADC_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    if (handle == NULL || out_raw == NULL || chan < 0 || chan >= HOST_HAL_ADC_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    *out_raw = adc_raw[chan];
+    pthread_mutex_unlock(&hal_lock);
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config,
+                                              adc_cali_handle_t *ret_handle)
+{
+    if (config == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct adc_cali_scheme_t *scheme = calloc(1, sizeof(*scheme));
+    if (scheme == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    scheme->atten = config->atten;
+    *ret_handle = scheme;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_line_fitting(adc_cali_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    if (handle == NULL || voltage == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *voltage = raw * HOST_ADC_FULL_SCALE_MV / HOST_ADC_MAX_RAW;
+    return ESP_OK;
+}
+
+// =============================================================================
+// RECORDING API
+// =============================================================================
+
+void host_hal_reset(void)
+{
+    pthread_mutex_lock(&hal_lock);
+    event_count = 0;
+    pthread_mutex_unlock(&hal_lock);
+}
+
+void host_hal_set_recording(bool enabled)
+{
+    pthread_mutex_lock(&hal_lock);
+    recording = enabled;
+    pthread_mutex_unlock(&hal_lock);
+}
+
+uint64_t host_hal_event_count(void)
+{
+    pthread_mutex_lock(&hal_lock);
+    uint64_t count = event_count;
+    pthread_mutex_unlock(&hal_lock);
+    return count;
+}
+
+size_t host_hal_events(uint64_t first, host_hal_event_t *events, size_t max_events)
+{
+    size_t copied = 0;
+
+    pthread_mutex_lock(&hal_lock);
+    uint64_t oldest = event_count > HOST_HAL_LOG_SIZE ? event_count - HOST_HAL_LOG_SIZE : 0;
+    if (first < oldest) {
+        first = oldest;
+    }
+    for (uint64_t index = first; index < event_count && copied < max_events; index++) {
+        events[copied++] = event_log[index & (HOST_HAL_LOG_SIZE - 1)];
+    }
+    pthread_mutex_unlock(&hal_lock);
+
+    return copied;
+}
+
+void host_hal_dump(FILE *out)
+{
+    static const char *const kind_names[] = { "ledc_duty", "ledc_stop", "gpio_level" };
+
+    pthread_mutex_lock(&hal_lock);
+    uint64_t oldest = event_count > HOST_HAL_LOG_SIZE ? event_count - HOST_HAL_LOG_SIZE : 0;
+    for (uint64_t index = oldest; index < event_count; index++) {
+        const host_hal_event_t *event = &event_log[index & (HOST_HAL_LOG_SIZE - 1)];
+        fprintf(out, "%10lld us  %-10s  unit=%-2u gpio=%-2d value=%lu\n",
+                (long long)event->time_us, kind_names[event->kind], event->unit, event->gpio,
+                (unsigned long)event->value);
+    }
+    pthread_mutex_unlock(&hal_lock);
+}
+
+uint32_t host_hal_ledc_duty(int channel)
+{
+    if (channel < 0 || channel >= HOST_HAL_LEDC_CHANNELS) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    uint32_t duty = ledc_channels[channel].duty;
+    pthread_mutex_unlock(&hal_lock);
+    return duty;
+}
+
+int host_hal_ledc_resolution(int channel)
+{
+    if (channel < 0 || channel >= HOST_HAL_LEDC_CHANNELS) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    int bits = ledc_channels[channel].configured ? (int)timer_resolution[ledc_channels[channel].timer] : 0;
+    pthread_mutex_unlock(&hal_lock);
+    return bits;
+}
+
+int host_hal_gpio_level(int gpio)
+{
+    if (gpio < 0 || gpio >= GPIO_NUM_MAX) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    int level = gpio_written[gpio] ? gpio_levels[gpio] : -1;
+    pthread_mutex_unlock(&hal_lock);
+    return level;
+}
+
+void host_hal_set_adc_raw(int channel, int raw)
+{
+    if (channel < 0 || channel >= HOST_HAL_ADC_CHANNELS) {
+        return;
+    }
+
+    pthread_mutex_lock(&hal_lock);
+    adc_raw[channel] = raw < 0 ? 0 : (raw > HOST_ADC_MAX_RAW ? HOST_ADC_MAX_RAW : raw);
+    pthread_mutex_unlock(&hal_lock);
+}
+
+void host_hal_set_adc_mv(int channel, int mv)
+{
+    // Rounded up, so adc_cali_raw_to_voltage() gives back at least mv
+    host_hal_set_adc_raw(channel, (mv * HOST_ADC_MAX_RAW + HOST_ADC_FULL_SCALE_MV - 1) / HOST_ADC_FULL_SCALE_MV);
+}
@@ -0,0 +1,12 @@
+/**
+ * @file host_internal.h
+ * @brief Helpers shared by the stand-ins, not part of any IDF API
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Sleep until esp_timer_get_time() reaches @p time_us
+ */
+void host_sleep_until_us(int64_t time_us);
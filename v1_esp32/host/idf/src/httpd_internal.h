@@ -0,0 +1,181 @@
+/**
+ * @file httpd_internal.h
+ * @brief State shared by the esp_http_server stand-in and its TCP front end
+ *
+ * esp_http_server.c owns the handler table, the sessions and the httpd
+ * task; httpd_sock.c speaks HTTP/1.1 and WebSocket on real sockets and
+ * feeds the same request and frame paths as the host_httpd.h injection.
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "host_httpd.h"
+
+#define HTTPD_WS_METHOD             0       // req->method of WebSocket frames, anything but HTTP_GET
+
+/**
+ * @brief Open session, one per socket
+ */
+typedef struct {
+    bool used;
+    bool socket;                    // TCP connection, otherwise injected over a socketpair
+    bool websocket;                 // Handshake done
+    bool busy;                      // Request owned by an async handler, not polled
+    int fd;
+    int peer_fd;                    // Other socketpair end, -1 for TCP
+    uint64_t lru;                   // Server lru_counter at the last request
+    const httpd_uri_t *ws_handler;
+    void *ctx;
+    httpd_free_ctx_fn_t free_ctx;
+    uint8_t *rx;                    // Received, not yet handled bytes (TCP)
+    size_t rx_len;
+    size_t rx_cap;
+} httpd_session_t;
+
+typedef struct httpd_server {
+    httpd_config_t config;
+    httpd_uri_t *handlers;
+    int handler_count;
+    httpd_session_t *sessions;      // config.max_open_sockets entries
+    pthread_mutex_t *send_locks;    // One per session slot, held while a frame goes out
+    pthread_mutex_t lock;           // Session table and the WebSocket sink
+    QueueHandle_t work_queue;
+    int wake_fd;                    // eventfd, signalled with each work item
+    int listen_fd;                  // -1 without a TCP front end
+    uint64_t lru_counter;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped;
+    host_httpd_ws_sink_t ws_sink;
+    void *ws_sink_ctx;
+} httpd_server_t;
+
+/**
+ * @brief Request in flight, httpd_req_t.aux
+ */
+typedef struct httpd_conn {
+    httpd_server_t *server;
+    httpd_session_t *session;
+    httpd_method_t method;
+    const uint8_t *body;            // Body bytes already received
+    size_t body_len;
+    size_t content_len;             // Whole body, the rest is still on the socket
+    size_t body_read;
+    httpd_ws_type_t ws_type;        // WebSocket frame delivered to the handler
+    const uint8_t *ws_data;
+    size_t ws_len;
+    host_httpd_response_t *resp;    // Response being built, own_resp on TCP
+    host_httpd_response_t own_resp;
+    size_t resp_cap;
+    bool head_sent;                 // TCP: status line and headers are out
+    bool sent;                      // Response complete
+    bool failed;                    // Handler returned an error, the session is closed
+    bool detached;                  // Owned by httpd_req_async_handler_begin()
+    void (*finish)(struct httpd_conn *conn);   // Called on the httpd task once the request is done
+    void *finish_ctx;
+} httpd_conn_t;
+
+// =============================================================================
+// CORE, esp_http_server.c
+// =============================================================================
+
+/**
+ * @brief Take a session slot, httpd task only
+ *
+ * @param fd Accepted TCP socket, or -1 for an injected session
+ */
+httpd_session_t *httpd_session_open(httpd_server_t *server, int fd);
+
+/**
+ * @brief Run close_fn and free_ctx and release the slot, httpd task only
+ */
+void httpd_session_close(httpd_server_t *server, httpd_session_t *session);
+
+/**
+ * @brief Least recently used session, for lru_purge_enable
+ */
+httpd_session_t *httpd_session_lru(httpd_server_t *server);
+
+/**
+ * @brief Handle one HTTP request on the httpd task
+ *
+ * Runs a static file, a URI handler or the 404/405 reply. conn->finish is
+ * called once the response is complete, which for async handlers is later
+ * and from httpd_req_async_handler_complete().
+ *
+ * @param conn Request, session, body and response already set up
+ * @param uri Path with optional query string
+ */
+void httpd_dispatch_request(httpd_conn_t *conn, const char *uri);
+
+/**
+ * @brief WebSocket handler for a GET on @p uri, NULL when there is none
+ */
+const httpd_uri_t *httpd_find_ws_handler(httpd_server_t *server, const char *uri);
+
+/**
+ * @brief Run the handshake call of a WebSocket handler, httpd task only
+ *
+ * The session is a WebSocket from here on; it is closed on failure.
+ */
+esp_err_t httpd_ws_accept(httpd_server_t *server, httpd_session_t *session, const httpd_uri_t *handler,
+                          const char *uri);
+
+/**
+ * @brief Deliver one received frame to the session handler, httpd task only
+ *
+ * Control frames are answered here unless the handler asked for them. The
+ * session is closed when the handler fails.
+ */
+esp_err_t httpd_ws_deliver(httpd_server_t *server, httpd_session_t *session, httpd_ws_type_t type,
+                           const uint8_t *data, size_t len);
+
+// =============================================================================
+// TCP FRONT END, httpd_sock.c
+// =============================================================================
+
+/**
+ * @brief Open the listening socket
+ */
+esp_err_t httpd_sock_listen(httpd_server_t *server, uint16_t port);
+
+/**
+ * @brief Handle every complete request or frame in the session buffer
+ */
+void httpd_sock_process(httpd_server_t *server, httpd_session_t *session);
+
+/**
+ * @brief Wait for socket activity or queued work and handle the sockets
+ */
+void httpd_sock_poll(httpd_server_t *server);
+
+/**
+ * @brief Write the status line and headers, chunked or with Content-Length
+ */
+esp_err_t httpd_sock_send_head(httpd_conn_t *conn, bool chunked, size_t content_len);
+
+/**
+ * @brief Write all of @p data, within send_wait_timeout
+ */
+esp_err_t httpd_sock_write(httpd_server_t *server, int fd, const void *data, size_t len);
+
+/**
+ * @brief Body bytes not received yet, within recv_wait_timeout
+ *
+ * @return Bytes read, or HTTPD_SOCK_ERR_TIMEOUT / HTTPD_SOCK_ERR_FAIL
+ */
+int httpd_sock_recv_body(httpd_conn_t *conn, char *buf, size_t len);
+
+/**
+ * @brief Encode and write one server frame, the session send lock held
+ */
+esp_err_t httpd_sock_ws_send(httpd_server_t *server, int fd, httpd_ws_type_t type,
+                             const uint8_t *data, size_t len);
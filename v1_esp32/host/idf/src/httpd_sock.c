@@ -0,0 +1,695 @@
+/**
+ * @file httpd_sock.c
+ * @brief TCP front end of the esp_http_server stand-in
+ *
+ * HTTP/1.1 with keep-alive and chunked responses, and WebSocket (RFC 6455)
+ * with the handshake done before the handler's GET call, as the IDF server
+ * does. Everything here runs on the httpd task except the writes, which
+ * come from whichever task sends.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "httpd_internal.h"
+
+#define HTTPD_RX_CHUNK_SIZE         4096
+#define HTTPD_WS_MAX_FRAME          65536   // Larger client frames close the session
+#define HTTPD_WS_HEADER_MAX         10      // Server frames are not masked
+#define HTTPD_WS_GUID               "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define HTTPD_WS_KEY_MAX            64
+
+static const char *TAG = "httpd_sock";
+
+/**
+ * @brief Request read from a TCP session
+ */
+typedef struct {
+    httpd_conn_t conn;              // First, so the finish callback gets back here
+    size_t header_len;              // Request line and headers in session->rx
+    bool close;                     // Connection: close, or HTTP/1.0 without keep-alive
+} sock_request_t;
+
+/**
+ * @brief Header fields the front end acts on
+ */
+typedef struct {
+    size_t content_len;
+    bool close;
+    bool upgrade_websocket;
+    char ws_key[HTTPD_WS_KEY_MAX];
+} sock_headers_t;
+
+// =============================================================================
+// SHA-1 AND BASE64, FOR Sec-WebSocket-Accept
+// =============================================================================
+
+static uint32_t rol32(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1_block(uint32_t h[5], const uint8_t *block)
+{
+    uint32_t w[80];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+/**
+ * @brief SHA-1 of a short message, up to 119 bytes
+ */
+static void sha1_short(const uint8_t *data, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t blocks[128] = { 0 };
+    size_t total = len + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+
+    memcpy(blocks, data, len);
+    blocks[len] = 0x80;
+    for (int i = 0; i < 8; i++) {
+        blocks[total - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    for (size_t offset = 0; offset < total; offset += 64) {
+        sha1_block(h, blocks + offset);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (uint8_t)(h[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)h[i];
+    }
+}
+
+static void base64_encode(const uint8_t *data, size_t len, char *out)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < len) {
+            triple |= (uint32_t)data[i + 1] << 8;
+        }
+        if (i + 2 < len) {
+            triple |= data[i + 2];
+        }
+        *out++ = alphabet[(triple >> 18) & 0x3F];
+        *out++ = alphabet[(triple >> 12) & 0x3F];
+        *out++ = i + 1 < len ? alphabet[(triple >> 6) & 0x3F] : '=';
+        *out++ = i + 2 < len ? alphabet[triple & 0x3F] : '=';
+    }
+    *out = '\0';
+}
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static void rx_consume(httpd_session_t *session, size_t len)
+{
+    if (len >= session->rx_len) {
+        session->rx_len = 0;
+        return;
+    }
+    memmove(session->rx, session->rx + len, session->rx_len - len);
+    session->rx_len -= len;
+}
+
+/**
+ * @brief Answer with an error page and close, for requests no handler sees
+ */
+static void reply_error_and_close(httpd_server_t *server, httpd_session_t *session, httpd_err_code_t error)
+{
+    httpd_conn_t conn = {
+        .server = server,
+        .session = session,
+        .method = HTTP_GET,
+    };
+    snprintf(conn.own_resp.status_line, sizeof(conn.own_resp.status_line), "200 OK");
+    conn.resp = &conn.own_resp;
+
+    httpd_req_t req = { .handle = server, .aux = &conn };
+    httpd_resp_send_err(&req, error, NULL);
+    host_httpd_response_free(&conn.own_resp);
+    httpd_session_close(server, session);
+}
+
+static bool parse_method(const char *token, size_t len, httpd_method_t *method)
+{
+    static const struct {
+        const char *name;
+        httpd_method_t method;
+    } methods[] = {
+        { "GET", HTTP_GET },
+        { "POST", HTTP_POST },
+        { "PUT", HTTP_PUT },
+        { "DELETE", HTTP_DELETE },
+        { "HEAD", HTTP_HEAD },
+        { "OPTIONS", HTTP_OPTIONS },
+    };
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strlen(methods[i].name) == len && strncmp(methods[i].name, token, len) == 0) {
+            *method = methods[i].method;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool header_has_token(const char *value, const char *token)
+{
+    size_t token_len = strlen(token);
+
+    for (const char *p = value; *p != '\0'; p++) {
+        if (strncasecmp(p, token, token_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Pick the fields of interest out of a NUL terminated header block
+ */
+static void parse_headers(char *lines, bool http10, sock_headers_t *headers)
+{
+    bool keep_alive = false;
+
+    memset(headers, 0, sizeof(*headers));
+    char *save = NULL;
+    for (char *line = strtok_r(lines, "\r\n", &save); line != NULL; line = strtok_r(NULL, "\r\n", &save)) {
+        char *colon = strchr(line, ':');
+        if (colon == NULL) {
+            continue;
+        }
+        *colon = '\0';
+        char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') {
+            value++;
+        }
+
+        if (strcasecmp(line, "Content-Length") == 0) {
+            headers->content_len = strtoul(value, NULL, 10);
+        } else if (strcasecmp(line, "Connection") == 0) {
+            headers->close = header_has_token(value, "close");
+            keep_alive = header_has_token(value, "keep-alive");
+        } else if (strcasecmp(line, "Upgrade") == 0) {
+            headers->upgrade_websocket = header_has_token(value, "websocket");
+        } else if (strcasecmp(line, "Sec-WebSocket-Key") == 0) {
+            snprintf(headers->ws_key, sizeof(headers->ws_key), "%s", value);
+        }
+    }
+
+    if (http10 && !keep_alive) {
+        headers->close = true;
+    }
+}
+
+static void sock_request_finish(httpd_conn_t *conn)
+{
+    sock_request_t *request = (sock_request_t *)conn;
+    httpd_server_t *server = conn->server;
+    httpd_session_t *session = conn->session;
+
+    // Unread body bytes would be taken for the next request
+    bool keep = !conn->failed && conn->sent && !request->close && conn->body_read == conn->content_len;
+    bool detached = conn->detached;
+
+    if (keep) {
+        rx_consume(session, request->header_len + conn->body_len);
+    } else {
+        httpd_session_close(server, session);
+    }
+    host_httpd_response_free(&conn->own_resp);
+    free(request);
+
+    // The poll loop skipped the session meanwhile, pipelined bytes may wait
+    if (keep && detached) {
+        httpd_sock_process(server, session);
+    }
+}
+
+/**
+ * @brief Answer the upgrade and hand the session to the WebSocket handler
+ */
+static void websocket_handshake(httpd_server_t *server, httpd_session_t *session, const char *uri,
+                                const sock_headers_t *headers, size_t header_len)
+{
+    const httpd_uri_t *handler = httpd_find_ws_handler(server, uri);
+    if (handler == NULL || headers->ws_key[0] == '\0') {
+        reply_error_and_close(server, session, handler == NULL ? HTTPD_404_NOT_FOUND : HTTPD_400_BAD_REQUEST);
+        return;
+    }
+
+    char key[HTTPD_WS_KEY_MAX + sizeof(HTTPD_WS_GUID)];
+    uint8_t digest[20];
+    char accept[32];
+    int key_len = snprintf(key, sizeof(key), "%s%s", headers->ws_key, HTTPD_WS_GUID);
+    sha1_short((const uint8_t *)key, (size_t)key_len, digest);
+    base64_encode(digest, sizeof(digest), accept);
+
+    char response[192];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 101 Switching Protocols\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    if (httpd_sock_write(server, session->fd, response, (size_t)len) != ESP_OK) {
+        httpd_session_close(server, session);
+        return;
+    }
+
+    rx_consume(session, header_len);
+    httpd_ws_accept(server, session, handler, uri);
+}
+
+/**
+ * @brief Handle one request once its headers are in, false when incomplete
+ */
+static bool process_http(httpd_server_t *server, httpd_session_t *session)
+{
+    const uint8_t *end = memmem(session->rx, session->rx_len, "\r\n\r\n", 4);
+    if (end == NULL) {
+        if (session->rx_len > CONFIG_HTTPD_MAX_REQ_HDR_LEN) {
+            reply_error_and_close(server, session, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE);
+        }
+        return false;
+    }
+
+    size_t header_len = (size_t)(end - session->rx) + 4;
+    if (header_len > CONFIG_HTTPD_MAX_REQ_HDR_LEN) {
+        reply_error_and_close(server, session, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE);
+        return false;
+    }
+
+    char head[CONFIG_HTTPD_MAX_REQ_HDR_LEN + 1];
+    memcpy(head, session->rx, header_len);
+    head[header_len] = '\0';
+
+    // Request line: METHOD SP URI SP HTTP/1.x
+    char *line_end = strstr(head, "\r\n");
+    *line_end = '\0';
+    char *uri = strchr(head, ' ');
+    char *version = uri != NULL ? strchr(uri + 1, ' ') : NULL;
+    if (uri == NULL || version == NULL || strncmp(version + 1, "HTTP/1.", 7) != 0) {
+        reply_error_and_close(server, session, HTTPD_400_BAD_REQUEST);
+        return false;
+    }
+    *version = '\0';
+
+    httpd_method_t method;
+    if (!parse_method(head, (size_t)(uri - head), &method)) {
+        reply_error_and_close(server, session, HTTPD_501_METHOD_NOT_IMPLEMENTED);
+        return false;
+    }
+    uri++;
+    if (strlen(uri) > HTTPD_MAX_URI_LEN) {
+        reply_error_and_close(server, session, HTTPD_414_URI_TOO_LONG);
+        return false;
+    }
+
+    sock_headers_t headers;
+    parse_headers(line_end + 2, strcmp(version + 1, "HTTP/1.0") == 0, &headers);
+
+    if (headers.upgrade_websocket && method == HTTP_GET) {
+        websocket_handshake(server, session, uri, &headers, header_len);
+        return true;
+    }
+
+    sock_request_t *request = calloc(1, sizeof(sock_request_t));
+    if (request == NULL) {
+        reply_error_and_close(server, session, HTTPD_500_INTERNAL_SERVER_ERROR);
+        return false;
+    }
+    size_t buffered = session->rx_len - header_len;
+
+    request->header_len = header_len;
+    request->close = headers.close;
+    httpd_conn_t *conn = &request->conn;
+    conn->server = server;
+    conn->session = session;
+    conn->method = method;
+    conn->body = session->rx + header_len;
+    conn->body_len = buffered < headers.content_len ? buffered : headers.content_len;
+    conn->content_len = headers.content_len;
+    snprintf(conn->own_resp.status_line, sizeof(conn->own_resp.status_line), "200 OK");
+    snprintf(conn->own_resp.content_type, sizeof(conn->own_resp.content_type), "text/html");
+    conn->resp = &conn->own_resp;
+    conn->finish = sock_request_finish;
+
+    httpd_dispatch_request(conn, uri);
+    return true;
+}
+
+/**
+ * @brief Deliver one client frame once it is complete, false when incomplete
+ */
+static bool process_websocket(httpd_server_t *server, httpd_session_t *session)
+{
+    uint8_t *rx = session->rx;
+    if (session->rx_len < 2) {
+        return false;
+    }
+
+    httpd_ws_type_t type = (httpd_ws_type_t)(rx[0] & 0x0F);
+    bool masked = (rx[1] & 0x80) != 0;
+    uint64_t len = rx[1] & 0x7F;
+    size_t header_len = 2;
+
+    if (len == 126) {
+        if (session->rx_len < 4) {
+            return false;
+        }
+        len = ((uint64_t)rx[2] << 8) | rx[3];
+        header_len = 4;
+    } else if (len == 127) {
+        if (session->rx_len < 10) {
+            return false;
+        }
+        len = 0;
+        for (int i = 0; i < 8; i++) {
+            len = (len << 8) | rx[2 + i];
+        }
+        header_len = 10;
+    }
+
+    if (len > HTTPD_WS_MAX_FRAME) {
+        ESP_LOGW(TAG, "fd %d: %llu byte frame, closing", session->fd, (unsigned long long)len);
+        httpd_session_close(server, session);
+        return false;
+    }
+
+    const uint8_t *mask = rx + header_len;
+    if (masked) {
+        header_len += 4;
+    }
+    if (session->rx_len < header_len + len) {
+        return false;
+    }
+
+    uint8_t *payload = rx + header_len;
+    for (size_t i = 0; masked && i < len; i++) {
+        payload[i] ^= mask[i & 3];
+    }
+
+    int fd = session->fd;
+    httpd_ws_deliver(server, session, type, payload, (size_t)len);
+    if (session->used && session->fd == fd) {
+        rx_consume(session, header_len + (size_t)len);
+    }
+    return true;
+}
+
+static void accept_client(httpd_server_t *server)
+{
+    int fd = accept4(server->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    bool full = true;
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        full = full && server->sessions[i].used;
+    }
+    if (full && server->config.lru_purge_enable) {
+        httpd_session_t *oldest = httpd_session_lru(server);
+        if (oldest != NULL) {
+            ESP_LOGD(TAG, "Purging fd %d to accept a new client", oldest->fd);
+            httpd_session_close(server, oldest);
+        }
+    }
+
+    // Frames are small and their latency is what the simulator measures
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    httpd_session_open(server, fd);    // Closes fd when no slot is free
+}
+
+static void read_client(httpd_server_t *server, httpd_session_t *session)
+{
+    if (session->rx_cap - session->rx_len < HTTPD_RX_CHUNK_SIZE) {
+        size_t cap = session->rx_len + HTTPD_RX_CHUNK_SIZE;
+        uint8_t *rx = realloc(session->rx, cap);
+        if (rx == NULL) {
+            httpd_session_close(server, session);
+            return;
+        }
+        session->rx = rx;
+        session->rx_cap = cap;
+    }
+
+    ssize_t received = recv(session->fd, session->rx + session->rx_len, HTTPD_RX_CHUNK_SIZE, MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (received <= 0) {
+        httpd_session_close(server, session);
+        return;
+    }
+
+    session->rx_len += (size_t)received;
+    httpd_sock_process(server, session);
+}
+
+// =============================================================================
+// FRONT END API
+// =============================================================================
+
+void httpd_sock_process(httpd_server_t *server, httpd_session_t *session)
+{
+    int fd = session->fd;
+
+    while (session->used && session->fd == fd && !session->busy && session->rx_len > 0) {
+        bool progress = session->websocket ? process_websocket(server, session) : process_http(server, session);
+        if (!progress) {
+            break;
+        }
+    }
+}
+
+esp_err_t httpd_sock_listen(httpd_server_t *server, uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return ESP_ERR_HTTPD_TASK;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, server->config.backlog_conn) != 0) {
+        ESP_LOGE(TAG, "Cannot listen on port %u: %s", port, strerror(errno));
+        close(fd);
+        return ESP_ERR_HTTPD_TASK;
+    }
+
+    server->listen_fd = fd;
+    ESP_LOGI(TAG, "Listening on port %u", port);
+    return ESP_OK;
+}
+
+void httpd_sock_poll(httpd_server_t *server)
+{
+    int max_fds = 2 + server->config.max_open_sockets;
+    struct pollfd fds[max_fds];
+    httpd_session_t *polled[max_fds];
+    int count = 0;
+
+    fds[count++] = (struct pollfd){ .fd = server->wake_fd, .events = POLLIN };
+    if (server->listen_fd >= 0) {
+        fds[count++] = (struct pollfd){ .fd = server->listen_fd, .events = POLLIN };
+    }
+    int first_session = count;
+    for (int i = 0; i < server->config.max_open_sockets; i++) {
+        httpd_session_t *session = &server->sessions[i];
+        if (session->used && session->socket && !session->busy) {
+            polled[count] = session;
+            fds[count++] = (struct pollfd){ .fd = session->fd, .events = POLLIN };
+        }
+    }
+
+    if (poll(fds, (nfds_t)count, -1) <= 0) {
+        return;
+    }
+
+    if (fds[0].revents != 0) {
+        eventfd_t value;
+        eventfd_read(server->wake_fd, &value);
+    }
+    // Sessions first: an accept may purge one of them
+    for (int i = first_session; i < count; i++) {
+        httpd_session_t *session = polled[i];
+        if (fds[i].revents != 0 && session->used && session->fd == fds[i].fd && !session->busy) {
+            read_client(server, session);
+        }
+    }
+    if (server->listen_fd >= 0 && fds[1].revents != 0) {
+        accept_client(server);
+    }
+}
+
+esp_err_t httpd_sock_send_head(httpd_conn_t *conn, bool chunked, size_t content_len)
+{
+    const host_httpd_response_t *resp = conn->resp;
+    const char *headers = resp->headers != NULL ? resp->headers : "";
+    size_t size = 256 + strlen(headers);
+    char *head = malloc(size);
+    if (head == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+
+    int len;
+    if (chunked) {
+        len = snprintf(head, size, "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n%s\r\n",
+                       resp->status_line, resp->content_type, headers);
+    } else {
+        len = snprintf(head, size, "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+                       resp->status_line, resp->content_type, content_len, headers);
+    }
+
+    conn->head_sent = true;
+    esp_err_t ret = httpd_sock_write(conn->server, conn->session->fd, head, (size_t)len);
+    free(head);
+    return ret;
+}
+
+esp_err_t httpd_sock_write(httpd_server_t *server, int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    int timeout_ms = (int)server->config.send_wait_timeout * 1000;
+
+    while (len > 0) {
+        ssize_t sent = send(fd, p, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            p += sent;
+            len -= (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+    }
+    return ESP_OK;
+}
+
+int httpd_sock_recv_body(httpd_conn_t *conn, char *buf, size_t len)
+{
+    if (conn->session == NULL || !conn->session->socket) {
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+
+    struct pollfd pfd = { .fd = conn->session->fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, (int)conn->server->config.recv_wait_timeout * 1000);
+    if (ready == 0) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+
+    ssize_t received = ready > 0 ? recv(conn->session->fd, buf, len, MSG_DONTWAIT) : -1;
+    if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    return received > 0 ? (int)received : HTTPD_SOCK_ERR_FAIL;
+}
+
+esp_err_t httpd_sock_ws_send(httpd_server_t *server, int fd, httpd_ws_type_t type,
+                             const uint8_t *data, size_t len)
+{
+    uint8_t small[HTTPD_WS_HEADER_MAX + 1024];
+    uint8_t *frame = len <= sizeof(small) - HTTPD_WS_HEADER_MAX ? small : malloc(HTTPD_WS_HEADER_MAX + len);
+    if (frame == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t header_len = 2;
+    frame[0] = 0x80 | (uint8_t)type;   // FIN, never fragmented
+    if (len < 126) {
+        frame[1] = (uint8_t)len;
+    } else if (len <= 0xFFFF) {
+        frame[1] = 126;
+        frame[2] = (uint8_t)(len >> 8);
+        frame[3] = (uint8_t)len;
+        header_len = 4;
+    } else {
+        frame[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = (uint8_t)((uint64_t)len >> (56 - i * 8));
+        }
+        header_len = 10;
+    }
+    if (len > 0) {
+        memcpy(frame + header_len, data, len);
+    }
+
+    // One write, so the frame leaves in one segment
+    esp_err_t ret = httpd_sock_write(server, fd, frame, header_len + len);
+    if (frame != small) {
+        free(frame);
+    }
+    return ret == ESP_OK ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,17 @@
+/**
+ * @file index_html.c
+ * @brief main/wwwroot/index.html under the symbols EMBED_FILES gives it
+ *
+ * INDEX_HTML_PATH is set by host/CMakeLists.txt.
+ */
+
+__asm__(
+    ".section .rodata\n"
+    ".global _binary_index_html_start\n"
+    ".global _binary_index_html_end\n"
+    "_binary_index_html_start:\n"
+    ".incbin \"" INDEX_HTML_PATH "\"\n"
+    "_binary_index_html_end:\n"
+    ".byte 0\n"
+    ".previous\n"
+);
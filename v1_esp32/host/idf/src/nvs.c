@@ -0,0 +1,228 @@
+/**
+ * @file nvs.c
+ * @brief NVS blobs kept in memory for the life of the process
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define NVS_KEY_NAME_MAX_SIZE       16
+#define NVS_MAX_HANDLES             8
+
+typedef struct nvs_entry {
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    void *value;
+    size_t length;
+    struct nvs_entry *next;
+} nvs_entry_t;
+
+typedef struct {
+    bool open;
+    bool writable;
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+} nvs_handle_state_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool nvs_initialized = false;
+static nvs_entry_t *entries = NULL;
+static nvs_handle_state_t handles[NVS_MAX_HANDLES];    // nvs_handle_t is the index + 1
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static nvs_handle_state_t *handle_get_locked(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_MAX_HANDLES || !handles[handle - 1].open) {
+        return NULL;
+    }
+    return &handles[handle - 1];
+}
+
+static nvs_entry_t **entry_find_locked(const char *namespace_name, const char *key)
+{
+    nvs_entry_t **link = &entries;
+    while (*link != NULL) {
+        if (strcmp((*link)->namespace_name, namespace_name) == 0 && strcmp((*link)->key, key) == 0) {
+            break;
+        }
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t nvs_flash_init(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_initialized = true;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    while (entries != NULL) {
+        nvs_entry_t *entry = entries;
+        entries = entry->next;
+        free(entry->value);
+        free(entry);
+    }
+    nvs_initialized = false;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (namespace_name == NULL || out_handle == NULL || strlen(namespace_name) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&nvs_lock);
+    if (!nvs_initialized) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+        if (!handles[i].open) {
+            handles[i].open = true;
+            handles[i].writable = (open_mode == NVS_READWRITE);
+            snprintf(handles[i].namespace_name, sizeof(handles[i].namespace_name), "%s", namespace_name);
+            *out_handle = (nvs_handle_t)(i + 1);
+            pthread_mutex_unlock(&nvs_lock);
+            return ESP_OK;
+        }
+    }
+
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_handle_state_t *state = handle_get_locked(handle);
+    if (state != NULL) {
+        state->open = false;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    if (key == NULL || length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_handle_state_t *state = handle_get_locked(handle);
+    if (state == NULL) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    nvs_entry_t *entry = *entry_find_locked(state->namespace_name, key);
+    if (entry == NULL) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // NULL out_value asks for the length only
+    esp_err_t ret = ESP_OK;
+    if (out_value != NULL) {
+        if (*length < entry->length) {
+            ret = ESP_ERR_NVS_INVALID_LENGTH;
+        } else {
+            memcpy(out_value, entry->value, entry->length);
+        }
+    }
+    *length = entry->length;
+
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (key == NULL || (value == NULL && length > 0) || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    void *copy = malloc(length > 0 ? length : 1);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, length);
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_handle_state_t *state = handle_get_locked(handle);
+    if (state == NULL || !state->writable) {
+        pthread_mutex_unlock(&nvs_lock);
+        free(copy);
+        return state == NULL ? ESP_ERR_NVS_INVALID_HANDLE : ESP_ERR_NVS_READ_ONLY;
+    }
+
+    nvs_entry_t *entry = *entry_find_locked(state->namespace_name, key);
+    if (entry == NULL) {
+        entry = calloc(1, sizeof(*entry));
+        if (entry == NULL) {
+            pthread_mutex_unlock(&nvs_lock);
+            free(copy);
+            return ESP_ERR_NO_MEM;
+        }
+        snprintf(entry->namespace_name, sizeof(entry->namespace_name), "%s", state->namespace_name);
+        snprintf(entry->key, sizeof(entry->key), "%s", key);
+        entry->next = entries;
+        entries = entry;
+    }
+    free(entry->value);
+    entry->value = copy;
+    entry->length = length;
+
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_handle_state_t *state = handle_get_locked(handle);
+    if (state == NULL) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    nvs_entry_t **link = entry_find_locked(state->namespace_name, key);
+    nvs_entry_t *entry = *link;
+    if (entry == NULL) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *link = entry->next;
+    free(entry->value);
+    free(entry);
+
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t ret = handle_get_locked(handle) != NULL ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file rc_sim.c
+ * @brief The firmware as a Linux process, serving the web UI and /ws
+ *
+ * Starts the same modules as app_main(), with http_server_start() called
+ * directly instead of from the Wi-Fi handler in net.c. The stand-in httpd
+ * listens on a TCP port, so a browser, the web UI or a load tool talk to
+ * the real handlers, rcp_protocol.c dispatch and motor/servo math, while
+ * the actuators are the recording stand-ins of host_hal.h.
+ *
+ * Build and run from v1_esp32/host:
+ *   cmake -S . -B build && cmake --build build -j
+ *   ./build/rc_sim -p 8080                     (embedded main/wwwroot page)
+ *   ./build/rc_sim -p 8080 -w ../dev_html      (dev page, set DEBUG = true in script.js)
+ *
+ * An OTA restart exits with HOST_RESTART_EXIT_CODE, so a shell loop can
+ * start the process again.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_hal.h"
+#include "host_httpd.h"
+#include "project_config.h"
+#include "config.h"
+#include "http_server.h"
+#include "ota.h"
+#include "dlog.h"
+
+#if ENABLE_LOG_STREAM
+#include "log_stream.h"
+#endif
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+#include "battery_monitor.h"
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#endif
+
+#if ENABLE_TELEMETRY
+#include "telemetry.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#if ENABLE_TASK_STATS
+#include "task_stats.h"
+#endif
+
+#define SIM_DEFAULT_PORT            8080    // Port 80 of the firmware config needs root
+#define SIM_DEFAULT_BATTERY_MV      3900
+
+static const char *TAG = "rc_sim";
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-p port] [-w www_dir] [-b battery_mv]\n"
+            "  -p port        TCP port of the web server (default %d)\n"
+            "  -w www_dir     Serve files from www_dir ahead of the handlers, e.g. ../dev_html\n"
+            "  -b battery_mv  Simulated battery voltage in mV (default %d)\n",
+            program, SIM_DEFAULT_PORT, SIM_DEFAULT_BATTERY_MV);
+}
+
+int main(int argc, char **argv)
+{
+    int port = SIM_DEFAULT_PORT;
+    int battery_mv = SIM_DEFAULT_BATTERY_MV;
+    const char *www_dir = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:w:b:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'w':
+                www_dir = optarg;
+                break;
+            case 'b':
+                battery_mv = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (port <= 0 || port > 65535) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Logs reach a pipe or file line by line, as on the UART
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+#if ENABLE_BATTERY_MONITORING
+    // The divider of battery_monitor.h between the battery and the ADC pin
+    host_hal_set_adc_mv(BATTERY_ADC_CHANNEL,
+                        (int)((int64_t)battery_mv * BATTERY_RESISTOR_R2 / (BATTERY_RESISTOR_R1 + BATTERY_RESISTOR_R2)));
+#endif
+
+    host_httpd_set_listen_port((uint16_t)port);
+    host_httpd_set_www_root(www_dir);
+
+#if ENABLE_DLOG
+    dlog_start();
+#endif
+
+#if ENABLE_LOG_STREAM
+    log_stream_init();
+#endif
+
+    config_init();
+
+#if ENABLE_LED_CONTROL
+    led_control_init();
+#endif
+
+#if ENABLE_SERVO_CONTROL
+    servo_control_init();
+#endif
+
+#if ENABLE_BATTERY_MONITORING
+    battery_monitor_init();
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+    motor_control_init();
+#endif
+
+#if ENABLE_OTA_UPDATES
+    ota_init();
+#endif
+
+#if ENABLE_CONTROL_TASK
+    control_task_start();
+#endif
+
+    // What net.c does once the station got an IP
+    http_server_start();
+
+#if ENABLE_BATTERY_MONITORING
+    battery_monitor_start_task();
+#endif
+
+#if ENABLE_TELEMETRY
+    telemetry_start_task();
+#endif
+
+#if ENABLE_TASK_STATS
+    task_stats_start();
+#endif
+
+    ESP_LOGI(TAG, "Open http://localhost:%d/", port);
+
+    // The tasks do the work, as after app_main() returns
+    for (;;) {
+        vTaskDelay(portMAX_DELAY);
+    }
+}
@@ -0,0 +1,23 @@
+# Fails when main/wwwroot/index.html was not rebuilt after a dev_html change
+#
+#   cmake -DDEV_HTML=<dev_html dir> -DBUNDLE=<index.html> -P check_bundle.cmake
+#
+# dev_html/prod.js appends <!--dev_html:DIGEST--> to the bundle, DIGEST being
+# the SHA-256 of the concatenated SHA-256 hex digests of its sources.
+
+set(digests "")
+foreach(source index.html script.js style.css)
+    file(SHA256 ${DEV_HTML}/${source} source_digest)
+    string(APPEND digests ${source_digest})
+endforeach()
+string(SHA256 expected "${digests}")
+
+file(READ ${BUNDLE} bundle)
+string(REGEX MATCH "<!--dev_html:([0-9a-f]+)-->$" stamp "${bundle}")
+if(NOT stamp)
+    message(FATAL_ERROR "${BUNDLE} has no dev_html stamp, run `npm run prod` in dev_html")
+endif()
+if(NOT CMAKE_MATCH_1 STREQUAL expected)
+    message(FATAL_ERROR "${BUNDLE} is stale (stamp ${CMAKE_MATCH_1}, dev_html ${expected}), run `npm run prod` in dev_html")
+endif()
+message(STATUS "UI bundle matches dev_html")
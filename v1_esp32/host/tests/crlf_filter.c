@@ -0,0 +1,23 @@
+/**
+ * @file crlf_filter.c
+ * @brief Copy stdin to stdout with every \n written as \r\n
+ *
+ * Does to a byte stream what CONFIG_LIBC_STDOUT_LINE_ENDING_CRLF does to
+ * the firmware console, for dlog_roundtrip.cmake.
+ */
+
+#include <stdio.h>
+
+int main(void)
+{
+    int c;
+
+    while ((c = getchar()) != EOF) {
+        if (c == '\n') {
+            putchar('\r');
+        }
+        putchar(c);
+    }
+
+    return 0;
+}
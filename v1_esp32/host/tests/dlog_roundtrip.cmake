@@ -0,0 +1,73 @@
+# Decoding the binary dlog output must give the text output of the firmware
+#
+#   cmake -DEMIT_TEXT=<dlog_emit_text> -DEMIT_BINARY=<dlog_emit_binary>
+#         -DDECODE=<dlog_decode> -DCRLF_FILTER=<crlf_filter>
+#         -P dlog_roundtrip.cmake
+
+execute_process(COMMAND ${EMIT_TEXT}
+    OUTPUT_VARIABLE text
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${EMIT_TEXT} exited with ${result}")
+endif()
+
+execute_process(COMMAND ${EMIT_BINARY}
+    COMMAND ${DECODE}
+    OUTPUT_VARIABLE decoded
+    RESULTS_VARIABLE results)
+if(NOT results STREQUAL "0;0")
+    message(FATAL_ERROR "${EMIT_BINARY} | ${DECODE} exited with ${results}")
+endif()
+
+# Same capture after the console's \n -> \r\n conversion: frames hold
+# 0x0A bytes in IDs and arguments and must come through intact
+execute_process(COMMAND ${EMIT_BINARY}
+    COMMAND ${CRLF_FILTER}
+    COMMAND ${DECODE}
+    OUTPUT_VARIABLE decoded_crlf
+    ERROR_VARIABLE decode_summary
+    RESULTS_VARIABLE results)
+if(NOT results STREQUAL "0;0;0")
+    message(FATAL_ERROR "${EMIT_BINARY} | ${CRLF_FILTER} | ${DECODE} exited with ${results}")
+endif()
+if(NOT decode_summary MATCHES ", 0 bad")
+    message(FATAL_ERROR "Frames lost to the CRLF conversion: ${decode_summary}")
+endif()
+string(REPLACE "\r\n" "\n" decoded_crlf "${decoded_crlf}")
+
+# Timestamps differ between the runs
+string(REGEX REPLACE "\\(([0-9]+)\\)" "(T)" text "${text}")
+string(REGEX REPLACE "\\(([0-9]+)\\)" "(T)" decoded "${decoded}")
+string(REGEX REPLACE "\\(([0-9]+)\\)" "(T)" decoded_crlf "${decoded_crlf}")
+
+if(NOT decoded STREQUAL text)
+    message(FATAL_ERROR "Decoded binary output differs from the text output\n"
+                        "--- text\n${text}--- decoded\n${decoded}")
+endif()
+if(NOT decoded_crlf STREQUAL text)
+    message(FATAL_ERROR "Decoded CRLF capture differs from the text output\n"
+                        "--- text\n${text}--- decoded\n${decoded_crlf}")
+endif()
+
+# Signed values and the ON/OFF and HIGH/LOW states read as the ESP_LOGx
+# lines they replaced
+set(expected
+    "I \\(T\\) rcp_protocol: RCP: Motor speed set to -7\n"
+    "I \\(T\\) rcp_protocol: RCP: Motor speed set to 10\n"
+    "I \\(T\\) rcp_protocol: RCP: Horn ON\n"
+    "I \\(T\\) rcp_protocol: RCP: Horn OFF\n"
+    "I \\(T\\) led_control: Light LED ON\n"
+    "I \\(T\\) led_control: Light LED OFF\n"
+    "D \\(T\\) drv8833: Brake mode: IN1=HIGH, IN2=HIGH\n"
+    "D \\(T\\) drv8833: Free mode: IN1=LOW, IN2=LOW\n"
+    "D \\(T\\) rcp_protocol: RCP: Drive seq=42 speed=-7 steering=1 flags=0x00\n"
+    "D \\(T\\) rcp_protocol: RCP: Drive seq=4294967289 speed=42 steering=0 flags=0x01\n")
+foreach(line ${expected})
+    if(NOT decoded MATCHES "${line}")
+        message(FATAL_ERROR "Decoded output lacks \"${line}\":\n${decoded}")
+    endif()
+endforeach()
+
+string(REGEX MATCHALL "\n" lines "${decoded}")
+list(LENGTH lines line_count)
+message(STATUS "dlog round trip: ${line_count} lines match")
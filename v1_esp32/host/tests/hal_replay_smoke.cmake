@@ -0,0 +1,30 @@
+# Replays tests/frames.txt through hal_replay and checks the recorded outputs
+#
+#   cmake -DHAL_REPLAY=<hal_replay> -DFRAMES=<frames.txt> -P hal_replay_smoke.cmake
+
+execute_process(COMMAND ${HAL_REPLAY}
+    INPUT_FILE ${FRAMES}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "hal_replay exited with ${result}:\n${output}")
+endif()
+
+# Motor 50, servo -30, light and horn on (active low), then a full reverse
+# drive frame that centers the servo and turns both LEDs off
+set(expected
+    "ledc_duty +unit=2 +gpio=16 value=511"
+    "ledc_duty +unit=1 +gpio=4 +value=552"
+    "gpio_level +unit=2 +gpio=2 +value=0"
+    "gpio_level +unit=14 gpio=14 value=0"
+    "ledc_duty +unit=1 +gpio=4 +value=614"
+    "ledc_duty +unit=3 +gpio=17 value=1023"
+    "gpio_level +unit=2 +gpio=2 +value=1"
+    "gpio_level +unit=14 gpio=14 value=1")
+foreach(line ${expected})
+    if(NOT output MATCHES "${line}")
+        message(FATAL_ERROR "hal_replay output lacks \"${line}\":\n${output}")
+    endif()
+endforeach()
+message(STATUS "hal_replay: ${FRAMES} replayed")
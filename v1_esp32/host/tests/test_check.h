@@ -0,0 +1,32 @@
+/**
+ * @file test_check.h
+ * @brief Minimal assertions for the host tests run by ctest
+ *
+ * A failed CHECK prints the location and counts the failure; the test
+ * returns TEST_RESULT() from main() so ctest sees a nonzero exit code.
+ */
+#pragma once
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do {                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ_INT(actual, expected) do {                                     \
+        long long check_a_ = (long long)(actual);                               \
+        long long check_e_ = (long long)(expected);                             \
+        if (check_a_ != check_e_) {                                             \
+            fprintf(stderr, "%s:%d: CHECK failed: %s == %lld, expected %lld\n", \
+                    __FILE__, __LINE__, #actual, check_a_, check_e_);           \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define TEST_RESULT(name) (printf("%s: %s\n", (name), test_failures == 0 ? "PASS" : "FAIL"), \
+                           test_failures == 0 ? 0 : 1)
@@ -0,0 +1,132 @@
+/**
+ * @file test_failsafe_keepalive.c
+ * @brief The UI keepalive holds off the link-loss failsafe, silence trips it
+ *
+ * Repeats an unchanged drive frame every COMMAND_KEEPALIVE_MS, as the web
+ * UI does while the throttle is held steady, and checks that the motor
+ * keeps running. Then stops sending and checks that the failsafe brakes
+ * within a few control ticks, that a light frame releases it without
+ * bringing back the old speed, and that a drive frame resumes motion.
+ */
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_hal.h"
+#include "host_httpd.h"
+#include "project_config.h"
+#include "config.h"
+#include "http_server.h"
+#include "rcp_protocol.h"
+#include "control_task.h"
+#include "motor_control.h"
+#include "test_check.h"
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#define COMMAND_KEEPALIVE_MS    50      // dev_html/script.js
+#define HOLD_MS                 1000    // Steady throttle before going silent
+#define DRIVE_SPEED             40
+
+static esp_err_t send_drive(httpd_handle_t server, int fd, uint16_t sequence)
+{
+    uint8_t frame[RCP_HEADER_SIZE + sizeof(rcp_drive_body_t)];
+    rcp_drive_body_t drive = {
+        .speed = DRIVE_SPEED,
+        .steering = 0,
+        .flags = 0,
+        .sequence = sequence,
+    };
+
+    frame[2] = RCP_PORT_DRIVE;
+    memcpy(frame + RCP_HEADER_SIZE, &drive, sizeof(drive));
+    RCP_SET_LENGTH(frame, sizeof(drive));
+    return host_httpd_ws_send(server, fd, HTTPD_WS_TYPE_BINARY, frame, sizeof(frame));
+}
+
+static esp_err_t send_light(httpd_handle_t server, int fd, bool state)
+{
+    uint8_t frame[RCP_HEADER_SIZE + 1];
+
+    frame[2] = RCP_PORT_LIGHT;
+    frame[3] = state ? 1 : 0;
+    RCP_SET_LENGTH(frame, 1);
+    return host_httpd_ws_send(server, fd, HTTPD_WS_TYPE_BINARY, frame, sizeof(frame));
+}
+
+static int motor_speed(void)
+{
+    motor_state_t state = { 0 };
+    motor_control_get_state(&state);
+    return state.speed;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    host_hal_set_recording(false);
+
+    config_init();
+#if ENABLE_LED_CONTROL
+    led_control_init();
+#endif
+#if ENABLE_SERVO_CONTROL
+    servo_control_init();
+#endif
+    motor_control_init();
+    control_task_start();
+    http_server_start();
+
+    httpd_handle_t server = http_server_get_handle();
+    CHECK(server != NULL);
+    if (server == NULL) {
+        return TEST_RESULT("test_failsafe_keepalive");
+    }
+
+    int fd = -1;
+    CHECK_EQ_INT(host_httpd_ws_open(server, "/ws", &fd), ESP_OK);
+
+    // Steady throttle: the UI repeats the unchanged drive state
+    uint16_t sequence = 0;
+    for (int elapsed_ms = 0; elapsed_ms < HOLD_MS; elapsed_ms += COMMAND_KEEPALIVE_MS) {
+        CHECK_EQ_INT(send_drive(server, fd, sequence++), ESP_OK);
+        vTaskDelay(pdMS_TO_TICKS(COMMAND_KEEPALIVE_MS));
+    }
+
+    control_stats_t stats;
+    control_get_stats(&stats);
+    CHECK_EQ_INT(stats.failsafe_trips, 0);
+    CHECK(!control_failsafe_active());
+    CHECK_EQ_INT(motor_speed(), DRIVE_SPEED);
+
+    // Link loss
+    vTaskDelay(pdMS_TO_TICKS(CONTROL_FAILSAFE_TIMEOUT_MS * 3));
+
+    control_get_stats(&stats);
+    CHECK_EQ_INT(stats.failsafe_trips, 1);
+    CHECK(control_failsafe_active());
+    CHECK_EQ_INT(motor_speed(), 0);
+
+    // A light frame proves the link is back but must not restore the old throttle
+    CHECK_EQ_INT(send_light(server, fd, true), ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(COMMAND_KEEPALIVE_MS));
+    CHECK(!control_failsafe_active());
+    CHECK_EQ_INT(motor_speed(), 0);
+
+    // A fresh drive frame resumes driving
+    CHECK_EQ_INT(send_drive(server, fd, sequence++), ESP_OK);
+    vTaskDelay(pdMS_TO_TICKS(COMMAND_KEEPALIVE_MS));
+    CHECK(!control_failsafe_active());
+    CHECK_EQ_INT(motor_speed(), DRIVE_SPEED);
+
+    host_httpd_close(server, fd);
+    return TEST_RESULT("test_failsafe_keepalive");
+}
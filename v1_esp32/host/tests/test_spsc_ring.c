@@ -0,0 +1,121 @@
+/**
+ * @file test_spsc_ring.c
+ * @brief Single-threaded checks of the SPSC ring bookkeeping
+ *
+ * Covers the power-of-two capacity rule, the full and empty conditions,
+ * FIFO order across the storage wrap, and head/tail wrapping at 2^32.
+ * Cross-thread throughput is measured by bench_spsc.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "spsc_ring.h"
+#include "test_check.h"
+
+#define RING_CAPACITY   8
+
+SPSC_RING_DEFINE(static_ring, uint32_t, RING_CAPACITY);
+
+static void test_capacity(void)
+{
+    uint32_t storage[16];
+    spsc_ring_t ring;
+
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(uint32_t), 0));
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(uint32_t), 3));
+    CHECK(!spsc_ring_init(&ring, storage, sizeof(uint32_t), 12));
+    CHECK(spsc_ring_init(&ring, storage, sizeof(uint32_t), 1));
+    CHECK_EQ_INT(spsc_ring_capacity(&ring), 1);
+    CHECK(spsc_ring_init(&ring, storage, sizeof(uint32_t), 16));
+    CHECK_EQ_INT(spsc_ring_capacity(&ring), 16);
+
+    CHECK_EQ_INT(spsc_ring_capacity(&static_ring), RING_CAPACITY);
+}
+
+static void test_full_empty(void)
+{
+    uint32_t value = 0;
+
+    CHECK_EQ_INT(spsc_ring_count(&static_ring), 0);
+    CHECK(!spsc_ring_pop(&static_ring, &value));
+
+    for (uint32_t i = 0; i < RING_CAPACITY; i++) {
+        CHECK(spsc_ring_push(&static_ring, &i));
+    }
+    CHECK_EQ_INT(spsc_ring_count(&static_ring), RING_CAPACITY);
+
+    uint32_t extra = 99;
+    CHECK(!spsc_ring_push(&static_ring, &extra));
+
+    for (uint32_t i = 0; i < RING_CAPACITY; i++) {
+        CHECK(spsc_ring_pop(&static_ring, &value));
+        CHECK_EQ_INT(value, i);
+    }
+    CHECK_EQ_INT(spsc_ring_count(&static_ring), 0);
+    CHECK(!spsc_ring_pop(&static_ring, &value));
+}
+
+/**
+ * @brief Push and pop in uneven steps so reads and writes cross the end of storage
+ */
+static void test_storage_wrap(void)
+{
+    uint32_t storage[RING_CAPACITY];
+    spsc_ring_t ring;
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    uint32_t value;
+
+    CHECK(spsc_ring_init(&ring, storage, sizeof(uint32_t), RING_CAPACITY));
+
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 5; i++) {
+            CHECK(spsc_ring_push(&ring, &next_push));
+            next_push++;
+        }
+        for (int i = 0; i < 5; i++) {
+            CHECK(spsc_ring_pop(&ring, &value));
+            CHECK_EQ_INT(value, next_pop);
+            next_pop++;
+        }
+    }
+    CHECK_EQ_INT(spsc_ring_count(&ring), 0);
+}
+
+/**
+ * @brief Start the free-running indices just below 2^32
+ */
+static void test_index_wrap(void)
+{
+    uint32_t storage[RING_CAPACITY];
+    spsc_ring_t ring;
+    uint32_t value;
+
+    CHECK(spsc_ring_init(&ring, storage, sizeof(uint32_t), RING_CAPACITY));
+    atomic_store(&ring.head, UINT_MAX - 2);
+    atomic_store(&ring.tail, UINT_MAX - 2);
+
+    for (uint32_t i = 0; i < RING_CAPACITY; i++) {
+        CHECK(spsc_ring_push(&ring, &i));
+    }
+    CHECK_EQ_INT(spsc_ring_count(&ring), RING_CAPACITY);
+    CHECK(!spsc_ring_push(&ring, &value));
+
+    for (uint32_t i = 0; i < RING_CAPACITY; i++) {
+        CHECK(spsc_ring_pop(&ring, &value));
+        CHECK_EQ_INT(value, i);
+    }
+    CHECK_EQ_INT(spsc_ring_count(&ring), 0);
+    CHECK(!spsc_ring_pop(&ring, &value));
+}
+
+int main(void)
+{
+    test_capacity();
+    test_full_empty();
+    test_storage_wrap();
+    test_index_wrap();
+
+    return TEST_RESULT("test_spsc_ring");
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_ws_rx_alloc.c
+ * @brief The steady-state WebSocket receive path does not allocate
+ *
+ * Interposes malloc/calloc/realloc/free, opens a /ws session through
+ * host_httpd.h and delivers control frames to ws_handler(). Allocations
+ * made on the httpd task while the frames are handled are counted; the
+ * receive buffer, the RCP decode and the control hand-off must not add
+ * any once the session is set up.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "host_hal.h"
+#include "host_httpd.h"
+#include "project_config.h"
+#include "config.h"
+#include "http_server.h"
+#include "rcp_protocol.h"
+#include "test_check.h"
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#define FRAMES_WARMUP       64
+#define FRAMES_COUNTED      1000
+
+// =============================================================================
+// ALLOCATION COUNTING
+// =============================================================================
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static atomic_bool counting = false;
+static pthread_t counted_thread;
+static atomic_int allocations = 0;
+
+static void count_allocation(void)
+{
+    if (atomic_load(&counting) && pthread_equal(pthread_self(), counted_thread)) {
+        atomic_fetch_add(&allocations, 1);
+    }
+}
+
+void *malloc(size_t size)
+{
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    count_allocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+// =============================================================================
+// TEST
+// =============================================================================
+
+static void record_httpd_thread(void *arg)
+{
+    counted_thread = pthread_self();
+    xSemaphoreGive((SemaphoreHandle_t)arg);
+}
+
+static size_t make_frame(uint8_t *frame, uint32_t i)
+{
+    int8_t value = (int8_t)(i % 201 - 100);
+
+    switch (i % 4) {
+        case 0:
+            frame[2] = RCP_PORT_MOTOR;
+            frame[3] = (uint8_t)value;
+            RCP_SET_LENGTH(frame, 1);
+            return RCP_HEADER_SIZE + 1;
+        case 1:
+            frame[2] = RCP_PORT_SERVO;
+            frame[3] = (uint8_t)value;
+            RCP_SET_LENGTH(frame, 1);
+            return RCP_HEADER_SIZE + 1;
+        case 2: {
+            rcp_drive_body_t drive = {
+                .speed = value,
+                .steering = (int8_t)-value,
+                .flags = 0,
+                .sequence = (uint16_t)i,
+            };
+            frame[2] = RCP_PORT_DRIVE;
+            memcpy(frame + RCP_HEADER_SIZE, &drive, sizeof(drive));
+            RCP_SET_LENGTH(frame, sizeof(drive));
+            return RCP_HEADER_SIZE + sizeof(drive);
+        }
+        default: {
+            const uint8_t batch[] = {
+                RCP_PORT_MOTOR, 1, (uint8_t)value,
+                RCP_PORT_SERVO, 1, (uint8_t)-value,
+            };
+            frame[2] = RCP_PORT_BATCH;
+            memcpy(frame + RCP_HEADER_SIZE, batch, sizeof(batch));
+            RCP_SET_LENGTH(frame, sizeof(batch));
+            return RCP_HEADER_SIZE + sizeof(batch);
+        }
+    }
+}
+
+static int send_frames(httpd_handle_t server, int fd, uint32_t first, uint32_t count)
+{
+    uint8_t frame[RCP_HEADER_SIZE + 16];
+    int failed = 0;
+
+    for (uint32_t i = first; i < first + count; i++) {
+        size_t len = make_frame(frame, i);
+        if (host_httpd_ws_send(server, fd, HTTPD_WS_TYPE_BINARY, frame, len) != ESP_OK) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    host_hal_set_recording(false);
+
+    config_init();
+#if ENABLE_LED_CONTROL
+    led_control_init();
+#endif
+#if ENABLE_SERVO_CONTROL
+    servo_control_init();
+#endif
+#if ENABLE_MOTOR_CONTROL
+    motor_control_init();
+#endif
+#if ENABLE_CONTROL_TASK
+    control_task_start();
+#endif
+    http_server_start();
+
+    httpd_handle_t server = http_server_get_handle();
+    CHECK(server != NULL);
+    if (server == NULL) {
+        return TEST_RESULT("test_ws_rx_alloc");
+    }
+
+    int fd = -1;
+    CHECK_EQ_INT(host_httpd_ws_open(server, "/ws", &fd), ESP_OK);
+
+    // Lazy setup (stdio buffers, first log lines) happens here
+    CHECK_EQ_INT(send_frames(server, fd, 0, FRAMES_WARMUP), 0);
+
+    SemaphoreHandle_t recorded = xSemaphoreCreateBinary();
+    CHECK_EQ_INT(httpd_queue_work(server, record_httpd_thread, recorded), ESP_OK);
+    xSemaphoreTake(recorded, portMAX_DELAY);
+    vSemaphoreDelete(recorded);
+
+    atomic_store(&counting, true);
+    int failed = send_frames(server, fd, FRAMES_WARMUP, FRAMES_COUNTED);
+    atomic_store(&counting, false);
+
+    CHECK_EQ_INT(failed, 0);
+    CHECK_EQ_INT(atomic_load(&allocations), 0);
+    printf("%d control frames, %d allocations on the httpd task\n", FRAMES_COUNTED, atomic_load(&allocations));
+
+    host_httpd_close(server, fd);
+    return TEST_RESULT("test_ws_rx_alloc");
+}
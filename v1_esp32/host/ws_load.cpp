@@ -0,0 +1,903 @@
+/**
+ * @file ws_load.cpp
+ * @brief Multi-client WebSocket load generator for /ws
+ *
+ * Opens N WebSocket connections to rc_sim or a board and has each one send
+ * RCP drive frames at a fixed rate, as N phones holding the sticks. Every
+ * client also sends timestamped pings and may subscribe to telemetry;
+ * pongs, telemetry and battery frames are timestamped on arrival.
+ *
+ * Reported per client and in total:
+ *   - ping RTT p50/p99/p999 and the device time between receive and reply
+ *   - telemetry and battery inter-arrival gaps, telemetry frames with the
+ *     failsafe flag set (the control task saw no fresh setpoint)
+ *   - drop rate: pings without pong, telemetry frames short of the rate
+ *   - sent and received frames per second, send slots missed
+ *
+ * Results go to stdout (or -o file) as one JSON document, the same way as
+ * bench_rcp; a summary goes to stderr.
+ *
+ * Build and run from v1_esp32/host:
+ *   cmake -S . -B build && cmake --build build -j
+ *   ./build/rc_sim -p 8080 &
+ *   ./build/ws_load -c 5 -r 100 -d 10               (5 clients at 100 Hz)
+ *   ./build/ws_load -H 192.168.4.1 -p 80 -c 3 -m 1  (board, 2 drivers and a dashboard)
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcp_protocol.h"
+#include "telemetry.h"
+#include "ws_clients.h"
+
+#define LOAD_DEFAULT_HOST           "127.0.0.1"
+#define LOAD_DEFAULT_PORT           8080        // rc_sim default, 80 on the board
+#define LOAD_DEFAULT_PATH           "/ws"
+#define LOAD_DEFAULT_CLIENTS        1
+#define LOAD_DEFAULT_RATE_HZ        100
+#define LOAD_DEFAULT_PING_HZ        10
+#define LOAD_DEFAULT_TELEMETRY_HZ   20
+#define LOAD_DEFAULT_DURATION_S     10
+#define LOAD_GRACE_MS               500         // Replies still accepted after the last send
+#define LOAD_HANDSHAKE_TIMEOUT_MS   3000
+#define LOAD_MAX_WS_FRAME           65536
+
+#define WS_OPCODE_CONTINUATION      0x0
+#define WS_OPCODE_BINARY            0x2
+#define WS_OPCODE_CLOSE             0x8
+#define WS_OPCODE_PING              0x9
+#define WS_OPCODE_PONG              0xA
+
+using load_clock = std::chrono::steady_clock;
+
+typedef struct {
+    std::string host;
+    int port;
+    std::string path;
+    int clients;
+    int monitors;                   // Clients with RCP_ROLE_MONITOR, no control frames
+    int rate_hz;
+    int ping_hz;
+    int telemetry_hz;               // 0 = no subscription
+    int duration_s;
+} load_config_t;
+
+typedef struct {
+    int index;
+    bool monitor;
+    bool connected;
+    bool closed_by_server;
+    std::string error;
+
+    uint64_t control_sent;
+    uint64_t slots_missed;          // Send ticks skipped because the loop ran late
+    uint64_t pings_sent;
+    uint64_t pongs;
+    uint64_t pongs_late;            // Pong matching no pending ping, its id was reused
+    uint64_t telemetry;
+    uint64_t telemetry_expected;
+    uint64_t telemetry_failsafe;
+    uint64_t battery;
+    uint64_t other_frames;
+    uint64_t server_pings;          // WebSocket heartbeat pings answered
+    uint64_t frames_tx;
+    uint64_t frames_rx;
+    uint64_t bytes_tx;
+    uint64_t bytes_rx;
+
+    std::vector<uint32_t> rtt_us;
+    std::vector<uint32_t> device_us;
+    std::vector<uint32_t> telemetry_gap_us;
+    std::vector<uint32_t> battery_gap_us;
+} load_client_t;
+
+static load_config_t config = {
+    LOAD_DEFAULT_HOST, LOAD_DEFAULT_PORT, LOAD_DEFAULT_PATH, LOAD_DEFAULT_CLIENTS, 0,
+    LOAD_DEFAULT_RATE_HZ, LOAD_DEFAULT_PING_HZ, LOAD_DEFAULT_TELEMETRY_HZ, LOAD_DEFAULT_DURATION_S,
+};
+
+static load_clock::time_point run_epoch;
+
+// Microseconds since start, the client_time_us of the pings
+static uint32_t now_us(void)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(load_clock::now() - run_epoch).count();
+}
+
+// =============================================================================
+// WEBSOCKET CLIENT
+// =============================================================================
+
+class ws_connection {
+public:
+    explicit ws_connection(uint32_t seed) : mask_state(seed | 1) {}
+
+    ~ws_connection()
+    {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool open(const load_config_t &cfg, std::string &error)
+    {
+        struct addrinfo hints = {};
+        struct addrinfo *res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        std::string port = std::to_string(cfg.port);
+        int gai = getaddrinfo(cfg.host.c_str(), port.c_str(), &hints, &res);
+        if (gai != 0) {
+            error = gai_strerror(gai);
+            return false;
+        }
+        for (struct addrinfo *ai = res; ai != nullptr && fd < 0; ai = ai->ai_next) {
+            fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(res);
+        if (fd < 0) {
+            error = std::string("connect: ") + strerror(errno);
+            return false;
+        }
+
+        // Small frames at a fixed rate, as the web UI sends them
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        return handshake(cfg, error);
+    }
+
+    /**
+     * @brief Send one masked client frame
+     */
+    bool send_frame(uint8_t opcode, const uint8_t *data, size_t len)
+    {
+        uint8_t frame[14 + 256];
+        if (len > 256) {
+            return false;
+        }
+
+        size_t pos = 0;
+        frame[pos++] = (uint8_t)(0x80 | opcode);
+        if (len < 126) {
+            frame[pos++] = (uint8_t)(0x80 | len);
+        } else {
+            frame[pos++] = 0x80 | 126;
+            frame[pos++] = (uint8_t)(len >> 8);
+            frame[pos++] = (uint8_t)len;
+        }
+
+        uint32_t mask = next_mask();
+        uint8_t key[4] = { (uint8_t)mask, (uint8_t)(mask >> 8), (uint8_t)(mask >> 16), (uint8_t)(mask >> 24) };
+        memcpy(frame + pos, key, 4);
+        pos += 4;
+        for (size_t i = 0; i < len; i++) {
+            frame[pos++] = data[i] ^ key[i & 3];
+        }
+
+        return write_all(frame, pos);
+    }
+
+    /**
+     * @brief Wait up to @p timeout_ms for data and append it to the buffer
+     *
+     * @return false when the connection is gone
+     */
+    bool receive(int timeout_ms, uint64_t &bytes_rx)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready <= 0) {
+            return ready == 0 || errno == EINTR;
+        }
+
+        uint8_t buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        rx.insert(rx.end(), buf, buf + n);
+        bytes_rx += (uint64_t)n;
+        return true;
+    }
+
+    /**
+     * @brief Take the next complete server frame out of the buffer
+     *
+     * @return 1 with a frame, 0 when more data is needed, -1 on a protocol error
+     */
+    int next_frame(uint8_t &opcode, std::vector<uint8_t> &payload)
+    {
+        if (rx.size() < 2) {
+            return 0;
+        }
+
+        size_t header = 2;
+        uint64_t len = rx[1] & 0x7F;
+        if (rx[1] & 0x80) {
+            return -1;              // Server frames are never masked
+        }
+        if (len == 126) {
+            if (rx.size() < 4) {
+                return 0;
+            }
+            len = ((uint64_t)rx[2] << 8) | rx[3];
+            header = 4;
+        } else if (len == 127) {
+            if (rx.size() < 10) {
+                return 0;
+            }
+            len = 0;
+            for (int i = 0; i < 8; i++) {
+                len = (len << 8) | rx[2 + i];
+            }
+            header = 10;
+        }
+        if (len > LOAD_MAX_WS_FRAME) {
+            return -1;
+        }
+        if (rx.size() < header + len) {
+            return 0;
+        }
+
+        opcode = rx[0] & 0x0F;
+        payload.assign(rx.begin() + (long)header, rx.begin() + (long)(header + len));
+        rx.erase(rx.begin(), rx.begin() + (long)(header + len));
+        return 1;
+    }
+
+private:
+    int fd = -1;
+    uint32_t mask_state;
+    std::vector<uint8_t> rx;
+
+    uint32_t next_mask(void)
+    {
+        // xorshift32, masking only has to be unpredictable to proxies
+        mask_state ^= mask_state << 13;
+        mask_state ^= mask_state >> 17;
+        mask_state ^= mask_state << 5;
+        return mask_state;
+    }
+
+    bool write_all(const uint8_t *data, size_t len)
+    {
+        while (len > 0) {
+            ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            len -= (size_t)n;
+        }
+        return true;
+    }
+
+    static std::string base64(const uint8_t *data, size_t len)
+    {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (size_t i = 0; i < len; i += 3) {
+            uint32_t v = (uint32_t)data[i] << 16;
+            if (i + 1 < len) {
+                v |= (uint32_t)data[i + 1] << 8;
+            }
+            if (i + 2 < len) {
+                v |= data[i + 2];
+            }
+            out += table[(v >> 18) & 0x3F];
+            out += table[(v >> 12) & 0x3F];
+            out += i + 1 < len ? table[(v >> 6) & 0x3F] : '=';
+            out += i + 2 < len ? table[v & 0x3F] : '=';
+        }
+        return out;
+    }
+
+    bool handshake(const load_config_t &cfg, std::string &error)
+    {
+        uint8_t nonce[16];
+        for (int i = 0; i < 16; i += 4) {
+            uint32_t r = next_mask();
+            memcpy(nonce + i, &r, 4);
+        }
+
+        std::string request =
+            "GET " + cfg.path + " HTTP/1.1\r\n"
+            "Host: " + cfg.host + ":" + std::to_string(cfg.port) + "\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: " + base64(nonce, sizeof(nonce)) + "\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n";
+        if (!write_all((const uint8_t *)request.data(), request.size())) {
+            error = "handshake write failed";
+            return false;
+        }
+
+        // Only the status line is checked; frames may follow the headers
+        auto deadline = load_clock::now() + std::chrono::milliseconds(LOAD_HANDSHAKE_TIMEOUT_MS);
+        uint64_t unused = 0;
+        for (;;) {
+            auto end = std::search(rx.begin(), rx.end(), "\r\n\r\n", "\r\n\r\n" + 4);
+            if (end != rx.end()) {
+                std::string head(rx.begin(), end);
+                rx.erase(rx.begin(), end + 4);
+                if (head.compare(0, 12, "HTTP/1.1 101") != 0) {
+                    error = "handshake refused: " + head.substr(0, head.find('\r'));
+                    return false;
+                }
+                return true;
+            }
+
+            int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - load_clock::now()).count();
+            if (left <= 0) {
+                error = "handshake timeout";
+                return false;
+            }
+            if (!receive(left, unused)) {
+                error = "handshake: connection closed";
+                return false;
+            }
+        }
+    }
+};
+
+// =============================================================================
+// LOAD CLIENT
+// =============================================================================
+
+static bool send_rcp(ws_connection &ws, load_client_t &stats, uint8_t port, const void *body, size_t len)
+{
+    uint8_t frame[RCP_HEADER_SIZE + RCP_MAX_BODY_SIZE];
+
+    RCP_SET_LENGTH(frame, len);
+    frame[2] = port;
+    memcpy(frame + RCP_HEADER_SIZE, body, len);
+
+    if (!ws.send_frame(WS_OPCODE_BINARY, frame, RCP_HEADER_SIZE + len)) {
+        return false;
+    }
+    stats.frames_tx++;
+    stats.bytes_tx += RCP_HEADER_SIZE + len;
+    return true;
+}
+
+static bool send_system(ws_connection &ws, load_client_t &stats, uint8_t command, uint8_t param)
+{
+    rcp_system_body_t body = { command, param };
+    return send_rcp(ws, stats, RCP_PORT_SYSTEM, &body, sizeof(body));
+}
+
+// Speed and steering sweep, each client on its own phase
+static rcp_drive_body_t make_drive(const load_client_t &stats, uint16_t sequence)
+{
+    int step = (int)((sequence + stats.index * 37) % 200);
+    int8_t value = (int8_t)(step < 100 ? step - 50 : 150 - step);
+
+    rcp_drive_body_t body = {};
+    body.speed = value;
+    body.steering = (int8_t)-value;
+    body.flags = 0;
+    body.sequence = sequence;
+    return body;
+}
+
+/**
+ * @brief Advance a send schedule, counting the ticks that were skipped
+ */
+static void advance_slot(load_clock::time_point &next, load_clock::duration period,
+                         load_clock::time_point now, uint64_t &missed)
+{
+    next += period;
+    if (now - next > period) {
+        // More than a period behind: skip instead of sending a burst
+        uint64_t behind = (uint64_t)((now - next) / period);
+        missed += behind;
+        next += period * (long)behind;
+    }
+}
+
+static void handle_rcp(load_client_t &stats, const uint8_t *frame, size_t len, uint32_t rx_us,
+                       uint32_t ping_sent_us[256], bool ping_pending[256],
+                       uint32_t &last_telemetry_us, uint32_t &last_battery_us, bool counting)
+{
+    if (len < RCP_HEADER_SIZE) {
+        stats.other_frames++;
+        return;
+    }
+
+    size_t body_len = (size_t)frame[0] | ((size_t)(frame[1] & 0x7F) << 8);
+    const uint8_t *body = frame + RCP_HEADER_SIZE;
+    if (RCP_HEADER_SIZE + body_len > len) {
+        stats.other_frames++;
+        return;
+    }
+
+    switch (frame[2]) {
+        case RCP_PORT_PONG: {
+            if (body_len < sizeof(rcp_pong_body_t)) {
+                stats.other_frames++;
+                return;
+            }
+            rcp_pong_body_t pong;
+            memcpy(&pong, body, sizeof(pong));
+            if (!ping_pending[pong.id] || ping_sent_us[pong.id] != pong.client_time_us) {
+                stats.pongs_late++;
+                return;
+            }
+            ping_pending[pong.id] = false;
+            stats.pongs++;
+            stats.rtt_us.push_back(rx_us - pong.client_time_us);
+            stats.device_us.push_back(pong.tx_time_us - pong.rx_time_us);
+            break;
+        }
+
+        case RCP_PORT_TELEMETRY: {
+            if (!counting) {
+                return;
+            }
+            stats.telemetry++;
+            if (last_telemetry_us != 0) {
+                stats.telemetry_gap_us.push_back(rx_us - last_telemetry_us);
+            }
+            last_telemetry_us = rx_us;
+            if (body_len >= sizeof(rcp_telemetry_body_t)) {
+                rcp_telemetry_body_t telemetry;
+                memcpy(&telemetry, body, sizeof(telemetry));
+                if (telemetry.flags & RCP_TELEMETRY_FLAG_FAILSAFE) {
+                    stats.telemetry_failsafe++;
+                }
+            }
+            break;
+        }
+
+        case RCP_PORT_BATTERY:
+            if (!counting) {
+                return;
+            }
+            stats.battery++;
+            if (last_battery_us != 0) {
+                stats.battery_gap_us.push_back(rx_us - last_battery_us);
+            }
+            last_battery_us = rx_us;
+            break;
+
+        default:
+            stats.other_frames++;
+            break;
+    }
+}
+
+static void client_run(load_client_t *stats_ptr, load_clock::time_point start)
+{
+    load_client_t &stats = *stats_ptr;
+    ws_connection ws((uint32_t)(0x9E3779B9u * (uint32_t)(stats.index + 1)) ^ now_us());
+
+    if (!ws.open(config, stats.error)) {
+        return;
+    }
+    stats.connected = true;
+
+    if (stats.monitor && !send_system(ws, stats, RCP_SYS_ROLE, RCP_ROLE_MONITOR)) {
+        stats.error = "send failed";
+        return;
+    }
+
+    // Clients spread over one control period instead of sending in lockstep
+    auto control_period = std::chrono::duration_cast<load_clock::duration>(std::chrono::seconds(1)) / config.rate_hz;
+    auto phase = control_period * stats.index / config.clients;
+    auto end = start + std::chrono::seconds(config.duration_s);
+    auto drain_end = end + std::chrono::milliseconds(LOAD_GRACE_MS);
+    auto next_control = start + phase;
+    auto ping_period = config.ping_hz > 0
+        ? std::chrono::duration_cast<load_clock::duration>(std::chrono::seconds(1)) / config.ping_hz
+        : load_clock::duration::max();
+    auto next_ping = config.ping_hz > 0 ? start + phase : load_clock::time_point::max();
+
+    bool subscribed = false;
+    load_clock::time_point subscribed_at;
+
+    uint32_t ping_sent_us[256] = {};
+    bool ping_pending[256] = {};
+    uint8_t ping_id = 0;
+    uint16_t sequence = 0;
+    uint32_t last_telemetry_us = 0;
+    uint32_t last_battery_us = 0;
+    uint64_t ping_slots_missed = 0;
+    std::vector<uint8_t> payload;
+
+    for (;;) {
+        auto now = load_clock::now();
+        // Replies are read from the connect on, counted only between start and end
+        bool sending = now >= start && now < end;
+        if (now >= drain_end) {
+            break;
+        }
+
+        if (sending && config.telemetry_hz > 0 && !subscribed) {
+            if (!send_system(ws, stats, RCP_SYS_TELEMETRY, (uint8_t)config.telemetry_hz)) {
+                stats.error = "send failed";
+                break;
+            }
+            subscribed = true;
+            subscribed_at = now;
+        }
+
+        if (sending && !stats.monitor && now >= next_control) {
+            rcp_drive_body_t drive = make_drive(stats, sequence++);
+            if (!send_rcp(ws, stats, RCP_PORT_DRIVE, &drive, sizeof(drive))) {
+                stats.error = "send failed";
+                break;
+            }
+            stats.control_sent++;
+            advance_slot(next_control, control_period, now, stats.slots_missed);
+        }
+
+        if (sending && now >= next_ping) {
+            rcp_ping_body_t ping = {};
+            ping.command = RCP_SYS_PING;
+            ping.id = ping_id;
+            ping.client_time_us = now_us();
+            ping.last_rtt_us = stats.rtt_us.empty() ? 0 : stats.rtt_us.back();
+            ping_sent_us[ping_id] = ping.client_time_us;
+            ping_pending[ping_id] = true;
+            ping_id++;
+            if (!send_rcp(ws, stats, RCP_PORT_SYSTEM, &ping, sizeof(ping))) {
+                stats.error = "send failed";
+                break;
+            }
+            stats.pings_sent++;
+            advance_slot(next_ping, ping_period, now, ping_slots_missed);
+        }
+
+        auto wake = drain_end;
+        if (now < start) {
+            wake = start;
+        } else if (sending) {
+            wake = std::min(wake, stats.monitor ? next_ping : std::min(next_control, next_ping));
+        }
+        int timeout_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(wake - load_clock::now()).count();
+        if (!ws.receive(std::max(timeout_ms, 0), stats.bytes_rx)) {
+            stats.closed_by_server = true;
+            stats.error = "connection closed";
+            break;
+        }
+
+        uint8_t opcode;
+        int got;
+        auto rx_time = load_clock::now();
+        bool counting = rx_time >= start && rx_time < end;
+        while ((got = ws.next_frame(opcode, payload)) == 1) {
+            uint32_t rx_us = now_us();
+            stats.frames_rx++;
+            switch (opcode) {
+                case WS_OPCODE_BINARY:
+                    handle_rcp(stats, payload.data(), payload.size(), rx_us, ping_sent_us, ping_pending,
+                               last_telemetry_us, last_battery_us, counting);
+                    break;
+                case WS_OPCODE_PING:
+                    // The server heartbeat evicts clients that do not answer
+                    stats.server_pings++;
+                    ws.send_frame(WS_OPCODE_PONG, payload.data(), payload.size());
+                    break;
+                case WS_OPCODE_CLOSE:
+                    stats.closed_by_server = true;
+                    break;
+                case WS_OPCODE_CONTINUATION:
+                default:
+                    stats.other_frames++;
+                    break;
+            }
+        }
+        if (got < 0) {
+            stats.error = "bad frame from server";
+            break;
+        }
+        if (stats.closed_by_server) {
+            stats.error = "closed by server";
+            break;
+        }
+    }
+
+    if (subscribed) {
+        auto window = std::min(load_clock::now(), end) - subscribed_at;
+        stats.telemetry_expected =
+            (uint64_t)(std::chrono::duration<double>(window).count() * config.telemetry_hz);
+        send_system(ws, stats, RCP_SYS_TELEMETRY, 0);
+    }
+}
+
+// =============================================================================
+// REPORT
+// =============================================================================
+
+typedef struct {
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+    double mean;
+    size_t count;
+} load_percentiles_t;
+
+static load_percentiles_t percentiles(std::vector<uint32_t> samples)
+{
+    load_percentiles_t out = {};
+    if (samples.empty()) {
+        return out;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto rank = [&samples](double p) {
+        size_t i = (size_t)(p * (double)samples.size() + 0.999999);
+        return samples[std::min(std::max(i, (size_t)1), samples.size()) - 1];
+    };
+
+    double sum = 0;
+    for (uint32_t v : samples) {
+        sum += v;
+    }
+    out.p50 = rank(0.50);
+    out.p99 = rank(0.99);
+    out.p999 = rank(0.999);
+    out.max = samples.back();
+    out.mean = sum / (double)samples.size();
+    out.count = samples.size();
+    return out;
+}
+
+static void print_percentiles(FILE *out, const char *name, const load_percentiles_t &p, bool last)
+{
+    fprintf(out, "\"%s\": { \"count\": %zu, \"p50\": %u, \"p99\": %u, \"p999\": %u, \"max\": %u, \"mean\": %.1f }%s",
+            name, p.count, p.p50, p.p99, p.p999, p.max, p.mean, last ? "" : ", ");
+}
+
+static double ratio(uint64_t part, uint64_t whole)
+{
+    return whole == 0 ? 0.0 : (double)part / (double)whole;
+}
+
+static void print_client_json(FILE *out, const load_client_t &c, double seconds)
+{
+    uint64_t telemetry_short = c.telemetry_expected > c.telemetry ? c.telemetry_expected - c.telemetry : 0;
+
+    fprintf(out, "{ \"index\": %d, \"monitor\": %s, \"connected\": %s, \"error\": \"%s\", ",
+            c.index, c.monitor ? "true" : "false", c.connected ? "true" : "false", c.error.c_str());
+    fprintf(out, "\"control_sent\": %" PRIu64 ", \"control_per_sec\": %.1f, \"slots_missed\": %" PRIu64 ", ",
+            c.control_sent, c.control_sent / seconds, c.slots_missed);
+    fprintf(out, "\"pings_sent\": %" PRIu64 ", \"pongs\": %" PRIu64 ", \"ping_loss\": %.6f, ",
+            c.pings_sent, c.pongs, 1.0 - (c.pings_sent ? ratio(c.pongs, c.pings_sent) : 1.0));
+    fprintf(out, "\"telemetry\": %" PRIu64 ", \"telemetry_expected\": %" PRIu64 ", \"telemetry_drop\": %.6f, "
+                 "\"telemetry_failsafe\": %" PRIu64 ", \"battery\": %" PRIu64 ", ",
+            c.telemetry, c.telemetry_expected, ratio(telemetry_short, c.telemetry_expected),
+            c.telemetry_failsafe, c.battery);
+    fprintf(out, "\"frames_tx\": %" PRIu64 ", \"frames_rx\": %" PRIu64 ", \"bytes_tx\": %" PRIu64 ", "
+                 "\"bytes_rx\": %" PRIu64 ", ",
+            c.frames_tx, c.frames_rx, c.bytes_tx, c.bytes_rx);
+    print_percentiles(out, "rtt_us", percentiles(c.rtt_us), true);
+    fprintf(out, " }");
+}
+
+static int report(FILE *out, const std::vector<load_client_t> &clients)
+{
+    double seconds = config.duration_s;
+    load_client_t total = {};
+    int connected = 0;
+    int failed = 0;
+
+    for (const load_client_t &c : clients) {
+        connected += c.connected ? 1 : 0;
+        failed += c.error.empty() ? 0 : 1;
+        total.control_sent += c.control_sent;
+        total.slots_missed += c.slots_missed;
+        total.pings_sent += c.pings_sent;
+        total.pongs += c.pongs;
+        total.telemetry += c.telemetry;
+        total.telemetry_expected += c.telemetry_expected;
+        total.telemetry_failsafe += c.telemetry_failsafe;
+        total.battery += c.battery;
+        total.frames_tx += c.frames_tx;
+        total.frames_rx += c.frames_rx;
+        total.bytes_tx += c.bytes_tx;
+        total.bytes_rx += c.bytes_rx;
+        total.rtt_us.insert(total.rtt_us.end(), c.rtt_us.begin(), c.rtt_us.end());
+        total.device_us.insert(total.device_us.end(), c.device_us.begin(), c.device_us.end());
+        total.telemetry_gap_us.insert(total.telemetry_gap_us.end(), c.telemetry_gap_us.begin(), c.telemetry_gap_us.end());
+        total.battery_gap_us.insert(total.battery_gap_us.end(), c.battery_gap_us.begin(), c.battery_gap_us.end());
+    }
+
+    uint64_t telemetry_short = total.telemetry_expected > total.telemetry ? total.telemetry_expected - total.telemetry : 0;
+    double ping_loss = 1.0 - (total.pings_sent ? ratio(total.pongs, total.pings_sent) : 1.0);
+    double telemetry_drop = ratio(telemetry_short, total.telemetry_expected);
+    load_percentiles_t rtt = percentiles(total.rtt_us);
+    load_percentiles_t device = percentiles(total.device_us);
+    load_percentiles_t telemetry_gap = percentiles(total.telemetry_gap_us);
+    load_percentiles_t battery_gap = percentiles(total.battery_gap_us);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"tool\": \"ws_load\",\n");
+    fprintf(out, "  \"target\": \"%s:%d%s\",\n", config.host.c_str(), config.port, config.path.c_str());
+    fprintf(out, "  \"clients\": %d, \"monitors\": %d, \"connected\": %d, \"failed\": %d,\n",
+            config.clients, config.monitors, connected, failed);
+    fprintf(out, "  \"rate_hz\": %d, \"ping_hz\": %d, \"telemetry_hz\": %d, \"duration_s\": %d,\n",
+            config.rate_hz, config.ping_hz, config.telemetry_hz, config.duration_s);
+    fprintf(out, "  \"control_sent\": %" PRIu64 ", \"control_per_sec\": %.1f, \"slots_missed\": %" PRIu64 ",\n",
+            total.control_sent, total.control_sent / seconds, total.slots_missed);
+    fprintf(out, "  \"frames_tx_per_sec\": %.1f, \"frames_rx_per_sec\": %.1f, \"bytes_tx\": %" PRIu64 ", "
+                 "\"bytes_rx\": %" PRIu64 ",\n",
+            total.frames_tx / seconds, total.frames_rx / seconds, total.bytes_tx, total.bytes_rx);
+    fprintf(out, "  \"pings_sent\": %" PRIu64 ", \"pongs\": %" PRIu64 ", \"ping_loss\": %.6f,\n",
+            total.pings_sent, total.pongs, ping_loss);
+    fprintf(out, "  \"telemetry\": %" PRIu64 ", \"telemetry_expected\": %" PRIu64 ", \"telemetry_drop\": %.6f, "
+                 "\"telemetry_failsafe\": %" PRIu64 ", \"battery\": %" PRIu64 ",\n",
+            total.telemetry, total.telemetry_expected, telemetry_drop, total.telemetry_failsafe, total.battery);
+    fprintf(out, "  ");
+    print_percentiles(out, "rtt_us", rtt, false);
+    fprintf(out, "\n  ");
+    print_percentiles(out, "device_us", device, false);
+    fprintf(out, "\n  ");
+    print_percentiles(out, "telemetry_gap_us", telemetry_gap, false);
+    fprintf(out, "\n  ");
+    print_percentiles(out, "battery_gap_us", battery_gap, false);
+    fprintf(out, "\n  \"per_client\": [");
+    for (size_t i = 0; i < clients.size(); i++) {
+        fprintf(out, "%s\n    ", i == 0 ? "" : ",");
+        print_client_json(out, clients[i], seconds);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    fprintf(stderr, "ws_load: %d/%d clients connected to %s:%d%s, %d Hz each for %d s\n",
+            connected, config.clients, config.host.c_str(), config.port, config.path.c_str(),
+            config.rate_hz, config.duration_s);
+    fprintf(stderr, "  control   %" PRIu64 " frames, %.1f/s, %" PRIu64 " send slots missed\n",
+            total.control_sent, total.control_sent / seconds, total.slots_missed);
+    fprintf(stderr, "  ping rtt  p50 %u us, p99 %u us, p999 %u us, max %u us (%zu pongs, loss %.3f%%)\n",
+            rtt.p50, rtt.p99, rtt.p999, rtt.max, rtt.count, ping_loss * 100.0);
+    fprintf(stderr, "  device    p50 %u us, p99 %u us between ping receive and pong\n", device.p50, device.p99);
+    fprintf(stderr, "  telemetry %" PRIu64 "/%" PRIu64 " frames (drop %.3f%%), gap p50 %u us, p99 %u us, "
+                    "%" PRIu64 " in failsafe\n",
+            total.telemetry, total.telemetry_expected, telemetry_drop * 100.0, telemetry_gap.p50,
+            telemetry_gap.p99, total.telemetry_failsafe);
+    fprintf(stderr, "  battery   %" PRIu64 " frames, gap p50 %u us\n", total.battery, battery_gap.p50);
+    fprintf(stderr, "  traffic   %.1f frames/s out, %.1f frames/s in\n", total.frames_tx / seconds,
+            total.frames_rx / seconds);
+    for (const load_client_t &c : clients) {
+        if (!c.error.empty()) {
+            fprintf(stderr, "  client %d: %s\n", c.index, c.error.c_str());
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-H host] [-p port] [-u path] [-c clients] [-m monitors] [-r hz] [-P hz] [-t hz]\n"
+            "          [-d seconds] [-o file]\n"
+            "  -H host     Device or rc_sim address (default %s)\n"
+            "  -p port     HTTP port (default %d, 80 on the board)\n"
+            "  -u path     WebSocket path (default %s)\n"
+            "  -c clients  Connections (default %d, the firmware accepts %d)\n"
+            "  -m count    How many of them are monitors that send no control frames (default 0)\n"
+            "  -r hz       Drive frames per second per client (default %d)\n"
+            "  -P hz       Pings per second per client, 0 = none (default %d)\n"
+            "  -t hz       Telemetry subscription rate, 0 = none (default %d, %d..%d)\n"
+            "  -d seconds  Duration (default %d)\n"
+            "  -o file     Write the JSON results to file instead of stdout\n",
+            program, LOAD_DEFAULT_HOST, LOAD_DEFAULT_PORT, LOAD_DEFAULT_PATH, LOAD_DEFAULT_CLIENTS,
+            WS_CLIENTS_MAX, LOAD_DEFAULT_RATE_HZ, LOAD_DEFAULT_PING_HZ, LOAD_DEFAULT_TELEMETRY_HZ,
+            TELEMETRY_MIN_RATE_HZ, TELEMETRY_MAX_RATE_HZ, LOAD_DEFAULT_DURATION_S);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = nullptr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:u:c:m:r:P:t:d:o:h")) != -1) {
+        switch (opt) {
+            case 'H':
+                config.host = optarg;
+                break;
+            case 'p':
+                config.port = atoi(optarg);
+                break;
+            case 'u':
+                config.path = optarg;
+                break;
+            case 'c':
+                config.clients = atoi(optarg);
+                break;
+            case 'm':
+                config.monitors = atoi(optarg);
+                break;
+            case 'r':
+                config.rate_hz = atoi(optarg);
+                break;
+            case 'P':
+                config.ping_hz = atoi(optarg);
+                break;
+            case 't':
+                config.telemetry_hz = atoi(optarg);
+                break;
+            case 'd':
+                config.duration_s = atoi(optarg);
+                break;
+            case 'o':
+                out_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (config.port <= 0 || config.port > 65535 || config.clients <= 0 || config.monitors < 0 ||
+        config.monitors > config.clients || config.rate_hz <= 0 || config.ping_hz < 0 ||
+        (config.telemetry_hz != 0 &&
+         (config.telemetry_hz < TELEMETRY_MIN_RATE_HZ || config.telemetry_hz > TELEMETRY_MAX_RATE_HZ)) ||
+        config.duration_s <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *out = stdout;
+    if (out_path != nullptr) {
+        out = fopen(out_path, "w");
+        if (out == nullptr) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    run_epoch = load_clock::now();
+
+    // Monitors are the last clients, as a dashboard joining the drivers
+    std::vector<load_client_t> clients((size_t)config.clients);
+    for (int i = 0; i < config.clients; i++) {
+        clients[(size_t)i].index = i;
+        clients[(size_t)i].monitor = i >= config.clients - config.monitors;
+    }
+
+    // Every client connects first, then all start sending together
+    auto start = load_clock::now() + std::chrono::milliseconds(LOAD_HANDSHAKE_TIMEOUT_MS);
+    std::vector<std::thread> threads;
+    for (load_client_t &c : clients) {
+        threads.emplace_back(client_run, &c, start);
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    int ret = report(out, clients);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return ret;
+}
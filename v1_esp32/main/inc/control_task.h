@@ -0,0 +1,160 @@
+#ifndef __CONTROL_TASK_H__
+#define __CONTROL_TASK_H__
+
+#include "project_config.h"
+
+#if ENABLE_CONTROL_TASK
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// =============================================================================
+// CONTROL TASK CONFIGURATION
+// =============================================================================
+
+#define CONTROL_TASK_RATE_HZ        200     // Actuator update rate
+#define CONTROL_TASK_STACK_SIZE     3072
+#define CONTROL_TASK_PRIORITY       10      // Above httpd (5), below esp_timer and WiFi
+#define CONTROL_FAILSAFE_TIMEOUT_MS 150     // Brake and center when no control frame arrives for this long
+
+// WiFi and lwIP run on core 0, keep actuation on the other core
+#if CONFIG_FREERTOS_UNICORE
+#define CONTROL_TASK_CORE           0
+#else
+#define CONTROL_TASK_CORE           1
+#endif
+
+// Setpoint fields (control_setpoint_t.fields)
+#define CONTROL_FIELD_SPEED         0x01
+#define CONTROL_FIELD_STEERING      0x02
+#define CONTROL_FIELD_HORN          0x04
+#define CONTROL_FIELD_LIGHT         0x08
+
+// =============================================================================
+// CONTROL TASK TYPES
+// =============================================================================
+
+/**
+ * @brief Latest requested actuator state
+ */
+typedef struct {
+    int8_t speed;               // -100 to +100
+    int8_t steering;            // -100 to +100
+    bool horn;
+    bool light;
+    uint8_t fields;             // CONTROL_FIELD_* bits ever set, unset fields are not driven
+    uint8_t written;            // CONTROL_FIELD_* bits set since the previous publish
+    uint32_t failsafe_generation; // Failsafe trips the writer had seen when publishing
+    int64_t updated_us;         // esp_timer time of the last publish
+} control_setpoint_t;
+
+/**
+ * @brief Control loop counters
+ */
+typedef struct {
+    uint32_t ticks;             // Loop iterations
+    uint32_t missed_ticks;      // Timer periods that elapsed while the loop was busy
+    uint32_t updates;           // Setpoints applied
+    uint32_t latency_last_us;   // Publish to actuation of the last setpoint
+    uint32_t latency_max_us;    // Highest latency seen
+    uint32_t latency_avg_us;    // Mean latency over all updates
+    uint32_t exec_max_us;       // Longest loop iteration
+    uint32_t failsafe_trips;    // Times the failsafe braked the motor
+    uint32_t failsafe_reaction_last_us; // Last control frame to brake, last trip
+    uint32_t failsafe_reaction_max_us;  // Last control frame to brake, worst trip
+    bool failsafe_active;       // Outputs held safe until the next control frame
+} control_stats_t;
+
+// =============================================================================
+// CONTROL TASK API
+// =============================================================================
+
+/**
+ * @brief Set the requested motor speed
+ *
+ * The setter functions only write the setpoint mailbox and return
+ * immediately; the control task drives the outputs on its next tick.
+ * They must all be called from the same task (the httpd task).
+ *
+ * @param speed -100 (full reverse) to +100 (full forward)
+ */
+void control_set_speed(int8_t speed);
+
+/**
+ * @brief Set the requested steering position
+ *
+ * @param steering -100 (full left) to +100 (full right)
+ */
+void control_set_steering(int8_t steering);
+
+/**
+ * @brief Set the requested horn state
+ */
+void control_set_horn(bool state);
+
+/**
+ * @brief Set the requested light state
+ */
+void control_set_light(bool state);
+
+/**
+ * @brief Start a group of setter calls published together
+ *
+ * Until the matching control_commit(), setters only stage their value, so
+ * the control task never applies half of a drive frame or batch. Groups
+ * may nest.
+ */
+void control_begin(void);
+
+/**
+ * @brief Publish the setters called since control_begin()
+ */
+void control_commit(void);
+
+/**
+ * @brief Read the latest published setpoint
+ *
+ * @param[out] setpoint Setpoint copy
+ * @return true on success, false if a publish overlapped every attempt
+ */
+bool control_get_setpoint(control_setpoint_t *setpoint);
+
+/**
+ * @brief Check whether the link-loss failsafe holds the outputs
+ *
+ * @return true between a failsafe trip and the next control frame
+ */
+bool control_failsafe_active(void);
+
+/**
+ * @brief Read the control loop counters
+ *
+ * @param[out] stats Counters
+ */
+void control_get_stats(control_stats_t *stats);
+
+/**
+ * @brief Start the control task and its tick timer
+ *
+ * The task is pinned to CONTROL_TASK_CORE and woken by an esp_timer every
+ * 1/CONTROL_TASK_RATE_HZ seconds, which is finer than the FreeRTOS tick.
+ * Once a setpoint has been published, every tick also checks its age:
+ * after CONTROL_FAILSAFE_TIMEOUT_MS without one, the motor brakes and the
+ * servo centers until the next setpoint arrives. Clients keep the link
+ * alive by repeating their setpoint while idle. After a trip, motion only
+ * resumes on a fresh speed or steering write: a light or horn frame does
+ * not bring back the speed staged before the link loss.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t control_task_start(void);
+
+/**
+ * @brief Stop the control task and its tick timer
+ */
+void control_task_stop(void);
+
+#endif // ENABLE_CONTROL_TASK
+
+#endif // __CONTROL_TASK_H__
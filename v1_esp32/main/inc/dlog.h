@@ -0,0 +1,123 @@
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_log.h>
+
+#include "dlog_formats.h"
+
+/**
+ * @file dlog.h
+ * @brief Deferred binary logging
+ *
+ * DLOG() stores a format ID, a timestamp and the raw integer arguments in
+ * a lock-free RAM ring; a low priority task formats and prints them later.
+ * Logging from the control path costs a few stores instead of a printf and
+ * a UART write. The formats are listed in dlog_formats.h.
+ *
+ * Until dlog_start() is called, or with ENABLE_DLOG set to 0, records are
+ * printed right away, so the log output is the same either way.
+ */
+
+// =============================================================================
+// DLOG CONFIGURATION
+// =============================================================================
+
+#define DLOG_RING_SIZE              128     // Records, power of two
+#define DLOG_TASK_STACK_SIZE        3072
+#define DLOG_TASK_PRIORITY          1       // Just above idle
+#define DLOG_DRAIN_INTERVAL_MS      20
+#ifndef DLOG_OUTPUT_BINARY
+#define DLOG_OUTPUT_BINARY          0       // 1 = frames for host/dlog_decode.c, 0 = text
+#endif
+
+// Map the table levels to IDF levels
+#define DLOG_LEVEL_E    ESP_LOG_ERROR
+#define DLOG_LEVEL_W    ESP_LOG_WARN
+#define DLOG_LEVEL_I    ESP_LOG_INFO
+#define DLOG_LEVEL_D    ESP_LOG_DEBUG
+#define DLOG_LEVEL_V    ESP_LOG_VERBOSE
+
+#define DLOG_FORMAT_LEVEL(id, level, tag, format)   id##_LEVEL = DLOG_LEVEL_##level,
+
+enum {
+    DLOG_FORMATS(DLOG_FORMAT_LEVEL)
+};
+
+// =============================================================================
+// DLOG TYPES
+// =============================================================================
+
+/**
+ * @brief Deferred logger counters
+ */
+typedef struct {
+    uint32_t written;           // Records stored in the ring
+    uint32_t dropped;           // Records lost because the ring was full
+    uint32_t drained;           // Records printed by the drain task
+    uint32_t high_water;        // Most records waiting at once
+} dlog_stats_t;
+
+// =============================================================================
+// DLOG API
+// =============================================================================
+
+/**
+ * @brief Log a table entry with integer arguments
+ *
+ * Compiled out like ESP_LOGx when the entry level is above LOG_LOCAL_LEVEL.
+ * Arguments are converted to uint32_t, printed with the table format.
+ *
+ * @param id DLOG_* entry from dlog_formats.h
+ */
+#define DLOG(id, ...)                                                           \
+    do {                                                                        \
+        if ((int)id##_LEVEL <= (int)LOG_LOCAL_LEVEL) {                          \
+            const uint32_t dlog_args_[] = { 0, ##__VA_ARGS__ };                 \
+            _Static_assert(sizeof(dlog_args_) / sizeof(uint32_t) - 1 <= DLOG_MAX_ARGS, \
+                           "too many DLOG arguments");                          \
+            dlog_write((id), &dlog_args_[1], sizeof(dlog_args_) / sizeof(uint32_t) - 1); \
+        }                                                                       \
+    } while (0)
+
+/**
+ * @brief Store one record, use DLOG() instead
+ *
+ * Never blocks: when the ring is full the record is counted as dropped.
+ * Safe from any task on any core; not from ISRs.
+ *
+ * @param id Format ID
+ * @param args Arguments
+ * @param argc Number of arguments, at most DLOG_MAX_ARGS
+ */
+void dlog_write(dlog_format_id_t id, const uint32_t *args, uint8_t argc);
+
+/**
+ * @brief Start the drain task, records are deferred from then on
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t dlog_start(void);
+
+/**
+ * @brief Print pending records and go back to immediate output
+ */
+void dlog_stop(void);
+
+/**
+ * @brief Print every pending record from the calling task
+ *
+ * For panic or restart paths that want the latest records out first.
+ */
+void dlog_flush(void);
+
+/**
+ * @brief Get the logger counters
+ *
+ * @param[out] stats Counters
+ */
+void dlog_get_stats(dlog_stats_t *stats);
+
+#endif // __DLOG_H__
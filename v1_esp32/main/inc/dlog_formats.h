@@ -0,0 +1,186 @@
+#ifndef __DLOG_FORMATS_H__
+#define __DLOG_FORMATS_H__
+
+/**
+ * @file dlog_formats.h
+ * @brief Deferred log format table and binary frame layout
+ *
+ * Shared by the firmware and the host decoder (host/dlog_decode.c), so it
+ * must not include any IDF header. A record only carries the format ID and
+ * its integer arguments; the text lives here.
+ *
+ * Each entry is X(id, level, tag, format):
+ * - id:     DLOG_* name used at the call site
+ * - level:  E, W, I, D or V, same meaning as ESP_LOGx
+ * - tag:    same string as the TAG of the file that logs it, so per-tag
+ *           levels apply to deferred records too
+ * - format: printf format with at most DLOG_MAX_ARGS int-sized conversions
+ *           (%d %i %u %x %X %c, flags and width allowed) plus %B and %H,
+ *           which print a boolean argument as ON/OFF and HIGH/LOW; no
+ *           strings, pointers or 64-bit values
+ *
+ * Append new entries at the end: IDs are positions in this table and the
+ * decoder must be built from the same table as the firmware.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DLOG_MAX_ARGS   4
+
+#define DLOG_FORMATS(X)                                                                          \
+    X(DLOG_RCP_MOTOR,           I, "rcp_protocol",  "RCP: Motor speed set to %d")                   \
+    X(DLOG_RCP_SERVO,           I, "rcp_protocol",  "RCP: Servo angle set to %d")                   \
+    X(DLOG_RCP_HORN,            I, "rcp_protocol",  "RCP: Horn %B")                                 \
+    X(DLOG_RCP_LIGHT,           I, "rcp_protocol",  "RCP: Light %B")                                \
+    X(DLOG_RCP_DRIVE,           D, "rcp_protocol",  "RCP: Drive seq=%u speed=%d steering=%d flags=0x%02X") \
+    X(DLOG_RCP_DRIVE_STALE,     D, "rcp_protocol",  "RCP: Stale drive frame seq=%u (last=%u) dropped") \
+    X(DLOG_MOTOR_SET_SPEED,     I, "motor_control", "Setting motor speed: %d")                      \
+    X(DLOG_MOTOR_SET_MODE,      I, "motor_control", "Setting motor mode: %d")                       \
+    X(DLOG_MOTOR_STOP,          I, "motor_control", "Stopping motor")                               \
+    X(DLOG_DRV8833_SET_SPEED,   I, "drv8833",       "Setting DRV8833 speed: %d")                    \
+    X(DLOG_DRV8833_SET_MODE,    I, "drv8833",       "Setting DRV8833 mode: %d")                     \
+    X(DLOG_DRV8833_STOP,        I, "drv8833",       "Stopping DRV8833 motor")                       \
+    X(DLOG_DRV8833_FORWARD,     D, "drv8833",       "Forward mode: IN1=%d%%, IN2=0%%")              \
+    X(DLOG_DRV8833_REVERSE,     D, "drv8833",       "Reverse mode: IN1=0%%, IN2=%d%%")              \
+    X(DLOG_DRV8833_BRAKE,       D, "drv8833",       "Brake mode: IN1=%H, IN2=%H")                   \
+    X(DLOG_DRV8833_FREE,        D, "drv8833",       "Free mode: IN1=%H, IN2=%H")                    \
+    X(DLOG_SERVO_POSITION,      I, "servo_control", "Servo position set to %d (pulse width: %u us, duty: %u)") \
+    X(DLOG_LED_LIGHT,           I, "led_control",   "Light LED %B")                                 \
+    X(DLOG_LED_HORN,            I, "led_control",   "Horn LED %B")                                  \
+    X(DLOG_HTTP_SPEED_CMD,      I, "http_server",   "Processing speed command: %d")                 \
+    X(DLOG_HTTP_SPEED_SET,      I, "http_server",   "Motor speed set to: %d")                       \
+    X(DLOG_HTTP_WHEELS_CMD,     I, "http_server",   "Processing wheels command: %d")                \
+    X(DLOG_HTTP_HORN_CMD,       I, "http_server",   "Processing horn command: %d")                  \
+    X(DLOG_HTTP_LIGHT_CMD,      I, "http_server",   "Processing light command: %d")                 \
+    X(DLOG_FAILSAFE_TRIP,       W, "control_task",  "Failsafe: no control frame for %u ms, motor braked") \
+    X(DLOG_FAILSAFE_RESUMED,    I, "control_task",  "Failsafe: control frames resumed")             \
+    X(DLOG_DROPPED,             W, "dlog",          "%u records dropped, ring full")
+
+#define DLOG_FORMAT_ID(id, level, tag, format)  id,
+
+typedef enum {
+    DLOG_FORMATS(DLOG_FORMAT_ID)
+    DLOG_FORMAT_COUNT
+} dlog_format_id_t;
+
+// =============================================================================
+// BINARY FRAME LAYOUT
+// =============================================================================
+
+// In binary output mode every record is written to the console as one frame,
+// all fields little endian:
+//
+//   magic[2]  DLOG_FRAME_MAGIC0, DLOG_FRAME_MAGIC1
+//   u32       timestamp, ms since boot
+//   u16       format ID
+//   u8        argument count
+//   u32[n]    arguments
+//   u8        checksum, XOR of every byte from timestamp to the last argument
+//
+// The magic bytes are not printable, so the decoder passes regular console
+// text (boot messages, ESP_LOGx) through unchanged.
+//
+// After the magic, 0x0A, 0x0D and DLOG_FRAME_ESCAPE are sent as
+// DLOG_FRAME_ESCAPE followed by the byte XOR DLOG_FRAME_ESCAPE_XOR. A frame
+// therefore never contains a line ending, and the console's \n -> \r\n
+// conversion (CONFIG_LIBC_STDOUT_LINE_ENDING_CRLF) leaves it intact. Sizes
+// and the checksum refer to the unescaped bytes.
+
+#define DLOG_FRAME_MAGIC0       0xD1
+#define DLOG_FRAME_MAGIC1       0x06
+#define DLOG_FRAME_HEADER_SIZE  9       // Magic, timestamp, ID, count
+#define DLOG_FRAME_MAX_SIZE     (DLOG_FRAME_HEADER_SIZE + DLOG_MAX_ARGS * 4 + 1)
+#define DLOG_FRAME_MAX_ENCODED  (2 + 2 * (DLOG_FRAME_MAX_SIZE - 2))   // Every byte escaped
+
+#define DLOG_FRAME_ESCAPE       0x7D
+#define DLOG_FRAME_ESCAPE_XOR   0x20
+
+/**
+ * @brief Check whether a frame byte after the magic must be escaped
+ */
+static inline int dlog_frame_needs_escape(uint8_t byte)
+{
+    return byte == 0x0A || byte == 0x0D || byte == DLOG_FRAME_ESCAPE;
+}
+
+// =============================================================================
+// TEXT FORMATTING
+// =============================================================================
+
+/**
+ * @brief Format a record as text, shared by the firmware and the decoder
+ *
+ * Each conversion takes the next argument with its own signedness: %d %i
+ * and %c as int, %u %x %X as unsigned int, %B as ON/OFF, %H as HIGH/LOW.
+ *
+ * @param out Output buffer, always NUL terminated when @p size > 0
+ * @param size Size of @p out
+ * @param format Format from the table
+ * @param args DLOG_MAX_ARGS arguments, unused ones zero
+ * @return Length of the full text, as snprintf
+ */
+static inline int dlog_format_text(char *out, size_t size, const char *format, const uint32_t *args)
+{
+    size_t len = 0;
+    int arg = 0;
+
+    for (const char *p = format; *p != '\0'; p++) {
+        if (*p != '%' || p[1] == '%') {
+            if (len + 1 < size) {
+                out[len] = *p;
+            }
+            len++;
+            p += (*p == '%');
+            continue;
+        }
+
+        // Copy "%[flags][width][.precision]" and the conversion letter
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && n < sizeof(spec) - 2) {
+            spec[n++] = *p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        spec[n++] = *p;
+        spec[n] = '\0';
+
+        uint32_t value = (arg < DLOG_MAX_ARGS) ? args[arg] : 0;
+        arg++;
+
+        char *dst = out + (len < size ? len : size);
+        size_t room = (len < size) ? size - len : 0;
+        int written;
+        switch (*p) {
+            case 'd':
+            case 'i':
+            case 'c':
+                written = snprintf(dst, room, spec, (int)value);
+                break;
+            case 'B':
+                written = snprintf(dst, room, "%s", value ? "ON" : "OFF");
+                break;
+            case 'H':
+                written = snprintf(dst, room, "%s", value ? "HIGH" : "LOW");
+                break;
+            default:
+                written = snprintf(dst, room, spec, (unsigned int)value);
+                break;
+        }
+        if (written > 0) {
+            len += (size_t)written;
+        }
+    }
+
+    if (size > 0) {
+        out[len < size ? len : size - 1] = '\0';
+    }
+    return (int)len;
+}
+
+#endif // __DLOG_FORMATS_H__
@@ -11,11 +11,14 @@ bool http_server_is_running(void);
 // WebSocket server handle access
 void* http_server_get_handle(void);
 
-// WebSocket broadcast function
+// WebSocket broadcast function, to the clients of WS_STREAM_STATUS
 esp_err_t http_server_broadcast_ws(const char *message);
 
-// WebSocket binary broadcast function  
-esp_err_t http_server_broadcast_ws_binary(const void *data, size_t len);
+// WebSocket binary broadcast function, to the clients of any of the WS_STREAM_* bits
+esp_err_t http_server_broadcast_ws_binary(uint8_t streams, const void *data, size_t len);
+
+// WebSocket binary send to a single client
+esp_err_t http_server_send_ws_binary(int fd, const void *data, size_t len);
 
 // WebSocket client management
 void http_server_cleanup_ws_clients(void);
@@ -0,0 +1,57 @@
+#ifndef __HTTP_WORKERS_H__
+#define __HTTP_WORKERS_H__
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+// =============================================================================
+// HTTP WORKER POOL CONFIGURATION
+// =============================================================================
+
+#define HTTP_WORKERS_COUNT          2       // Long requests served at the same time
+#define HTTP_WORKERS_STACK_SIZE     4096    // Same as the httpd task, handlers are unchanged
+#define HTTP_WORKERS_PRIORITY       4       // Below the httpd task (5)
+
+// =============================================================================
+// HTTP WORKER POOL TYPES
+// =============================================================================
+
+/**
+ * @brief Request handler run on a worker, same signature as a URI handler
+ */
+typedef esp_err_t (*http_worker_handler_t)(httpd_req_t *req);
+
+// =============================================================================
+// HTTP WORKER POOL API
+// =============================================================================
+
+/**
+ * @brief Start the worker tasks
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t http_workers_start(void);
+
+/**
+ * @brief Stop the worker tasks and wait for them to exit
+ *
+ * Requests already queued are served first. Afterwards the pool can be
+ * started again with http_workers_start().
+ */
+void http_workers_stop(void);
+
+/**
+ * @brief Run a request handler on a worker instead of the httpd task
+ *
+ * Called from a URI handler; the request is detached with
+ * httpd_req_async_handler_begin(), so the httpd task returns at once and
+ * keeps serving other clients. When every worker is busy the client gets
+ * 503 right away instead of waiting behind a long upload.
+ *
+ * @param req Request received by the URI handler
+ * @param handler Handler to run on the worker
+ * @return ESP_OK when queued or answered with 503, error code otherwise
+ */
+esp_err_t http_workers_submit(httpd_req_t *req, http_worker_handler_t handler);
+
+#endif // __HTTP_WORKERS_H__
@@ -14,5 +14,7 @@ void led_light_set(bool state);
 void led_horn_set(bool state);
 void led_light_toggle(void);
 void led_horn_toggle(void);
+bool led_light_get(void);
+bool led_horn_get(void);
 
 #endif
@@ -0,0 +1,91 @@
+#ifndef __LOG_STREAM_H__
+#define __LOG_STREAM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_log.h>
+
+/**
+ * @file log_stream.h
+ * @brief Console log forwarding to WebSocket clients
+ *
+ * Every line printed through esp_log (ESP_LOGx and the dlog drain task) is
+ * copied to a queue and sent on RCP_PORT_LOG to the clients that subscribed
+ * with RCP_SYS_LOG. Lines are rate limited and dropped when the queue is
+ * full, so a log burst never stalls the task that logs it.
+ *
+ * Nothing is copied while no client is subscribed.
+ */
+
+// =============================================================================
+// LOG STREAM CONFIGURATION
+// =============================================================================
+
+#define LOG_STREAM_QUEUE_LEN        32      // Lines waiting to be sent
+#define LOG_STREAM_LINE_MAX         160     // Longer lines are truncated
+#define LOG_STREAM_RATE_PER_SEC     20      // Sustained lines per second
+#define LOG_STREAM_BURST            40      // Lines accepted at once above the rate
+#define LOG_STREAM_TASK_STACK_SIZE  3072
+#define LOG_STREAM_TASK_PRIORITY    2       // Below httpd and telemetry
+#define LOG_STREAM_UART_ECHO        1       // 0 = only subscribers see the log while any is connected
+
+// =============================================================================
+// LOG STREAM TYPES
+// =============================================================================
+
+/**
+ * @brief Log stream counters
+ */
+typedef struct {
+    uint32_t lines_sent;        // Lines queued for subscribers
+    uint32_t dropped_rate;      // Lines over LOG_STREAM_RATE_PER_SEC
+    uint32_t dropped_full;      // Lines lost because the queue was full
+    uint8_t subscribers;        // Clients receiving the stream
+} log_stream_stats_t;
+
+// =============================================================================
+// LOG STREAM API
+// =============================================================================
+
+/**
+ * @brief Install the esp_log hook and start the sender task
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t log_stream_init(void);
+
+/**
+ * @brief Start or stop streaming to a client
+ *
+ * The subscription is dropped with the client on disconnect.
+ *
+ * @param client_id Socket fd of the WebSocket client
+ * @param enable true to subscribe, false to unsubscribe
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not initialized
+ */
+esp_err_t log_stream_subscribe(int client_id, bool enable);
+
+/**
+ * @brief Change the runtime level of a tag
+ *
+ * Thin wrapper over esp_log_level_set() with range checks, used by
+ * RCP_SYS_LOG_LEVEL. Levels above the compile-time LOG_LOCAL_LEVEL of a
+ * file have no effect on it. Only the TAGs of the firmware modules and "*"
+ * are accepted, so clients cannot fill the esp_log tag cache.
+ *
+ * @param tag Tag, "*" for every tag
+ * @param level ESP_LOG_NONE to ESP_LOG_VERBOSE
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND for other tags,
+ *         ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t log_stream_set_level(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Get the stream counters
+ *
+ * @param[out] stats Counters
+ */
+void log_stream_get_stats(log_stream_stats_t *stats);
+
+#endif // __LOG_STREAM_H__
@@ -0,0 +1,92 @@
+#ifndef __MAILBOX_H__
+#define __MAILBOX_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// MAILBOX CONFIGURATION
+// =============================================================================
+
+// Copies attempted by mailbox_read() before it gives up. A reader with a
+// higher priority than the writer on the same core would otherwise spin
+// while the preempted writer holds the mailbox.
+#define MAILBOX_READ_RETRIES    8
+
+// =============================================================================
+// MAILBOX TYPES
+// =============================================================================
+
+/**
+ * @brief Latest-value mailbox (seqlock)
+ *
+ * One writer task publishes whole values, any number of readers copy the
+ * newest one. The writer never waits; a reader retries its copy if a
+ * write overlapped it. Meant for small values (setpoints, state snapshots)
+ * where only the latest one matters.
+ *
+ * Only depends on C11 atomics, so it also builds on the host.
+ */
+typedef struct {
+    void *storage;
+    size_t size;
+    atomic_uint seq;            // Odd while a write is in progress, 0 = never written
+} mailbox_t;
+
+/**
+ * @brief Define a static mailbox and its storage
+ *
+ * @param name Mailbox variable name
+ * @param type Value type
+ */
+#define MAILBOX_DEFINE(name, type)                                              \
+    static type name##_storage;                                               \
+    static mailbox_t name = {                                                 \
+        .storage = &name##_storage,                                           \
+        .size = sizeof(type),                                                 \
+    }
+
+// =============================================================================
+// MAILBOX API
+// =============================================================================
+
+/**
+ * @brief Initialize a mailbox over caller storage
+ *
+ * @param mailbox Mailbox to initialize
+ * @param storage Buffer of @p size bytes
+ * @param size Size of the value
+ */
+void mailbox_init(mailbox_t *mailbox, void *storage, size_t size);
+
+/**
+ * @brief Publish a new value, single writer only
+ *
+ * @param mailbox Mailbox
+ * @param value Value of mailbox->size bytes
+ */
+void mailbox_write(mailbox_t *mailbox, const void *value);
+
+/**
+ * @brief Copy the latest value
+ *
+ * @param mailbox Mailbox
+ * @param[out] value Buffer of mailbox->size bytes
+ * @param[out] seq Sequence of the copied value, changes on every write
+ *                 (0 = never written), may be NULL
+ * @return true on success, false if writes kept overlapping the copy
+ *         (@p value is then undefined, try again later)
+ */
+bool mailbox_read(mailbox_t *mailbox, void *value, uint32_t *seq);
+
+/**
+ * @brief Sequence of the latest value, without copying it
+ */
+static inline uint32_t mailbox_seq(mailbox_t *mailbox)
+{
+    return atomic_load_explicit(&mailbox->seq, memory_order_acquire) & ~1u;
+}
+
+#endif // __MAILBOX_H__
@@ -0,0 +1,160 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/**
+ * @file metrics.h
+ * @brief Counters, gauges and histograms for the whole firmware
+ *
+ * Hot paths update registry entries with single atomic operations, no
+ * locks. Values kept by other modules (control, RCP, WebSocket, logging)
+ * are copied in by metrics_refresh() when a snapshot is taken. Snapshots
+ * are served as Prometheus text on /metrics and as a binary body on
+ * RCP_PORT_METRICS.
+ */
+
+// =============================================================================
+// METRICS CONFIGURATION
+// =============================================================================
+
+// Upper bounds of the histogram buckets in microseconds, the last bucket
+// counts everything above
+#define METRICS_HISTOGRAM_BOUNDS_US     { 100, 250, 500, 1000, 2500, 10000, 50000, 250000 }
+#define METRICS_HISTOGRAM_BUCKETS       9
+
+#define METRICS_SNAPSHOT_VERSION        1
+#define METRICS_CHUNK_SIZE              1024    // Prometheus text written per httpd_resp_send_chunk()
+
+/**
+ * @brief Registry entries: X(id, type, name, help)
+ *
+ * IDs are positions in this list and appear in the binary snapshot, so
+ * append new entries at the end.
+ */
+#define METRICS_LIST(X)                                                                                     \
+    X(METRIC_UPTIME,              GAUGE,     "rc_uptime_seconds",            "Time since boot")               \
+    X(METRIC_HEAP_FREE,           GAUGE,     "rc_heap_free_bytes",           "Free heap")                     \
+    X(METRIC_HEAP_MIN_FREE,       GAUGE,     "rc_heap_min_free_bytes",       "Lowest free heap since boot")   \
+    X(METRIC_RCP_FRAMES,          COUNTER,   "rc_rcp_frames_total",          "RCP frames dispatched, all ports") \
+    X(METRIC_RCP_ERRORS,          COUNTER,   "rc_rcp_errors_total",          "RCP frames rejected or failed, all ports") \
+    X(METRIC_RCP_DROPPED,         COUNTER,   "rc_rcp_dropped_total",         "RCP frames dropped as stale or late") \
+    X(METRIC_WS_CLIENTS,          GAUGE,     "rc_ws_clients",                "Connected WebSocket clients")   \
+    X(METRIC_WS_SEND_FAILURES,    COUNTER,   "rc_ws_send_failures_total",    "WebSocket sends that failed and closed the client") \
+    X(METRIC_WS_OUTBOX_DEPTH,     GAUGE,     "rc_ws_outbox_depth",           "Frames waiting for an httpd send, all clients") \
+    X(METRIC_WS_OUTBOX_DROPPED,   COUNTER,   "rc_ws_outbox_dropped_total",   "Frames dropped on full client queues") \
+    X(METRIC_ACTUATION_LATENCY,   HISTOGRAM, "rc_actuation_latency_us",      "Setpoint publish to outputs applied") \
+    X(METRIC_CONTROL_EXEC,        HISTOGRAM, "rc_control_exec_us",           "Control tick execution time")   \
+    X(METRIC_CONTROL_MISSED,      COUNTER,   "rc_control_missed_ticks_total","Control ticks that ran late")   \
+    X(METRIC_FAILSAFE_TRIPS,      COUNTER,   "rc_failsafe_trips_total",      "Link-loss failsafe activations") \
+    X(METRIC_BATTERY_READ,        HISTOGRAM, "rc_battery_read_us",           "Battery voltage read, all samples") \
+    X(METRIC_DLOG_DROPPED,        COUNTER,   "rc_dlog_dropped_total",        "Deferred log records lost")     \
+    X(METRIC_LOG_STREAM_DROPPED,  COUNTER,   "rc_log_stream_dropped_total",  "Log lines not streamed (rate or queue)")
+
+#define METRICS_ID(id, type, name, help)    id,
+
+typedef enum {
+    METRICS_LIST(METRICS_ID)
+    METRIC_COUNT
+} metric_id_t;
+
+// =============================================================================
+// METRICS TYPES
+// =============================================================================
+
+typedef enum {
+    METRIC_TYPE_COUNTER = 0,
+    METRIC_TYPE_GAUGE = 1,
+    METRIC_TYPE_HISTOGRAM = 2,
+} metric_type_t;
+
+/**
+ * @brief Registry entry value
+ *
+ * Histogram sums are 32-bit microseconds and wrap like counters.
+ */
+typedef struct {
+    atomic_uint value;                              // Counter or gauge
+    atomic_uint sum;                                // Histogram sum
+    atomic_uint buckets[METRICS_HISTOGRAM_BUCKETS]; // Histogram samples per bucket
+} metric_t;
+
+extern metric_t metrics_registry[METRIC_COUNT];
+
+// =============================================================================
+// METRICS API
+// =============================================================================
+
+/**
+ * @brief Add to a counter, safe from any task
+ */
+static inline void metrics_add(metric_id_t id, uint32_t amount)
+{
+    atomic_fetch_add_explicit(&metrics_registry[id].value, amount, memory_order_relaxed);
+}
+
+/**
+ * @brief Increment a counter, safe from any task
+ */
+static inline void metrics_inc(metric_id_t id)
+{
+    metrics_add(id, 1);
+}
+
+/**
+ * @brief Set a gauge (or copy a counter kept elsewhere)
+ */
+static inline void metrics_set(metric_id_t id, uint32_t value)
+{
+    atomic_store_explicit(&metrics_registry[id].value, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Record one histogram sample, safe from any task
+ *
+ * @param id Histogram entry
+ * @param value_us Sample in microseconds
+ */
+void metrics_observe(metric_id_t id, uint32_t value_us);
+
+/**
+ * @brief Copy the values kept by other modules into the registry
+ */
+void metrics_refresh(void);
+
+/**
+ * @brief Writer used by metrics_render_prometheus(), returns ESP_OK to continue
+ */
+typedef esp_err_t (*metrics_write_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Render the registry and per-port RCP counters as Prometheus text
+ *
+ * Output is handed to @p write in pieces of at most METRICS_CHUNK_SIZE
+ * bytes, so the page has no size limit. Per-port series are labeled only
+ * for ports in the RCP port table; frames on any other port are summed
+ * into a single port="other" series.
+ *
+ * @param write Output function
+ * @param ctx Passed to @p write
+ * @return ESP_OK, ESP_ERR_NO_MEM, or the first error returned by @p write
+ */
+esp_err_t metrics_render_prometheus(metrics_write_fn_t write, void *ctx);
+
+/**
+ * @brief Build the binary snapshot sent on RCP_PORT_METRICS
+ *
+ * Layout, little endian: [version][entry count] then per entry
+ * [id][type] and either a u32 value (counter, gauge) or
+ * [count u32][sum u32][bucket count u8][bucket u32 x n] (histogram).
+ *
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @return Bytes written, 0 if the buffer is too small
+ */
+size_t metrics_build_snapshot(uint8_t *buf, size_t size);
+
+#endif // __METRICS_H__
@@ -1,9 +1,12 @@
 #ifndef __OTA_H__
 #define __OTA_H__
 
+#include <stdint.h>
 #include "esp_err.h"
 #include "esp_http_server.h"
 
+#define OTA_RESTART_DELAY_MS    3000    // Time for the HTTP response to reach the browser
+
 /**
  * @brief Initialize OTA system
  */
@@ -34,4 +37,14 @@ esp_err_t ota_get_partition_info(char *buffer, size_t buffer_size);
  */
 esp_err_t ota_restart_handler(httpd_req_t *req);
 
+/**
+ * @brief Restart after a delay without blocking the caller
+ *
+ * A one-shot esp_timer calls esp_restart(), so the HTTP response is
+ * flushed meanwhile and the calling task keeps running.
+ *
+ * @param delay_ms Delay before the restart
+ */
+void ota_schedule_restart(uint32_t delay_ms);
+
 #endif
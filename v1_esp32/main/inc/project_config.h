@@ -83,6 +83,65 @@
  */
 #define ENABLE_WIFI_CONFIG          1   // 0 = Disabled, 1 = Enabled
 
+/**
+ * @brief Enable telemetry stream
+ * 
+ * Set to 1 to publish actuator state on the RCP telemetry port to clients
+ * that subscribe with RCP_SYS_TELEMETRY.
+ * Set to 0 to disable the telemetry task.
+ */
+#define ENABLE_TELEMETRY            1   // 0 = Disabled, 1 = Enabled
+
+/**
+ * @brief Enable fixed-rate control task
+ * 
+ * Set to 1 to drive motor, servo and LEDs from a dedicated task pinned to
+ * its own core, which applies the latest RCP setpoints at a fixed rate
+ * (CONTROL_TASK_RATE_HZ in control_task.h).
+ * Set to 0 to write the outputs directly from the WebSocket handler.
+ */
+#define ENABLE_CONTROL_TASK         1   // 0 = Disabled, 1 = Enabled
+
+/**
+ * @brief Enable deferred logging
+ * 
+ * Set to 1 to queue the control path logs (DLOG() call sites) in a RAM
+ * ring printed by a low priority task, see dlog.h.
+ * Set to 0 to print them right away like ESP_LOGx.
+ */
+#define ENABLE_DLOG                 1   // 0 = Disabled, 1 = Enabled
+
+/**
+ * @brief Enable log streaming over WebSocket
+ * 
+ * Set to 1 to forward console log lines to WebSocket clients that subscribe
+ * with RCP_SYS_LOG, and accept RCP_SYS_LOG_LEVEL to change tag levels at
+ * runtime. See log_stream.h.
+ * Set to 0 to keep the log on the UART only.
+ */
+#define ENABLE_LOG_STREAM           1   // 0 = Disabled, 1 = Enabled
+
+/**
+ * @brief Enable per-task CPU and stack reporting
+ * 
+ * Set to 1 to sample the FreeRTOS run-time counters and serve per-task CPU
+ * load, stack high-water mark and core on /api/system-info/tasks and
+ * RCP_SYS_TASKS. Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in sdkconfig. See task_stats.h.
+ * Set to 0 to leave the kernel counters off.
+ */
+#define ENABLE_TASK_STATS           1   // 0 = Disabled, 1 = Enabled
+
+/**
+ * @brief Enable command latency tracing
+ * 
+ * Set to 1 to record timestamps at each stage of a command (WebSocket
+ * frame, RCP dispatch, control task, motor and servo drivers) and serve
+ * them as Chrome trace JSON on /api/trace for Perfetto. See trace.h.
+ * Set to 0 to compile the trace points out.
+ */
+#define ENABLE_TRACE                1   // 0 = Disabled, 1 = Enabled
+
 /**
  * @brief Enable debug logging
  * 
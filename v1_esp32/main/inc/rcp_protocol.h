@@ -11,21 +11,42 @@ extern "C" {
 #endif
 
 // Protocol version
-#define RCP_VERSION_MAJOR    1
+#define RCP_VERSION_MAJOR    2
 #define RCP_VERSION_MINOR    0
 
 // RCP frame header: [len_lo][len_hi][port]
 #define RCP_HEADER_SIZE      3
 
+// RCP v2 frame header (client to device, opt-in after RCP_SYS_HELLO):
+// [len_lo][len_hi | RCP_HEADER_V2_FLAG][port][seq_lo][seq_hi][ts0][ts1][ts2][ts3]
+// seq is a per-connection frame counter, ts the sender clock in milliseconds
+#define RCP_HEADER_V2_SIZE   9
+#define RCP_HEADER_V2_FLAG   0x80
+
+// Control frames whose one-way delay exceeds the best observed delay by more
+// than this are considered replayed from a stalled link and dropped
+#define RCP_MAX_FRAME_AGE_MS 200
+
+// Number of control ports (0x00-0x0F) with per-session sequence tracking
+#define RCP_SEQ_TRACKED_PORTS 16
+
 // Maximum payload/body size (tunable depending on resources)
 #define RCP_MAX_BODY_SIZE    256
 
+// Batch record header inside a RCP_PORT_BATCH body: [port][len]
+#define RCP_BATCH_RECORD_HEADER_SIZE  2
+
+// Maximum number of records carried by one batch frame
+#define RCP_BATCH_MAX_RECORDS         8
+
 // Port definitions
 // Control Commands (0x01-0x0F)
 #define RCP_PORT_MOTOR       0x01  // Motor speed control
 #define RCP_PORT_SERVO       0x02  // Servo steering control
 #define RCP_PORT_HORN        0x03  // Horn on/off
 #define RCP_PORT_LIGHT       0x04  // Light on/off
+#define RCP_PORT_DRIVE       0x05  // Combined speed/steering/light/horn setpoint
+#define RCP_PORT_BATCH       0x0F  // Several control records in one frame
 
 // System Commands (0x10-0x1F)
 #define RCP_PORT_SYSTEM      0x10  // System commands
@@ -35,15 +56,48 @@ extern "C" {
 // Response Commands (0x80-0xFF)
 #define RCP_PORT_BATTERY     0x80  // Battery status response
 #define RCP_PORT_TELEMETRY   0x81  // Telemetry data response
+#define RCP_PORT_VERSION     0x82  // Protocol version response (reply to RCP_SYS_HELLO)
+#define RCP_PORT_PONG        0x83  // Ping reply with device timestamps
+#define RCP_PORT_TELEMETRY_DELTA 0x84  // Changed telemetry fields since the previous frame
+#define RCP_PORT_LOG         0x85  // One console log line, UTF-8 text without newline
+#define RCP_PORT_METRICS     0x86  // Metrics registry snapshot, layout in metrics.h
+#define RCP_PORT_TASKS       0x87  // Page of per-task CPU and stack figures
 #define RCP_PORT_ACK         0xFF  // Acknowledgment
 
 // Reserved/Invalid
 #define RCP_PORT_INVALID     0x00  // Invalid/reserved port
 
+// Number of addressable ports (one table entry per port byte value)
+#define RCP_PORT_COUNT       256
+
 // Error codes
 #define RCP_ERR_INVALID_PORT    (ESP_ERR_INVALID_ARG + 1)
 #define RCP_ERR_INVALID_SIZE    (ESP_ERR_INVALID_SIZE)
 
+/**
+ * @brief Drive setpoint payload (Port 0x05)
+ *
+ * Carries the complete control state of one input tick, so motor, servo
+ * and LEDs are updated together by a single handler call.
+ */
+#pragma pack(1)
+typedef struct {
+    int8_t speed;         // Motor speed (-100 to +100)
+    int8_t steering;      // Servo position (-100 to +100)
+    uint8_t flags;        // RCP_DRIVE_FLAG_* bits
+    uint16_t sequence;    // Sender sequence number, incremented per frame
+} rcp_drive_body_t;
+#pragma pack()
+
+// Drive flags
+#define RCP_DRIVE_FLAG_LIGHT     0x01  // Light on
+#define RCP_DRIVE_FLAG_HORN      0x02  // Horn on
+#define RCP_DRIVE_FLAGS_MASK     (RCP_DRIVE_FLAG_LIGHT | RCP_DRIVE_FLAG_HORN)
+
+// Drive frames this far behind the last applied sequence are treated as a
+// new sender stream (e.g. a reconnected client) instead of stale frames
+#define RCP_DRIVE_SEQ_RESET_WINDOW  1024
+
 /**
  * @brief Battery status response payload (Port 0x80)
  */
@@ -65,9 +119,26 @@ typedef struct {
     uint8_t horn_state;   // Horn state
     uint8_t light_state;  // Light state
     uint8_t flags;        // Status flags
+    uint8_t link_rtt_ms;  // Heartbeat RTT of the receiving client, saturates at 255 (0 = unknown)
 } rcp_telemetry_body_t;
 #pragma pack()
 
+// Telemetry status flags
+#define RCP_TELEMETRY_FLAG_MOTOR_ENABLED  0x01  // Motor driver initialized and enabled
+#define RCP_TELEMETRY_FLAG_MOTOR_BRAKE    0x02  // Motor in brake mode
+#define RCP_TELEMETRY_FLAG_SERVO_READY    0x04  // Servo initialized
+#define RCP_TELEMETRY_FLAG_FAILSAFE       0x08  // Link-loss failsafe holds the outputs
+
+// Delta telemetry (Port 0x84): [mask][changed fields in rcp_telemetry_body_t order]
+// Full frames (keyframes) are sent on RCP_PORT_TELEMETRY
+#define RCP_TELEMETRY_FIELD_SPEED   0x01
+#define RCP_TELEMETRY_FIELD_ANGLE   0x02
+#define RCP_TELEMETRY_FIELD_HORN    0x04
+#define RCP_TELEMETRY_FIELD_LIGHT   0x08
+#define RCP_TELEMETRY_FIELD_FLAGS   0x10
+#define RCP_TELEMETRY_FIELD_LINK_RTT 0x20
+#define RCP_TELEMETRY_FIELD_COUNT   6
+
 /**
  * @brief System command payload (Port 0x10)
  */
@@ -83,20 +154,299 @@ typedef struct {
 #define RCP_SYS_RESET        0x02  // Reset system
 #define RCP_SYS_STATUS       0x03  // Request status
 #define RCP_SYS_CONFIG       0x04  // Configuration request
+#define RCP_SYS_HELLO        0x05  // Version negotiation, param = highest major version supported
+#define RCP_SYS_TELEMETRY    0x06  // Telemetry subscription, param = rate in Hz (0 = unsubscribe)
+#define RCP_SYS_TELEMETRY_DELTA 0x07  // Delta telemetry subscription, param = rate in Hz
+#define RCP_SYS_TELEMETRY_KEYFRAME 0x08  // Request a full telemetry frame on the next tick
+#define RCP_SYS_ROLE         0x09  // Set the client role, param = RCP_ROLE_*
+#define RCP_SYS_LOG          0x0A  // Console log subscription, param = 1 on, 0 off
+#define RCP_SYS_LOG_LEVEL    0x0B  // Set a tag log level, see below
+#define RCP_SYS_METRICS      0x0C  // Request a metrics snapshot on RCP_PORT_METRICS
+#define RCP_SYS_TASKS        0x0D  // Request task stats on RCP_PORT_TASKS, param = first task index
+#define RCP_SYS_BROADCASTS   0x0E  // Choose the broadcasts received, param = RCP_BROADCAST_* bits
+
+// Broadcasts a client receives (RCP_SYS_BROADCASTS), both on at connect
+#define RCP_BROADCAST_BATTERY  0x01  // Battery reports on RCP_PORT_BATTERY
+#define RCP_BROADCAST_STATUS   0x02  // Replies to commands issued on the device itself
+
+// Client roles
+#define RCP_ROLE_CONTROL     0x00  // May drive (default)
+#define RCP_ROLE_MONITOR     0x01  // Receives data only, control ports are rejected
+
+// Log level payload (Port 0x10, command RCP_SYS_LOG_LEVEL):
+// [RCP_SYS_LOG_LEVEL][level][tag...], level as esp_log_level_t (0 = none,
+// 5 = verbose), tag without terminator, "*" for every tag. Only the TAGs
+// of the firmware modules are accepted, and monitor clients are refused.
+#define RCP_SYS_LOG_TAG_MAX        31
+#define RCP_SYS_LOG_LEVEL_MAX_SIZE (2 + RCP_SYS_LOG_TAG_MAX)
+
+/**
+ * @brief Extended ping payload (Port 0x10, command RCP_SYS_PING)
+ *
+ * The 2-byte form [RCP_SYS_PING][id] is still accepted and answered with a
+ * zero client timestamp.
+ */
+#pragma pack(1)
+typedef struct {
+    uint8_t command;          // RCP_SYS_PING
+    uint8_t id;               // Echoed in the pong
+    uint32_t client_time_us;  // Sender clock, echoed in the pong
+    uint32_t last_rtt_us;     // RTT the client measured for its previous ping (0 = none)
+} rcp_ping_body_t;
+#pragma pack()
+
+/**
+ * @brief Pong payload (Port 0x83)
+ *
+ * Device times are the low 32 bits of esp_timer_get_time(); tx - rx is the
+ * device processing time to subtract from the client RTT.
+ */
+#pragma pack(1)
+typedef struct {
+    uint8_t id;               // Ping id
+    uint32_t client_time_us;  // Ping client_time_us
+    uint32_t rx_time_us;      // Device time the ping was received
+    uint32_t tx_time_us;      // Device time the pong was queued
+} rcp_pong_body_t;
+#pragma pack()
+
+/**
+ * @brief Task stats page (Port 0x87, reply to RCP_SYS_TASKS)
+ *
+ * Body is [total tasks][first index][entry count] followed by the entries.
+ * Clients ask again with param = first + count until first + count = total.
+ */
+#pragma pack(1)
+typedef struct {
+    uint8_t priority;         // Current priority
+    int8_t core;              // Pinned core, -1 = no affinity
+    uint16_t cpu_permille;    // Share of all cores over the sampling window
+    uint32_t stack_free_min;  // Stack high-water mark in bytes
+    char name[16];            // NUL padded
+} rcp_task_entry_t;
+#pragma pack()
+
+#define RCP_TASKS_HEADER_SIZE 3
+#define RCP_TASKS_PER_PAGE   ((RCP_MAX_BODY_SIZE - RCP_TASKS_HEADER_SIZE) / sizeof(rcp_task_entry_t))
+
+// RTT histogram: bucket i counts samples below (1 << i) ms, the last bucket the rest
+#define RCP_RTT_BUCKETS      12
+#define RCP_RTT_WINDOW       64    // Samples kept in the rolling histogram
+
+/**
+ * @brief Rolling RTT statistics reported by clients
+ */
+typedef struct {
+    uint32_t buckets[RCP_RTT_BUCKETS];  // Samples per bucket over the window
+    uint32_t samples;                   // Samples in the window
+    uint32_t total_samples;             // Samples since boot
+    uint32_t last_us;                   // Most recent RTT
+    uint32_t min_us;                    // Minimum over the window
+    uint32_t max_us;                    // Maximum over the window
+} rcp_rtt_stats_t;
+
+/**
+ * @brief Protocol version response payload (Port 0x82)
+ */
+#pragma pack(1)
+typedef struct {
+    uint8_t major;          // Firmware RCP_VERSION_MAJOR
+    uint8_t minor;          // Firmware RCP_VERSION_MINOR
+    uint8_t header_version; // Header version accepted from this client from now on
+} rcp_version_body_t;
+#pragma pack()
+
+/**
+ * @brief Per-connection protocol state
+ *
+ * Owned by the transport (one per WebSocket client) and passed along with
+ * every frame received from that client.
+ */
+typedef struct {
+    int client_id;                              // Transport identifier (socket fd)
+    uint8_t header_version;                     // Negotiated header version (1 or 2)
+    uint8_t role;                               // RCP_ROLE_*
+    bool clock_valid;                           // min_delay_ms holds a measurement
+    int32_t min_delay_ms;                       // Lowest (device time - sender time) seen
+    int64_t min_delay_aged_us;                  // Last time min_delay_ms was aged
+    uint16_t seq_valid;                         // Bit per tracked port with a last_seq
+    uint16_t last_seq[RCP_SEQ_TRACKED_PORTS];   // Last applied sequence per control port
+    bool drive_seq_valid;                       // drive_last_seq holds a value
+    uint16_t drive_last_seq;                    // Last applied rcp_drive_body_t.sequence
+} rcp_session_t;
+
+/**
+ * @brief Per-port counters
+ */
+typedef struct {
+    uint32_t rx_frames;       // Frames dispatched to the port
+    uint32_t errors;          // Frames rejected by checks or failed by the handler
+    uint32_t dropped_stale;   // v2 frames not newer than the last applied sequence
+    uint32_t dropped_late;    // v2 frames delayed beyond RCP_MAX_FRAME_AGE_MS
+} rcp_port_stats_t;
+
+/**
+ * @brief Decoded RCP frame
+ *
+ * Produced by rcp_decode_frame(). The body pointer refers directly into the
+ * receive buffer, so the frame is only valid while that buffer is untouched.
+ */
+typedef struct {
+    uint8_t port;             // Destination port
+    uint16_t declared_len;    // Body length declared in the header
+    const uint8_t* body;      // Pointer to the body inside the receive buffer
+    size_t body_len;          // Usable body length (clamped to the bytes received)
+    uint8_t header_version;   // 1 for [len][port] headers, 2 when seq/timestamp are present
+    uint16_t seq;             // Sender sequence number (v2 only)
+    uint32_t timestamp_ms;    // Sender clock in milliseconds (v2 only)
+    int64_t rx_time_us;       // Device time the frame was received
+    rcp_session_t* session;   // Sending connection, NULL for local callers
+} rcp_frame_t;
+
+/**
+ * @brief Port handler
+ *
+ * Called only after the generic length/range checks of its table entry
+ * passed, so the handler can read its body without re-validating it.
+ */
+typedef esp_err_t (*rcp_port_handler_t)(const rcp_frame_t* frame);
+
+/**
+ * @brief Optional extra body check for bodies with several ranged fields
+ */
+typedef esp_err_t (*rcp_port_validator_t)(const uint8_t* body, size_t body_len);
+
+// Port entry flags
+#define RCP_PORT_FLAG_RANGE      0x01  // Check the first body byte against value_min/value_max
+#define RCP_PORT_FLAG_SIGNED     0x02  // First body byte is a signed value
+#define RCP_PORT_FLAG_BATCHABLE  0x04  // Port may appear inside a RCP_PORT_BATCH body
+
+/**
+ * @brief Port table entry
+ */
+typedef struct {
+    rcp_port_handler_t handler;       // Handler, NULL when the port is not built in
+    rcp_port_validator_t validate;    // Optional extra check, run after the generic ones
+    uint16_t min_len;                 // Minimum body length
+    uint16_t max_len;                 // Maximum body length (== min_len for fixed-size bodies)
+    int16_t value_min;                // Lowest accepted first-byte value (RCP_PORT_FLAG_RANGE)
+    int16_t value_max;                // Highest accepted first-byte value (RCP_PORT_FLAG_RANGE)
+    uint8_t flags;                    // RCP_PORT_FLAG_* bits
+} rcp_port_entry_t;
+
+// Entry with a single-byte body whose value must lie in [lo, hi]
+#define RCP_PORT_ENTRY_RANGE(fn, lo, hi, entry_flags) \
+    { .handler = (fn), .min_len = 1, .max_len = 1, .value_min = (lo), .value_max = (hi), \
+      .flags = (uint8_t)(RCP_PORT_FLAG_RANGE | (entry_flags)) }
+
+/**
+ * @brief Dispatch a decoded frame through the port table
+ *
+ * Looks up the port in O(1), runs the generic length/range checks of its
+ * entry and calls the handler.
+ *
+ * @param frame Decoded frame
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t rcp_dispatch(const rcp_frame_t* frame);
+
+/**
+ * @brief Decode an RCP frame in place
+ *
+ * No copy or allocation is made: the decoded body points into @p data.
+ *
+ * @param data Pointer to the raw frame ([len_lo][len_hi][port][body...])
+ * @param len Number of bytes available in @p data
+ * @param frame Output decoded frame
+ * @return ESP_OK on success, RCP_ERR_INVALID_SIZE if the frame is too short
+ */
+esp_err_t rcp_decode_frame(const uint8_t* data, size_t len, rcp_frame_t* frame);
+
+/**
+ * @brief Decode and process a raw RCP frame
+ *
+ * v2 frames are only accepted once the session negotiated them. Control
+ * frames that are not newer than the last applied sequence on their port,
+ * or that arrive later than RCP_MAX_FRAME_AGE_MS, are dropped and counted.
+ *
+ * @param session Sending connection (may be NULL)
+ * @param data Pointer to the raw frame
+ * @param len Number of bytes available in @p data
+ * @return ESP_OK on success or silent drop, error code on failure
+ */
+esp_err_t rcp_process_frame(rcp_session_t* session, const uint8_t* data, size_t len);
+
+/**
+ * @brief Reset a session for a newly connected client
+ *
+ * @param session Session to initialize
+ * @param client_id Transport identifier of the client
+ */
+void rcp_session_init(rcp_session_t* session, int client_id);
+
+/**
+ * @brief Read the counters of a port
+ *
+ * @param port Port number
+ * @param stats Output counters
+ * @return ESP_OK on success
+ */
+esp_err_t rcp_get_port_stats(uint8_t port, rcp_port_stats_t* stats);
 
+/**
+ * @brief Check whether a port has a handler in the port table
+ *
+ * @param port Port number
+ * @return true if frames on the port are dispatched to a handler
+ */
+bool rcp_port_is_known(uint8_t port);
 
+/**
+ * @brief Read the rolling histogram of client-reported RTTs
+ *
+ * @param stats Output statistics
+ * @return ESP_OK on success
+ */
+esp_err_t rcp_get_rtt_stats(rcp_rtt_stats_t* stats);
+
+/**
+ * @brief Send an RCP response to a single client
+ *
+ * @param client_id Destination connection (rcp_session_t.client_id)
+ * @param port Response port
+ * @param body Pointer to payload data
+ * @param body_len Length of payload
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t rcp_send_to(int client_id, uint8_t port, const void* body, size_t body_len);
 
 /**
  * @brief Process incoming RCP message
  * 
- * @param data Pointer to message data
- * @param len Length of message
+ * @param port Destination port
+ * @param body Pointer to message body
+ * @param body_len Length of message body
  * @return ESP_OK on success, error code on failure
  */
 esp_err_t rcp_process_message(uint8_t port, const uint8_t* body, size_t body_len);
 
+/**
+ * @brief Check an RCP message without applying it
+ *
+ * Runs the generic checks of the port's table entry with no side effects. Used to validate every record of a batch before any is applied.
+ *
+ * @param port Destination port
+ * @param body Pointer to message body
+ * @param body_len Length of message body
+ * @return ESP_OK if the message would be accepted, error code otherwise
+ */
+esp_err_t rcp_validate_message(uint8_t port, const uint8_t* body, size_t body_len);
+
 /**
  * @brief Send RCP response message
+ *
+ * Broadcast to the clients that receive the matching stream: battery
+ * reports to WS_STREAM_BATTERY, everything else to WS_STREAM_STATUS.
  * 
  * @param port Response port
  * @param body Pointer to payload data
@@ -115,18 +465,6 @@ esp_err_t rcp_send_response(uint8_t port, const void* body, size_t body_len);
  */
 esp_err_t rcp_send_battery_status(uint16_t voltage_mv, uint8_t level, uint8_t type);
 
-/**
- * @brief Create and send telemetry response
- * 
- * @param speed Current motor speed
- * @param angle Current servo angle
- * @param horn_state Horn state
- * @param light_state Light state
- * @param flags Status flags
- * @return ESP_OK on success, error code on failure
- */
-esp_err_t rcp_send_telemetry(int8_t speed, int8_t angle, uint8_t horn_state, uint8_t light_state, uint8_t flags);
-
 /**
  * @brief Initialize RCP protocol
  * 
@@ -41,6 +41,7 @@ typedef struct {
 // Function declarations
 esp_err_t servo_control_init(void);
 esp_err_t servo_control_set_position(int position);
+esp_err_t servo_control_get_position(int *position);
 esp_err_t servo_control_get_calibration(servo_calibration_t *calibration);
 esp_err_t servo_control_apply_calibration(const servo_calibration_t *calibration, bool move_to_center);
 void servo_control_deinit(void);
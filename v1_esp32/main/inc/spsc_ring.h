@@ -0,0 +1,92 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// SPSC RING TYPES
+// =============================================================================
+
+/**
+ * @brief Single-producer/single-consumer ring of fixed-size items
+ *
+ * Lock-free between one producer task and one consumer task, on the same
+ * core or on different cores. Storage is supplied by the caller, usually
+ * static (see SPSC_RING_DEFINE). Capacity must be a power of two.
+ *
+ * Only depends on C11 atomics, so it also builds on the host.
+ */
+typedef struct {
+    uint8_t *storage;
+    size_t item_size;
+    uint32_t mask;              // capacity - 1
+    atomic_uint head;           // Next slot to write, only written by the producer
+    atomic_uint tail;           // Next slot to read, only written by the consumer
+} spsc_ring_t;
+
+/**
+ * @brief Define a static ring and its storage
+ *
+ * @param name Ring variable name
+ * @param type Item type
+ * @param capacity Number of items, power of two
+ */
+#define SPSC_RING_DEFINE(name, type, capacity)                                  \
+    _Static_assert(((capacity) & ((capacity) - 1)) == 0 && (capacity) > 0,    \
+                   #name " capacity must be a power of two");                 \
+    static type name##_storage[capacity];                                     \
+    static spsc_ring_t name = {                                               \
+        .storage = (uint8_t *)name##_storage,                                 \
+        .item_size = sizeof(type),                                            \
+        .mask = (capacity) - 1,                                               \
+    }
+
+// =============================================================================
+// SPSC RING API
+// =============================================================================
+
+/**
+ * @brief Initialize a ring over caller storage
+ *
+ * @param ring Ring to initialize
+ * @param storage Buffer of @p capacity * @p item_size bytes
+ * @param item_size Size of one item
+ * @param capacity Number of items, power of two
+ * @return true on success, false if @p capacity is not a power of two
+ */
+bool spsc_ring_init(spsc_ring_t *ring, void *storage, size_t item_size, uint32_t capacity);
+
+/**
+ * @brief Append an item, producer only
+ *
+ * @return true when queued, false when the ring is full
+ */
+bool spsc_ring_push(spsc_ring_t *ring, const void *item);
+
+/**
+ * @brief Remove the oldest item, consumer only
+ *
+ * @param[out] item Buffer of item_size bytes
+ * @return true when an item was read, false when the ring is empty
+ */
+bool spsc_ring_pop(spsc_ring_t *ring, void *item);
+
+/**
+ * @brief Number of queued items
+ *
+ * Exact from the producer or consumer, a snapshot from anywhere else.
+ */
+uint32_t spsc_ring_count(spsc_ring_t *ring);
+
+/**
+ * @brief Capacity of the ring
+ */
+static inline uint32_t spsc_ring_capacity(const spsc_ring_t *ring)
+{
+    return ring->mask + 1;
+}
+
+#endif // __SPSC_RING_H__
@@ -0,0 +1,70 @@
+#ifndef __TASK_STATS_H__
+#define __TASK_STATS_H__
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/**
+ * @file task_stats.h
+ * @brief Per-task CPU load and stack usage
+ *
+ * A low priority task samples the FreeRTOS run-time counters every
+ * TASK_STATS_SAMPLE_MS and keeps the last TASK_STATS_WINDOW_SAMPLES of them,
+ * so CPU load is averaged over a sliding window instead of since boot.
+ * Served as JSON on /api/system-info/tasks and in pages on RCP_PORT_TASKS.
+ *
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS in sdkconfig.
+ */
+
+// =============================================================================
+// TASK STATS CONFIGURATION
+// =============================================================================
+
+#define TASK_STATS_MAX_TASKS        32      // Tasks tracked, extra ones are ignored
+#define TASK_STATS_SAMPLE_MS        1000    // Run-time counter sample period
+#define TASK_STATS_WINDOW_SAMPLES   5       // Samples kept, the window is (n - 1) periods
+#define TASK_STATS_TASK_STACK_SIZE  3072
+#define TASK_STATS_TASK_PRIORITY    1       // Just above idle
+
+// =============================================================================
+// TASK STATS TYPES
+// =============================================================================
+
+/**
+ * @brief Load and stack figures of one task
+ */
+typedef struct {
+    char name[16];              // Truncated to configMAX_TASK_NAME_LEN
+    uint8_t priority;           // Current priority
+    int8_t core;                // Pinned core, -1 when the task may run on any
+    uint16_t cpu_permille;      // Share of all cores over the window, 1000 = every core busy
+    uint32_t stack_free_min;    // Stack high-water mark, bytes never used
+} task_stats_entry_t;
+
+// =============================================================================
+// TASK STATS API
+// =============================================================================
+
+/**
+ * @brief Start the sampling task
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t task_stats_start(void);
+
+/**
+ * @brief Copy the figures of the last sample
+ *
+ * Tasks keep the order of uxTaskGetSystemState() between two calls unless
+ * tasks were created or deleted in between.
+ *
+ * @param first Index of the first task to copy
+ * @param[out] entries Destination
+ * @param max_entries Size of entries
+ * @param[out] total Tasks in the sample, may be NULL
+ * @return Entries copied
+ */
+int task_stats_read(int first, task_stats_entry_t *entries, int max_entries, int *total);
+
+#endif // __TASK_STATS_H__
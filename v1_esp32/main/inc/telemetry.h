@@ -0,0 +1,141 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "project_config.h"
+
+#if ENABLE_TELEMETRY
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rcp_protocol.h"
+#include "ws_clients.h"
+
+// =============================================================================
+// TELEMETRY CONFIGURATION
+// =============================================================================
+
+#define TELEMETRY_MIN_RATE_HZ       10      // Slowest rate a client may request
+#define TELEMETRY_MAX_RATE_HZ       100     // Fastest rate a client may request
+#define TELEMETRY_MAX_SUBSCRIBERS   WS_CLIENTS_MAX
+#define TELEMETRY_KEYFRAME_INTERVAL 50      // Delta mode: full frame every N ticks
+#define TELEMETRY_BATTERY_RING_SIZE 4       // Battery readings waiting for broadcast, power of two
+
+#define TELEMETRY_TASK_STACK_SIZE   3072
+#define TELEMETRY_TASK_PRIORITY     5
+
+// =============================================================================
+// TELEMETRY TYPES
+// =============================================================================
+
+/**
+ * @brief Telemetry publisher counters
+ */
+typedef struct {
+    uint32_t keyframes;     // Full frames sent
+    uint32_t deltas;        // Delta frames sent
+    uint32_t unchanged;     // Delta ticks skipped because nothing changed
+    uint32_t bytes;         // RCP bytes sent (headers included)
+} telemetry_stats_t;
+
+// =============================================================================
+// TELEMETRY API
+// =============================================================================
+
+/**
+ * @brief Read the current actuator state
+ *
+ * Values come from the modules themselves (motor driver state, servo
+ * position, LED outputs), not from the last command received. The
+ * per-client link_rtt_ms is left 0, see telemetry_link_rtt_ms().
+ *
+ * @param[out] telemetry Telemetry payload to fill
+ */
+void telemetry_read(rcp_telemetry_body_t *telemetry);
+
+/**
+ * @brief Heartbeat RTT of a client in telemetry units
+ *
+ * @param client_id WebSocket client (socket fd)
+ * @return RTT in milliseconds, saturated at 255, 0 if unknown
+ */
+uint8_t telemetry_link_rtt_ms(int client_id);
+
+/**
+ * @brief Encode the fields of @p current that differ from @p previous
+ *
+ * @param previous Last state the client received
+ * @param current State to send
+ * @param[out] out Buffer of at least 1 + RCP_TELEMETRY_FIELD_COUNT bytes
+ * @return Encoded length, 0 if nothing changed
+ */
+size_t telemetry_encode_delta(const rcp_telemetry_body_t *previous,
+                              const rcp_telemetry_body_t *current, uint8_t *out);
+
+/**
+ * @brief Subscribe a client to the telemetry stream
+ *
+ * Subscribing again changes the rate and mode. The first frame after a
+ * subscription is always a keyframe.
+ *
+ * @param client_id WebSocket client (socket fd)
+ * @param rate_hz Requested rate, clamped to TELEMETRY_MIN_RATE_HZ..TELEMETRY_MAX_RATE_HZ
+ * @param delta true to receive delta frames between keyframes
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all subscriber slots are used
+ */
+esp_err_t telemetry_subscribe(int client_id, uint8_t rate_hz, bool delta);
+
+/**
+ * @brief Make the next frame for a client a keyframe
+ *
+ * @param client_id WebSocket client (socket fd)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the client is not subscribed
+ */
+esp_err_t telemetry_request_keyframe(int client_id);
+
+/**
+ * @brief Read the publisher counters
+ *
+ * @param[out] stats Counters
+ */
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+/**
+ * @brief Queue a battery reading for broadcast by the telemetry task
+ *
+ * Hands the reading over through a lock-free SPSC ring, so the only
+ * producer allowed is the battery monitoring task.
+ *
+ * @param status Battery status body
+ * @return ESP_OK when queued, ESP_ERR_NO_MEM when the ring is full
+ */
+esp_err_t telemetry_post_battery(const rcp_battery_body_t *status);
+
+/**
+ * @brief Remove a client from the telemetry stream
+ *
+ * Safe to call for clients that never subscribed.
+ *
+ * @param client_id WebSocket client (socket fd)
+ */
+void telemetry_unsubscribe(int client_id);
+
+/**
+ * @brief Start the telemetry publisher task
+ *
+ * The task sleeps while there are no subscribers and no battery reading
+ * is queued.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t telemetry_start_task(void);
+
+/**
+ * @brief Stop the telemetry publisher task
+ */
+void telemetry_stop_task(void);
+
+#endif // ENABLE_TELEMETRY
+
+#endif // __TELEMETRY_H__
@@ -0,0 +1,157 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "project_config.h"
+
+/**
+ * @file trace.h
+ * @brief Command latency trace points with Chrome trace export
+ *
+ * Trace points record esp_timer timestamps into a RAM ring that overwrites
+ * its oldest events. trace_dump_json() writes the ring as Chrome trace-event
+ * JSON, served on /api/trace and viewable in Perfetto (ui.perfetto.dev) or
+ * chrome://tracing.
+ *
+ * Spans are recorded once, when they end, so early returns only lose the
+ * span and never leave an unmatched begin:
+ *
+ *   uint32_t start = TRACE_START();
+ *   ret = drv8833_set_speed(speed);
+ *   TRACE_SPAN(TRACE_DRV8833_SET_SPEED, start, speed);
+ *
+ * Flows link a span on one task to a span on another, here a setpoint
+ * published by the httpd task and applied by the control task.
+ *
+ * With ENABLE_TRACE set to 0 every macro compiles to nothing.
+ */
+
+// =============================================================================
+// TRACE CONFIGURATION
+// =============================================================================
+
+#define TRACE_RING_SIZE             512     // Events kept, power of two
+#define TRACE_CHUNK_SIZE            1024    // JSON written per httpd_resp_send_chunk()
+
+/**
+ * @brief Trace points: X(id, name, category)
+ *
+ * The name is what Perfetto shows on the span.
+ */
+#define TRACE_POINTS(X)                                                         \
+    X(TRACE_WS_FRAME,            "ws_frame",                   "http")          \
+    X(TRACE_RCP_DISPATCH,        "rcp_dispatch",               "rcp")           \
+    X(TRACE_SETPOINT,            "setpoint",                   "control")       \
+    X(TRACE_CONTROL_APPLY,       "control_apply",              "control")       \
+    X(TRACE_MOTOR_SET_SPEED,     "motor_control_set_speed",    "motor")         \
+    X(TRACE_DRV8833_SET_SPEED,   "drv8833_set_speed",          "motor")         \
+    X(TRACE_LEDC_UPDATE,         "ledc_update_duty",           "motor")         \
+    X(TRACE_SERVO_SET_POSITION,  "servo_control_set_position", "servo")
+
+#define TRACE_POINT_ID(id, name, category)  id,
+
+typedef enum {
+    TRACE_POINTS(TRACE_POINT_ID)
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+// =============================================================================
+// TRACE TYPES
+// =============================================================================
+
+typedef enum {
+    TRACE_PHASE_SPAN = 'X',         // Complete event, ts + duration
+    TRACE_PHASE_INSTANT = 'i',
+    TRACE_PHASE_FLOW_START = 's',
+    TRACE_PHASE_FLOW_END = 'f',
+} trace_phase_t;
+
+/**
+ * @brief One ring entry
+ *
+ * Timestamps are the low 32 bits of esp_timer_get_time(), so a dump spans
+ * at most 71 minutes, far more than the ring holds.
+ */
+typedef struct {
+    atomic_uint seq;                // Ring index + 1 once written, 0 while being written
+    uint32_t ts_us;
+    uint32_t dur_us;
+    uint32_t tid;                   // Recording task
+    uint32_t arg;                   // Value shown in the span args, flow id for flows
+    uint8_t point;                  // trace_point_t
+    uint8_t phase;                  // trace_phase_t
+} trace_event_t;
+
+// =============================================================================
+// TRACE API
+// =============================================================================
+
+/**
+ * @brief Record one event, safe from any task
+ *
+ * @param point Trace point
+ * @param phase Event phase
+ * @param start_us Start time for spans, ignored otherwise
+ * @param arg Span argument or flow id
+ */
+void trace_record(trace_point_t point, trace_phase_t phase, uint32_t start_us, uint32_t arg);
+
+/**
+ * @brief Current trace clock
+ */
+uint32_t trace_now(void);
+
+/**
+ * @brief Turn recording on or off, on after boot
+ */
+void trace_set_enabled(bool enabled);
+
+/**
+ * @brief Drop every recorded event
+ */
+void trace_clear(void);
+
+/**
+ * @brief Writer used by trace_dump_json(), returns ESP_OK to continue
+ */
+typedef esp_err_t (*trace_write_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Write the ring as Chrome trace-event JSON, oldest event first
+ *
+ * Events recorded during the dump are not included. Output is handed to
+ * @p write in pieces of at most TRACE_CHUNK_SIZE bytes.
+ *
+ * @param write Output function
+ * @param ctx Passed to @p write
+ * @return ESP_OK, ESP_ERR_NO_MEM, or the first error returned by @p write
+ */
+esp_err_t trace_dump_json(trace_write_fn_t write, void *ctx);
+
+// =============================================================================
+// TRACE MACROS
+// =============================================================================
+
+#if ENABLE_TRACE
+
+#define TRACE_START()                           trace_now()
+#define TRACE_SPAN(point, start, arg)           trace_record((point), TRACE_PHASE_SPAN, (start), (uint32_t)(arg))
+#define TRACE_INSTANT(point, arg)               trace_record((point), TRACE_PHASE_INSTANT, 0, (uint32_t)(arg))
+#define TRACE_FLOW_START(point, flow_id)        trace_record((point), TRACE_PHASE_FLOW_START, 0, (uint32_t)(flow_id))
+#define TRACE_FLOW_END(point, flow_id)          trace_record((point), TRACE_PHASE_FLOW_END, 0, (uint32_t)(flow_id))
+
+#else
+
+#define TRACE_START()                           0u
+#define TRACE_SPAN(point, start, arg)           ((void)(start))
+#define TRACE_INSTANT(point, arg)               ((void)0)
+#define TRACE_FLOW_START(point, flow_id)        ((void)0)
+#define TRACE_FLOW_END(point, flow_id)          ((void)0)
+
+#endif
+
+#endif // __TRACE_H__
@@ -0,0 +1,54 @@
+#ifndef __VIDEO_SERVER_H__
+#define __VIDEO_SERVER_H__
+
+#include "project_config.h"
+
+#if ENABLE_CAMERA_SUPPORT
+
+#include <esp_err.h>
+#include <stdbool.h>
+
+// =============================================================================
+// VIDEO SERVER CONFIGURATION
+// =============================================================================
+
+#define VIDEO_SERVER_PORT           81      // MJPEG stream at http://<device>:81/video
+#define VIDEO_SERVER_CTRL_PORT      32769   // Must differ from the main server
+#define VIDEO_SERVER_PRIORITY       4       // Below the main httpd task (5)
+#define VIDEO_SERVER_CORE           0       // Away from the control task core
+#define VIDEO_MAX_STREAMS           2       // Concurrent /video clients
+#define VIDEO_STREAM_STACK_SIZE     4096
+#define VIDEO_STREAM_PRIORITY       3       // Below both httpd tasks
+
+// =============================================================================
+// VIDEO SERVER API
+// =============================================================================
+
+/**
+ * @brief Start the MJPEG server
+ *
+ * Video runs on its own httpd instance, so a stream never blocks the
+ * task that serves /ws and the API. Each stream is handed to its own task,
+ * so viewers do not block each other or the video server either.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t video_server_start(void);
+
+/**
+ * @brief Stop the MJPEG server
+ *
+ * Running streams end after their current frame. Returns once every stream
+ * task has completed its async request, the send timeout of the server
+ * bounds how long a stalled client can hold it up.
+ */
+void video_server_stop(void);
+
+/**
+ * @brief Number of running streams
+ */
+int video_server_get_stream_count(void);
+
+#endif // ENABLE_CAMERA_SUPPORT
+
+#endif // __VIDEO_SERVER_H__
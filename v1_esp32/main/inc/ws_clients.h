@@ -0,0 +1,192 @@
+#ifndef __WS_CLIENTS_H__
+#define __WS_CLIENTS_H__
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "rcp_protocol.h"
+
+// =============================================================================
+// WEBSOCKET CLIENT REGISTRY CONFIGURATION
+// =============================================================================
+
+#define WS_CLIENTS_MAX          5       // Concurrent WebSocket clients
+
+#define WS_HEARTBEAT_INTERVAL_MS    1000    // Server ping period
+#define WS_HEARTBEAT_MAX_MISSED     3       // Unanswered pings before a client is evicted
+
+// Streams a client receives (ws_client_info_t.streams)
+#define WS_STREAM_BATTERY       0x01    // Battery status broadcasts
+#define WS_STREAM_TELEMETRY     0x02    // Telemetry subscription active
+#define WS_STREAM_LOG           0x04    // Console log subscription active
+#define WS_STREAM_STATUS        0x08    // Replies to local commands and text broadcasts
+#define WS_STREAM_DEFAULT       (WS_STREAM_BATTERY | WS_STREAM_STATUS)     // Streams of a new client
+#define WS_STREAM_ALL           0xFF    // Every client, whatever its streams (snapshots only)
+
+// =============================================================================
+// WEBSOCKET CLIENT REGISTRY TYPES
+// =============================================================================
+
+/**
+ * @brief Client handle: slot index in the low byte, slot generation above
+ *
+ * A handle kept after its client left never matches the next client that
+ * reuses the slot. 0 is never a valid handle.
+ */
+typedef uint32_t ws_client_handle_t;
+
+#define WS_CLIENT_HANDLE_INVALID    0
+
+/**
+ * @brief Client reference for sending, copied out of the registry
+ */
+typedef struct {
+    ws_client_handle_t handle;
+    int fd;
+} ws_client_ref_t;
+
+/**
+ * @brief Client state snapshot
+ */
+typedef struct {
+    ws_client_handle_t handle;
+    int fd;                     // Socket fd
+    uint8_t role;               // RCP_ROLE_*
+    uint8_t streams;            // WS_STREAM_* bits
+    uint32_t rx_frames;         // Frames received
+    uint32_t rx_bytes;          // Payload bytes received
+    int64_t connected_us;       // esp_timer time of the handshake
+    uint32_t ping_id;           // Id of the last server ping
+    int64_t ping_sent_us;       // Send time of the outstanding ping, 0 if answered
+    uint8_t missed_pongs;       // Consecutive pings without a pong
+    uint32_t pongs;             // Pongs matched to a ping
+    uint32_t rtt_last_us;       // Ping to pong of the last answer
+    uint32_t rtt_avg_us;        // Smoothed RTT (1/8 weight per sample), 0 until the first pong
+    uint32_t rtt_max_us;        // Highest RTT seen
+} ws_client_info_t;
+
+// =============================================================================
+// WEBSOCKET CLIENT REGISTRY API
+// =============================================================================
+
+/**
+ * @brief Register a client, O(1)
+ *
+ * @param fd Socket fd of the WebSocket session
+ * @param[out] handle Handle of the new client
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all slots are used
+ */
+esp_err_t ws_clients_add(int fd, ws_client_handle_t *handle);
+
+/**
+ * @brief Unregister a client, O(1)
+ *
+ * Stale handles are ignored, so calling it twice is safe.
+ *
+ * @param handle Client handle
+ * @param[out] fd Socket fd of the removed client (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND for stale handles
+ */
+esp_err_t ws_clients_remove(ws_client_handle_t handle, int *fd);
+
+/**
+ * @brief Find the handle of a socket fd
+ *
+ * @param fd Socket fd
+ * @return Client handle, WS_CLIENT_HANDLE_INVALID if not registered
+ */
+ws_client_handle_t ws_clients_find_fd(int fd);
+
+/**
+ * @brief Get the RCP session of a client
+ *
+ * Only for the httpd task, which is also the only task that removes
+ * clients, so the pointer stays valid while the handler runs.
+ *
+ * @param handle Client handle
+ * @return Session, NULL for stale handles
+ */
+rcp_session_t *ws_clients_get_session(ws_client_handle_t handle);
+
+/**
+ * @brief Enable or disable a stream for a client
+ *
+ * @param fd Socket fd
+ * @param stream WS_STREAM_* bits
+ * @param enable true to add, false to remove
+ */
+void ws_clients_set_stream(int fd, uint8_t stream, bool enable);
+
+/**
+ * @brief Account a received frame
+ *
+ * @param handle Client handle
+ * @param bytes Payload length
+ */
+void ws_clients_record_rx(ws_client_handle_t handle, size_t bytes);
+
+/**
+ * @brief Start a heartbeat round for a client
+ *
+ * Counts the previous ping as missed if it was never answered, then
+ * records a new ping.
+ *
+ * @param handle Client handle
+ * @param now_us Send time
+ * @param[out] ping_id Id to put in the ping payload
+ * @return Consecutive missed pings, 0 for stale handles
+ */
+uint8_t ws_clients_ping_sent(ws_client_handle_t handle, int64_t now_us, uint32_t *ping_id);
+
+/**
+ * @brief Match a pong to the outstanding ping
+ *
+ * @param handle Client handle
+ * @param ping_id Id echoed in the pong payload
+ * @param now_us Receive time
+ * @return ESP_OK when matched, ESP_ERR_NOT_FOUND for stale handles or
+ *         pongs of older pings
+ */
+esp_err_t ws_clients_pong_received(ws_client_handle_t handle, uint32_t ping_id, int64_t now_us);
+
+/**
+ * @brief Smoothed heartbeat RTT of a client
+ *
+ * @param fd Socket fd
+ * @return RTT in microseconds, 0 if unknown
+ */
+uint32_t ws_clients_get_rtt_us(int fd);
+
+/**
+ * @brief Copy the clients receiving any of the given streams
+ *
+ * Safe from any task; the lock is only held while copying, so callers send
+ * to the returned references without holding it.
+ *
+ * @param[out] refs Array of at least @p max entries
+ * @param max Capacity of @p refs
+ * @param streams WS_STREAM_* bits, WS_STREAM_ALL for every client
+ * @return Number of references written
+ */
+int ws_clients_snapshot(ws_client_ref_t *refs, int max, uint8_t streams);
+
+/**
+ * @brief Copy the state of every client
+ *
+ * @param[out] info Array of at least @p max entries
+ * @param max Capacity of @p info
+ * @return Number of entries written
+ */
+int ws_clients_get_info(ws_client_info_t *info, int max);
+
+/**
+ * @brief Number of registered clients
+ */
+int ws_clients_count(void);
+
+/**
+ * @brief Unregister every client
+ */
+void ws_clients_clear(void);
+
+#endif // __WS_CLIENTS_H__
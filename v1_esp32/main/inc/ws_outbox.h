@@ -0,0 +1,130 @@
+#ifndef __WS_OUTBOX_H__
+#define __WS_OUTBOX_H__
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rcp_protocol.h"
+#include "ws_clients.h"
+
+// =============================================================================
+// WEBSOCKET OUTBOX CONFIGURATION
+// =============================================================================
+
+#define WS_OUTBOX_MAX_CLIENTS   WS_CLIENTS_MAX
+#define WS_OUTBOX_DEPTH         8       // Frames queued per client
+#define WS_OUTBOX_FRAME_MAX     (RCP_HEADER_SIZE + RCP_MAX_BODY_SIZE)
+#define WS_OUTBOX_RETRY_MS      10      // Poll period while a client socket is full
+
+#define WS_OUTBOX_TASK_STACK_SIZE   3072
+#define WS_OUTBOX_TASK_PRIORITY     5
+
+// =============================================================================
+// WEBSOCKET OUTBOX TYPES
+// =============================================================================
+
+/**
+ * @brief Called from the outbox task when a send to a client failed
+ *
+ * The client queue is already dropped; the callback closes the session.
+ */
+typedef void (*ws_outbox_error_cb_t)(int fd);
+
+/**
+ * @brief Per-client outbox counters
+ */
+typedef struct {
+    int fd;                 // WebSocket client (socket fd)
+    uint16_t depth;         // Frames currently queued
+    uint16_t max_depth;     // Highest depth seen
+    uint32_t enqueued;      // Frames accepted
+    uint32_t sent;          // Frames written to the socket
+    uint32_t coalesced;     // Queued frames replaced by a newer one of the same port
+    uint32_t dropped;       // Frames rejected because the queue was full
+    uint32_t blocked;       // Passes skipped because the socket was not writable
+} ws_outbox_stats_t;
+
+// =============================================================================
+// WEBSOCKET OUTBOX API
+// =============================================================================
+
+/**
+ * @brief Start the outbox task
+ *
+ * All WebSocket frames to clients go through per-client queues drained by
+ * this task, so a client whose socket is full only delays itself.
+ *
+ * @param server HTTP server the WebSocket sessions belong to
+ * @param on_error Called when a send to a client fails (may be NULL)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ws_outbox_init(httpd_handle_t server, ws_outbox_error_cb_t on_error);
+
+/**
+ * @brief Stop the outbox task and drop every queue
+ *
+ * Returns once the task has exited, so the server it sends on can be
+ * stopped right after.
+ */
+void ws_outbox_deinit(void);
+
+/**
+ * @brief Create the queue of a new client
+ *
+ * @param fd WebSocket client (socket fd)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all queues are used
+ */
+esp_err_t ws_outbox_add_client(int fd);
+
+/**
+ * @brief Drop the queue of a client
+ *
+ * @param fd WebSocket client (socket fd)
+ */
+void ws_outbox_remove_client(int fd);
+
+/**
+ * @brief Mark an RCP port as latest-value
+ *
+ * A queued frame of a coalescing port is replaced by the newest one, which
+ * moves to the tail so it still follows anything queued before it.
+ *
+ * @param port RCP port (third byte of the frame)
+ * @param coalesce true to keep only the newest frame of this port
+ */
+void ws_outbox_set_coalesce(uint8_t port, bool coalesce);
+
+/**
+ * @brief Queue a frame for one client
+ *
+ * @param fd WebSocket client (socket fd)
+ * @param type HTTPD_WS_TYPE_BINARY or HTTPD_WS_TYPE_TEXT
+ * @param data Frame payload
+ * @param len Payload length, at most WS_OUTBOX_FRAME_MAX
+ * @return ESP_OK when queued, ESP_ERR_NO_MEM when the client queue is full,
+ *         ESP_ERR_NOT_FOUND for unknown clients
+ */
+esp_err_t ws_outbox_send(int fd, httpd_ws_type_t type, const void *data, size_t len);
+
+/**
+ * @brief Queue a frame for every client
+ *
+ * @param type HTTPD_WS_TYPE_BINARY or HTTPD_WS_TYPE_TEXT
+ * @param data Frame payload
+ * @param len Payload length, at most WS_OUTBOX_FRAME_MAX
+ * @return Number of clients the frame was queued for
+ */
+int ws_outbox_broadcast(httpd_ws_type_t type, const void *data, size_t len);
+
+/**
+ * @brief Read the counters of every client queue
+ *
+ * @param[out] stats Array of at least @p max entries
+ * @param max Capacity of @p stats
+ * @return Number of entries written
+ */
+int ws_outbox_get_stats(ws_outbox_stats_t *stats, int max);
+
+#endif // __WS_OUTBOX_H__
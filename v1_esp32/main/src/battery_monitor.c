@@ -2,6 +2,7 @@
 
 #if ENABLE_BATTERY_MONITORING
 
+#include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
@@ -9,8 +10,14 @@
 #include <esp_adc/adc_cali.h>
 #include <esp_adc/adc_cali_scheme.h>
 #include <esp_http_server.h>
+#include <esp_timer.h>
 #include "http_server.h"
 #include "rcp_protocol.h"
+#include "metrics.h"
+
+#if ENABLE_TELEMETRY
+#include "telemetry.h"
+#endif
 
 static const char *TAG = "battery_monitor";
 
@@ -94,8 +101,8 @@ esp_err_t battery_monitor_init(void)
 
     ESP_LOGI(TAG, "Initializing battery monitor");
     ESP_LOGI(TAG, "ADC Channel: %d", battery_config.adc_channel);
-    ESP_LOGI(TAG, "Resistor R1: %lu ohms", battery_config.resistor_r1);
-    ESP_LOGI(TAG, "Resistor R2: %lu ohms", battery_config.resistor_r2);
+    ESP_LOGI(TAG, "Resistor R1: %" PRIu32 " ohms", battery_config.resistor_r1);
+    ESP_LOGI(TAG, "Resistor R2: %" PRIu32 " ohms", battery_config.resistor_r2);
     ESP_LOGI(TAG, "Battery Type: %dS", battery_config.battery_type);
     
     // Initialize ADC
@@ -180,13 +187,11 @@ battery_type_t battery_get_type(void)
     return battery_config.battery_type;
 }
 
-esp_err_t battery_send_voltage(float voltage)
+/**
+ * @brief Convert a voltage to the RCP battery status body
+ */
+static void battery_build_status(float voltage, rcp_battery_body_t *status)
 {
-    if (http_server_get_handle() == NULL) {
-        ESP_LOGW(TAG, "WebSocket server not available");
-        return ESP_ERR_INVALID_STATE;
-    }
-
     uint16_t voltage_mv = (uint16_t)(voltage * 1000.0f);
 
     float min_voltage = (battery_config.battery_type == BATTERY_TYPE_1S) ? 3.0f : 6.0f;
@@ -205,11 +210,45 @@ esp_err_t battery_send_voltage(float voltage)
         level = 10;
     }
 
-    uint8_t type = (uint8_t)battery_config.battery_type;
+    status->voltage_mv = voltage_mv;
+    status->level = level;
+    status->type = (uint8_t)battery_config.battery_type;
+}
+
+/**
+ * @brief Hand a periodic reading to the broadcaster, battery task only
+ *
+ * With telemetry enabled the reading goes through the telemetry task's
+ * SPSC ring, so this task is its single producer.
+ */
+static void battery_publish_voltage(float voltage)
+{
+#if ENABLE_TELEMETRY
+    rcp_battery_body_t status;
+    battery_build_status(voltage, &status);
+
+    esp_err_t ret = telemetry_post_battery(&status);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue battery reading: %s", esp_err_to_name(ret));
+    }
+#else
+    battery_send_voltage(voltage);
+#endif
+}
+
+esp_err_t battery_send_voltage(float voltage)
+{
+    if (http_server_get_handle() == NULL) {
+        ESP_LOGW(TAG, "WebSocket server not available");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    rcp_battery_body_t status;
+    battery_build_status(voltage, &status);
 
-    esp_err_t ret = rcp_send_battery_status(voltage_mv, level, type);
+    esp_err_t ret = rcp_send_battery_status(status.voltage_mv, status.level, status.type);
     if (ret == ESP_OK) {
-        ESP_LOGD(TAG, "RCP battery message broadcasted: %.3fV, level=%d/10, type=%dS", voltage, level, battery_config.battery_type);
+        ESP_LOGD(TAG, "RCP battery message broadcasted: %.3fV, level=%d/10, type=%dS", voltage, status.level, battery_config.battery_type);
     } else {
         ESP_LOGW(TAG, "Failed to broadcast RCP battery message: %s", esp_err_to_name(ret));
     }
@@ -248,10 +287,12 @@ static void battery_monitor_task(void *pvParameters)
     
     while (battery_task_running) {
         float voltage = 0.0;
+        int64_t read_start_us = esp_timer_get_time();
         esp_err_t ret = battery_get_voltage(&voltage);
+        metrics_observe(METRIC_BATTERY_READ, (uint32_t)(esp_timer_get_time() - read_start_us));
         
         if (ret == ESP_OK) {
-            battery_send_voltage(voltage);
+            battery_publish_voltage(voltage);
         } else {
             ESP_LOGE(TAG, "Failed to read battery voltage: %s", esp_err_to_name(ret));
         }
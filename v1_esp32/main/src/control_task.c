@@ -0,0 +1,389 @@
+#include "control_task.h"
+
+#if ENABLE_CONTROL_TASK
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "mailbox.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "trace.h"
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+static const char *TAG = "control_task";
+
+// Setpoint mailbox: written by the httpd task, read by the control task
+MAILBOX_DEFINE(setpoint_mailbox, control_setpoint_t);
+
+// Writer side, only touched by the httpd task
+static control_setpoint_t staged;
+static int group_depth = 0;
+static uint32_t staged_generation = 0;      // Failsafe trips already folded into staged
+
+// Incremented by the control task on every failsafe trip, read by the writer
+static atomic_uint failsafe_generation;
+
+// Reader side, only touched by the control task
+static control_setpoint_t applied;
+static uint32_t applied_seq = 0;
+static uint64_t latency_sum_us = 0;
+static int64_t last_setpoint_us = 0;        // 0 = never received, failsafe disarmed
+
+static control_stats_t control_stats;
+
+static TaskHandle_t control_task_handle = NULL;
+static esp_timer_handle_t control_timer = NULL;
+static volatile bool control_task_running = false;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Zero the speed and steering a failsafe trip has overridden
+ *
+ * Only values written since the previous publish survive, so a stale
+ * throttle is never driven again after a link loss.
+ */
+static void control_drop_stale_motion(control_setpoint_t *setpoint)
+{
+    if (!(setpoint->written & CONTROL_FIELD_SPEED)) {
+        setpoint->speed = 0;
+    }
+    if (!(setpoint->written & CONTROL_FIELD_STEERING)) {
+        setpoint->steering = 0;
+    }
+}
+
+/**
+ * @brief Copy the staged setpoint into the mailbox
+ */
+static void control_publish(void)
+{
+    uint32_t generation = atomic_load_explicit(&failsafe_generation, memory_order_acquire);
+    if (generation != staged_generation) {
+        control_drop_stale_motion(&staged);
+        staged_generation = generation;
+    }
+
+    staged.failsafe_generation = generation;
+    staged.updated_us = esp_timer_get_time();
+    mailbox_write(&setpoint_mailbox, &staged);
+    staged.written = 0;
+    TRACE_FLOW_START(TRACE_SETPOINT, mailbox_seq(&setpoint_mailbox));
+}
+
+static bool control_field_changed(const control_setpoint_t *setpoint, uint8_t field, bool changed)
+{
+    return (setpoint->fields & field) && (!(applied.fields & field) || changed);
+}
+
+/**
+ * @brief Drive the outputs whose setpoint changed since the last tick
+ */
+static void control_apply(const control_setpoint_t *setpoint)
+{
+    if (control_field_changed(setpoint, CONTROL_FIELD_STEERING, setpoint->steering != applied.steering)) {
+#if ENABLE_SERVO_CONTROL
+        esp_err_t ret = servo_control_set_position(setpoint->steering);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set servo position: %s", esp_err_to_name(ret));
+        }
+#endif
+    }
+
+    if (control_field_changed(setpoint, CONTROL_FIELD_SPEED, setpoint->speed != applied.speed)) {
+#if ENABLE_MOTOR_CONTROL
+        esp_err_t ret = motor_control_set_speed(setpoint->speed);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set motor speed: %s", esp_err_to_name(ret));
+        }
+#endif
+    }
+
+#if ENABLE_LED_CONTROL
+    if (control_field_changed(setpoint, CONTROL_FIELD_LIGHT, setpoint->light != applied.light)) {
+        led_light_set(setpoint->light);
+    }
+
+    if (control_field_changed(setpoint, CONTROL_FIELD_HORN, setpoint->horn != applied.horn)) {
+        led_horn_set(setpoint->horn);
+    }
+#endif
+
+    applied = *setpoint;
+}
+
+/**
+ * @brief Brake the motor and center the servo after a link loss
+ *
+ * The applied state is updated too, so the first setpoint after the link
+ * comes back is driven again even if it repeats the old values.
+ */
+static void control_failsafe_trip(int64_t now_us)
+{
+#if ENABLE_MOTOR_CONTROL
+    esp_err_t ret = motor_control_stop();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failsafe: failed to stop motor: %s", esp_err_to_name(ret));
+    }
+#endif
+
+#if ENABLE_SERVO_CONTROL
+    esp_err_t servo_ret = servo_control_set_position(0);
+    if (servo_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failsafe: failed to center servo: %s", esp_err_to_name(servo_ret));
+    }
+#endif
+
+    applied.speed = 0;
+    applied.steering = 0;
+
+    uint32_t reaction_us = (uint32_t)(esp_timer_get_time() - last_setpoint_us);
+    control_stats.failsafe_trips++;
+    control_stats.failsafe_reaction_last_us = reaction_us;
+    if (reaction_us > control_stats.failsafe_reaction_max_us) {
+        control_stats.failsafe_reaction_max_us = reaction_us;
+    }
+    control_stats.failsafe_active = true;
+    atomic_fetch_add_explicit(&failsafe_generation, 1, memory_order_release);
+
+    DLOG(DLOG_FAILSAFE_TRIP, (uint32_t)((now_us - last_setpoint_us) / 1000));
+}
+
+/**
+ * @brief Tick timer callback, runs on the esp_timer task
+ */
+static void control_timer_callback(void *arg)
+{
+    if (control_task_handle != NULL) {
+        xTaskNotifyGive(control_task_handle);
+    }
+}
+
+/**
+ * @brief Control task, one iteration per timer tick
+ */
+static void control_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Control task started on core %d at %d Hz", xPortGetCoreID(), CONTROL_TASK_RATE_HZ);
+
+    while (control_task_running) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        if (!control_task_running) {
+            break;
+        }
+        if (pending == 0) {
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+
+        control_stats.ticks++;
+        control_stats.missed_ticks += pending - 1;
+
+        // A busy mailbox means the writer was preempted mid-copy: retry next tick
+        control_setpoint_t setpoint;
+        uint32_t seq;
+        if (mailbox_seq(&setpoint_mailbox) != applied_seq &&
+            mailbox_read(&setpoint_mailbox, &setpoint, &seq)) {
+            // Published before the writer saw the last trip
+            if (setpoint.failsafe_generation !=
+                atomic_load_explicit(&failsafe_generation, memory_order_relaxed)) {
+                control_drop_stale_motion(&setpoint);
+            }
+
+            uint32_t trace_start = TRACE_START();
+            control_apply(&setpoint);
+            TRACE_FLOW_END(TRACE_SETPOINT, seq);
+            TRACE_SPAN(TRACE_CONTROL_APPLY, trace_start, seq);
+            applied_seq = seq;
+            last_setpoint_us = setpoint.updated_us;
+            if (control_stats.failsafe_active) {
+                control_stats.failsafe_active = false;
+                DLOG(DLOG_FAILSAFE_RESUMED);
+            }
+
+            uint32_t latency_us = (uint32_t)(esp_timer_get_time() - setpoint.updated_us);
+            latency_sum_us += latency_us;
+            control_stats.updates++;
+            control_stats.latency_last_us = latency_us;
+            if (latency_us > control_stats.latency_max_us) {
+                control_stats.latency_max_us = latency_us;
+            }
+            metrics_observe(METRIC_ACTUATION_LATENCY, latency_us);
+        }
+
+        if (last_setpoint_us != 0 && !control_stats.failsafe_active &&
+            start_us - last_setpoint_us > CONTROL_FAILSAFE_TIMEOUT_MS * 1000LL) {
+            control_failsafe_trip(start_us);
+        }
+
+        uint32_t exec_us = (uint32_t)(esp_timer_get_time() - start_us);
+        if (exec_us > control_stats.exec_max_us) {
+            control_stats.exec_max_us = exec_us;
+        }
+        metrics_observe(METRIC_CONTROL_EXEC, exec_us);
+    }
+
+    ESP_LOGI(TAG, "Control task stopped");
+    control_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void control_set_speed(int8_t speed)
+{
+    staged.speed = speed;
+    staged.fields |= CONTROL_FIELD_SPEED;
+    staged.written |= CONTROL_FIELD_SPEED;
+    if (group_depth == 0) {
+        control_publish();
+    }
+}
+
+void control_set_steering(int8_t steering)
+{
+    staged.steering = steering;
+    staged.fields |= CONTROL_FIELD_STEERING;
+    staged.written |= CONTROL_FIELD_STEERING;
+    if (group_depth == 0) {
+        control_publish();
+    }
+}
+
+void control_set_horn(bool state)
+{
+    staged.horn = state;
+    staged.fields |= CONTROL_FIELD_HORN;
+    staged.written |= CONTROL_FIELD_HORN;
+    if (group_depth == 0) {
+        control_publish();
+    }
+}
+
+void control_set_light(bool state)
+{
+    staged.light = state;
+    staged.fields |= CONTROL_FIELD_LIGHT;
+    staged.written |= CONTROL_FIELD_LIGHT;
+    if (group_depth == 0) {
+        control_publish();
+    }
+}
+
+void control_begin(void)
+{
+    group_depth++;
+}
+
+void control_commit(void)
+{
+    if (group_depth > 0 && --group_depth == 0) {
+        control_publish();
+    }
+}
+
+bool control_get_setpoint(control_setpoint_t *setpoint)
+{
+    return mailbox_read(&setpoint_mailbox, setpoint, NULL);
+}
+
+bool control_failsafe_active(void)
+{
+    return control_stats.failsafe_active;
+}
+
+void control_get_stats(control_stats_t *stats)
+{
+    *stats = control_stats;
+    stats->latency_avg_us = control_stats.updates > 0
+        ? (uint32_t)(latency_sum_us / control_stats.updates) : 0;
+}
+
+esp_err_t control_task_start(void)
+{
+    if (control_task_running) {
+        ESP_LOGW(TAG, "Control task already running");
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = control_timer_callback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "control_tick",
+        .skip_unhandled_events = true,
+    };
+
+    esp_err_t err = esp_timer_create(&timer_args, &control_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create control timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    control_task_running = true;
+
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        control_task,
+        "control",
+        CONTROL_TASK_STACK_SIZE,    // Stack size
+        NULL,                       // Parameters
+        CONTROL_TASK_PRIORITY,      // Priority
+        &control_task_handle,       // Task handle
+        CONTROL_TASK_CORE           // Core
+    );
+
+    if (ret != pdPASS) {
+        control_task_running = false;
+        esp_timer_delete(control_timer);
+        control_timer = NULL;
+        ESP_LOGE(TAG, "Failed to create control task");
+        return ESP_FAIL;
+    }
+
+    err = esp_timer_start_periodic(control_timer, 1000000 / CONTROL_TASK_RATE_HZ);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start control timer: %s", esp_err_to_name(err));
+        control_task_stop();
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+void control_task_stop(void)
+{
+    if (control_timer != NULL) {
+        esp_timer_stop(control_timer);
+        esp_timer_delete(control_timer);
+        control_timer = NULL;
+    }
+
+    if (control_task_running) {
+        control_task_running = false;
+        if (control_task_handle != NULL) {
+            xTaskNotifyGive(control_task_handle);
+        }
+        ESP_LOGI(TAG, "Stopping control task");
+    }
+}
+
+#endif // ENABLE_CONTROL_TASK
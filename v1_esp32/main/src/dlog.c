@@ -0,0 +1,352 @@
+#include "dlog.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+static const char *TAG = "dlog";
+
+/**
+ * @brief One deferred record
+ */
+typedef struct {
+    uint32_t timestamp_ms;
+    uint16_t id;
+    uint8_t argc;
+    uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+/**
+ * @brief Ring cell, seq tells whose turn it is
+ *
+ * seq == pos: free for the producer that claims pos
+ * seq == pos + 1: holds the record of pos, ready for the consumer
+ */
+typedef struct {
+    atomic_uint seq;
+    dlog_record_t record;
+} dlog_cell_t;
+
+/**
+ * @brief Format table entry
+ */
+typedef struct {
+    esp_log_level_t level;
+    char letter;
+    const char *tag;
+    const char *format;
+} dlog_format_t;
+
+#define DLOG_LETTER_E   'E'
+#define DLOG_LETTER_W   'W'
+#define DLOG_LETTER_I   'I'
+#define DLOG_LETTER_D   'D'
+#define DLOG_LETTER_V   'V'
+
+#define DLOG_FORMAT_ENTRY(id, level, tag, format) \
+    [id] = { DLOG_LEVEL_##level, DLOG_LETTER_##level, tag, format },
+
+static const dlog_format_t dlog_formats[DLOG_FORMAT_COUNT] = {
+    DLOG_FORMATS(DLOG_FORMAT_ENTRY)
+};
+
+_Static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0, "DLOG_RING_SIZE must be a power of two");
+
+static dlog_cell_t dlog_ring[DLOG_RING_SIZE];
+static atomic_uint enqueue_pos;
+static atomic_uint dequeue_pos;
+static bool ring_initialized = false;
+
+static atomic_uint stat_written;
+static atomic_uint stat_dropped;
+static atomic_uint stat_drained;
+static uint32_t stat_high_water = 0;
+static uint32_t reported_dropped = 0;
+
+static volatile bool dlog_running = false;
+static TaskHandle_t dlog_task_handle = NULL;
+
+// =============================================================================
+// RING
+// =============================================================================
+
+/**
+ * @brief Claim a cell, fill it and publish it (bounded MPMC queue)
+ *
+ * Producers only race on the CAS of enqueue_pos; a producer preempted after
+ * its claim delays the consumer at that cell but never blocks other
+ * producers.
+ */
+static bool dlog_ring_push(const dlog_record_t *record)
+{
+    unsigned pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    dlog_cell_t *cell;
+
+    for (;;) {
+        cell = &dlog_ring[pos & (DLOG_RING_SIZE - 1)];
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   // Full: the cell still holds the record from a lap ago
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->record = *record;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool dlog_ring_pop(dlog_record_t *record)
+{
+    unsigned pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+    dlog_cell_t *cell;
+
+    for (;;) {
+        cell = &dlog_ring[pos & (DLOG_RING_SIZE - 1)];
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int diff = (int)(seq - (pos + 1));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   // Empty, or the producer of pos has not published yet
+        } else {
+            pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    *record = cell->record;
+    atomic_store_explicit(&cell->seq, pos + DLOG_RING_SIZE, memory_order_release);
+    return true;
+}
+
+// =============================================================================
+// OUTPUT
+// =============================================================================
+
+#if DLOG_OUTPUT_BINARY
+
+static void dlog_print(const dlog_record_t *record)
+{
+    const dlog_format_t *format = &dlog_formats[record->id];
+    if (format->level > esp_log_level_get(format->tag)) {
+        return;
+    }
+
+    uint8_t frame[DLOG_FRAME_MAX_SIZE];
+    size_t len = 0;
+
+    frame[len++] = DLOG_FRAME_MAGIC0;
+    frame[len++] = DLOG_FRAME_MAGIC1;
+    for (int i = 0; i < 4; i++) {
+        frame[len++] = (uint8_t)(record->timestamp_ms >> (8 * i));
+    }
+    frame[len++] = (uint8_t)record->id;
+    frame[len++] = (uint8_t)(record->id >> 8);
+    frame[len++] = record->argc;
+    for (int a = 0; a < record->argc; a++) {
+        for (int i = 0; i < 4; i++) {
+            frame[len++] = (uint8_t)(record->args[a] >> (8 * i));
+        }
+    }
+
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < len; i++) {
+        checksum ^= frame[i];
+    }
+    frame[len++] = checksum;
+
+    // No line ending may reach stdout, see dlog_formats.h
+    uint8_t encoded[DLOG_FRAME_MAX_ENCODED];
+    size_t encoded_len = 0;
+    encoded[encoded_len++] = frame[0];
+    encoded[encoded_len++] = frame[1];
+    for (size_t i = 2; i < len; i++) {
+        if (dlog_frame_needs_escape(frame[i])) {
+            encoded[encoded_len++] = DLOG_FRAME_ESCAPE;
+            encoded[encoded_len++] = frame[i] ^ DLOG_FRAME_ESCAPE_XOR;
+        } else {
+            encoded[encoded_len++] = frame[i];
+        }
+    }
+
+    fwrite(encoded, 1, encoded_len, stdout);
+}
+
+#else
+
+static void dlog_print(const dlog_record_t *record)
+{
+    const dlog_format_t *format = &dlog_formats[record->id];
+    char text[128];
+
+    // Unused trailing arguments are zero and ignored by the format
+    dlog_format_text(text, sizeof(text), format->format, record->args);
+    esp_log_write(format->level, format->tag, "%c (%" PRIu32 ") %s: %s\n",
+                  format->letter, record->timestamp_ms, format->tag, text);
+}
+
+#endif // DLOG_OUTPUT_BINARY
+
+/**
+ * @brief Print everything pending, returns the number of records printed
+ */
+static uint32_t dlog_drain(void)
+{
+    uint32_t waiting = atomic_load_explicit(&enqueue_pos, memory_order_relaxed) -
+                       atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+    if (waiting > stat_high_water && waiting <= DLOG_RING_SIZE) {
+        stat_high_water = waiting;
+    }
+
+    dlog_record_t record;
+    uint32_t count = 0;
+    while (dlog_ring_pop(&record)) {
+        dlog_print(&record);
+        count++;
+    }
+
+    uint32_t dropped = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+    if (dropped != reported_dropped) {
+        dlog_record_t notice = {
+            .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+            .id = DLOG_DROPPED,
+            .argc = 1,
+            .args = { dropped - reported_dropped },
+        };
+        reported_dropped = dropped;
+        dlog_print(&notice);
+    }
+
+#if DLOG_OUTPUT_BINARY
+    fflush(stdout);
+#endif
+
+    if (count > 0) {
+        atomic_fetch_add_explicit(&stat_drained, count, memory_order_relaxed);
+    }
+    return count;
+}
+
+/**
+ * @brief Drain task, prints the ring at a low priority
+ */
+static void dlog_task(void *pvParameters)
+{
+    while (dlog_running) {
+        dlog_drain();
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_INTERVAL_MS));
+    }
+
+    dlog_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void dlog_write(dlog_format_id_t id, const uint32_t *args, uint8_t argc)
+{
+    if ((unsigned)id >= DLOG_FORMAT_COUNT) {
+        return;
+    }
+    if (argc > DLOG_MAX_ARGS) {
+        argc = DLOG_MAX_ARGS;
+    }
+
+    dlog_record_t record = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .id = (uint16_t)id,
+        .argc = argc,
+    };
+    memcpy(record.args, args, argc * sizeof(uint32_t));
+
+    if (!dlog_running) {
+        dlog_print(&record);
+        return;
+    }
+
+    if (dlog_ring_push(&record)) {
+        atomic_fetch_add_explicit(&stat_written, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+    }
+}
+
+esp_err_t dlog_start(void)
+{
+    if (dlog_running) {
+        return ESP_OK;
+    }
+
+    if (!ring_initialized) {
+        for (unsigned i = 0; i < DLOG_RING_SIZE; i++) {
+            atomic_init(&dlog_ring[i].seq, i);
+        }
+        atomic_init(&enqueue_pos, 0);
+        atomic_init(&dequeue_pos, 0);
+        ring_initialized = true;
+    }
+
+    dlog_running = true;
+
+    BaseType_t ret = xTaskCreate(
+        dlog_task,
+        "dlog",
+        DLOG_TASK_STACK_SIZE,       // Stack size
+        NULL,                       // Parameters
+        DLOG_TASK_PRIORITY,         // Priority
+        &dlog_task_handle           // Task handle
+    );
+    if (ret != pdPASS) {
+        dlog_running = false;
+        ESP_LOGE(TAG, "Failed to create drain task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Deferred logging started (%d records, %s output)",
+             DLOG_RING_SIZE, DLOG_OUTPUT_BINARY ? "binary" : "text");
+    return ESP_OK;
+}
+
+void dlog_stop(void)
+{
+    if (!dlog_running) {
+        return;
+    }
+
+    // New records print right away; the task exits after its current round
+    dlog_running = false;
+    dlog_flush();
+}
+
+void dlog_flush(void)
+{
+    if (ring_initialized) {
+        dlog_drain();
+    }
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    stats->written = atomic_load_explicit(&stat_written, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+    stats->drained = atomic_load_explicit(&stat_drained, memory_order_relaxed);
+    stats->high_water = stat_high_water;
+}
@@ -2,6 +2,7 @@
 #include <sys/socket.h>
 #include <stdlib.h>
 #include <string.h>
+#include <freertos/FreeRTOS.h>
 #include <esp_timer.h>
 #include <esp_log.h>
 #include <esp_http_server.h>
@@ -18,6 +19,12 @@
 #include "http_server.h"
 #include "ota.h"
 #include "rcp_protocol.h"
+#include "ws_clients.h"
+#include "ws_outbox.h"
+#include "http_workers.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "trace.h"
 
 #if ENABLE_LED_CONTROL
 #include "led_control.h"
@@ -35,24 +42,35 @@
 #include "motor_control.h"
 #endif
 
+#if ENABLE_TELEMETRY
+#include "telemetry.h"
+#endif
+
+#if ENABLE_TASK_STATS
+#include "task_stats.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
 #if ENABLE_CAMERA_SUPPORT
     #include "cam.h"
-    #include "esp_camera.h"
-    
-    #define PART_BOUNDARY "123456789000000000000987654321"
-    static const char* _STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
-    static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-    static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+    #include "video_server.h"
 #endif
 
 static const char *TAG = "http_server";
 static httpd_handle_t server = NULL;
 
-// WebSocket client management
-#define MAX_WS_CLIENTS 5
+// Server-side WebSocket ping timer
+static esp_timer_handle_t ws_heartbeat_timer = NULL;
+
+// WebSocket receive buffer
+// All URI handlers of a server run on its single httpd task, so one
+// preallocated buffer serves every connection without heap traffic.
+#define WS_RX_BUFFER_SIZE 1024
 
-static int ws_client_fds[MAX_WS_CLIENTS];
-static int ws_client_count = 0;
+static uint8_t ws_rx_buffer[WS_RX_BUFFER_SIZE];
 
 static esp_err_t json_response(httpd_req_t *req, const char *payload)
 {
@@ -185,119 +203,160 @@ static esp_err_t steering_config_post_handler(httpd_req_t *req)
 #endif
 }
 
-// Function to add WebSocket client
-static void add_ws_client(int fd) {
-    if (ws_client_count < MAX_WS_CLIENTS) {
-        ws_client_fds[ws_client_count] = fd;
-        ws_client_count++;
-        ESP_LOGI(TAG, "WebSocket client fd=%d added, total clients: %d", fd, ws_client_count);
-    } else {
-        ESP_LOGW(TAG, "Cannot add WebSocket client fd=%d - max clients reached", fd);
+// Function to forget a WebSocket client, safe to call for stale handles
+static void remove_ws_client_handle(ws_client_handle_t handle) {
+    int fd = -1;
+
+    if (ws_clients_remove(handle, &fd) != ESP_OK) {
+        return;
     }
+
+    ws_outbox_remove_client(fd);
+#if ENABLE_TELEMETRY
+    telemetry_unsubscribe(fd);
+#endif
 }
 
 // Function to remove WebSocket client
 static void remove_ws_client(int fd) {
-    for (int i = 0; i < ws_client_count; i++) {
-        if (ws_client_fds[i] == fd) {
-            // Shift remaining clients
-            for (int j = i; j < ws_client_count - 1; j++) {
-                ws_client_fds[j] = ws_client_fds[j + 1];
-            }
-            ws_client_count--;
-            ESP_LOGI(TAG, "WebSocket client fd=%d removed, total clients: %d", fd, ws_client_count);
-            break;
-        }
+    remove_ws_client_handle(ws_clients_find_fd(fd));
+}
+
+// Session context destructor, httpd calls it when the socket closes
+static void ws_client_free_ctx(void *ctx) {
+    remove_ws_client_handle((ws_client_handle_t)(uintptr_t)ctx);
+}
+
+// Function to add WebSocket client
+static esp_err_t add_ws_client(httpd_req_t *req) {
+    int fd = httpd_req_to_sockfd(req);
+    ws_client_handle_t handle;
+
+    esp_err_t ret = ws_clients_add(fd, &handle);
+    if (ret != ESP_OK) {
+        return ret;
     }
+
+    ret = ws_outbox_add_client(fd);
+    if (ret != ESP_OK) {
+        ws_clients_remove(handle, NULL);
+        return ret;
+    }
+
+    // The handle rides on the session: O(1) lookup per frame, removal on close
+    req->sess_ctx = (void *)(uintptr_t)handle;
+    req->free_ctx = ws_client_free_ctx;
+    return ESP_OK;
 }
 
+// Function to queue a frame for every client of the given streams
+static int ws_send_to_streams(uint8_t streams, httpd_ws_type_t type, const void *data, size_t len) {
+    ws_client_ref_t refs[WS_CLIENTS_MAX];
+    int count = ws_clients_snapshot(refs, WS_CLIENTS_MAX, streams);
+    int queued = 0;
+
+    // Sent from the copy, the registry lock is never held around the outbox
+    for (int i = 0; i < count; i++) {
+        if (ws_outbox_send(refs[i].fd, type, data, len) == ESP_OK) {
+            queued++;
+        }
+    }
 
+    return queued;
+}
 
-// Function to broadcast message to all WebSocket clients
+// Function to broadcast message to the WebSocket clients of the status stream
 esp_err_t http_server_broadcast_ws(const char *message) {
     if (server == NULL || message == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    httpd_ws_frame_t ws_pkt;
-    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-    ws_pkt.payload = (uint8_t *)message;
-    ws_pkt.len = strlen(message);
-    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    // Queued per client, the outbox task does the socket writes
+    int queued = ws_send_to_streams(WS_STREAM_STATUS, HTTPD_WS_TYPE_TEXT, message, strlen(message));
 
-    int sent_count = 0;
-    int removed_count = 0;
-    
-    // Iterate backwards to safely remove clients during iteration
-    for (int i = ws_client_count - 1; i >= 0; i--) {
-        esp_err_t ret = httpd_ws_send_frame_async(server, ws_client_fds[i], &ws_pkt);
-        if (ret == ESP_OK) {
-            sent_count++;
-        } else {
-            ESP_LOGW(TAG, "Failed to send to client %d: %s - removing client", 
-                     ws_client_fds[i], esp_err_to_name(ret));
-            
-            // Remove disconnected client from list
-            remove_ws_client(ws_client_fds[i]);
-            removed_count++;
-        }
-    }
-    
-    if (removed_count > 0) {
-        ESP_LOGI(TAG, "Removed %d disconnected WebSocket clients", removed_count);
+    ESP_LOGD(TAG, "Broadcast queued for %d/%d clients", queued, ws_clients_count());
+    return ESP_OK;
+}
+
+// Function to broadcast binary message to the WebSocket clients of the given streams
+esp_err_t http_server_broadcast_ws_binary(uint8_t streams, const void *data, size_t len) {
+    if (server == NULL || data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
-    
-    ESP_LOGD(TAG, "Broadcast sent to %d/%d clients", sent_count, ws_client_count);
+
+    // Queued per client, the outbox task does the socket writes
+    int queued = ws_send_to_streams(streams, HTTPD_WS_TYPE_BINARY, data, len);
+
+    ESP_LOGD(TAG, "Binary broadcast queued for %d/%d clients (%zu bytes)", queued, ws_clients_count(), len);
     return ESP_OK;
 }
 
-// Function to broadcast binary message to all WebSocket clients
-esp_err_t http_server_broadcast_ws_binary(const void *data, size_t len) {
+// Function to send binary message to a single WebSocket client
+esp_err_t http_server_send_ws_binary(int fd, const void *data, size_t len) {
     if (server == NULL || data == NULL || len == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    httpd_ws_frame_t ws_pkt;
-    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-    ws_pkt.payload = (uint8_t *)data;
-    ws_pkt.len = len;
-    ws_pkt.type = HTTPD_WS_TYPE_BINARY;
+    return ws_outbox_send(fd, HTTPD_WS_TYPE_BINARY, data, len);
+}
 
-    int sent_count = 0;
-    int removed_count = 0;
-    
-    // Iterate backwards to safely remove clients during iteration
-    for (int i = ws_client_count - 1; i >= 0; i--) {
-        esp_err_t ret = httpd_ws_send_frame_async(server, ws_client_fds[i], &ws_pkt);
-        if (ret == ESP_OK) {
-            sent_count++;
-        } else {
-            ESP_LOGW(TAG, "Failed to send binary to client %d: %s - removing client", 
-                     ws_client_fds[i], esp_err_to_name(ret));
-            
-            // Remove disconnected client from list
-            remove_ws_client(ws_client_fds[i]);
-            removed_count++;
+// Runs on the httpd task: forget a client whose socket failed in the outbox task
+static void ws_client_failed_work(void *arg) {
+    remove_ws_client((int)(intptr_t)arg);
+}
+
+// Outbox error callback, called from the outbox task
+static void ws_outbox_error(int fd) {
+    if (server == NULL) {
+        return;
+    }
+
+    httpd_queue_work(server, ws_client_failed_work, (void *)(intptr_t)fd);
+    httpd_sess_trigger_close(server, fd);
+}
+
+// Runs on the httpd task: ping every client, evict the ones that stopped answering
+static void ws_heartbeat_work(void *arg) {
+    ws_client_ref_t refs[WS_CLIENTS_MAX];
+    int count = ws_clients_snapshot(refs, WS_CLIENTS_MAX, WS_STREAM_ALL);
+    int64_t now_us = esp_timer_get_time();
+
+    for (int i = 0; i < count; i++) {
+        uint32_t ping_id = 0;
+        uint8_t missed = ws_clients_ping_sent(refs[i].handle, now_us, &ping_id);
+
+        if (missed >= WS_HEARTBEAT_MAX_MISSED) {
+            ESP_LOGW(TAG, "WebSocket client fd=%d missed %u pongs - evicting", refs[i].fd, missed);
+            remove_ws_client_handle(refs[i].handle);
+            httpd_sess_trigger_close(server, refs[i].fd);
+            continue;
         }
+
+        // A full queue loses the ping, which counts as a miss on the next round
+        ws_outbox_send(refs[i].fd, HTTPD_WS_TYPE_PING, &ping_id, sizeof(ping_id));
     }
-    
-    if (removed_count > 0) {
-        ESP_LOGI(TAG, "Removed %d disconnected WebSocket clients", removed_count);
+}
+
+// Heartbeat timer callback, runs on the esp_timer task
+static void ws_heartbeat_timer_callback(void *arg) {
+    if (server != NULL) {
+        httpd_queue_work(server, ws_heartbeat_work, NULL);
     }
-    
-    ESP_LOGD(TAG, "Binary broadcast sent to %d/%d clients (%zu bytes)", sent_count, ws_client_count, len);
-    return ESP_OK;
 }
 
-// Function to manually cleanup invalid WebSocket clients
+// Function to run a heartbeat round now instead of waiting for the timer
 void http_server_cleanup_ws_clients(void) {
-    // Simple cleanup - no advanced validation needed
-    ESP_LOGD(TAG, "WebSocket client cleanup - %d clients active", ws_client_count);
+    if (server == NULL) {
+        return;
+    }
+
+    ESP_LOGD(TAG, "WebSocket client cleanup - %d clients active", ws_clients_count());
+    httpd_queue_work(server, ws_heartbeat_work, NULL);
 }
 
 // Function to get current WebSocket client count
 int http_server_get_ws_client_count(void) {
-    return ws_client_count;
+    return ws_clients_count();
 }
 
 
@@ -311,7 +370,10 @@ static esp_err_t ws_handler(httpd_req_t *req)
         ESP_LOGI(TAG, "WebSocket handshake done, new connection opened");
         
         // Add client to list
-        add_ws_client(httpd_req_to_sockfd(req));
+        if (add_ws_client(req) != ESP_OK) {
+            ESP_LOGW(TAG, "Rejecting WebSocket client fd=%d - max clients reached", httpd_req_to_sockfd(req));
+            return ESP_FAIL;
+        }
         
 #if ENABLE_BATTERY_MONITORING
         // Send battery initialization message
@@ -322,7 +384,6 @@ static esp_err_t ws_handler(httpd_req_t *req)
     }
     
     httpd_ws_frame_t ws_pkt;
-    uint8_t *buf = NULL;
     memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
     
     // Get frame length first
@@ -348,41 +409,65 @@ static esp_err_t ws_handler(httpd_req_t *req)
         }
     }
     
-    // Handle special frame types that don't have payload
+    // Control frames reach this handler (handle_ws_control_frames), their
+    // payload is at most 125 bytes
+    if (ws_pkt.type == HTTPD_WS_TYPE_PONG || ws_pkt.type == HTTPD_WS_TYPE_PING ||
+        ws_pkt.type == HTTPD_WS_TYPE_CLOSE) {
+        if (ws_pkt.len > 0) {
+            ws_pkt.payload = ws_rx_buffer;
+            if (ws_pkt.len > WS_RX_BUFFER_SIZE ||
+                httpd_ws_recv_frame(req, &ws_pkt, WS_RX_BUFFER_SIZE) != ESP_OK) {
+                ESP_LOGW(TAG, "Bad control frame (client fd=%d) - removing client", httpd_req_to_sockfd(req));
+                remove_ws_client(httpd_req_to_sockfd(req));
+                return ESP_FAIL;
+            }
+        }
+    }
+
     if (ws_pkt.type == HTTPD_WS_TYPE_PONG) {
-        ESP_LOGD(TAG, "Received pong from client fd=%d", httpd_req_to_sockfd(req));
+        uint32_t ping_id = 0;
+        if (ws_pkt.len == sizeof(ping_id)) {
+            memcpy(&ping_id, ws_pkt.payload, sizeof(ping_id));
+        }
+        if (ws_clients_pong_received((ws_client_handle_t)(uintptr_t)req->sess_ctx, ping_id,
+                                     esp_timer_get_time()) != ESP_OK) {
+            ESP_LOGD(TAG, "Unmatched pong from client fd=%d", httpd_req_to_sockfd(req));
+        }
         return ESP_OK;
     }
     
     if (ws_pkt.type == HTTPD_WS_TYPE_CLOSE) {
         ESP_LOGI(TAG, "WebSocket connection closed by client");
         remove_ws_client(httpd_req_to_sockfd(req));
+
+        // Echo the close frame, httpd no longer does it for us
+        httpd_ws_frame_t close_pkt = { .type = HTTPD_WS_TYPE_CLOSE, .final = true };
+        httpd_ws_send_frame(req, &close_pkt);
         return ESP_OK;
     }
     
     if (ws_pkt.type == HTTPD_WS_TYPE_PING) {
         ESP_LOGD(TAG, "Received ping from client fd=%d", httpd_req_to_sockfd(req));
-        return ESP_OK;
+
+        // Answer right away with the same payload, httpd no longer does it for us
+        ws_pkt.type = HTTPD_WS_TYPE_PONG;
+        ws_pkt.final = true;
+        return httpd_ws_send_frame(req, &ws_pkt);
     }
     
     // Process frames with payload
     if (ws_pkt.len > 0) {
+        uint32_t trace_start = TRACE_START();
+
         // Validate frame length to prevent buffer overflow
-        if (ws_pkt.len > 1024) {
-            ESP_LOGW(TAG, "WebSocket frame too large (%d bytes), ignoring", ws_pkt.len);
+        if (ws_pkt.len > WS_RX_BUFFER_SIZE) {
+            ESP_LOGW(TAG, "WebSocket frame too large (%zu bytes), ignoring", ws_pkt.len);
             return ESP_OK;
         }
         
-        // Allocate buffer for payload
-        buf = calloc(1, ws_pkt.len + 1);
-        if (buf == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate memory for WebSocket frame (%d bytes)", ws_pkt.len);
-            return ESP_ERR_NO_MEM;
-        }
-        
-        // Receive the actual payload
-        ws_pkt.payload = buf;
-        ret = httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
+        // Receive the actual payload straight into the preallocated buffer
+        ws_pkt.payload = ws_rx_buffer;
+        ret = httpd_ws_recv_frame(req, &ws_pkt, WS_RX_BUFFER_SIZE);
         if (ret != ESP_OK) {
             int client_fd = httpd_req_to_sockfd(req);
             
@@ -392,7 +477,6 @@ static esp_err_t ws_handler(httpd_req_t *req)
                 case 259: // Specific masking error
                     ESP_LOGW(TAG, "WebSocket payload masking error %d (client fd=%d) - removing client", ret, client_fd);
                     remove_ws_client(client_fd);
-                    free(buf);
                     return ESP_FAIL; // Close connection immediately
                     
                 case ESP_ERR_TIMEOUT:
@@ -406,35 +490,22 @@ static esp_err_t ws_handler(httpd_req_t *req)
                     break;
             }
             
-            free(buf);
             return ESP_OK;
         }
         
         // Process frame based on type
         if (ws_pkt.type == HTTPD_WS_TYPE_BINARY) {
-            ESP_LOGD(TAG, "Received binary WebSocket frame (%d bytes) - processing as RCP", ws_pkt.len);
-
-            if (ws_pkt.len < RCP_HEADER_SIZE) {
-                ESP_LOGW(TAG, "RCP: Frame too small (%d bytes)", ws_pkt.len);
-            } else {
-                uint16_t declared_len = (uint16_t)ws_pkt.payload[0] | ((uint16_t)ws_pkt.payload[1] << 8);
-                uint8_t port = ws_pkt.payload[2];
-                size_t available = ws_pkt.len - RCP_HEADER_SIZE;
-                size_t body_len = declared_len;
-
-                if (body_len > available) {
-                    ESP_LOGW(TAG, "RCP: Declared body length %u exceeds available %zu, truncating", declared_len, available);
-                    body_len = available;
-                }
-
-                const uint8_t* body = ws_pkt.payload + RCP_HEADER_SIZE;
-
-                esp_err_t rcp_ret = rcp_process_message(port, body, body_len);
-                if (rcp_ret != ESP_OK) {
-                    ESP_LOGW(TAG, "RCP: Failed to process message port=0x%02X: %s (decl_len=%u, body_len=%zu, client_fd=%d)",
-                             port, esp_err_to_name(rcp_ret), declared_len, body_len, httpd_req_to_sockfd(req));
-                }
+            ESP_LOGD(TAG, "Received binary WebSocket frame (%zu bytes) - processing as RCP", ws_pkt.len);
+
+            // Decoded in place: the RCP body points into ws_rx_buffer
+            int client_fd = httpd_req_to_sockfd(req);
+            ws_client_handle_t handle = (ws_client_handle_t)(uintptr_t)req->sess_ctx;
+            ws_clients_record_rx(handle, ws_pkt.len);
+            esp_err_t rcp_ret = rcp_process_frame(ws_clients_get_session(handle), ws_pkt.payload, ws_pkt.len);
+            if (rcp_ret != ESP_OK) {
+                ESP_LOGD(TAG, "RCP: Frame rejected (client_fd=%d)", client_fd);
             }
+            TRACE_SPAN(TRACE_WS_FRAME, trace_start, ws_pkt.len);
         } else if (ws_pkt.type == HTTPD_WS_TYPE_TEXT) {
             // Log and reject text frames (RCP only supports binary)
             ESP_LOGW(TAG, "Received text WebSocket frame (client fd=%d) - RCP only supports binary frames", 
@@ -444,18 +515,14 @@ static esp_err_t ws_handler(httpd_req_t *req)
             ESP_LOGW(TAG, "Received invalid/continuation WebSocket frame type 5 (client fd=%d) - removing client", 
                      httpd_req_to_sockfd(req));
             remove_ws_client(httpd_req_to_sockfd(req));
-            free(buf);
             return ESP_FAIL;
         } else {
             // Log unknown frame types and potentially remove problematic clients
             ESP_LOGW(TAG, "Received unknown WebSocket frame type %d (client fd=%d) - removing client", 
                      ws_pkt.type, httpd_req_to_sockfd(req));
             remove_ws_client(httpd_req_to_sockfd(req));
-            free(buf);
             return ESP_FAIL;
         }
-        
-        free(buf);
     }
     
     return ESP_OK;
@@ -463,15 +530,22 @@ static esp_err_t ws_handler(httpd_req_t *req)
 
 void process_speed_command(int speed_value)
 {
-    ESP_LOGI(TAG, "Processing speed command: %d", speed_value);
-#if ENABLE_MOTOR_CONTROL
+    DLOG(DLOG_HTTP_SPEED_CMD, speed_value);
+#if ENABLE_CONTROL_TASK
+    // speed_value: -100 to +100 (-100 = full reverse, 0 = stop, +100 = full forward)
+    if (speed_value < -100 || speed_value > 100) {
+        ESP_LOGE(TAG, "Invalid speed value: %d", speed_value);
+        return;
+    }
+    control_set_speed((int8_t)speed_value);
+#elif ENABLE_MOTOR_CONTROL
     // Use the motor control HAL to set speed
     // speed_value: -100 to +100 (-100 = full reverse, 0 = stop, +100 = full forward)
     esp_err_t ret = motor_control_set_speed(speed_value);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set motor speed: %s", esp_err_to_name(ret));
     } else {
-        ESP_LOGI(TAG, "Motor speed set to: %d", speed_value);
+        DLOG(DLOG_HTTP_SPEED_SET, speed_value);
     }
 #else
     ESP_LOGW(TAG, "Motor control disabled in project_config.h");
@@ -480,8 +554,15 @@ void process_speed_command(int speed_value)
 
 void process_wheels_command(int wheels_value)
 {
-    ESP_LOGI(TAG, "Processing wheels command: %d", wheels_value);
-#if ENABLE_SERVO_CONTROL
+    DLOG(DLOG_HTTP_WHEELS_CMD, wheels_value);
+#if ENABLE_CONTROL_TASK
+    // wheels_value: -100 to +100 (-100 = full left, 0 = center, +100 = full right)
+    if (wheels_value < -100 || wheels_value > 100) {
+        ESP_LOGE(TAG, "Invalid wheels value: %d", wheels_value);
+        return;
+    }
+    control_set_steering((int8_t)wheels_value);
+#elif ENABLE_SERVO_CONTROL
     // Control servo position based on wheels command
     // wheels_value: -100 to +100 (-100 = full left, 0 = center, +100 = full right)
     esp_err_t ret = servo_control_set_position(wheels_value);
@@ -495,8 +576,11 @@ void process_wheels_command(int wheels_value)
 
 void process_horn_command(int horn_value)
 {
-    ESP_LOGI(TAG, "Processing horn command: %d", horn_value);
-#if ENABLE_LED_CONTROL
+    DLOG(DLOG_HTTP_HORN_CMD, horn_value);
+#if ENABLE_CONTROL_TASK
+    // horn_value: 1 = horn ON, 0 = horn OFF
+    control_set_horn(horn_value != 0);
+#elif ENABLE_LED_CONTROL
     // Control horn LED based on command value
     // horn_value: 1 = horn ON, 0 = horn OFF
     led_horn_set(horn_value != 0);
@@ -507,8 +591,11 @@ void process_horn_command(int horn_value)
 
 void process_light_command(int light_value)
 {
-    ESP_LOGI(TAG, "Processing light command: %d", light_value);
-#if ENABLE_LED_CONTROL
+    DLOG(DLOG_HTTP_LIGHT_CMD, light_value);
+#if ENABLE_CONTROL_TASK
+    // light_value: 1 = light ON, 0 = light OFF
+    control_set_light(light_value != 0);
+#elif ENABLE_LED_CONTROL
     // Control light LED based on command value
     // light_value: 1 = light ON, 0 = light OFF
     led_light_set(light_value != 0);
@@ -519,6 +606,178 @@ void process_light_command(int light_value)
 
 
 
+// WebSocket clients with their send queue counters
+static esp_err_t ws_clients_handler(httpd_req_t *req)
+{
+    ws_client_info_t clients[WS_CLIENTS_MAX];
+    int client_count = ws_clients_get_info(clients, WS_CLIENTS_MAX);
+
+    ws_outbox_stats_t stats[WS_OUTBOX_MAX_CLIENTS];
+    int count = ws_outbox_get_stats(stats, WS_OUTBOX_MAX_CLIENTS);
+
+    // Static: too big for the httpd stack, and handlers never run concurrently
+    static char response[2048];
+    size_t offset = 0;
+    int64_t now_us = esp_timer_get_time();
+
+    offset += snprintf(response + offset, sizeof(response) - offset, "[");
+    for (int i = 0; i < client_count && offset < sizeof(response); i++) {
+        ws_outbox_stats_t *outbox = NULL;
+        for (int j = 0; j < count; j++) {
+            if (stats[j].fd == clients[i].fd) {
+                outbox = &stats[j];
+                break;
+            }
+        }
+
+        offset += snprintf(response + offset, sizeof(response) - offset,
+                           "%s{\"handle\":%lu,\"fd\":%d,\"role\":\"%s\",\"streams\":%u,"
+                           "\"connected_s\":%lu,\"rx_frames\":%lu,\"rx_bytes\":%lu,"
+                           "\"rtt_last_us\":%lu,\"rtt_avg_us\":%lu,\"rtt_max_us\":%lu,"
+                           "\"pongs\":%lu,\"missed_pongs\":%u",
+                           i > 0 ? "," : "", (unsigned long)clients[i].handle, clients[i].fd,
+                           clients[i].role == RCP_ROLE_MONITOR ? "monitor" : "control", clients[i].streams,
+                           (unsigned long)((now_us - clients[i].connected_us) / 1000000),
+                           (unsigned long)clients[i].rx_frames, (unsigned long)clients[i].rx_bytes,
+                           (unsigned long)clients[i].rtt_last_us, (unsigned long)clients[i].rtt_avg_us,
+                           (unsigned long)clients[i].rtt_max_us, (unsigned long)clients[i].pongs,
+                           clients[i].missed_pongs);
+        if (outbox != NULL && offset < sizeof(response)) {
+            offset += snprintf(response + offset, sizeof(response) - offset,
+                               ",\"depth\":%u,\"max_depth\":%u,\"enqueued\":%lu,\"sent\":%lu,"
+                               "\"coalesced\":%lu,\"dropped\":%lu,\"blocked\":%lu",
+                               outbox->depth, outbox->max_depth,
+                               (unsigned long)outbox->enqueued, (unsigned long)outbox->sent,
+                               (unsigned long)outbox->coalesced, (unsigned long)outbox->dropped,
+                               (unsigned long)outbox->blocked);
+        }
+        if (offset < sizeof(response)) {
+            offset += snprintf(response + offset, sizeof(response) - offset, "}");
+        }
+    }
+    if (offset < sizeof(response)) {
+        snprintf(response + offset, sizeof(response) - offset, "]");
+    }
+
+    return json_response(req, response);
+}
+
+#if ENABLE_CONTROL_TASK
+// Control loop setpoint and actuation latency
+static esp_err_t control_stats_handler(httpd_req_t *req)
+{
+    // Setpoints are published from this task, so the read cannot overlap one
+    control_setpoint_t setpoint;
+    control_stats_t stats;
+    control_get_setpoint(&setpoint);
+    control_get_stats(&stats);
+
+    char response[512];
+    snprintf(response, sizeof(response),
+             "{\"rate_hz\":%d,\"speed\":%d,\"steering\":%d,\"horn\":%s,\"light\":%s,"
+             "\"ticks\":%lu,\"missed_ticks\":%lu,\"updates\":%lu,\"latency_last_us\":%lu,"
+             "\"latency_avg_us\":%lu,\"latency_max_us\":%lu,\"exec_max_us\":%lu,"
+             "\"failsafe_active\":%s,\"failsafe_trips\":%lu,\"failsafe_reaction_last_us\":%lu,"
+             "\"failsafe_reaction_max_us\":%lu}",
+             CONTROL_TASK_RATE_HZ, setpoint.speed, setpoint.steering,
+             setpoint.horn ? "true" : "false", setpoint.light ? "true" : "false",
+             (unsigned long)stats.ticks, (unsigned long)stats.missed_ticks,
+             (unsigned long)stats.updates, (unsigned long)stats.latency_last_us,
+             (unsigned long)stats.latency_avg_us, (unsigned long)stats.latency_max_us,
+             (unsigned long)stats.exec_max_us,
+             stats.failsafe_active ? "true" : "false", (unsigned long)stats.failsafe_trips,
+             (unsigned long)stats.failsafe_reaction_last_us, (unsigned long)stats.failsafe_reaction_max_us);
+
+    return json_response(req, response);
+}
+#endif
+
+#if ENABLE_TASK_STATS
+// Per-task CPU load, stack high-water mark and core over the sampling window
+static esp_err_t system_info_tasks_handler(httpd_req_t *req)
+{
+    // Static: too big for the httpd stack, and handlers never run concurrently
+    static task_stats_entry_t tasks[TASK_STATS_MAX_TASKS];
+    static char response[4096];
+    int count = task_stats_read(0, tasks, TASK_STATS_MAX_TASKS, NULL);
+    size_t offset = 0;
+
+    offset += snprintf(response + offset, sizeof(response) - offset,
+                       "{\"window_ms\":%d,\"cores\":%d,\"tasks\":[",
+                       TASK_STATS_SAMPLE_MS * (TASK_STATS_WINDOW_SAMPLES - 1), configNUMBER_OF_CORES);
+    for (int i = 0; i < count && offset < sizeof(response); i++) {
+        offset += snprintf(response + offset, sizeof(response) - offset,
+                           "%s{\"name\":\"%s\",\"priority\":%u,\"core\":%d,"
+                           "\"cpu_permille\":%u,\"stack_free_min\":%lu}",
+                           i > 0 ? "," : "", tasks[i].name, tasks[i].priority, tasks[i].core,
+                           tasks[i].cpu_permille, (unsigned long)tasks[i].stack_free_min);
+    }
+    if (offset < sizeof(response)) {
+        snprintf(response + offset, sizeof(response) - offset, "]}");
+    }
+
+    return json_response(req, response);
+}
+#endif
+
+#if ENABLE_TRACE
+static esp_err_t trace_send_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+// Trace ring as Chrome trace-event JSON, ?clear=1 empties the ring after the dump
+static esp_err_t trace_handler(httpd_req_t *req)
+{
+    char query[32];
+    char value[4];
+    bool clear = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                 httpd_query_key_value(query, "clear", value, sizeof(value)) == ESP_OK &&
+                 value[0] == '1';
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"rc-trace.json\"");
+
+    esp_err_t ret = trace_dump_json(trace_send_chunk, req);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Trace dump failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (clear) {
+        trace_clear();
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief /api/trace: the dump is tens of kilobytes, keep it off the httpd task
+ */
+static esp_err_t trace_async_handler(httpd_req_t *req)
+{
+    return http_workers_submit(req, trace_handler);
+}
+#endif
+
+static esp_err_t metrics_send_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+// Metrics registry as Prometheus text
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    esp_err_t ret = metrics_render_prometheus(metrics_send_chunk, req);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Metrics page failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
 static esp_err_t system_info_handler(httpd_req_t *req)
 {
     // Get chip information
@@ -627,6 +886,14 @@ static esp_err_t system_info_handler(httpd_req_t *req)
     return httpd_resp_send(req, (const char *)response, sizeof(response));
 }
 
+/**
+ * @brief /ota/upload: the upload runs for seconds, keep it off the httpd task
+ */
+static esp_err_t ota_upload_async_handler(httpd_req_t *req)
+{
+    return http_workers_submit(req, ota_upload_handler);
+}
+
 static esp_err_t httpd_get_handler(httpd_req_t *req)
 {
     extern const uint8_t index_html_start[] asm("_binary_index_html_start");
@@ -639,90 +906,6 @@ static esp_err_t httpd_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-#if ENABLE_CAMERA_SUPPORT
-esp_err_t jpg_stream_httpd_handler(httpd_req_t *req)
-{
-    camera_fb_t * fb = NULL;
-    esp_err_t res = ESP_OK;
-    size_t _jpg_buf_len;
-    uint8_t * _jpg_buf;
-    char * part_buf[64];
-    static int64_t last_frame = 0;
-    if (!last_frame) {
-        last_frame = esp_timer_get_time();
-    }
-
-    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-    if(res != ESP_OK){
-        return res;
-    }
-
-    while(true)
-    {
-        fb = esp_camera_fb_get();
-        if (!fb) {
-            ESP_LOGE(TAG, "Camera capture failed");
-            res = ESP_FAIL;
-            break;
-        }
-
-        if (fb->format != PIXFORMAT_JPEG)
-        {
-            bool jpeg_converted = frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len);
-            if (!jpeg_converted)
-            {
-                ESP_LOGE(TAG, "JPEG compression failed");
-                esp_camera_fb_return(fb);
-                res = ESP_FAIL;
-            }
-        }
-        else
-        {
-            _jpg_buf_len = fb->len;
-            _jpg_buf = fb->buf;
-        }
-
-        if (res == ESP_OK)
-        {
-            res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
-        }
-
-        if (res == ESP_OK)
-        {
-            size_t hlen = snprintf((char *)part_buf, 64, _STREAM_PART, _jpg_buf_len);
-            res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
-        }
-
-        if (res == ESP_OK)
-        {
-            res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
-        }
-
-        if (fb->format != PIXFORMAT_JPEG)
-        {
-            free(_jpg_buf);
-        }
-
-        esp_camera_fb_return(fb);
-        if (res != ESP_OK)
-        {
-            break;
-        }
-
-        int64_t fr_end = esp_timer_get_time();
-        int64_t frame_time = fr_end - last_frame;
-        last_frame = fr_end;
-        frame_time /= 1000;
-        ESP_LOGI(TAG, "MJPG: %uKB %ums (%.1ffps)",
-            (unsigned int)(_jpg_buf_len/1024),
-            (unsigned int)frame_time, 1000.0 / (uint32_t)frame_time);
-    }
-
-    last_frame = 0;
-    return res;
-}
-#endif // ENABLE_CAMERA_SUPPORT
-
 /******************************* PUBLIC METHODS *************************************/
 
 void http_server_start(void)
@@ -734,38 +917,47 @@ void http_server_start(void)
 
 #if ENABLE_CAMERA_SUPPORT
     cam_start_camera();
+
+    // MJPEG on its own server instance, see video_server.h
+    esp_err_t video_ret = video_server_start();
+    if (video_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start video server: %s", esp_err_to_name(video_ret));
+    }
 #endif
     
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.uri_match_fn = httpd_uri_match_wildcard;
+    config.max_uri_handlers = 16;
 
     ESP_ERROR_CHECK(httpd_start(&server, &config));
 
+    // Long handlers run on workers so /ws keeps flowing meanwhile
+    esp_err_t workers_ret = http_workers_start();
+    if (workers_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP workers: %s", esp_err_to_name(workers_ret));
+    }
+
+    // Per-client WebSocket send queues
+    esp_err_t outbox_ret = ws_outbox_init(server, ws_outbox_error);
+    if (outbox_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start WebSocket outbox: %s", esp_err_to_name(outbox_ret));
+    }
+
     // Register WebSocket handler for commands
     httpd_uri_t ws = {
         .uri        = "/ws",
         .method     = HTTP_GET,
         .handler    = ws_handler,
         .user_ctx   = NULL,
-        .is_websocket = true
+        .is_websocket = true,
+        .handle_ws_control_frames = true    // Pongs carry the heartbeat RTT
     };
     httpd_register_uri_handler(server, &ws);
 
-#if ENABLE_CAMERA_SUPPORT
-    // Video streaming handler
-    httpd_uri_t httpd_video = {
-        .uri       = "/video",
-        .method    = HTTP_GET,
-        .handler   = jpg_stream_httpd_handler,
-        .user_ctx  = NULL
-    };
-    httpd_register_uri_handler(server, &httpd_video);
-#endif
-
     httpd_uri_t ota_upload = {
         .uri       = "/ota/upload",
         .method    = HTTP_POST,
-        .handler   = ota_upload_handler,
+        .handler   = ota_upload_async_handler,
         .user_ctx  = NULL
     };
     httpd_register_uri_handler(server, &ota_upload);
@@ -794,6 +986,16 @@ void http_server_start(void)
     };
     httpd_register_uri_handler(server, &system_info);
 
+#if ENABLE_TASK_STATS
+    httpd_uri_t system_info_tasks = {
+        .uri       = "/api/system-info/tasks",
+        .method    = HTTP_GET,
+        .handler   = system_info_tasks_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &system_info_tasks);
+#endif
+
     httpd_uri_t steering_config_get = {
         .uri       = "/api/steering-config",
         .method    = HTTP_GET,
@@ -810,6 +1012,41 @@ void http_server_start(void)
     };
     httpd_register_uri_handler(server, &steering_config_post);
 
+    httpd_uri_t ws_clients_get = {
+        .uri       = "/api/ws-clients",
+        .method    = HTTP_GET,
+        .handler   = ws_clients_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &ws_clients_get);
+
+#if ENABLE_CONTROL_TASK
+    httpd_uri_t control_stats_get = {
+        .uri       = "/api/control",
+        .method    = HTTP_GET,
+        .handler   = control_stats_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &control_stats_get);
+#endif
+
+    httpd_uri_t metrics_get = {
+        .uri       = "/metrics",
+        .method    = HTTP_GET,
+        .handler   = metrics_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &metrics_get);
+
+#if ENABLE_TRACE
+    httpd_uri_t trace_get = {
+        .uri       = "/api/trace",
+        .method    = HTTP_GET,
+        .handler   = trace_async_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &trace_get);
+#endif
 
 
     httpd_uri_t httpd_get = {
@@ -821,7 +1058,17 @@ void http_server_start(void)
     httpd_register_uri_handler(server, &httpd_get);
     
     // Start WebSocket heartbeat timer
-
+    const esp_timer_create_args_t heartbeat_args = {
+        .callback = ws_heartbeat_timer_callback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ws_heartbeat",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&heartbeat_args, &ws_heartbeat_timer) == ESP_OK) {
+        esp_timer_start_periodic(ws_heartbeat_timer, WS_HEARTBEAT_INTERVAL_MS * 1000);
+    } else {
+        ESP_LOGE(TAG, "Failed to create WebSocket heartbeat timer");
+    }
     
     // Initialize RCP protocol
     esp_err_t rcp_ret = rcp_init();
@@ -838,13 +1085,24 @@ void http_server_stop(void)
         ESP_LOGI(TAG, "Stopping HTTP server");
         
         // Stop WebSocket heartbeat timer
-
+        if (ws_heartbeat_timer != NULL) {
+            esp_timer_stop(ws_heartbeat_timer);
+            esp_timer_delete(ws_heartbeat_timer);
+            ws_heartbeat_timer = NULL;
+        }
         
+#if ENABLE_CAMERA_SUPPORT
+        video_server_stop();
+#endif
+
+        http_workers_stop();
+
         // Deinitialize RCP protocol
         rcp_deinit();
         
         // Clear all WebSocket clients
-        ws_client_count = 0;
+        ws_outbox_deinit();
+        ws_clients_clear();
         
         ESP_ERROR_CHECK(httpd_stop(server));
         server = NULL;
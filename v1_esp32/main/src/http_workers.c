@@ -0,0 +1,186 @@
+#include "http_workers.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+
+static const char *TAG = "http_workers";
+
+/**
+ * @brief Detached request waiting for a worker
+ */
+typedef struct {
+    httpd_req_t *req;               // Copy from httpd_req_async_handler_begin()
+    http_worker_handler_t handler;  // NULL asks the worker to exit
+} http_work_t;
+
+static QueueHandle_t work_queue = NULL;
+static SemaphoreHandle_t idle_workers = NULL;    // Counts workers without a request
+static SemaphoreHandle_t stopped_workers = NULL; // Given by each worker on exit
+static TaskHandle_t worker_handles[HTTP_WORKERS_COUNT];
+static int workers_started = 0;
+static volatile bool workers_running = false;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Run a detached request and release it
+ */
+static void http_worker_run(int index, const http_work_t *work)
+{
+    esp_err_t ret = work->handler(work->req);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Worker %d: handler for %s failed: %s", index, work->req->uri, esp_err_to_name(ret));
+    }
+
+    httpd_req_async_handler_complete(work->req);
+}
+
+/**
+ * @brief Worker task, runs one detached request at a time until a stop message
+ */
+static void http_worker_task(void *pvParameters)
+{
+    int index = (int)(intptr_t)pvParameters;
+    http_work_t work;
+
+    ESP_LOGD(TAG, "Worker %d started", index);
+
+    while (xQueueReceive(work_queue, &work, portMAX_DELAY) == pdTRUE && work.handler != NULL) {
+        http_worker_run(index, &work);
+        xSemaphoreGive(idle_workers);
+    }
+
+    ESP_LOGD(TAG, "Worker %d stopped", index);
+    worker_handles[index] = NULL;
+    xSemaphoreGive(stopped_workers);
+    vTaskDelete(NULL);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t http_workers_start(void)
+{
+    if (workers_running) {
+        ESP_LOGW(TAG, "Workers already running");
+        return ESP_OK;
+    }
+
+    // Reused across stop/start: http_workers_stop() leaves them empty, and the
+    // httpd task may still be inside http_workers_submit() when it returns
+    if (work_queue == NULL) {
+        work_queue = xQueueCreate(HTTP_WORKERS_COUNT, sizeof(http_work_t));
+    }
+    if (idle_workers == NULL) {
+        idle_workers = xSemaphoreCreateCounting(HTTP_WORKERS_COUNT, 0);
+    }
+    if (stopped_workers == NULL) {
+        stopped_workers = xSemaphoreCreateCounting(HTTP_WORKERS_COUNT, 0);
+    }
+    if (work_queue == NULL || idle_workers == NULL || stopped_workers == NULL) {
+        ESP_LOGE(TAG, "Failed to create worker queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    workers_running = true;
+    workers_started = 0;
+
+    for (int i = 0; i < HTTP_WORKERS_COUNT; i++) {
+        BaseType_t ret = xTaskCreate(
+            http_worker_task,
+            "http_worker",
+            HTTP_WORKERS_STACK_SIZE,    // Stack size
+            (void *)(intptr_t)i,        // Parameters
+            HTTP_WORKERS_PRIORITY,      // Priority
+            &worker_handles[i]          // Task handle
+        );
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            continue;
+        }
+        workers_started++;
+        xSemaphoreGive(idle_workers);
+    }
+
+    if (workers_started == 0) {
+        workers_running = false;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "%d HTTP workers started", workers_started);
+    return ESP_OK;
+}
+
+void http_workers_stop(void)
+{
+    if (!workers_running) {
+        return;
+    }
+
+    // New requests run inline from here on
+    workers_running = false;
+    ESP_LOGI(TAG, "Stopping HTTP workers");
+
+    // Queued after the pending requests, so those are still served
+    const http_work_t stop = { .req = NULL, .handler = NULL };
+    for (int i = 0; i < workers_started; i++) {
+        xQueueSend(work_queue, &stop, portMAX_DELAY);
+    }
+    for (int i = 0; i < workers_started; i++) {
+        xSemaphoreTake(stopped_workers, portMAX_DELAY);
+    }
+    workers_started = 0;
+
+    // A submit that raced the stop may have queued behind the stop messages
+    http_work_t work;
+    while (xQueueReceive(work_queue, &work, 0) == pdTRUE) {
+        if (work.handler != NULL) {
+            http_worker_run(-1, &work);
+        }
+    }
+
+    // Leave no idle tokens for the next http_workers_start() to add to
+    while (xSemaphoreTake(idle_workers, 0) == pdTRUE) {
+    }
+
+    ESP_LOGI(TAG, "HTTP workers stopped");
+}
+
+esp_err_t http_workers_submit(httpd_req_t *req, http_worker_handler_t handler)
+{
+    if (!workers_running || idle_workers == NULL) {
+        // No pool: run inline like a normal handler
+        return handler(req);
+    }
+
+    if (xSemaphoreTake(idle_workers, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "All workers busy, rejecting %s", req->uri);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, "{\"status\":\"error\",\"message\":\"Server busy, try again\"}",
+                               HTTPD_RESP_USE_STRLEN);
+    }
+
+    http_work_t work = { .req = NULL, .handler = handler };
+    esp_err_t ret = httpd_req_async_handler_begin(req, &work.req);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to detach %s: %s", req->uri, esp_err_to_name(ret));
+        xSemaphoreGive(idle_workers);
+        return ret;
+    }
+
+    // Cannot block: an idle worker was reserved, so the queue has room
+    if (xQueueSend(work_queue, &work, 0) != pdTRUE) {
+        httpd_req_async_handler_complete(work.req);
+        xSemaphoreGive(idle_workers);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
@@ -1,6 +1,7 @@
 #include <esp_log.h>
 #include <driver/gpio.h>
 #include "led_control.h"
+#include "dlog.h"
 
 static const char *TAG = "led_control";
 
@@ -41,7 +42,7 @@ void led_light_set(bool state)
     light_state = state;
     // For sinking mode: LOW = LED ON, HIGH = LED OFF
     gpio_set_level(LED_LIGHT_PIN, !state);
-    ESP_LOGI(TAG, "Light LED %s", state ? "ON" : "OFF");
+    DLOG(DLOG_LED_LIGHT, state);
 }
 
 void led_horn_set(bool state)
@@ -49,7 +50,7 @@ void led_horn_set(bool state)
     horn_state = state;
     // For sinking mode: LOW = LED ON, HIGH = LED OFF
     gpio_set_level(LED_HORN_PIN, !state);
-    ESP_LOGI(TAG, "Horn LED %s", state ? "ON" : "OFF");
+    DLOG(DLOG_LED_HORN, state);
 }
 
 void led_light_toggle(void)
@@ -61,3 +62,13 @@ void led_horn_toggle(void)
 {
     led_horn_set(!horn_state);
 }
+
+bool led_light_get(void)
+{
+    return light_state;
+}
+
+bool led_horn_get(void)
+{
+    return horn_state;
+}
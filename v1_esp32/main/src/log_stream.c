@@ -0,0 +1,293 @@
+#include "log_stream.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+
+#include "rcp_protocol.h"
+#include "ws_clients.h"
+
+static const char *TAG = "log_stream";
+
+#define LOG_STREAM_IDLE_CHECK_MS    1000    // Subscriber recount while the queue is quiet
+
+/**
+ * @brief Queued console line
+ */
+typedef struct {
+    uint16_t len;
+    char text[LOG_STREAM_LINE_MAX];
+} log_line_t;
+
+static QueueHandle_t line_queue = NULL;
+static TaskHandle_t sender_task_handle = NULL;
+static vprintf_like_t previous_vprintf = NULL;
+static volatile bool stream_active = false;     // Some client subscribed, lines are copied
+
+// Token bucket, in lines scaled by 1000 to keep integer math
+static portMUX_TYPE bucket_lock = portMUX_INITIALIZER_UNLOCKED;
+static int32_t bucket_tokens = LOG_STREAM_BURST * 1000;
+static int64_t bucket_refill_us = 0;
+
+static log_stream_stats_t stream_stats = { 0 };
+static uint32_t reported_drops = 0;
+
+// Tags accepted by log_stream_set_level(): the TAG of every firmware module.
+// esp_log caches each tag it is given a level for, so arbitrary client
+// strings would grow the heap without bound.
+static const char *const settable_tags[] = {
+    "*",
+    "battery_monitor",
+    "cam",
+    "config",
+    "control_task",
+    "dlog",
+    "drv8833",
+    "http_server",
+    "http_workers",
+    "led_control",
+    "log_stream",
+    "motor_control",
+    "net",
+    "ota",
+    "rcp_protocol",
+    "servo_control",
+    "task_stats",
+    "telemetry",
+    "trace",
+    "video_server",
+    "ws_clients",
+    "ws_outbox",
+};
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Take one line from the token bucket
+ */
+static bool log_stream_rate_take(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool allowed = false;
+
+    taskENTER_CRITICAL(&bucket_lock);
+    int64_t elapsed_us = now_us - bucket_refill_us;
+    bucket_refill_us = now_us;
+    if (elapsed_us > 1000000LL * LOG_STREAM_BURST / LOG_STREAM_RATE_PER_SEC) {
+        elapsed_us = 1000000LL * LOG_STREAM_BURST / LOG_STREAM_RATE_PER_SEC;    // Full bucket
+    }
+    bucket_tokens += (int32_t)(elapsed_us * LOG_STREAM_RATE_PER_SEC / 1000);
+    if (bucket_tokens > LOG_STREAM_BURST * 1000) {
+        bucket_tokens = LOG_STREAM_BURST * 1000;
+    }
+    if (bucket_tokens >= 1000) {
+        bucket_tokens -= 1000;
+        allowed = true;
+    }
+    taskEXIT_CRITICAL(&bucket_lock);
+
+    return allowed;
+}
+
+/**
+ * @brief Strip color codes and the trailing newline in place
+ */
+static uint16_t log_stream_clean(char *text, size_t len)
+{
+    uint16_t out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\033') {
+            // Skip "ESC [ ... m" (CONFIG_LOG_COLORS)
+            while (i < len && text[i] != 'm') {
+                i++;
+            }
+            continue;
+        }
+        text[out++] = text[i];
+    }
+    while (out > 0 && (text[out - 1] == '\n' || text[out - 1] == '\r')) {
+        out--;
+    }
+
+    return out;
+}
+
+/**
+ * @brief esp_log output hook, runs in the task that logs
+ */
+static int log_stream_vprintf(const char *format, va_list args)
+{
+    int ret = 0;
+
+    if (LOG_STREAM_UART_ECHO || !stream_active) {
+        va_list uart_args;
+        va_copy(uart_args, args);
+        ret = previous_vprintf(format, uart_args);
+        va_end(uart_args);
+    }
+
+    // Lines logged while sending would loop back into the stream
+    if (!stream_active || xTaskGetCurrentTaskHandle() == sender_task_handle) {
+        return ret;
+    }
+
+    if (!log_stream_rate_take()) {
+        stream_stats.dropped_rate++;
+        return ret;
+    }
+
+    log_line_t line;
+    int len = vsnprintf(line.text, sizeof(line.text), format, args);
+    if (len <= 0) {
+        return ret;
+    }
+
+    line.len = log_stream_clean(line.text, len < (int)sizeof(line.text) ? len : sizeof(line.text) - 1);
+    if (line.len == 0) {
+        return ret;
+    }
+
+    if (xQueueSend(line_queue, &line, 0) != pdTRUE) {
+        stream_stats.dropped_full++;
+    }
+
+    return LOG_STREAM_UART_ECHO ? ret : len;
+}
+
+/**
+ * @brief Send one line to every subscriber, returns the subscriber count
+ */
+static int log_stream_send(const char *text, size_t len)
+{
+    ws_client_ref_t refs[WS_CLIENTS_MAX];
+    int count = ws_clients_snapshot(refs, WS_CLIENTS_MAX, WS_STREAM_LOG);
+
+    for (int i = 0; i < count; i++) {
+        rcp_send_to(refs[i].fd, RCP_PORT_LOG, text, len);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Sender task, forwards queued lines to the subscribers
+ */
+static void log_stream_task(void *pvParameters)
+{
+    log_line_t line;
+
+    while (1) {
+        if (xQueueReceive(line_queue, &line, pdMS_TO_TICKS(LOG_STREAM_IDLE_CHECK_MS)) == pdTRUE) {
+            int count = log_stream_send(line.text, line.len);
+            stream_stats.subscribers = count;
+            stream_stats.lines_sent++;
+        } else {
+            // Subscribers leave with their connection, stop copying once all are gone
+            ws_client_ref_t refs[WS_CLIENTS_MAX];
+            stream_stats.subscribers = ws_clients_snapshot(refs, WS_CLIENTS_MAX, WS_STREAM_LOG);
+        }
+
+        // Also turns copying back on if a subscribe raced with the last recount
+        stream_active = stream_stats.subscribers > 0;
+        if (!stream_active) {
+            continue;
+        }
+
+        uint32_t drops = stream_stats.dropped_rate + stream_stats.dropped_full;
+        if (drops != reported_drops && uxQueueMessagesWaiting(line_queue) == 0) {
+            char notice[48];
+            int len = snprintf(notice, sizeof(notice), "%s: %lu lines dropped",
+                               TAG, (unsigned long)(drops - reported_drops));
+            reported_drops = drops;
+            log_stream_send(notice, len);
+        }
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t log_stream_init(void)
+{
+    if (line_queue != NULL) {
+        return ESP_OK;
+    }
+
+    line_queue = xQueueCreate(LOG_STREAM_QUEUE_LEN, sizeof(log_line_t));
+    if (line_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create line queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreate(
+        log_stream_task,
+        "log_stream",
+        LOG_STREAM_TASK_STACK_SIZE, // Stack size
+        NULL,                       // Parameters
+        LOG_STREAM_TASK_PRIORITY,   // Priority
+        &sender_task_handle         // Task handle
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create log stream task");
+        vQueueDelete(line_queue);
+        line_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    bucket_refill_us = esp_timer_get_time();
+    previous_vprintf = esp_log_set_vprintf(log_stream_vprintf);
+
+    ESP_LOGI(TAG, "Log stream ready (%d lines/s, burst %d)", LOG_STREAM_RATE_PER_SEC, LOG_STREAM_BURST);
+    return ESP_OK;
+}
+
+esp_err_t log_stream_subscribe(int client_id, bool enable)
+{
+    if (line_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ws_clients_set_stream(client_id, WS_STREAM_LOG, enable);
+    if (enable) {
+        stream_active = true;
+    }
+
+    ESP_LOGI(TAG, "Client %d %s the log stream", client_id, enable ? "joined" : "left");
+    return ESP_OK;
+}
+
+esp_err_t log_stream_set_level(const char *tag, esp_log_level_t level)
+{
+    if (tag == NULL || tag[0] == '\0' || level < ESP_LOG_NONE || level > ESP_LOG_VERBOSE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *known = NULL;
+    for (size_t i = 0; i < sizeof(settable_tags) / sizeof(settable_tags[0]); i++) {
+        if (strcmp(tag, settable_tags[i]) == 0) {
+            known = settable_tags[i];
+            break;
+        }
+    }
+    if (known == NULL) {
+        ESP_LOGW(TAG, "Log level change for unknown tag '%s' ignored", tag);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_log_level_set(known, level);
+    ESP_LOGI(TAG, "Log level of '%s' set to %d", tag, level);
+    return ESP_OK;
+}
+
+void log_stream_get_stats(log_stream_stats_t *stats)
+{
+    *stats = stream_stats;
+}
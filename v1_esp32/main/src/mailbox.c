@@ -0,0 +1,46 @@
+#include "mailbox.h"
+
+#include <string.h>
+
+void mailbox_init(mailbox_t *mailbox, void *storage, size_t size)
+{
+    mailbox->storage = storage;
+    mailbox->size = size;
+    atomic_init(&mailbox->seq, 0);
+}
+
+void mailbox_write(mailbox_t *mailbox, const void *value)
+{
+    unsigned seq = atomic_load_explicit(&mailbox->seq, memory_order_relaxed);
+
+    // Odd sequence: readers that overlap this copy will retry
+    atomic_store_explicit(&mailbox->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(mailbox->storage, value, mailbox->size);
+
+    atomic_store_explicit(&mailbox->seq, seq + 2, memory_order_release);
+}
+
+bool mailbox_read(mailbox_t *mailbox, void *value, uint32_t *seq)
+{
+    for (int attempt = 0; attempt < MAILBOX_READ_RETRIES; attempt++) {
+        unsigned before = atomic_load_explicit(&mailbox->seq, memory_order_acquire);
+        if ((before & 1) != 0) {
+            continue;
+        }
+
+        memcpy(value, mailbox->storage, mailbox->size);
+        atomic_thread_fence(memory_order_acquire);
+
+        unsigned after = atomic_load_explicit(&mailbox->seq, memory_order_relaxed);
+        if (before == after) {
+            if (seq != NULL) {
+                *seq = after;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -5,6 +5,11 @@
 #include "config.h"
 #include "net.h"
 #include "ota.h"
+#include "dlog.h"
+
+#if ENABLE_LOG_STREAM
+#include "log_stream.h"
+#endif
 
 #if ENABLE_LED_CONTROL
 #include "led_control.h"
@@ -22,6 +27,18 @@
 #include "motor_control.h"
 #endif
 
+#if ENABLE_TELEMETRY
+#include "telemetry.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#if ENABLE_TASK_STATS
+#include "task_stats.h"
+#endif
+
 // #include <sys/unistd.h>
 // #include "esp_log.h"
 // #include "esp_system.h"
@@ -39,6 +56,16 @@ void app_main(void)
     // const size_t index_html_size = (index_html_end - index_html_start);
     // ESP_LOGI("test", "file size: %d", index_html_size);
 
+#if ENABLE_DLOG
+    // First, so control path logs never wait on the UART
+    dlog_start();
+#endif
+
+#if ENABLE_LOG_STREAM
+    // Hooks esp_log before the modules start logging
+    log_stream_init();
+#endif
+
     config_init();
 
 #if ENABLE_LED_CONTROL
@@ -61,12 +88,25 @@ void app_main(void)
     ota_init();
 #endif
 
+#if ENABLE_CONTROL_TASK
+    // Running before the network comes up, so the first command is applied
+    control_task_start();
+#endif
+
     net_init();
 
 #if ENABLE_BATTERY_MONITORING
     battery_monitor_start_task();
 #endif
 
+#if ENABLE_TELEMETRY
+    telemetry_start_task();
+#endif
+
+#if ENABLE_TASK_STATS
+    task_stats_start();
+#endif
+
     // config_data_t config_data = config_load();
 
     // ESP_LOGI(TAG, "Count: %d!\n", config_data.count++);
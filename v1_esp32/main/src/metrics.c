@@ -0,0 +1,313 @@
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "project_config.h"
+#include "rcp_protocol.h"
+#include "ws_clients.h"
+#include "ws_outbox.h"
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#if ENABLE_DLOG
+#include "dlog.h"
+#endif
+
+#if ENABLE_LOG_STREAM
+#include "log_stream.h"
+#endif
+
+/**
+ * @brief Static description of a registry entry
+ */
+typedef struct {
+    metric_type_t type;
+    const char *name;
+    const char *help;
+} metric_info_t;
+
+#define METRICS_INFO(id, type, name, help)  [id] = { METRIC_TYPE_##type, name, help },
+
+static const metric_info_t metrics_info[METRIC_COUNT] = {
+    METRICS_LIST(METRICS_INFO)
+};
+
+static const uint32_t histogram_bounds_us[METRICS_HISTOGRAM_BUCKETS - 1] = METRICS_HISTOGRAM_BOUNDS_US;
+
+static const char *const metric_type_names[] = { "counter", "gauge", "histogram" };
+
+/**
+ * @brief Prometheus text output, flushed to the writer in chunks
+ */
+typedef struct {
+    metrics_write_fn_t write;
+    void *ctx;
+    esp_err_t err;
+    size_t len;
+    char buf[METRICS_CHUNK_SIZE];
+} metrics_out_t;
+
+metric_t metrics_registry[METRIC_COUNT];
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static void metrics_out_flush(metrics_out_t *out)
+{
+    if (out->len > 0 && out->err == ESP_OK) {
+        out->err = out->write(out->ctx, out->buf, out->len);
+    }
+    out->len = 0;
+}
+
+static void metrics_printf(metrics_out_t *out, const char *format, ...)
+{
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len <= 0 || out->err != ESP_OK) {
+        return;
+    }
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    if (out->len + len > sizeof(out->buf)) {
+        metrics_out_flush(out);
+    }
+    memcpy(out->buf + out->len, line, len);
+    out->len += len;
+}
+
+/**
+ * @brief Per-port RCP counters, labeled by port
+ *
+ * Any client can send frames to any of the 256 ports, so ports without a
+ * handler share one port="other" series instead of one series each.
+ */
+static void metrics_render_rcp_ports(metrics_out_t *out)
+{
+    static const struct {
+        const char *name;
+        const char *help;
+    } port_metrics[] = {
+        { "rc_rcp_port_frames_total", "RCP frames dispatched per port" },
+        { "rc_rcp_port_errors_total", "RCP frames rejected or failed per port" },
+        { "rc_rcp_port_dropped_total", "RCP frames dropped as stale or late per port" },
+    };
+
+    for (int m = 0; m < 3; m++) {
+        metrics_printf(out, "# HELP %s %s\n# TYPE %s counter\n",
+                       port_metrics[m].name, port_metrics[m].help, port_metrics[m].name);
+
+        uint32_t other = 0;
+        bool other_seen = false;
+        for (int port = 0; port < RCP_PORT_COUNT; port++) {
+            rcp_port_stats_t stats;
+            if (rcp_get_port_stats((uint8_t)port, &stats) != ESP_OK ||
+                (stats.rx_frames == 0 && stats.errors == 0)) {
+                continue;
+            }
+
+            uint32_t value = (m == 0) ? stats.rx_frames :
+                             (m == 1) ? stats.errors :
+                             stats.dropped_stale + stats.dropped_late;
+            if (!rcp_port_is_known((uint8_t)port)) {
+                other += value;
+                other_seen = true;
+                continue;
+            }
+            metrics_printf(out, "%s{port=\"0x%02X\"} %lu\n",
+                           port_metrics[m].name, port, (unsigned long)value);
+        }
+        if (other_seen) {
+            metrics_printf(out, "%s{port=\"other\"} %lu\n", port_metrics[m].name, (unsigned long)other);
+        }
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void metrics_observe(metric_id_t id, uint32_t value_us)
+{
+    metric_t *metric = &metrics_registry[id];
+
+    int bucket = 0;
+    while (bucket < METRICS_HISTOGRAM_BUCKETS - 1 && value_us > histogram_bounds_us[bucket]) {
+        bucket++;
+    }
+
+    atomic_fetch_add_explicit(&metric->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->sum, value_us, memory_order_relaxed);
+}
+
+void metrics_refresh(void)
+{
+    metrics_set(METRIC_UPTIME, (uint32_t)(esp_timer_get_time() / 1000000));
+    metrics_set(METRIC_HEAP_FREE, esp_get_free_heap_size());
+    metrics_set(METRIC_HEAP_MIN_FREE, esp_get_minimum_free_heap_size());
+
+    uint32_t frames = 0;
+    uint32_t errors = 0;
+    uint32_t dropped = 0;
+    for (int port = 0; port < RCP_PORT_COUNT; port++) {
+        rcp_port_stats_t stats;
+        if (rcp_get_port_stats((uint8_t)port, &stats) == ESP_OK) {
+            frames += stats.rx_frames;
+            errors += stats.errors;
+            dropped += stats.dropped_stale + stats.dropped_late;
+        }
+    }
+    metrics_set(METRIC_RCP_FRAMES, frames);
+    metrics_set(METRIC_RCP_ERRORS, errors);
+    metrics_set(METRIC_RCP_DROPPED, dropped);
+
+    metrics_set(METRIC_WS_CLIENTS, ws_clients_count());
+
+    // Per-client queues stand in for the httpd send queue, which has no depth API
+    ws_outbox_stats_t outbox[WS_OUTBOX_MAX_CLIENTS];
+    int clients = ws_outbox_get_stats(outbox, WS_OUTBOX_MAX_CLIENTS);
+    uint32_t depth = 0;
+    for (int i = 0; i < clients; i++) {
+        depth += outbox[i].depth;
+    }
+    metrics_set(METRIC_WS_OUTBOX_DEPTH, depth);
+
+#if ENABLE_CONTROL_TASK
+    control_stats_t control;
+    control_get_stats(&control);
+    metrics_set(METRIC_CONTROL_MISSED, control.missed_ticks);
+    metrics_set(METRIC_FAILSAFE_TRIPS, control.failsafe_trips);
+#endif
+
+#if ENABLE_DLOG
+    dlog_stats_t dlog;
+    dlog_get_stats(&dlog);
+    metrics_set(METRIC_DLOG_DROPPED, dlog.dropped);
+#endif
+
+#if ENABLE_LOG_STREAM
+    log_stream_stats_t log_stream;
+    log_stream_get_stats(&log_stream);
+    metrics_set(METRIC_LOG_STREAM_DROPPED, log_stream.dropped_rate + log_stream.dropped_full);
+#endif
+}
+
+esp_err_t metrics_render_prometheus(metrics_write_fn_t write, void *ctx)
+{
+    // The caller's stack is the httpd task's, keep the chunk buffer off it
+    metrics_out_t *out = malloc(sizeof(metrics_out_t));
+    if (out == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    out->write = write;
+    out->ctx = ctx;
+    out->err = ESP_OK;
+    out->len = 0;
+
+    metrics_refresh();
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        const metric_info_t *info = &metrics_info[id];
+        metric_t *metric = &metrics_registry[id];
+
+        metrics_printf(out, "# HELP %s %s\n# TYPE %s %s\n",
+                       info->name, info->help, info->name, metric_type_names[info->type]);
+
+        if (info->type != METRIC_TYPE_HISTOGRAM) {
+            metrics_printf(out, "%s %lu\n", info->name,
+                           (unsigned long)atomic_load_explicit(&metric->value, memory_order_relaxed));
+            continue;
+        }
+
+        // Prometheus buckets are cumulative
+        uint32_t cumulative = 0;
+        for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+            cumulative += atomic_load_explicit(&metric->buckets[b], memory_order_relaxed);
+            if (b < METRICS_HISTOGRAM_BUCKETS - 1) {
+                metrics_printf(out, "%s_bucket{le=\"%lu\"} %lu\n", info->name,
+                               (unsigned long)histogram_bounds_us[b], (unsigned long)cumulative);
+            } else {
+                metrics_printf(out, "%s_bucket{le=\"+Inf\"} %lu\n", info->name,
+                               (unsigned long)cumulative);
+            }
+        }
+        metrics_printf(out, "%s_sum %lu\n%s_count %lu\n",
+                       info->name, (unsigned long)atomic_load_explicit(&metric->sum, memory_order_relaxed),
+                       info->name, (unsigned long)cumulative);
+    }
+
+    metrics_render_rcp_ports(out);
+    metrics_out_flush(out);
+
+    esp_err_t err = out->err;
+    free(out);
+    return err;
+}
+
+size_t metrics_build_snapshot(uint8_t *buf, size_t size)
+{
+    size_t len = 0;
+
+    metrics_refresh();
+
+    if (size < 2) {
+        return 0;
+    }
+    buf[len++] = METRICS_SNAPSHOT_VERSION;
+    buf[len++] = METRIC_COUNT;
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        const metric_info_t *info = &metrics_info[id];
+        metric_t *metric = &metrics_registry[id];
+        uint32_t values[2 + METRICS_HISTOGRAM_BUCKETS];
+        int value_count;
+
+        if (info->type == METRIC_TYPE_HISTOGRAM) {
+            uint32_t count = 0;
+            for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+                values[2 + b] = atomic_load_explicit(&metric->buckets[b], memory_order_relaxed);
+                count += values[2 + b];
+            }
+            values[0] = count;
+            values[1] = atomic_load_explicit(&metric->sum, memory_order_relaxed);
+            value_count = 2 + METRICS_HISTOGRAM_BUCKETS;
+        } else {
+            values[0] = atomic_load_explicit(&metric->value, memory_order_relaxed);
+            value_count = 1;
+        }
+
+        size_t entry_len = 2 + value_count * 4 + (info->type == METRIC_TYPE_HISTOGRAM ? 1 : 0);
+        if (len + entry_len > size) {
+            return 0;
+        }
+
+        buf[len++] = (uint8_t)id;
+        buf[len++] = (uint8_t)info->type;
+        for (int v = 0; v < value_count; v++) {
+            if (info->type == METRIC_TYPE_HISTOGRAM && v == 2) {
+                buf[len++] = METRICS_HISTOGRAM_BUCKETS;
+            }
+            for (int i = 0; i < 4; i++) {
+                buf[len++] = (uint8_t)(values[v] >> (8 * i));
+            }
+        }
+    }
+
+    return len;
+}
@@ -6,6 +6,8 @@
 #include <esp_err.h>
 #include <string.h>
 #include "motor_control.h"
+#include "dlog.h"
+#include "trace.h"
 
 static const char *TAG = "motor_control";
 static const motor_driver_interface_t *active_driver = NULL;
@@ -146,7 +148,8 @@ esp_err_t motor_control_set_speed(int speed)
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Setting motor speed: %d", speed);
+    DLOG(DLOG_MOTOR_SET_SPEED, speed);
+    uint32_t trace_start = TRACE_START();
 
     // Use driver's set_speed if available, otherwise convert to mode
     esp_err_t ret;
@@ -167,6 +170,7 @@ esp_err_t motor_control_set_speed(int speed)
         ESP_LOGE(TAG, "Failed to set motor speed: %s", esp_err_to_name(ret));
     }
 
+    TRACE_SPAN(TRACE_MOTOR_SET_SPEED, trace_start, speed);
     return ret;
 }
 
@@ -182,7 +186,7 @@ esp_err_t motor_control_set_mode(motor_mode_t mode)
         return ESP_ERR_NOT_SUPPORTED;
     }
 
-    ESP_LOGI(TAG, "Setting motor mode: %d", mode);
+    DLOG(DLOG_MOTOR_SET_MODE, mode);
 
     esp_err_t ret = active_driver->set_mode(mode);
     if (ret == ESP_OK) {
@@ -205,7 +209,7 @@ esp_err_t motor_control_stop(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    ESP_LOGI(TAG, "Stopping motor");
+    DLOG(DLOG_MOTOR_STOP);
 
     esp_err_t ret;
     if (active_driver->stop) {
@@ -8,6 +8,8 @@
 #include <driver/gpio.h>
 #include <string.h>
 #include "motor_drv8833.h"
+#include "dlog.h"
+#include "trace.h"
 
 static const char *TAG = "drv8833";
 static bool drv8833_initialized = false;
@@ -129,7 +131,10 @@ static esp_err_t set_pwm_duty(ledc_channel_t channel, int duty_percent)
         return ret;
     }
 
-    return ledc_update_duty(DRV8833_LEDC_MODE, channel);
+    uint32_t trace_start = TRACE_START();
+    ret = ledc_update_duty(DRV8833_LEDC_MODE, channel);
+    TRACE_SPAN(TRACE_LEDC_UPDATE, trace_start, channel);
+    return ret;
 }
 
 /**
@@ -149,7 +154,7 @@ static esp_err_t apply_motor_control(motor_mode_t mode, int speed_percent)
             if (ret == ESP_OK) {
                 ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, 0);
             }
-            ESP_LOGD(TAG, "Forward mode: IN1=%d%%, IN2=0%%", speed_percent);
+            DLOG(DLOG_DRV8833_FORWARD, speed_percent);
             break;
 
         case MOTOR_MODE_REVERSE:
@@ -158,7 +163,7 @@ static esp_err_t apply_motor_control(motor_mode_t mode, int speed_percent)
             if (ret == ESP_OK) {
                 ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, speed_percent);
             }
-            ESP_LOGD(TAG, "Reverse mode: IN1=0%%, IN2=%d%%", speed_percent);
+            DLOG(DLOG_DRV8833_REVERSE, speed_percent);
             break;
 
         case MOTOR_MODE_BRAKE:
@@ -169,14 +174,14 @@ static esp_err_t apply_motor_control(motor_mode_t mode, int speed_percent)
                 if (ret == ESP_OK) {
                     ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, 100);
                 }
-                ESP_LOGD(TAG, "Brake mode: IN1=HIGH, IN2=HIGH");
+                DLOG(DLOG_DRV8833_BRAKE, 1, 1);
             } else {
                 // IN1=LOW, IN2=LOW
                 ret = set_pwm_duty(DRV8833_LEDC_IN1_CHANNEL, 0);
                 if (ret == ESP_OK) {
                     ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, 0);
                 }
-                ESP_LOGD(TAG, "Brake mode: IN1=LOW, IN2=LOW");
+                DLOG(DLOG_DRV8833_BRAKE, 0, 0);
             }
             break;
 
@@ -188,14 +193,14 @@ static esp_err_t apply_motor_control(motor_mode_t mode, int speed_percent)
                 if (ret == ESP_OK) {
                     ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, 0);
                 }
-                ESP_LOGD(TAG, "Free mode: IN1=LOW, IN2=LOW");
+                DLOG(DLOG_DRV8833_FREE, 0, 0);
             } else {
                 // IN1=HIGH, IN2=HIGH
                 ret = set_pwm_duty(DRV8833_LEDC_IN1_CHANNEL, 100);
                 if (ret == ESP_OK) {
                     ret = set_pwm_duty(DRV8833_LEDC_IN2_CHANNEL, 100);
                 }
-                ESP_LOGD(TAG, "Free mode: IN1=HIGH, IN2=HIGH");
+                DLOG(DLOG_DRV8833_FREE, 1, 1);
             }
             break;
 
@@ -290,7 +295,8 @@ esp_err_t drv8833_set_speed(int speed)
     if (speed < -100) speed = -100;
     if (speed > 100) speed = 100;
 
-    ESP_LOGI(TAG, "Setting DRV8833 speed: %d", speed);
+    DLOG(DLOG_DRV8833_SET_SPEED, speed);
+    uint32_t trace_start = TRACE_START();
 
     motor_mode_t mode;
     int abs_speed;
@@ -312,6 +318,7 @@ esp_err_t drv8833_set_speed(int speed)
         drv8833_state.mode = mode;
     }
 
+    TRACE_SPAN(TRACE_DRV8833_SET_SPEED, trace_start, speed);
     return ret;
 }
 
@@ -322,7 +329,7 @@ esp_err_t drv8833_set_mode(motor_mode_t mode)
         return ESP_ERR_INVALID_STATE;
     }
 
-    ESP_LOGI(TAG, "Setting DRV8833 mode: %d", mode);
+    DLOG(DLOG_DRV8833_SET_MODE, mode);
 
     esp_err_t ret = apply_motor_control(mode, 0);
     if (ret == ESP_OK) {
@@ -342,7 +349,7 @@ esp_err_t drv8833_stop(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    ESP_LOGI(TAG, "Stopping DRV8833 motor");
+    DLOG(DLOG_DRV8833_STOP);
 
     esp_err_t ret = apply_motor_control(MOTOR_MODE_BRAKE, 0);
     if (ret == ESP_OK) {
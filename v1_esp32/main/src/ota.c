@@ -7,8 +7,12 @@
 #include <esp_flash_partitions.h>
 #include <esp_partition.h>
 #include <esp_http_server.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
 
 #include "ota.h"
+#include "dlog.h"
 
 static const char *TAG = "ota";
 
@@ -17,6 +21,33 @@ static const esp_partition_t *update_partition = NULL;
 static bool ota_in_progress = false;
 static size_t binary_file_length = 0;
 static size_t data_read = 0;
+static portMUX_TYPE ota_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t restart_timer = NULL;
+
+static void ota_restart_callback(void *arg)
+{
+    dlog_flush();
+    esp_restart();
+}
+
+void ota_schedule_restart(uint32_t delay_ms)
+{
+    if (restart_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = ota_restart_callback,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "ota_restart",
+        };
+        if (esp_timer_create(&timer_args, &restart_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create restart timer, restarting now");
+            esp_restart();
+        }
+    }
+
+    // Restarting the timer just moves the restart, it only happens once
+    esp_timer_stop(restart_timer);
+    esp_timer_start_once(restart_timer, (uint64_t)delay_ms * 1000);
+}
 
 void ota_init(void)
 {
@@ -63,7 +94,14 @@ esp_err_t ota_upload_handler(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "Starting OTA update...");
     
-    if (ota_in_progress) {
+    // Uploads run on the HTTP workers, two may arrive at once
+    bool busy;
+    taskENTER_CRITICAL(&ota_lock);
+    busy = ota_in_progress;
+    ota_in_progress = true;
+    taskEXIT_CRITICAL(&ota_lock);
+
+    if (busy) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "OTA already in progress");
         return ESP_FAIL;
     }
@@ -71,27 +109,31 @@ esp_err_t ota_upload_handler(httpd_req_t *req)
     // Get content length
     size_t content_len = req->content_len;
     if (content_len == 0) {
+        ota_in_progress = false;
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No content");
         return ESP_FAIL;
     }
     
     // Check if content length is reasonable (not too small, not too large)
     if (content_len < 100000) {  // Less than 100KB probably not a valid firmware
+        ota_in_progress = false;
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File too small to be valid firmware");
         return ESP_FAIL;
     }
     
     if (content_len > 2000000) {  // More than 2MB probably too large
+        ota_in_progress = false;
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File too large");
         return ESP_FAIL;
     }
     
-    ESP_LOGI(TAG, "Content length: %d", content_len);
+    ESP_LOGI(TAG, "Content length: %zu", content_len);
     
     // Find update partition
     update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "No OTA partition found");
+        ota_in_progress = false;
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No OTA partition");
         return ESP_FAIL;
     }
@@ -103,11 +145,11 @@ esp_err_t ota_upload_handler(httpd_req_t *req)
     esp_err_t err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_ota_begin failed (%s)", esp_err_to_name(err));
+        ota_in_progress = false;
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA begin failed");
         return ESP_FAIL;
     }
     
-    ota_in_progress = true;
     binary_file_length = content_len;
     data_read = 0;
     
@@ -140,7 +182,7 @@ esp_err_t ota_upload_handler(httpd_req_t *req)
                 break;
             }
             data_read += data_recv;
-            ESP_LOGI(TAG, "Received %d of %d bytes", data_read, binary_file_length);
+            ESP_LOGI(TAG, "Received %zu of %zu bytes", data_read, binary_file_length);
         }
     }
     
@@ -184,9 +226,8 @@ esp_err_t ota_upload_handler(httpd_req_t *req)
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, response, strlen(response));
     
-    // Restart after a delay
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    esp_restart();
+    // Restart after a delay, the worker is free again right away
+    ota_schedule_restart(OTA_RESTART_DELAY_MS);
     
     return ESP_OK;
 }
@@ -205,8 +246,7 @@ esp_err_t ota_restart_handler(httpd_req_t *req)
     httpd_resp_send(req, response, strlen(response));
     
     ESP_LOGI(TAG, "Remote restart requested. Restarting in 3 seconds...");
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    esp_restart();
+    ota_schedule_restart(OTA_RESTART_DELAY_MS);
     
     return ESP_OK;
 }
@@ -1,6 +1,12 @@
 #include "rcp_protocol.h"
 #include "http_server.h"
+#include "ws_outbox.h"
+#include "freertos/FreeRTOS.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "trace.h"
 #include <string.h>
 #include "project_config.h"
 
@@ -16,96 +22,410 @@
 #include "led_control.h"
 #endif
 
+#if ENABLE_TELEMETRY
+#include "telemetry.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+#if ENABLE_LOG_STREAM
+#include "log_stream.h"
+#endif
+
+#if ENABLE_TASK_STATS
+#include "task_stats.h"
+#endif
+
 static const char *TAG = "rcp_protocol";
 
+// Session used for frames injected locally (rcp_process_message)
+static rcp_session_t local_session = { .client_id = -1, .header_version = 1 };
+
+// Per-port counters
+static rcp_port_stats_t rcp_port_stats[RCP_PORT_COUNT];
+
+// Rolling window of client-reported RTTs, written by the httpd task and read
+// by telemetry/HTTP, guarded by rtt_lock
+static uint32_t rtt_window[RCP_RTT_WINDOW];
+static uint32_t rtt_window_head = 0;
+static rcp_rtt_stats_t rtt_stats;
+static portMUX_TYPE rtt_lock = portMUX_INITIALIZER_UNLOCKED;
+
 // Forward declarations for handlers
-static esp_err_t rcp_handle_motor(const uint8_t* body, size_t len);
-static esp_err_t rcp_handle_servo(const uint8_t* body, size_t len);
-static esp_err_t rcp_handle_horn(const uint8_t* body, size_t len);
-static esp_err_t rcp_handle_light(const uint8_t* body, size_t len);
-static esp_err_t rcp_handle_system(const uint8_t* body, size_t len);
+static esp_err_t rcp_handle_motor(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_servo(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_horn(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_light(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_drive(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_system(const rcp_frame_t* frame);
+static esp_err_t rcp_handle_batch(const rcp_frame_t* frame);
+static esp_err_t rcp_validate_drive(const uint8_t* body, size_t len);
+static esp_err_t rcp_reply(const rcp_session_t* session, uint8_t port, const void* body, size_t body_len);
+
+// =============================================================================
+// PORT TABLE
+// =============================================================================
+
+/**
+ * @brief Port table, indexed directly by port number
+ *
+ * Built at compile time from the modules enabled in project_config.h.
+ * Ports without a handler are rejected as unknown.
+ */
+static const rcp_port_entry_t rcp_port_table[RCP_PORT_COUNT] = {
+#if ENABLE_MOTOR_CONTROL
+    [RCP_PORT_MOTOR] = RCP_PORT_ENTRY_RANGE(rcp_handle_motor, -100, 100, RCP_PORT_FLAG_SIGNED | RCP_PORT_FLAG_BATCHABLE),
+#endif
+#if ENABLE_SERVO_CONTROL
+    [RCP_PORT_SERVO] = RCP_PORT_ENTRY_RANGE(rcp_handle_servo, -100, 100, RCP_PORT_FLAG_SIGNED | RCP_PORT_FLAG_BATCHABLE),
+#endif
+#if ENABLE_LED_CONTROL
+    [RCP_PORT_HORN]  = RCP_PORT_ENTRY_RANGE(rcp_handle_horn, 0, 1, RCP_PORT_FLAG_BATCHABLE),
+    [RCP_PORT_LIGHT] = RCP_PORT_ENTRY_RANGE(rcp_handle_light, 0, 1, RCP_PORT_FLAG_BATCHABLE),
+#endif
+    [RCP_PORT_DRIVE] = {
+        .handler = rcp_handle_drive,
+        .validate = rcp_validate_drive,
+        .min_len = sizeof(rcp_drive_body_t),
+        .max_len = sizeof(rcp_drive_body_t),
+        .flags = RCP_PORT_FLAG_BATCHABLE,
+    },
+    [RCP_PORT_SYSTEM] = {
+        .handler = rcp_handle_system,
+        .min_len = sizeof(rcp_system_body_t),
+        .max_len = RCP_SYS_LOG_LEVEL_MAX_SIZE,  // Longest system body
+    },
+    [RCP_PORT_BATCH] = {
+        .handler = rcp_handle_batch,
+        .min_len = RCP_BATCH_RECORD_HEADER_SIZE,
+        .max_len = RCP_MAX_BODY_SIZE,
+    },
+};
+
+/**
+ * @brief Run the generic checks of a port entry against a body
+ */
+static esp_err_t rcp_check_entry(const rcp_port_entry_t* entry, const uint8_t* body, size_t len) {
+    if (entry->handler == NULL) {
+        return RCP_ERR_INVALID_PORT;
+    }
 
-// CRC8 lookup table for faster computation
+    if (len < entry->min_len || len > entry->max_len) {
+        return RCP_ERR_INVALID_SIZE;
+    }
 
+    if (entry->flags & RCP_PORT_FLAG_RANGE) {
+        int value = (entry->flags & RCP_PORT_FLAG_SIGNED) ? (int)(int8_t)body[0] : (int)body[0];
+        if (value < entry->value_min || value > entry->value_max) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
 
-esp_err_t rcp_process_message(uint8_t port, const uint8_t* body, size_t body_len) {
-    ESP_LOGD(TAG, "RCP: Received message port=0x%02X, body_len=%zu", port, body_len);
+    if (entry->validate != NULL) {
+        return entry->validate(body, len);
+    }
 
-    if (body_len > RCP_MAX_BODY_SIZE) {
-        ESP_LOGW(TAG, "RCP: Body length %zu exceeds max %d", body_len, RCP_MAX_BODY_SIZE);
+    return ESP_OK;
+}
+
+esp_err_t rcp_decode_frame(const uint8_t* data, size_t len, rcp_frame_t* frame) {
+    if (data == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (len < RCP_HEADER_SIZE) {
+        ESP_LOGW(TAG, "RCP: Frame too small (%zu bytes)", len);
         return RCP_ERR_INVALID_SIZE;
     }
 
-    switch (port) {
-        case RCP_PORT_MOTOR:
-            return rcp_handle_motor(body, body_len);
+    memset(frame, 0, sizeof(rcp_frame_t));
 
-        case RCP_PORT_SERVO:
-            return rcp_handle_servo(body, body_len);
+    size_t header_size = RCP_HEADER_SIZE;
+    frame->header_version = 1;
 
-        case RCP_PORT_HORN:
-            return rcp_handle_horn(body, body_len);
+    if (data[1] & RCP_HEADER_V2_FLAG) {
+        if (len < RCP_HEADER_V2_SIZE) {
+            ESP_LOGW(TAG, "RCP: v2 frame too small (%zu bytes)", len);
+            return RCP_ERR_INVALID_SIZE;
+        }
+        header_size = RCP_HEADER_V2_SIZE;
+        frame->header_version = 2;
+        frame->seq = (uint16_t)data[3] | ((uint16_t)data[4] << 8);
+        frame->timestamp_ms = (uint32_t)data[5] | ((uint32_t)data[6] << 8) |
+                              ((uint32_t)data[7] << 16) | ((uint32_t)data[8] << 24);
+    }
 
-        case RCP_PORT_LIGHT:
-            return rcp_handle_light(body, body_len);
+    size_t available = len - header_size;
 
-        case RCP_PORT_SYSTEM:
-            return rcp_handle_system(body, body_len);
+    frame->declared_len = (uint16_t)data[0] | ((uint16_t)(data[1] & ~RCP_HEADER_V2_FLAG) << 8);
+    frame->port = data[2];
+    frame->body = data + header_size;
+    frame->body_len = frame->declared_len;
 
-        default:
-            ESP_LOGW(TAG, "RCP: Unknown port 0x%02X", port);
-            return RCP_ERR_INVALID_PORT;
+    if (frame->body_len > available) {
+        ESP_LOGW(TAG, "RCP: Declared body length %u exceeds available %zu, truncating",
+                 frame->declared_len, available);
+        frame->body_len = available;
     }
+
+    return ESP_OK;
 }
 
-static esp_err_t rcp_handle_motor(const uint8_t* body, size_t len) {
-    if (len != 1) {
-        ESP_LOGW(TAG, "RCP: Invalid motor command size %zu (expected 1)", len);
-        return RCP_ERR_INVALID_SIZE;
+void rcp_session_init(rcp_session_t* session, int client_id) {
+    memset(session, 0, sizeof(rcp_session_t));
+    session->client_id = client_id;
+    session->header_version = 1;
+}
+
+/**
+ * @brief Check the v2 sequence and timestamp of a control frame
+ *
+ * The sender clock is never synchronized; instead the smallest observed
+ * (device time - sender time) is kept as the reference one-way delay and a
+ * frame is late when it exceeds that reference by RCP_MAX_FRAME_AGE_MS. The
+ * reference is aged by 1 ms per second so clock drift cannot pin it.
+ *
+ * @return true if the frame should be applied
+ */
+static bool rcp_session_accept(rcp_session_t* session, const rcp_frame_t* frame) {
+    uint16_t bit = (uint16_t)(1u << frame->port);
+
+    if ((session->seq_valid & bit) &&
+        (int16_t)(frame->seq - session->last_seq[frame->port]) <= 0) {
+        rcp_port_stats[frame->port].dropped_stale++;
+        ESP_LOGD(TAG, "RCP: Stale frame port=0x%02X seq=%u (last=%u) dropped",
+                 frame->port, frame->seq, session->last_seq[frame->port]);
+        return false;
     }
 
-    int8_t speed = (int8_t)body[0];
+    int32_t delay_ms = (int32_t)((uint32_t)(frame->rx_time_us / 1000) - frame->timestamp_ms);
 
-#if ENABLE_MOTOR_CONTROL
-    // Validate speed range
-    if (speed < -100 || speed > 100) {
-        ESP_LOGW(TAG, "RCP: Motor speed out of range: %d", speed);
-        return ESP_ERR_INVALID_ARG;
+    if (session->clock_valid) {
+        int64_t aged_s = (frame->rx_time_us - session->min_delay_aged_us) / 1000000;
+        if (aged_s > 0) {
+            session->min_delay_ms += (int32_t)aged_s;
+            session->min_delay_aged_us += aged_s * 1000000;
+        }
     }
-    
-    // Process command
-    ESP_LOGI(TAG, "RCP: Motor speed set to %d", speed);
 
-    esp_err_t ret = motor_control_set_speed(speed);
+    if (!session->clock_valid || delay_ms < session->min_delay_ms) {
+        session->clock_valid = true;
+        session->min_delay_ms = delay_ms;
+        session->min_delay_aged_us = frame->rx_time_us;
+    } else if (delay_ms - session->min_delay_ms > RCP_MAX_FRAME_AGE_MS) {
+        rcp_port_stats[frame->port].dropped_late++;
+        ESP_LOGD(TAG, "RCP: Late frame port=0x%02X seq=%u (%ld ms over best) dropped",
+                 frame->port, frame->seq, (long)(delay_ms - session->min_delay_ms));
+        return false;
+    }
+
+    session->last_seq[frame->port] = frame->seq;
+    session->seq_valid |= bit;
+    return true;
+}
+
+esp_err_t rcp_process_frame(rcp_session_t* session, const uint8_t* data, size_t len) {
+    rcp_frame_t frame;
+
+    esp_err_t ret = rcp_decode_frame(data, len, &frame);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "RCP: Failed to set motor speed: %s", esp_err_to_name(ret));
         return ret;
     }
-#else
-    ESP_LOGW(TAG, "RCP: Motor control disabled in project_config.h (speed=%d ignored)", speed);
-#endif
-    
+
+    frame.rx_time_us = esp_timer_get_time();
+    frame.session = session;
+
+    if (session != NULL && session->role == RCP_ROLE_MONITOR && frame.port < RCP_SEQ_TRACKED_PORTS) {
+        ESP_LOGD(TAG, "RCP: Control port 0x%02X rejected for monitor client %d", frame.port, session->client_id);
+        rcp_port_stats[frame.port].errors++;
+        return ESP_ERR_NOT_ALLOWED;
+    }
+
+    if (frame.header_version == 2) {
+        if (session == NULL || session->header_version < 2) {
+            ESP_LOGW(TAG, "RCP: v2 frame on port 0x%02X before version negotiation", frame.port);
+            rcp_port_stats[frame.port].errors++;
+            return ESP_ERR_INVALID_VERSION;
+        }
+
+        if (frame.port < RCP_SEQ_TRACKED_PORTS && !rcp_session_accept(session, &frame)) {
+            return ESP_OK;
+        }
+    }
+
+    ret = rcp_dispatch(&frame);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "RCP: Failed to process message port=0x%02X: %s (decl_len=%u, body_len=%zu)",
+                 frame.port, esp_err_to_name(ret), frame.declared_len, frame.body_len);
+    }
+
+    return ret;
+}
+
+esp_err_t rcp_dispatch(const rcp_frame_t* frame) {
+    const rcp_port_entry_t* entry = &rcp_port_table[frame->port];
+    rcp_port_stats_t* stats = &rcp_port_stats[frame->port];
+
+    stats->rx_frames++;
+
+    esp_err_t ret = rcp_check_entry(entry, frame->body, frame->body_len);
+    if (ret != ESP_OK) {
+        stats->errors++;
+        if (ret == RCP_ERR_INVALID_PORT) {
+            ESP_LOGW(TAG, "RCP: Unknown port 0x%02X", frame->port);
+        } else if (ret == RCP_ERR_INVALID_SIZE) {
+            ESP_LOGW(TAG, "RCP: Invalid body size %zu for port 0x%02X (expected %u-%u)",
+                     frame->body_len, frame->port, entry->min_len, entry->max_len);
+        } else {
+            ESP_LOGW(TAG, "RCP: Body rejected for port 0x%02X: %s", frame->port, esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    uint32_t trace_start = TRACE_START();
+    ret = entry->handler(frame);
+    TRACE_SPAN(TRACE_RCP_DISPATCH, trace_start, frame->port);
+    if (ret != ESP_OK) {
+        stats->errors++;
+    }
+
+    return ret;
+}
+
+esp_err_t rcp_get_port_stats(uint8_t port, rcp_port_stats_t* stats) {
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = rcp_port_stats[port];
     return ESP_OK;
 }
 
-static esp_err_t rcp_handle_servo(const uint8_t* body, size_t len) {
-    if (len != 1) {
-        ESP_LOGW(TAG, "RCP: Invalid servo command size %zu (expected 1)", len);
+bool rcp_port_is_known(uint8_t port) {
+    return rcp_port_table[port].handler != NULL;
+}
+
+esp_err_t rcp_process_message(uint8_t port, const uint8_t* body, size_t body_len) {
+    ESP_LOGD(TAG, "RCP: Received message port=0x%02X, body_len=%zu", port, body_len);
+
+    if (body_len > RCP_MAX_BODY_SIZE) {
+        ESP_LOGW(TAG, "RCP: Body length %zu exceeds max %d", body_len, RCP_MAX_BODY_SIZE);
         return RCP_ERR_INVALID_SIZE;
     }
 
-    int8_t angle = (int8_t)body[0];
+    rcp_frame_t frame = {
+        .port = port,
+        .declared_len = (uint16_t)body_len,
+        .body = body,
+        .body_len = body_len,
+        .header_version = 1,
+        .rx_time_us = esp_timer_get_time(),
+        .session = &local_session,
+    };
 
-#if ENABLE_SERVO_CONTROL
-    // Validate angle range
-    if (angle < -100 || angle > 100) {
-        ESP_LOGW(TAG, "RCP: Servo angle out of range: %d", angle);
+    return rcp_dispatch(&frame);
+}
+
+esp_err_t rcp_validate_message(uint8_t port, const uint8_t* body, size_t body_len) {
+    if (body_len > 0 && body == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    // Process command
-    ESP_LOGI(TAG, "RCP: Servo angle set to %d", angle);
 
+    return rcp_check_entry(&rcp_port_table[port], body, body_len);
+}
+
+static esp_err_t rcp_handle_batch(const rcp_frame_t* frame) {
+    const uint8_t* body = frame->body;
+    size_t len = frame->body_len;
+    rcp_frame_t records[RCP_BATCH_MAX_RECORDS];
+    size_t count = 0;
+    size_t offset = 0;
+
+    // First pass: split and validate every record, nothing is applied yet
+    while (offset < len) {
+        if (len - offset < RCP_BATCH_RECORD_HEADER_SIZE) {
+            ESP_LOGW(TAG, "RCP: Truncated batch record header at offset %zu", offset);
+            return RCP_ERR_INVALID_SIZE;
+        }
+
+        if (count >= RCP_BATCH_MAX_RECORDS) {
+            ESP_LOGW(TAG, "RCP: Batch exceeds %d records", RCP_BATCH_MAX_RECORDS);
+            return RCP_ERR_INVALID_SIZE;
+        }
+
+        // Records inherit the header fields of the enclosing frame
+        rcp_frame_t* record = &records[count];
+        *record = *frame;
+        record->port = body[offset];
+        record->declared_len = body[offset + 1];
+        record->body = body + offset + RCP_BATCH_RECORD_HEADER_SIZE;
+        record->body_len = record->declared_len;
+        offset += RCP_BATCH_RECORD_HEADER_SIZE;
+
+        if (record->body_len > len - offset) {
+            ESP_LOGW(TAG, "RCP: Batch record port=0x%02X declares %u bytes, only %zu left",
+                     record->port, record->declared_len, len - offset);
+            return RCP_ERR_INVALID_SIZE;
+        }
+
+        // Only control ports may be batched (no nesting, no system commands)
+        if (!(rcp_port_table[record->port].flags & RCP_PORT_FLAG_BATCHABLE)) {
+            ESP_LOGW(TAG, "RCP: Port 0x%02X not allowed inside a batch", record->port);
+            return RCP_ERR_INVALID_PORT;
+        }
+
+        esp_err_t ret = rcp_validate_message(record->port, record->body, record->body_len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "RCP: Batch record %zu (port=0x%02X) rejected: %s",
+                     count, record->port, esp_err_to_name(ret));
+            return ret;
+        }
+
+        offset += record->body_len;
+        count++;
+    }
+
+    // Second pass: apply all records back to back, already validated
+    esp_err_t result = ESP_OK;
+#if ENABLE_CONTROL_TASK
+    control_begin();
+#endif
+    for (size_t i = 0; i < count; i++) {
+        esp_err_t ret = rcp_port_table[records[i].port].handler(&records[i]);
+        if (ret != ESP_OK && result == ESP_OK) {
+            result = ret;
+        }
+    }
+#if ENABLE_CONTROL_TASK
+    control_commit();
+#endif
+
+    ESP_LOGD(TAG, "RCP: Batch of %zu records applied", count);
+    return result;
+}
+
+static esp_err_t rcp_apply_motor(int8_t speed) {
+#if ENABLE_CONTROL_TASK
+    control_set_speed(speed);
+#elif ENABLE_MOTOR_CONTROL
+    esp_err_t ret = motor_control_set_speed(speed);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "RCP: Failed to set motor speed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+#else
+    ESP_LOGW(TAG, "RCP: Motor control disabled in project_config.h (speed=%d ignored)", speed);
+#endif
+
+    return ESP_OK;
+}
+
+static esp_err_t rcp_apply_servo(int8_t angle) {
+#if ENABLE_CONTROL_TASK
+    control_set_steering(angle);
+#elif ENABLE_SERVO_CONTROL
     esp_err_t ret = servo_control_set_position(angle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "RCP: Failed to set servo position: %s", esp_err_to_name(ret));
@@ -114,102 +434,387 @@ static esp_err_t rcp_handle_servo(const uint8_t* body, size_t len) {
 #else
     ESP_LOGW(TAG, "RCP: Servo control disabled in project_config.h (angle=%d ignored)", angle);
 #endif
-    
+
     return ESP_OK;
 }
 
-static esp_err_t rcp_handle_horn(const uint8_t* body, size_t len) {
-    if (len != 1) {
-        ESP_LOGW(TAG, "RCP: Invalid horn command size %zu (expected 1)", len);
-        return RCP_ERR_INVALID_SIZE;
-    }
+static void rcp_apply_horn(bool state) {
+#if ENABLE_CONTROL_TASK
+    control_set_horn(state);
+#elif ENABLE_LED_CONTROL
+    led_horn_set(state);
+#else
+    ESP_LOGW(TAG, "RCP: LED control disabled in project_config.h (horn=%s ignored)", state ? "ON" : "OFF");
+#endif
+}
+
+static void rcp_apply_light(bool state) {
+#if ENABLE_CONTROL_TASK
+    control_set_light(state);
+#elif ENABLE_LED_CONTROL
+    led_light_set(state);
+#else
+    ESP_LOGW(TAG, "RCP: LED control disabled in project_config.h (light=%s ignored)", state ? "ON" : "OFF");
+#endif
+}
+
+static esp_err_t rcp_handle_motor(const rcp_frame_t* frame) {
+    int8_t speed = (int8_t)frame->body[0];
+
+    DLOG(DLOG_RCP_MOTOR, speed);
+    return rcp_apply_motor(speed);
+}
+
+static esp_err_t rcp_handle_servo(const rcp_frame_t* frame) {
+    int8_t angle = (int8_t)frame->body[0];
+
+    DLOG(DLOG_RCP_SERVO, angle);
+    return rcp_apply_servo(angle);
+}
+
+static esp_err_t rcp_handle_horn(const rcp_frame_t* frame) {
+    bool state = frame->body[0] != 0;
 
-    uint8_t state = body[0];
+    DLOG(DLOG_RCP_HORN, state);
+    rcp_apply_horn(state);
+    return ESP_OK;
+}
+
+static esp_err_t rcp_handle_light(const rcp_frame_t* frame) {
+    bool state = frame->body[0] != 0;
 
-    // Validate state
-    if (state > 1) {
-        ESP_LOGW(TAG, "RCP: Horn state out of range: %d", state);
+    DLOG(DLOG_RCP_LIGHT, state);
+    rcp_apply_light(state);
+    return ESP_OK;
+}
+
+static esp_err_t rcp_validate_drive(const uint8_t* body, size_t len) {
+    const rcp_drive_body_t* drive = (const rcp_drive_body_t*)body;
+
+    if (drive->speed < -100 || drive->speed > 100 ||
+        drive->steering < -100 || drive->steering > 100 ||
+        (drive->flags & ~RCP_DRIVE_FLAGS_MASK) != 0) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-#if ENABLE_LED_CONTROL
-    // Process command
-    ESP_LOGI(TAG, "RCP: Horn %s", state ? "ON" : "OFF");
-    led_horn_set(state != 0);
-#else
-    ESP_LOGW(TAG, "RCP: LED control disabled in project_config.h (horn=%s ignored)", state ? "ON" : "OFF");
-#endif
-    
+
     return ESP_OK;
 }
 
-static esp_err_t rcp_handle_light(const uint8_t* body, size_t len) {
-    if (len != 1) {
-        ESP_LOGW(TAG, "RCP: Invalid light command size %zu (expected 1)", len);
-        return RCP_ERR_INVALID_SIZE;
+static esp_err_t rcp_handle_drive(const rcp_frame_t* frame) {
+    const rcp_drive_body_t* drive = (const rcp_drive_body_t*)frame->body;
+    rcp_session_t* session = frame->session ? frame->session : &local_session;
+
+    // Drop duplicated or reordered frames; a large step back means a new stream
+    if (session->drive_seq_valid) {
+        uint16_t behind = (uint16_t)(session->drive_last_seq - drive->sequence);
+        if (behind < RCP_DRIVE_SEQ_RESET_WINDOW) {
+            DLOG(DLOG_RCP_DRIVE_STALE, drive->sequence, session->drive_last_seq);
+            return ESP_OK;
+        }
     }
+    session->drive_last_seq = drive->sequence;
+    session->drive_seq_valid = true;
 
-    uint8_t state = body[0];
+    DLOG(DLOG_RCP_DRIVE, drive->sequence, drive->speed, drive->steering, drive->flags);
 
-    // Validate state
-    if (state > 1) {
-        ESP_LOGW(TAG, "RCP: Light state out of range: %d", state);
-        return ESP_ERR_INVALID_ARG;
+    // Steering first and throttle right after, published as one setpoint
+#if ENABLE_CONTROL_TASK
+    control_begin();
+#endif
+    esp_err_t servo_ret = rcp_apply_servo(drive->steering);
+    esp_err_t motor_ret = rcp_apply_motor(drive->speed);
+
+    // LEDs are only written on a change, compared with the actual output so
+    // that clients, the failsafe and the HTTP commands never disagree on it
+    bool light = (drive->flags & RCP_DRIVE_FLAG_LIGHT) != 0;
+    bool horn = (drive->flags & RCP_DRIVE_FLAG_HORN) != 0;
+#if ENABLE_CONTROL_TASK
+    // Staged with the rest of the setpoint; the control task writes changed fields only
+    rcp_apply_light(light);
+    rcp_apply_horn(horn);
+    control_commit();
+#elif ENABLE_LED_CONTROL
+    if (light != led_light_get()) {
+        rcp_apply_light(light);
+    }
+    if (horn != led_horn_get()) {
+        rcp_apply_horn(horn);
     }
-    
-#if ENABLE_LED_CONTROL
-    // Process command
-    ESP_LOGI(TAG, "RCP: Light %s", state ? "ON" : "OFF");
-    led_light_set(state != 0);
-#else
-    ESP_LOGW(TAG, "RCP: LED control disabled in project_config.h (light=%s ignored)", state ? "ON" : "OFF");
 #endif
-    
+
+    return (motor_ret != ESP_OK) ? motor_ret : servo_ret;
+}
+
+static uint8_t rcp_rtt_bucket(uint32_t rtt_us) {
+    uint32_t rtt_ms = rtt_us / 1000;
+    uint8_t bucket = 0;
+
+    while (bucket < RCP_RTT_BUCKETS - 1 && rtt_ms >= (1u << bucket)) {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/**
+ * @brief Add a client-reported RTT to the rolling histogram
+ */
+static void rcp_record_rtt(uint32_t rtt_us) {
+    portENTER_CRITICAL(&rtt_lock);
+    uint32_t slot = rtt_window_head % RCP_RTT_WINDOW;
+
+    // Evict the sample falling out of the window
+    if (rtt_stats.samples == RCP_RTT_WINDOW) {
+        rtt_stats.buckets[rcp_rtt_bucket(rtt_window[slot])]--;
+    } else {
+        rtt_stats.samples++;
+    }
+
+    rtt_window[slot] = rtt_us;
+    rtt_window_head++;
+    rtt_stats.buckets[rcp_rtt_bucket(rtt_us)]++;
+    rtt_stats.total_samples++;
+    rtt_stats.last_us = rtt_us;
+
+    rtt_stats.min_us = UINT32_MAX;
+    rtt_stats.max_us = 0;
+    for (uint32_t i = 0; i < rtt_stats.samples; i++) {
+        if (rtt_window[i] < rtt_stats.min_us) {
+            rtt_stats.min_us = rtt_window[i];
+        }
+        if (rtt_window[i] > rtt_stats.max_us) {
+            rtt_stats.max_us = rtt_window[i];
+        }
+    }
+    portEXIT_CRITICAL(&rtt_lock);
+}
+
+esp_err_t rcp_get_rtt_stats(rcp_rtt_stats_t* stats) {
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&rtt_lock);
+    *stats = rtt_stats;
+    portEXIT_CRITICAL(&rtt_lock);
     return ESP_OK;
 }
 
-static esp_err_t rcp_handle_system(const uint8_t* body, size_t len) {
-    if (len != sizeof(rcp_system_body_t)) {
-        ESP_LOGW(TAG, "RCP: Invalid system command size %zu (expected %zu)", 
-                 len, sizeof(rcp_system_body_t));
+/**
+ * @brief Answer a ping with the client timestamp and device rx/tx times
+ */
+static esp_err_t rcp_handle_ping(const rcp_frame_t* frame) {
+    rcp_pong_body_t response = {
+        .id = frame->body[1],
+        .rx_time_us = (uint32_t)frame->rx_time_us,
+    };
 
-        if (len <= 16) {
-            char debug_hex[64] = {0};
-            for (size_t i = 0; i < len && i < 15; i++) {
-                snprintf(debug_hex + i*3, sizeof(debug_hex) - i*3, "%02X ", body[i]);
-            }
-            ESP_LOGW(TAG, "RCP: Received system data: %s", debug_hex);
+    if (frame->body_len >= sizeof(rcp_ping_body_t)) {
+        const rcp_ping_body_t* ping = (const rcp_ping_body_t*)frame->body;
+        response.client_time_us = ping->client_time_us;
+        if (ping->last_rtt_us != 0) {
+            rcp_record_rtt(ping->last_rtt_us);
         }
+    } else if (frame->body_len != sizeof(rcp_system_body_t)) {
+        return RCP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGD(TAG, "RCP: Ping id=%u received", response.id);
+
+    response.tx_time_us = (uint32_t)esp_timer_get_time();
+    return rcp_reply(frame->session, RCP_PORT_PONG, &response, sizeof(response));
+}
+
+/**
+ * @brief Negotiate the header version with a client
+ *
+ * The client announces the highest major version it speaks; v2 headers are
+ * accepted from it afterwards when both sides support them.
+ */
+static esp_err_t rcp_handle_hello(rcp_session_t* session, uint8_t client_major) {
+    rcp_version_body_t response = {
+        .major = RCP_VERSION_MAJOR,
+        .minor = RCP_VERSION_MINOR,
+        .header_version = (client_major >= 2) ? 2 : 1,
+    };
+
+    if (session != NULL) {
+        session->header_version = response.header_version;
+        ESP_LOGI(TAG, "RCP: Client %d negotiated header v%u (client major %u)",
+                 session->client_id, response.header_version, client_major);
+    }
 
+    return rcp_reply(session, RCP_PORT_VERSION, &response, sizeof(response));
+}
+
+/**
+ * @brief Change the runtime level of one tag, body [command][level][tag...]
+ */
+static esp_err_t rcp_handle_log_level(const rcp_frame_t* frame) {
+#if ENABLE_LOG_STREAM
+    // Monitor clients only receive data, log levels affect every client
+    if (frame->session != NULL && frame->session->role == RCP_ROLE_MONITOR) {
+        ESP_LOGW(TAG, "RCP: Log level change rejected for monitor client %d", frame->session->client_id);
+        return ESP_ERR_NOT_ALLOWED;
+    }
+
+    size_t tag_len = frame->body_len - sizeof(rcp_system_body_t);
+    if (tag_len == 0 || tag_len > RCP_SYS_LOG_TAG_MAX) {
         return RCP_ERR_INVALID_SIZE;
     }
 
-    const rcp_system_body_t* cmd = (const rcp_system_body_t*)body;
+    char tag[RCP_SYS_LOG_TAG_MAX + 1];
+    memcpy(tag, frame->body + sizeof(rcp_system_body_t), tag_len);
+    tag[tag_len] = '\0';
+
+    return log_stream_set_level(tag, (esp_log_level_t)frame->body[1]);
+#else
+    ESP_LOGW(TAG, "RCP: Log stream disabled in project_config.h (level change ignored)");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static esp_err_t rcp_handle_system(const rcp_frame_t* frame) {
+    const rcp_system_body_t* cmd = (const rcp_system_body_t*)frame->body;
+
+    // Pings carry their own payload layout and are too frequent to log
+    if (cmd->command == RCP_SYS_PING) {
+        return rcp_handle_ping(frame);
+    }
+
+    if (cmd->command == RCP_SYS_LOG_LEVEL) {
+        return rcp_handle_log_level(frame);
+    }
+
+    if (frame->body_len != sizeof(rcp_system_body_t)) {
+        return RCP_ERR_INVALID_SIZE;
+    }
 
     ESP_LOGI(TAG, "RCP: System command 0x%02X with param 0x%02X", 
              cmd->command, cmd->param);
     
     // Process system commands
     switch (cmd->command) {
-        case RCP_SYS_PING:
-            ESP_LOGI(TAG, "RCP: Ping received");
-            // Could send pong response here
-            break;
-            
         case RCP_SYS_RESET:
             ESP_LOGW(TAG, "RCP: Reset command received");
             // Could trigger system reset here
             break;
             
-        case RCP_SYS_STATUS:
-            ESP_LOGI(TAG, "RCP: Status request received");
-            // Could send telemetry response here
-            break;
+        case RCP_SYS_STATUS: {
+#if ENABLE_TELEMETRY
+            rcp_telemetry_body_t telemetry;
+            telemetry_read(&telemetry);
+            if (frame->session != NULL) {
+                telemetry.link_rtt_ms = telemetry_link_rtt_ms(frame->session->client_id);
+            }
+            return rcp_reply(frame->session, RCP_PORT_TELEMETRY, &telemetry, sizeof(telemetry));
+#else
+            ESP_LOGW(TAG, "RCP: Telemetry disabled in project_config.h (status request ignored)");
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        }
             
         case RCP_SYS_CONFIG:
             ESP_LOGI(TAG, "RCP: Config command received");
             // Could handle configuration here
             break;
+
+        case RCP_SYS_HELLO:
+            return rcp_handle_hello(frame->session, cmd->param);
+
+        case RCP_SYS_TELEMETRY:
+        case RCP_SYS_TELEMETRY_DELTA:
+#if ENABLE_TELEMETRY
+            if (frame->session == NULL || frame->session->client_id < 0) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            if (cmd->param == 0) {
+                telemetry_unsubscribe(frame->session->client_id);
+                return ESP_OK;
+            }
+            return telemetry_subscribe(frame->session->client_id, cmd->param,
+                                       cmd->command == RCP_SYS_TELEMETRY_DELTA);
+#else
+            ESP_LOGW(TAG, "RCP: Telemetry disabled in project_config.h (subscription ignored)");
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+        case RCP_SYS_ROLE:
+            if (frame->session == NULL || cmd->param > RCP_ROLE_MONITOR) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            frame->session->role = cmd->param;
+            ESP_LOGI(TAG, "RCP: Client %d role set to %s", frame->session->client_id,
+                     cmd->param == RCP_ROLE_MONITOR ? "monitor" : "control");
+            return ESP_OK;
+
+        case RCP_SYS_LOG:
+#if ENABLE_LOG_STREAM
+            if (frame->session == NULL || frame->session->client_id < 0) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            return log_stream_subscribe(frame->session->client_id, cmd->param != 0);
+#else
+            ESP_LOGW(TAG, "RCP: Log stream disabled in project_config.h (subscription ignored)");
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+        case RCP_SYS_METRICS: {
+            uint8_t snapshot[RCP_MAX_BODY_SIZE];
+            size_t len = metrics_build_snapshot(snapshot, sizeof(snapshot));
+            if (len == 0) {
+                return ESP_ERR_NO_MEM;
+            }
+            return rcp_reply(frame->session, RCP_PORT_METRICS, snapshot, len);
+        }
+
+        case RCP_SYS_TASKS: {
+#if ENABLE_TASK_STATS
+            task_stats_entry_t entries[RCP_TASKS_PER_PAGE];
+            int total = 0;
+            int count = task_stats_read(cmd->param, entries, RCP_TASKS_PER_PAGE, &total);
+
+            uint8_t body[RCP_TASKS_HEADER_SIZE + RCP_TASKS_PER_PAGE * sizeof(rcp_task_entry_t)];
+            body[0] = (uint8_t)total;
+            body[1] = cmd->param;
+            body[2] = (uint8_t)count;
+            rcp_task_entry_t *out = (rcp_task_entry_t *)&body[RCP_TASKS_HEADER_SIZE];
+            for (int i = 0; i < count; i++) {
+                out[i].priority = entries[i].priority;
+                out[i].core = entries[i].core;
+                out[i].cpu_permille = entries[i].cpu_permille;
+                out[i].stack_free_min = entries[i].stack_free_min;
+                memcpy(out[i].name, entries[i].name, sizeof(out[i].name));
+            }
+            return rcp_reply(frame->session, RCP_PORT_TASKS, body,
+                             RCP_TASKS_HEADER_SIZE + count * sizeof(rcp_task_entry_t));
+#else
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        }
+
+        case RCP_SYS_BROADCASTS:
+            if (frame->session == NULL || frame->session->client_id < 0) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            if (cmd->param & ~(RCP_BROADCAST_BATTERY | RCP_BROADCAST_STATUS)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            ws_clients_set_stream(frame->session->client_id, WS_STREAM_BATTERY,
+                                  (cmd->param & RCP_BROADCAST_BATTERY) != 0);
+            ws_clients_set_stream(frame->session->client_id, WS_STREAM_STATUS,
+                                  (cmd->param & RCP_BROADCAST_STATUS) != 0);
+            return ESP_OK;
+
+        case RCP_SYS_TELEMETRY_KEYFRAME:
+#if ENABLE_TELEMETRY
+            if (frame->session == NULL || frame->session->client_id < 0) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            return telemetry_request_keyframe(frame->session->client_id);
+#else
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
             
         default:
             ESP_LOGW(TAG, "RCP: Unknown system command 0x%02X", cmd->command);
@@ -219,13 +824,15 @@ static esp_err_t rcp_handle_system(const uint8_t* body, size_t len) {
     return ESP_OK;
 }
 
-esp_err_t rcp_send_response(uint8_t port, const void* body, size_t body_len) {
+/**
+ * @brief Build a device-to-client frame, returns the total length or 0
+ */
+static size_t rcp_build_response(uint8_t* frame, uint8_t port, const void* body, size_t body_len) {
     if (body_len > RCP_MAX_BODY_SIZE) {
         ESP_LOGW(TAG, "RCP: Response body too large (%zu bytes)", body_len);
-        return RCP_ERR_INVALID_SIZE;
+        return 0;
     }
 
-    uint8_t frame[RCP_HEADER_SIZE + RCP_MAX_BODY_SIZE] = {0};
     RCP_SET_LENGTH(frame, body_len);
     frame[2] = port;
 
@@ -233,9 +840,45 @@ esp_err_t rcp_send_response(uint8_t port, const void* body, size_t body_len) {
         memcpy(frame + RCP_HEADER_SIZE, body, body_len);
     }
 
-    size_t total_len = RCP_HEADER_SIZE + body_len;
+    return RCP_HEADER_SIZE + body_len;
+}
 
-    return http_server_broadcast_ws_binary(frame, total_len);
+esp_err_t rcp_send_response(uint8_t port, const void* body, size_t body_len) {
+    uint8_t frame[RCP_HEADER_SIZE + RCP_MAX_BODY_SIZE];
+
+    size_t total_len = rcp_build_response(frame, port, body, body_len);
+    if (total_len == 0) {
+        return RCP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t stream = (port == RCP_PORT_BATTERY) ? WS_STREAM_BATTERY : WS_STREAM_STATUS;
+    return http_server_broadcast_ws_binary(stream, frame, total_len);
+}
+
+esp_err_t rcp_send_to(int client_id, uint8_t port, const void* body, size_t body_len) {
+    if (client_id < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t frame[RCP_HEADER_SIZE + RCP_MAX_BODY_SIZE];
+
+    size_t total_len = rcp_build_response(frame, port, body, body_len);
+    if (total_len == 0) {
+        return RCP_ERR_INVALID_SIZE;
+    }
+
+    return http_server_send_ws_binary(client_id, frame, total_len);
+}
+
+/**
+ * @brief Answer the sender of a frame, or every client for local callers
+ */
+static esp_err_t rcp_reply(const rcp_session_t* session, uint8_t port, const void* body, size_t body_len) {
+    if (session == NULL || session->client_id < 0) {
+        return rcp_send_response(port, body, body_len);
+    }
+
+    return rcp_send_to(session->client_id, port, body, body_len);
 }
 
 esp_err_t rcp_send_battery_status(uint16_t voltage_mv, uint8_t level, uint8_t type) {
@@ -251,23 +894,11 @@ esp_err_t rcp_send_battery_status(uint16_t voltage_mv, uint8_t level, uint8_t ty
     return rcp_send_response(RCP_PORT_BATTERY, &response, sizeof(response));
 }
 
-esp_err_t rcp_send_telemetry(int8_t speed, int8_t angle, uint8_t horn_state, 
-                            uint8_t light_state, uint8_t flags) {
-    rcp_telemetry_body_t response = {
-        .current_speed = speed,
-        .current_angle = angle,
-        .horn_state = horn_state,
-        .light_state = light_state,
-        .flags = flags
-    };
-
-    ESP_LOGD(TAG, "RCP: Sending telemetry: speed=%d, angle=%d, horn=%u, light=%u, flags=0x%02X", 
-             speed, angle, horn_state, light_state, flags);
-
-    return rcp_send_response(RCP_PORT_TELEMETRY, &response, sizeof(response));
-}
-
 esp_err_t rcp_init(void) {
+    // Status ports only matter in their latest value; a queued one is replaced
+    ws_outbox_set_coalesce(RCP_PORT_BATTERY, true);
+    ws_outbox_set_coalesce(RCP_PORT_TELEMETRY, true);
+
     ESP_LOGI(TAG, "RCP: Protocol initialized");
     return ESP_OK;
 }
@@ -9,9 +9,12 @@
 #include <math.h>
 #include "config.h"
 #include "servo_control.h"
+#include "dlog.h"
+#include "trace.h"
 
 static const char *TAG = "servo_control";
 static bool servo_initialized = false;
+static int servo_position = 0;
 static servo_calibration_t servo_calibration = {
     .min_pulse_width = SERVO_DEFAULT_MIN_PULSE_WIDTH,
     .center_pulse_width = SERVO_DEFAULT_CENTER_PULSE_WIDTH,
@@ -168,6 +171,8 @@ esp_err_t servo_control_set_position(int position)
         return ESP_ERR_INVALID_STATE;
     }
     
+    uint32_t trace_start = TRACE_START();
+
     // Convert position to pulse width
     uint32_t pulse_width_us = position_to_pulse_width(position);
     
@@ -182,18 +187,37 @@ esp_err_t servo_control_set_position(int position)
     }
     
     // Update duty cycle
+    uint32_t update_start = TRACE_START();
     ret = ledc_update_duty(SERVO_LEDC_MODE, SERVO_LEDC_CHANNEL);
+    TRACE_SPAN(TRACE_LEDC_UPDATE, update_start, SERVO_LEDC_CHANNEL);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to update LEDC duty: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ESP_LOGI(TAG, "Servo position set to %d (pulse width: %lu us, duty: %lu)", 
-             position, pulse_width_us, duty);
+    servo_position = (position < SERVO_INPUT_MIN) ? SERVO_INPUT_MIN :
+                     (position > SERVO_INPUT_MAX) ? SERVO_INPUT_MAX : position;
+
+    DLOG(DLOG_SERVO_POSITION, position, pulse_width_us, duty);
+    TRACE_SPAN(TRACE_SERVO_SET_POSITION, trace_start, position);
     
     return ESP_OK;
 }
 
+esp_err_t servo_control_get_position(int *position)
+{
+    if (position == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!servo_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *position = servo_position;
+    return ESP_OK;
+}
+
 esp_err_t servo_control_get_calibration(servo_calibration_t *calibration)
 {
     if (calibration == NULL) {
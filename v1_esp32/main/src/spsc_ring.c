@@ -0,0 +1,61 @@
+#include "spsc_ring.h"
+
+#include <string.h>
+
+// Head and tail run freely and wrap at 2^32; their difference is the fill
+// level because the capacity is a power of two.
+
+bool spsc_ring_init(spsc_ring_t *ring, void *storage, size_t item_size, uint32_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+
+    ring->storage = (uint8_t *)storage;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return true;
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *item)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail > ring->mask) {
+        return false;
+    }
+
+    memcpy(ring->storage + (head & ring->mask) * ring->item_size, item, ring->item_size);
+
+    // Publish the item only after it is fully written
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *item)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    memcpy(item, ring->storage + (tail & ring->mask) * ring->item_size, ring->item_size);
+
+    // Hand the slot back only after it is fully read
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t spsc_ring_count(spsc_ring_t *ring)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
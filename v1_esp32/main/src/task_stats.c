@@ -0,0 +1,215 @@
+#include "task_stats.h"
+#include "project_config.h"
+
+#if ENABLE_TASK_STATS
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY || !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    #error "task_stats needs CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, or set ENABLE_TASK_STATS to 0"
+#endif
+
+static const char *TAG = "task_stats";
+
+/**
+ * @brief Run-time counter history of one task
+ */
+typedef struct {
+    UBaseType_t task_number;    // 0 = free slot, FreeRTOS numbers start at 1
+    uint32_t runtime[TASK_STATS_WINDOW_SAMPLES];
+    uint8_t samples;            // Valid entries in runtime, newest at sample_head
+    bool seen;
+} task_history_t;
+
+static TaskHandle_t stats_task_handle = NULL;
+static bool overflow_logged = false;
+
+// Sampler state, only touched by the sampling task
+static TaskStatus_t status[TASK_STATS_MAX_TASKS];
+static task_history_t history[TASK_STATS_MAX_TASKS];
+static uint32_t total_runtime[TASK_STATS_WINDOW_SAMPLES];
+static uint8_t total_samples = 0;
+static uint8_t sample_head = 0;
+
+// Last result, copied out by readers
+static portMUX_TYPE result_lock = portMUX_INITIALIZER_UNLOCKED;
+static task_stats_entry_t result[TASK_STATS_MAX_TASKS];
+static int result_count = 0;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief History slot of a task, allocated on first sight
+ */
+static task_history_t *task_stats_slot(UBaseType_t task_number)
+{
+    task_history_t *free_slot = NULL;
+
+    for (int i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        if (history[i].task_number == task_number) {
+            return &history[i];
+        }
+        if (free_slot == NULL && history[i].task_number == 0) {
+            free_slot = &history[i];
+        }
+    }
+
+    if (free_slot != NULL) {
+        free_slot->task_number = task_number;
+        free_slot->samples = 0;
+    }
+    return free_slot;
+}
+
+/**
+ * @brief Share of all cores used by a task between its oldest sample and now
+ */
+static uint16_t task_stats_load(const task_history_t *slot)
+{
+    int span = (slot->samples < total_samples ? slot->samples : total_samples) - 1;
+    if (span <= 0) {
+        return 0;
+    }
+
+    int oldest = (sample_head + TASK_STATS_WINDOW_SAMPLES - span) % TASK_STATS_WINDOW_SAMPLES;
+    // Unsigned differences stay right across a 32-bit counter wrap
+    uint32_t elapsed = total_runtime[sample_head] - total_runtime[oldest];
+    uint32_t busy = slot->runtime[sample_head] - slot->runtime[oldest];
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    // The total counter is wall time, each core adds its own run time on top
+    uint64_t permille = (uint64_t)busy * 1000 / ((uint64_t)elapsed * configNUMBER_OF_CORES);
+    return permille > 1000 ? 1000 : (uint16_t)permille;
+}
+
+/**
+ * @brief Take one sample of every task and publish the result
+ */
+static void task_stats_sample(void)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, TASK_STATS_MAX_TASKS, &total);
+    if (count == 0) {
+        // Returns nothing rather than a partial list when the array is short
+        if (!overflow_logged) {
+            ESP_LOGW(TAG, "More than %d tasks, samples skipped", TASK_STATS_MAX_TASKS);
+            overflow_logged = true;
+        }
+        return;
+    }
+
+    sample_head = (sample_head + 1) % TASK_STATS_WINDOW_SAMPLES;
+    total_runtime[sample_head] = (uint32_t)total;
+    if (total_samples < TASK_STATS_WINDOW_SAMPLES) {
+        total_samples++;
+    }
+
+    for (int i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        history[i].seen = false;
+    }
+
+    task_stats_entry_t entries[TASK_STATS_MAX_TASKS];
+    int entry_count = 0;
+
+    for (UBaseType_t t = 0; t < count; t++) {
+        task_history_t *slot = task_stats_slot(status[t].xTaskNumber);
+        if (slot == NULL) {
+            continue;
+        }
+        slot->runtime[sample_head] = (uint32_t)status[t].ulRunTimeCounter;
+        if (slot->samples < TASK_STATS_WINDOW_SAMPLES) {
+            slot->samples++;
+        }
+        slot->seen = true;
+
+        task_stats_entry_t *entry = &entries[entry_count++];
+        strncpy(entry->name, status[t].pcTaskName, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+        entry->priority = (uint8_t)status[t].uxCurrentPriority;
+        BaseType_t core = xTaskGetCoreID(status[t].xHandle);
+        entry->core = (core == tskNO_AFFINITY) ? -1 : (int8_t)core;
+        entry->cpu_permille = task_stats_load(slot);
+        entry->stack_free_min = status[t].usStackHighWaterMark;
+    }
+
+    // Deleted tasks free their slot
+    for (int i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        if (!history[i].seen) {
+            history[i].task_number = 0;
+        }
+    }
+
+    taskENTER_CRITICAL(&result_lock);
+    memcpy(result, entries, entry_count * sizeof(task_stats_entry_t));
+    result_count = entry_count;
+    taskEXIT_CRITICAL(&result_lock);
+}
+
+/**
+ * @brief Sampling task
+ */
+static void task_stats_task(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        task_stats_sample();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TASK_STATS_SAMPLE_MS));
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t task_stats_start(void)
+{
+    if (stats_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+    BaseType_t ret = xTaskCreate(
+        task_stats_task,
+        "task_stats",
+        TASK_STATS_TASK_STACK_SIZE, // Stack size
+        NULL,                       // Parameters
+        TASK_STATS_TASK_PRIORITY,   // Priority
+        &stats_task_handle          // Task handle
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task stats task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Task stats every %d ms over %d samples", TASK_STATS_SAMPLE_MS, TASK_STATS_WINDOW_SAMPLES);
+    return ESP_OK;
+}
+
+int task_stats_read(int first, task_stats_entry_t *entries, int max_entries, int *total)
+{
+    int copied = 0;
+
+    taskENTER_CRITICAL(&result_lock);
+    if (total != NULL) {
+        *total = result_count;
+    }
+    if (first >= 0 && first < result_count) {
+        copied = result_count - first;
+        if (copied > max_entries) {
+            copied = max_entries;
+        }
+        memcpy(entries, &result[first], copied * sizeof(task_stats_entry_t));
+    }
+    taskEXIT_CRITICAL(&result_lock);
+
+    return copied;
+}
+
+#endif // ENABLE_TASK_STATS
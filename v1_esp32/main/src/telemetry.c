@@ -0,0 +1,464 @@
+#include "telemetry.h"
+
+#if ENABLE_TELEMETRY
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+#if ENABLE_MOTOR_CONTROL
+#include "motor_control.h"
+#endif
+
+#if ENABLE_SERVO_CONTROL
+#include "servo_control.h"
+#endif
+
+#if ENABLE_LED_CONTROL
+#include "led_control.h"
+#endif
+
+#if ENABLE_CONTROL_TASK
+#include "control_task.h"
+#endif
+
+static const char *TAG = "telemetry";
+
+/**
+ * @brief Telemetry subscriber slot
+ */
+typedef struct {
+    bool active;
+    bool delta;                     // Delta frames between keyframes
+    bool keyframe_pending;          // Next frame must be a keyframe
+    int client_id;                  // WebSocket client (socket fd)
+    uint32_t period_us;             // Send period derived from the requested rate
+    int64_t next_due_us;            // Next send time
+    uint32_t frames_since_keyframe; // Ticks since the last keyframe (delta mode)
+    rcp_telemetry_body_t last_sent; // State the client holds (delta mode)
+} telemetry_subscriber_t;
+
+/**
+ * @brief Frame to send on this tick, copied out of the subscriber table
+ */
+typedef struct {
+    int slot;
+    int client_id;
+    bool keyframe;
+    rcp_telemetry_body_t last_sent;
+} telemetry_due_t;
+
+// Subscribers are changed from the httpd task and read by the publisher task
+static telemetry_subscriber_t subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+static portMUX_TYPE subscribers_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Task handles
+static TaskHandle_t telemetry_task_handle = NULL;
+static bool telemetry_task_running = false;
+
+// Publisher counters, only written by the telemetry task
+static telemetry_stats_t telemetry_stats;
+
+// Battery task -> telemetry task, broadcast from here so the ADC loop never
+// waits on the outbox lock
+SPSC_RING_DEFINE(battery_ring, rcp_battery_body_t, TELEMETRY_BATTERY_RING_SIZE);
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Collect the clients due for a frame and advance their schedule
+ *
+ * @param now_us Current time
+ * @param[out] due Frames to send
+ * @param[out] due_count Number of entries written to @p due
+ * @return Time until the next send in microseconds, -1 without subscribers
+ */
+static int64_t telemetry_collect_due(int64_t now_us, telemetry_due_t *due, int *due_count)
+{
+    int64_t next_wake_us = -1;
+    *due_count = 0;
+
+    taskENTER_CRITICAL(&subscribers_lock);
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        telemetry_subscriber_t *sub = &subscribers[i];
+        if (!sub->active) {
+            continue;
+        }
+
+        if (sub->next_due_us <= now_us) {
+            telemetry_due_t *entry = &due[(*due_count)++];
+            entry->slot = i;
+            entry->client_id = sub->client_id;
+            entry->keyframe = !sub->delta || sub->keyframe_pending ||
+                              sub->frames_since_keyframe + 1 >= TELEMETRY_KEYFRAME_INTERVAL;
+            entry->last_sent = sub->last_sent;
+
+            if (entry->keyframe) {
+                sub->keyframe_pending = false;
+                sub->frames_since_keyframe = 0;
+            } else {
+                sub->frames_since_keyframe++;
+            }
+
+            sub->next_due_us += sub->period_us;
+            // Fell behind by more than a period (slow send): skip, don't burst
+            if (sub->next_due_us <= now_us) {
+                sub->next_due_us = now_us + sub->period_us;
+            }
+        }
+
+        int64_t wait_us = sub->next_due_us - now_us;
+        if (next_wake_us < 0 || wait_us < next_wake_us) {
+            next_wake_us = wait_us;
+        }
+    }
+    taskEXIT_CRITICAL(&subscribers_lock);
+
+    return next_wake_us;
+}
+
+/**
+ * @brief Remember what a client received, unless its slot changed meanwhile
+ */
+static void telemetry_commit_sent(const telemetry_due_t *entry, const rcp_telemetry_body_t *sent)
+{
+    taskENTER_CRITICAL(&subscribers_lock);
+    telemetry_subscriber_t *sub = &subscribers[entry->slot];
+    if (sub->active && sub->client_id == entry->client_id) {
+        sub->last_sent = *sent;
+    }
+    taskEXIT_CRITICAL(&subscribers_lock);
+}
+
+/**
+ * @brief Send the keyframe or delta frame of one subscriber
+ */
+static esp_err_t telemetry_send(const telemetry_due_t *entry, const rcp_telemetry_body_t *telemetry)
+{
+    esp_err_t ret;
+
+    if (entry->keyframe) {
+        ret = rcp_send_to(entry->client_id, RCP_PORT_TELEMETRY, telemetry, sizeof(rcp_telemetry_body_t));
+        if (ret == ESP_OK) {
+            telemetry_stats.keyframes++;
+            telemetry_stats.bytes += RCP_HEADER_SIZE + sizeof(rcp_telemetry_body_t);
+        }
+    } else {
+        uint8_t delta[1 + RCP_TELEMETRY_FIELD_COUNT];
+        size_t len = telemetry_encode_delta(&entry->last_sent, telemetry, delta);
+        if (len == 0) {
+            // Nothing changed: no frame at all, the next keyframe confirms the state
+            telemetry_stats.unchanged++;
+            return ESP_OK;
+        }
+
+        ret = rcp_send_to(entry->client_id, RCP_PORT_TELEMETRY_DELTA, delta, len);
+        if (ret == ESP_OK) {
+            telemetry_stats.deltas++;
+            telemetry_stats.bytes += RCP_HEADER_SIZE + len;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        telemetry_commit_sent(entry, telemetry);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Broadcast the battery readings queued by telemetry_post_battery()
+ */
+static void telemetry_send_battery(void)
+{
+    rcp_battery_body_t status;
+
+    while (spsc_ring_pop(&battery_ring, &status)) {
+        esp_err_t ret = rcp_send_battery_status(status.voltage_mv, status.level, status.type);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to broadcast battery status: %s", esp_err_to_name(ret));
+        }
+    }
+}
+
+/**
+ * @brief Telemetry publisher task
+ */
+static void telemetry_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Telemetry task started");
+
+    telemetry_due_t due[TELEMETRY_MAX_SUBSCRIBERS];
+    int due_count = 0;
+
+    while (telemetry_task_running) {
+        telemetry_send_battery();
+
+        int64_t next_wake_us = telemetry_collect_due(esp_timer_get_time(), due, &due_count);
+
+        if (due_count > 0) {
+            rcp_telemetry_body_t telemetry;
+            telemetry_read(&telemetry);
+
+            for (int i = 0; i < due_count; i++) {
+                // Same actuator state for everyone, only the link RTT is per client
+                telemetry.link_rtt_ms = telemetry_link_rtt_ms(due[i].client_id);
+                esp_err_t ret = telemetry_send(&due[i], &telemetry);
+                if (ret == ESP_ERR_NO_MEM) {
+                    // Client queue full: the frame is lost, resync with a keyframe
+                    telemetry_request_keyframe(due[i].client_id);
+                } else if (ret != ESP_OK) {
+                    ESP_LOGW(TAG, "Failed to send telemetry to client %d: %s - unsubscribing",
+                             due[i].client_id, esp_err_to_name(ret));
+                    telemetry_unsubscribe(due[i].client_id);
+                }
+            }
+        }
+
+        if (next_wake_us < 0) {
+            // No subscribers, sleep until telemetry_subscribe() or a battery reading wakes us
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } else {
+            TickType_t ticks = pdMS_TO_TICKS((next_wake_us + 999) / 1000);
+            ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+        }
+    }
+
+    ESP_LOGI(TAG, "Telemetry task stopped");
+    telemetry_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+uint8_t telemetry_link_rtt_ms(int client_id)
+{
+    uint32_t rtt_ms = (ws_clients_get_rtt_us(client_id) + 999) / 1000;
+
+    return rtt_ms > UINT8_MAX ? UINT8_MAX : (uint8_t)rtt_ms;
+}
+
+void telemetry_read(rcp_telemetry_body_t *telemetry)
+{
+    memset(telemetry, 0, sizeof(rcp_telemetry_body_t));
+
+#if ENABLE_MOTOR_CONTROL
+    motor_state_t motor_state;
+    if (motor_control_get_state(&motor_state) == ESP_OK) {
+        telemetry->current_speed = (int8_t)motor_state.speed;
+        if (motor_state.enabled) {
+            telemetry->flags |= RCP_TELEMETRY_FLAG_MOTOR_ENABLED;
+        }
+        if (motor_state.mode == MOTOR_MODE_BRAKE) {
+            telemetry->flags |= RCP_TELEMETRY_FLAG_MOTOR_BRAKE;
+        }
+    }
+#endif
+
+#if ENABLE_SERVO_CONTROL
+    int position = 0;
+    if (servo_control_get_position(&position) == ESP_OK) {
+        telemetry->current_angle = (int8_t)position;
+        telemetry->flags |= RCP_TELEMETRY_FLAG_SERVO_READY;
+    }
+#endif
+
+#if ENABLE_CONTROL_TASK
+    if (control_failsafe_active()) {
+        telemetry->flags |= RCP_TELEMETRY_FLAG_FAILSAFE;
+    }
+#endif
+
+#if ENABLE_LED_CONTROL
+    telemetry->horn_state = led_horn_get() ? 1 : 0;
+    telemetry->light_state = led_light_get() ? 1 : 0;
+#endif
+}
+
+size_t telemetry_encode_delta(const rcp_telemetry_body_t *previous,
+                              const rcp_telemetry_body_t *current, uint8_t *out)
+{
+    uint8_t mask = 0;
+    size_t len = 1;
+
+    if (current->current_speed != previous->current_speed) {
+        mask |= RCP_TELEMETRY_FIELD_SPEED;
+        out[len++] = (uint8_t)current->current_speed;
+    }
+    if (current->current_angle != previous->current_angle) {
+        mask |= RCP_TELEMETRY_FIELD_ANGLE;
+        out[len++] = (uint8_t)current->current_angle;
+    }
+    if (current->horn_state != previous->horn_state) {
+        mask |= RCP_TELEMETRY_FIELD_HORN;
+        out[len++] = current->horn_state;
+    }
+    if (current->light_state != previous->light_state) {
+        mask |= RCP_TELEMETRY_FIELD_LIGHT;
+        out[len++] = current->light_state;
+    }
+    if (current->flags != previous->flags) {
+        mask |= RCP_TELEMETRY_FIELD_FLAGS;
+        out[len++] = current->flags;
+    }
+    if (current->link_rtt_ms != previous->link_rtt_ms) {
+        mask |= RCP_TELEMETRY_FIELD_LINK_RTT;
+        out[len++] = current->link_rtt_ms;
+    }
+
+    if (mask == 0) {
+        return 0;
+    }
+
+    out[0] = mask;
+    return len;
+}
+
+esp_err_t telemetry_subscribe(int client_id, uint8_t rate_hz, bool delta)
+{
+    if (rate_hz < TELEMETRY_MIN_RATE_HZ) {
+        rate_hz = TELEMETRY_MIN_RATE_HZ;
+    } else if (rate_hz > TELEMETRY_MAX_RATE_HZ) {
+        rate_hz = TELEMETRY_MAX_RATE_HZ;
+    }
+
+    telemetry_subscriber_t *slot = NULL;
+
+    taskENTER_CRITICAL(&subscribers_lock);
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].active && subscribers[i].client_id == client_id) {
+            slot = &subscribers[i];
+            break;
+        }
+        if (slot == NULL && !subscribers[i].active) {
+            slot = &subscribers[i];
+        }
+    }
+
+    if (slot != NULL) {
+        slot->active = true;
+        slot->delta = delta;
+        slot->keyframe_pending = true;
+        slot->client_id = client_id;
+        slot->period_us = 1000000 / rate_hz;
+        slot->next_due_us = esp_timer_get_time();
+    }
+    taskEXIT_CRITICAL(&subscribers_lock);
+
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "Cannot subscribe client %d - max subscribers reached", client_id);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ws_clients_set_stream(client_id, WS_STREAM_TELEMETRY, true);
+    ESP_LOGI(TAG, "Client %d subscribed at %u Hz (%s)", client_id, rate_hz, delta ? "delta" : "full");
+
+    if (telemetry_task_handle != NULL) {
+        xTaskNotifyGive(telemetry_task_handle);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t telemetry_request_keyframe(int client_id)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    taskENTER_CRITICAL(&subscribers_lock);
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].active && subscribers[i].client_id == client_id) {
+            subscribers[i].keyframe_pending = true;
+            ret = ESP_OK;
+        }
+    }
+    taskEXIT_CRITICAL(&subscribers_lock);
+
+    return ret;
+}
+
+void telemetry_get_stats(telemetry_stats_t *stats)
+{
+    *stats = telemetry_stats;
+}
+
+esp_err_t telemetry_post_battery(const rcp_battery_body_t *status)
+{
+    if (status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!spsc_ring_push(&battery_ring, status)) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (telemetry_task_handle != NULL) {
+        xTaskNotifyGive(telemetry_task_handle);
+    }
+    return ESP_OK;
+}
+
+void telemetry_unsubscribe(int client_id)
+{
+    bool removed = false;
+
+    taskENTER_CRITICAL(&subscribers_lock);
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].active && subscribers[i].client_id == client_id) {
+            subscribers[i].active = false;
+            removed = true;
+        }
+    }
+    taskEXIT_CRITICAL(&subscribers_lock);
+
+    if (removed) {
+        ws_clients_set_stream(client_id, WS_STREAM_TELEMETRY, false);
+        ESP_LOGI(TAG, "Client %d unsubscribed", client_id);
+    }
+}
+
+esp_err_t telemetry_start_task(void)
+{
+    if (telemetry_task_running) {
+        ESP_LOGW(TAG, "Telemetry task already running");
+        return ESP_OK;
+    }
+
+    telemetry_task_running = true;
+
+    BaseType_t ret = xTaskCreate(
+        telemetry_task,
+        "telemetry",
+        TELEMETRY_TASK_STACK_SIZE,  // Stack size
+        NULL,                       // Parameters
+        TELEMETRY_TASK_PRIORITY,    // Priority
+        &telemetry_task_handle      // Task handle
+    );
+
+    if (ret != pdPASS) {
+        telemetry_task_running = false;
+        ESP_LOGE(TAG, "Failed to create telemetry task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+void telemetry_stop_task(void)
+{
+    if (telemetry_task_running) {
+        telemetry_task_running = false;
+        if (telemetry_task_handle != NULL) {
+            xTaskNotifyGive(telemetry_task_handle);
+        }
+        ESP_LOGI(TAG, "Stopping telemetry task");
+    }
+}
+
+#endif // ENABLE_TELEMETRY
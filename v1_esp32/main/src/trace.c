@@ -0,0 +1,269 @@
+#include "trace.h"
+
+#if ENABLE_TRACE
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+static const char *TAG = "trace";
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+/**
+ * @brief Static description of a trace point
+ */
+typedef struct {
+    const char *name;
+    const char *category;
+} trace_point_info_t;
+
+#define TRACE_POINT_INFO(id, name, category)    [id] = { name, category },
+
+static const trace_point_info_t trace_points[TRACE_POINT_COUNT] = {
+    TRACE_POINTS(TRACE_POINT_INFO)
+};
+
+static trace_event_t trace_ring[TRACE_RING_SIZE];
+static atomic_uint trace_head = 0;          // Next ring index
+static atomic_uint trace_first = 0;         // Oldest index still reported, moved by trace_clear()
+static atomic_bool trace_enabled = true;
+
+/**
+ * @brief Event copied out of the ring for the dump
+ */
+typedef struct {
+    uint32_t ts_us;
+    uint32_t dur_us;
+    uint32_t tid;
+    uint32_t arg;
+    uint8_t point;
+    uint8_t phase;
+} trace_copy_t;
+
+/**
+ * @brief Buffered JSON output
+ */
+typedef struct {
+    trace_write_fn_t write;
+    void *ctx;
+    esp_err_t err;
+    size_t len;
+    char buf[TRACE_CHUNK_SIZE];
+} trace_out_t;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static void trace_out_flush(trace_out_t *out)
+{
+    if (out->err == ESP_OK && out->len > 0) {
+        out->err = out->write(out->ctx, out->buf, out->len);
+    }
+    out->len = 0;
+}
+
+static void trace_out_printf(trace_out_t *out, const char *format, ...)
+{
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len <= 0 || out->err != ESP_OK) {
+        return;
+    }
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    if (out->len + len > sizeof(out->buf)) {
+        trace_out_flush(out);
+    }
+    memcpy(out->buf + out->len, line, len);
+    out->len += len;
+}
+
+/**
+ * @brief Copy the valid events out of the ring, oldest first
+ */
+static size_t trace_copy_ring(trace_copy_t *copies)
+{
+    unsigned int end = atomic_load_explicit(&trace_head, memory_order_acquire);
+    unsigned int first = atomic_load_explicit(&trace_first, memory_order_relaxed);
+    unsigned int start = end - first > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : first;
+    size_t count = 0;
+
+    for (unsigned int index = start; index != end; index++) {
+        trace_event_t *event = &trace_ring[index & (TRACE_RING_SIZE - 1)];
+
+        // Seqlock read: skip slots being written or already overwritten
+        if (atomic_load_explicit(&event->seq, memory_order_acquire) != index + 1) {
+            continue;
+        }
+        trace_copy_t copy = {
+            .ts_us = event->ts_us,
+            .dur_us = event->dur_us,
+            .tid = event->tid,
+            .arg = event->arg,
+            .point = event->point,
+            .phase = event->phase,
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&event->seq, memory_order_relaxed) != index + 1 ||
+            copy.point >= TRACE_POINT_COUNT) {
+            continue;
+        }
+        copies[count++] = copy;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Thread name records for the tasks still alive
+ */
+static void trace_dump_thread_names(trace_out_t *out)
+{
+#if configUSE_TRACE_FACILITY
+    UBaseType_t task_count = uxTaskGetNumberOfTasks() + 4;  // Room for tasks created meanwhile
+    TaskStatus_t *status = malloc(task_count * sizeof(TaskStatus_t));
+    if (status == NULL) {
+        return;
+    }
+
+    task_count = uxTaskGetSystemState(status, task_count, NULL);
+    for (UBaseType_t t = 0; t < task_count; t++) {
+        trace_out_printf(out, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,"
+                         "\"args\":{\"name\":\"%s\"}}",
+                         (unsigned long)(uintptr_t)status[t].xHandle, status[t].pcTaskName);
+    }
+    free(status);
+#else
+    (void)out;  // Perfetto falls back to the tid numbers
+#endif
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+uint32_t trace_now(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+void trace_record(trace_point_t point, trace_phase_t phase, uint32_t start_us, uint32_t arg)
+{
+    if (!atomic_load_explicit(&trace_enabled, memory_order_relaxed)) {
+        return;
+    }
+
+    uint32_t now_us = trace_now();
+    unsigned int index = atomic_fetch_add_explicit(&trace_head, 1, memory_order_relaxed);
+    trace_event_t *event = &trace_ring[index & (TRACE_RING_SIZE - 1)];
+
+    atomic_store_explicit(&event->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    event->ts_us = (phase == TRACE_PHASE_SPAN) ? start_us : now_us;
+    event->dur_us = (phase == TRACE_PHASE_SPAN) ? now_us - start_us : 0;
+    event->tid = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+    event->arg = arg;
+    event->point = (uint8_t)point;
+    event->phase = (uint8_t)phase;
+
+    atomic_store_explicit(&event->seq, index + 1, memory_order_release);
+}
+
+void trace_set_enabled(bool enabled)
+{
+    atomic_store_explicit(&trace_enabled, enabled, memory_order_relaxed);
+    ESP_LOGI(TAG, "Tracing %s", enabled ? "enabled" : "disabled");
+}
+
+void trace_clear(void)
+{
+    atomic_store_explicit(&trace_first, atomic_load_explicit(&trace_head, memory_order_acquire),
+                          memory_order_relaxed);
+}
+
+esp_err_t trace_dump_json(trace_write_fn_t write, void *ctx)
+{
+    trace_copy_t *copies = malloc(TRACE_RING_SIZE * sizeof(trace_copy_t));
+    trace_out_t *out = malloc(sizeof(trace_out_t));
+    if (copies == NULL || out == NULL) {
+        free(copies);
+        free(out);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t count = trace_copy_ring(copies);
+
+    // Spans are stored by start time, so the oldest entry is not always the earliest
+    uint32_t base_us = count > 0 ? copies[0].ts_us : 0;
+    for (size_t i = 1; i < count; i++) {
+        if ((int32_t)(copies[i].ts_us - base_us) < 0) {
+            base_us = copies[i].ts_us;
+        }
+    }
+
+    out->write = write;
+    out->ctx = ctx;
+    out->err = ESP_OK;
+    out->len = 0;
+
+    trace_out_printf(out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"base_us\":%lu,\"events\":%u},"
+                     "\"traceEvents\":[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"args\":{\"name\":\"rc-control\"}}",
+                     (unsigned long)base_us, (unsigned int)count);
+    trace_dump_thread_names(out);
+
+    for (size_t i = 0; i < count; i++) {
+        const trace_copy_t *event = &copies[i];
+        const trace_point_info_t *info = &trace_points[event->point];
+        unsigned long ts = (unsigned long)(event->ts_us - base_us);
+        unsigned long tid = (unsigned long)event->tid;
+
+        switch (event->phase) {
+            case TRACE_PHASE_SPAN:
+                trace_out_printf(out, ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,"
+                                 "\"pid\":1,\"tid\":%lu,\"args\":{\"v\":%lu}}",
+                                 info->name, info->category, ts, (unsigned long)event->dur_us,
+                                 tid, (unsigned long)event->arg);
+                break;
+
+            case TRACE_PHASE_FLOW_START:
+            case TRACE_PHASE_FLOW_END:
+                // Flow ends bind to the span that encloses them on their task
+                trace_out_printf(out, ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"id\":%lu,\"ts\":%lu,"
+                                 "\"pid\":1,\"tid\":%lu%s}",
+                                 info->name, info->category, event->phase, (unsigned long)event->arg,
+                                 ts, tid, event->phase == TRACE_PHASE_FLOW_END ? ",\"bp\":\"e\"" : "");
+                break;
+
+            default:
+                trace_out_printf(out, ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,"
+                                 "\"pid\":1,\"tid\":%lu,\"args\":{\"v\":%lu}}",
+                                 info->name, info->category, ts, tid, (unsigned long)event->arg);
+                break;
+        }
+    }
+
+    trace_out_printf(out, "]}");
+    trace_out_flush(out);
+
+    esp_err_t err = out->err;
+    free(copies);
+    free(out);
+    return err;
+}
+
+#endif // ENABLE_TRACE
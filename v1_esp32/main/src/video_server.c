@@ -0,0 +1,260 @@
+#include "video_server.h"
+
+#if ENABLE_CAMERA_SUPPORT
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_http_server.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_camera.h"
+
+static const char *TAG = "video_server";
+
+#define PART_BOUNDARY "123456789000000000000987654321"
+static const char* _STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
+static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
+static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+
+static httpd_handle_t video_server = NULL;
+static volatile bool video_running = false;
+static int stream_count = 0;
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t stream_ended = NULL;  // Given each time stream_count drops
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Drop a stream from the count and wake video_server_stop()
+ */
+static void video_stream_release(void)
+{
+    taskENTER_CRITICAL(&stream_lock);
+    stream_count--;
+    taskEXIT_CRITICAL(&stream_lock);
+
+    xSemaphoreGive(stream_ended);
+}
+
+/**
+ * @brief Send one camera frame as a multipart part
+ */
+static esp_err_t video_send_frame(httpd_req_t *req, size_t *frame_len)
+{
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+        ESP_LOGE(TAG, "Camera capture failed");
+        return ESP_FAIL;
+    }
+
+    esp_err_t res = ESP_OK;
+    size_t _jpg_buf_len = 0;
+    uint8_t *_jpg_buf = NULL;
+    char part_buf[64];
+
+    if (fb->format != PIXFORMAT_JPEG) {
+        if (!frame2jpg(fb, 80, &_jpg_buf, &_jpg_buf_len)) {
+            ESP_LOGE(TAG, "JPEG compression failed");
+            esp_camera_fb_return(fb);
+            return ESP_FAIL;
+        }
+    } else {
+        _jpg_buf_len = fb->len;
+        _jpg_buf = fb->buf;
+    }
+
+    res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+
+    if (res == ESP_OK) {
+        size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, _jpg_buf_len);
+        res = httpd_resp_send_chunk(req, part_buf, hlen);
+    }
+
+    if (res == ESP_OK) {
+        res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+    }
+
+    if (fb->format != PIXFORMAT_JPEG) {
+        free(_jpg_buf);
+    }
+    esp_camera_fb_return(fb);
+
+    *frame_len = _jpg_buf_len;
+    return res;
+}
+
+/**
+ * @brief Stream task, one per /video client
+ *
+ * Owns the async copy of the request until the client leaves or the
+ * server stops.
+ */
+static void video_stream_task(void *pvParameters)
+{
+    httpd_req_t *req = (httpd_req_t *)pvParameters;
+    int64_t last_frame = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Stream started (fd=%d)", httpd_req_to_sockfd(req));
+
+    esp_err_t res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
+    while (res == ESP_OK && video_running) {
+        size_t frame_len = 0;
+        res = video_send_frame(req, &frame_len);
+        if (res != ESP_OK) {
+            break;
+        }
+
+        int64_t fr_end = esp_timer_get_time();
+        int64_t frame_time = (fr_end - last_frame) / 1000;
+        last_frame = fr_end;
+        ESP_LOGD(TAG, "MJPG: %uKB %ums (%.1ffps)",
+            (unsigned int)(frame_len / 1024),
+            (unsigned int)frame_time, frame_time > 0 ? 1000.0 / (uint32_t)frame_time : 0.0);
+    }
+
+    ESP_LOGI(TAG, "Stream ended (fd=%d)", httpd_req_to_sockfd(req));
+    httpd_req_async_handler_complete(req);
+    video_stream_release();
+
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief /video handler: hand the request to a stream task and return
+ */
+static esp_err_t video_stream_handler(httpd_req_t *req)
+{
+    bool accepted = false;
+
+    // No new streams once video_server_stop() is waiting for the count to drain
+    taskENTER_CRITICAL(&stream_lock);
+    if (video_running && stream_count < VIDEO_MAX_STREAMS) {
+        stream_count++;
+        accepted = true;
+    }
+    taskEXIT_CRITICAL(&stream_lock);
+
+    if (!accepted) {
+        ESP_LOGW(TAG, "Rejecting stream - %d streams running", VIDEO_MAX_STREAMS);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Too many video streams", HTTPD_RESP_USE_STRLEN);
+    }
+
+    httpd_req_t *async_req = NULL;
+    esp_err_t ret = httpd_req_async_handler_begin(req, &async_req);
+    if (ret == ESP_OK) {
+        BaseType_t created = xTaskCreatePinnedToCore(
+            video_stream_task,
+            "video_stream",
+            VIDEO_STREAM_STACK_SIZE,    // Stack size
+            async_req,                  // Parameters
+            VIDEO_STREAM_PRIORITY,      // Priority
+            NULL,                       // Task handle
+            VIDEO_SERVER_CORE           // Core
+        );
+        if (created == pdPASS) {
+            return ESP_OK;
+        }
+
+        ESP_LOGE(TAG, "Failed to create stream task");
+        httpd_req_async_handler_complete(async_req);
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        ESP_LOGE(TAG, "Failed to detach stream request: %s", esp_err_to_name(ret));
+    }
+
+    video_stream_release();
+    return ret;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t video_server_start(void)
+{
+    if (video_server != NULL) {
+        ESP_LOGW(TAG, "Video server is already running");
+        return ESP_OK;
+    }
+
+    // Reused across stop/start
+    if (stream_ended == NULL) {
+        stream_ended = xSemaphoreCreateCounting(VIDEO_MAX_STREAMS, 0);
+        if (stream_ended == NULL) {
+            ESP_LOGE(TAG, "Failed to create stream semaphore");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = VIDEO_SERVER_PORT;
+    config.ctrl_port = VIDEO_SERVER_CTRL_PORT;
+    config.task_priority = VIDEO_SERVER_PRIORITY;
+    config.core_id = VIDEO_SERVER_CORE;
+    config.max_open_sockets = VIDEO_MAX_STREAMS + 1;    // One spare to answer 503
+    config.max_uri_handlers = 1;
+
+    esp_err_t ret = httpd_start(&video_server, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start video server: %s", esp_err_to_name(ret));
+        video_server = NULL;
+        return ret;
+    }
+
+    video_running = true;
+
+    httpd_uri_t video_uri = {
+        .uri       = "/video",
+        .method    = HTTP_GET,
+        .handler   = video_stream_handler,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(video_server, &video_uri);
+
+    ESP_LOGI(TAG, "Video server started on port %d", VIDEO_SERVER_PORT);
+    return ESP_OK;
+}
+
+void video_server_stop(void)
+{
+    if (video_server == NULL) {
+        return;
+    }
+
+    // Streams check the flag between frames. httpd_stop() must not run
+    // while any of them still holds its async request, so wait for every
+    // stream to complete it however long its last frame takes to send.
+    taskENTER_CRITICAL(&stream_lock);
+    video_running = false;
+    taskEXIT_CRITICAL(&stream_lock);
+
+    ESP_LOGI(TAG, "Stopping video server, %d streams running", video_server_get_stream_count());
+    while (video_server_get_stream_count() > 0) {
+        xSemaphoreTake(stream_ended, portMAX_DELAY);
+    }
+
+    // Tokens of streams that ended before the count was read
+    while (xSemaphoreTake(stream_ended, 0) == pdTRUE) {
+    }
+
+    httpd_stop(video_server);
+    video_server = NULL;
+    ESP_LOGI(TAG, "Video server stopped");
+}
+
+int video_server_get_stream_count(void)
+{
+    taskENTER_CRITICAL(&stream_lock);
+    int count = stream_count;
+    taskEXIT_CRITICAL(&stream_lock);
+
+    return count;
+}
+
+#endif // ENABLE_CAMERA_SUPPORT
@@ -0,0 +1,304 @@
+#include "ws_clients.h"
+
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <string.h>
+
+static const char *TAG = "ws_clients";
+
+#define HANDLE_SLOT(handle)         ((handle) & 0xFF)
+#define HANDLE_GENERATION(handle)   ((handle) >> 8)
+#define MAKE_HANDLE(slot, gen)      (((ws_client_handle_t)(gen) << 8) | (slot))
+#define GENERATION_MASK             0x00FFFFFF
+
+/**
+ * @brief Registry slot
+ */
+typedef struct {
+    bool active;
+    uint32_t generation;        // Bumped on every reuse, never 0
+    ws_client_info_t info;
+    rcp_session_t session;      // Protocol state, owned by the httpd task
+} ws_client_slot_t;
+
+static ws_client_slot_t slots[WS_CLIENTS_MAX];
+
+// Free slot stack for O(1) add/remove
+static uint8_t free_slots[WS_CLIENTS_MAX];
+static int free_count = -1;     // -1 until the stack is filled on first use
+static int active_count = 0;
+
+static portMUX_TYPE registry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+/**
+ * @brief Fill the free stack, must be called with registry_lock held
+ */
+static void reset_locked(void)
+{
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        slots[i].active = false;
+        free_slots[i] = (uint8_t)(WS_CLIENTS_MAX - 1 - i);
+    }
+    free_count = WS_CLIENTS_MAX;
+    active_count = 0;
+}
+
+/**
+ * @brief Resolve a handle, must be called with registry_lock held
+ */
+static ws_client_slot_t *lookup_locked(ws_client_handle_t handle)
+{
+    uint32_t index = HANDLE_SLOT(handle);
+    if (handle == WS_CLIENT_HANDLE_INVALID || index >= WS_CLIENTS_MAX) {
+        return NULL;
+    }
+
+    ws_client_slot_t *slot = &slots[index];
+    if (!slot->active || slot->generation != HANDLE_GENERATION(handle)) {
+        return NULL;
+    }
+
+    return slot;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t ws_clients_add(int fd, ws_client_handle_t *handle)
+{
+    ws_client_handle_t new_handle = WS_CLIENT_HANDLE_INVALID;
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&registry_lock);
+    if (free_count < 0) {
+        reset_locked();
+    }
+    if (free_count > 0) {
+        uint8_t index = free_slots[--free_count];
+        ws_client_slot_t *slot = &slots[index];
+
+        slot->generation = (slot->generation + 1) & GENERATION_MASK;
+        if (slot->generation == 0) {
+            slot->generation = 1;
+        }
+        new_handle = MAKE_HANDLE(index, slot->generation);
+
+        memset(&slot->info, 0, sizeof(ws_client_info_t));
+        slot->info.handle = new_handle;
+        slot->info.fd = fd;
+        slot->info.streams = WS_STREAM_DEFAULT;
+        slot->info.connected_us = now_us;
+        rcp_session_init(&slot->session, fd);
+
+        slot->active = true;
+        active_count++;
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    if (new_handle == WS_CLIENT_HANDLE_INVALID) {
+        ESP_LOGW(TAG, "Cannot add WebSocket client fd=%d - max clients reached", fd);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *handle = new_handle;
+    ESP_LOGI(TAG, "WebSocket client fd=%d added (handle 0x%08lx), total clients: %d",
+             fd, (unsigned long)new_handle, active_count);
+    return ESP_OK;
+}
+
+esp_err_t ws_clients_remove(ws_client_handle_t handle, int *fd)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    int removed_fd = -1;
+
+    taskENTER_CRITICAL(&registry_lock);
+    ws_client_slot_t *slot = lookup_locked(handle);
+    if (slot != NULL) {
+        removed_fd = slot->info.fd;
+        slot->active = false;
+        slot->info.fd = -1;
+        free_slots[free_count++] = (uint8_t)HANDLE_SLOT(handle);
+        active_count--;
+        ret = ESP_OK;
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    if (fd != NULL) {
+        *fd = removed_fd;
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "WebSocket client fd=%d removed, total clients: %d", removed_fd, active_count);
+    }
+
+    return ret;
+}
+
+ws_client_handle_t ws_clients_find_fd(int fd)
+{
+    ws_client_handle_t handle = WS_CLIENT_HANDLE_INVALID;
+
+    taskENTER_CRITICAL(&registry_lock);
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (slots[i].active && slots[i].info.fd == fd) {
+            handle = slots[i].info.handle;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return handle;
+}
+
+rcp_session_t *ws_clients_get_session(ws_client_handle_t handle)
+{
+    taskENTER_CRITICAL(&registry_lock);
+    ws_client_slot_t *slot = lookup_locked(handle);
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return slot != NULL ? &slot->session : NULL;
+}
+
+void ws_clients_set_stream(int fd, uint8_t stream, bool enable)
+{
+    taskENTER_CRITICAL(&registry_lock);
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (slots[i].active && slots[i].info.fd == fd) {
+            if (enable) {
+                slots[i].info.streams |= stream;
+            } else {
+                slots[i].info.streams &= ~stream;
+            }
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+}
+
+uint8_t ws_clients_ping_sent(ws_client_handle_t handle, int64_t now_us, uint32_t *ping_id)
+{
+    uint8_t missed = 0;
+
+    taskENTER_CRITICAL(&registry_lock);
+    ws_client_slot_t *slot = lookup_locked(handle);
+    if (slot != NULL) {
+        if (slot->info.ping_sent_us != 0 && slot->info.missed_pongs < UINT8_MAX) {
+            slot->info.missed_pongs++;
+        }
+        slot->info.ping_id++;
+        slot->info.ping_sent_us = now_us;
+        missed = slot->info.missed_pongs;
+        *ping_id = slot->info.ping_id;
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return missed;
+}
+
+esp_err_t ws_clients_pong_received(ws_client_handle_t handle, uint32_t ping_id, int64_t now_us)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    taskENTER_CRITICAL(&registry_lock);
+    ws_client_slot_t *slot = lookup_locked(handle);
+    if (slot != NULL && slot->info.ping_sent_us != 0 && slot->info.ping_id == ping_id) {
+        uint32_t rtt_us = (uint32_t)(now_us - slot->info.ping_sent_us);
+
+        slot->info.ping_sent_us = 0;
+        slot->info.missed_pongs = 0;
+        slot->info.pongs++;
+        slot->info.rtt_last_us = rtt_us;
+        if (rtt_us > slot->info.rtt_max_us) {
+            slot->info.rtt_max_us = rtt_us;
+        }
+        if (slot->info.rtt_avg_us == 0) {
+            slot->info.rtt_avg_us = rtt_us;
+        } else {
+            slot->info.rtt_avg_us = slot->info.rtt_avg_us - slot->info.rtt_avg_us / 8 + rtt_us / 8;
+        }
+        ret = ESP_OK;
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return ret;
+}
+
+uint32_t ws_clients_get_rtt_us(int fd)
+{
+    uint32_t rtt_us = 0;
+
+    taskENTER_CRITICAL(&registry_lock);
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (slots[i].active && slots[i].info.fd == fd) {
+            rtt_us = slots[i].info.rtt_avg_us;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return rtt_us;
+}
+
+void ws_clients_record_rx(ws_client_handle_t handle, size_t bytes)
+{
+    taskENTER_CRITICAL(&registry_lock);
+    ws_client_slot_t *slot = lookup_locked(handle);
+    if (slot != NULL) {
+        slot->info.rx_frames++;
+        slot->info.rx_bytes += bytes;
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+}
+
+int ws_clients_snapshot(ws_client_ref_t *refs, int max, uint8_t streams)
+{
+    int count = 0;
+
+    taskENTER_CRITICAL(&registry_lock);
+    for (int i = 0; i < WS_CLIENTS_MAX && count < max; i++) {
+        if (slots[i].active && slots[i].info.fd >= 0 &&
+            (streams == WS_STREAM_ALL || (slots[i].info.streams & streams))) {
+            refs[count].handle = slots[i].info.handle;
+            refs[count].fd = slots[i].info.fd;
+            count++;
+        }
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return count;
+}
+
+int ws_clients_get_info(ws_client_info_t *info, int max)
+{
+    int count = 0;
+
+    taskENTER_CRITICAL(&registry_lock);
+    for (int i = 0; i < WS_CLIENTS_MAX && count < max; i++) {
+        if (slots[i].active && slots[i].info.fd >= 0) {
+            info[count] = slots[i].info;
+            info[count].role = slots[i].session.role;
+            count++;
+        }
+    }
+    taskEXIT_CRITICAL(&registry_lock);
+
+    return count;
+}
+
+int ws_clients_count(void)
+{
+    return active_count;
+}
+
+void ws_clients_clear(void)
+{
+    taskENTER_CRITICAL(&registry_lock);
+    reset_locked();
+    taskEXIT_CRITICAL(&registry_lock);
+}
@@ -0,0 +1,499 @@
+#include "ws_outbox.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <string.h>
+#include <sys/select.h>
+#include "metrics.h"
+
+static const char *TAG = "ws_outbox";
+
+/**
+ * @brief Queued frame storage
+ */
+typedef struct {
+    httpd_ws_type_t type;
+    uint16_t len;
+    uint8_t data[WS_OUTBOX_FRAME_MAX];
+} ws_outbox_entry_t;
+
+/**
+ * @brief Per-client queue
+ *
+ * Frames live in fixed storage slots; the send order is kept as a short
+ * index list so coalescing can move a frame to the tail without copying it.
+ * Payloads are copied in and sent out without outbox_lock held: a slot is
+ * reserved (or claimed from the order) under the lock, filled or sent, then
+ * published (or freed) under the lock again. busy counts slots between the
+ * two steps, and a client is not reused for a new fd until it drops to 0.
+ */
+typedef struct {
+    bool active;
+    uint8_t count;                          // Frames queued
+    uint8_t order[WS_OUTBOX_DEPTH];         // Storage slots, oldest first
+    uint8_t busy;                           // Slots being filled or sent
+    uint16_t used;                          // Bit per occupied storage slot
+    ws_outbox_entry_t entries[WS_OUTBOX_DEPTH];
+    ws_outbox_stats_t stats;
+} ws_outbox_client_t;
+
+static ws_outbox_client_t clients[WS_OUTBOX_MAX_CLIENTS];
+static portMUX_TYPE outbox_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Ports whose queued frame is replaced by the newest one
+static uint32_t coalesce_ports[256 / 32];
+
+static httpd_handle_t outbox_server = NULL;
+static ws_outbox_error_cb_t outbox_error_cb = NULL;
+
+// Task handles
+static TaskHandle_t outbox_task_handle = NULL;
+static bool outbox_task_running = false;
+static SemaphoreHandle_t outbox_task_stopped = NULL;   // Given by the task on exit
+
+// =============================================================================
+// PRIVATE FUNCTIONS
+// =============================================================================
+
+static ws_outbox_client_t *find_client(int fd)
+{
+    for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].stats.fd == fd) {
+            return &clients[i];
+        }
+    }
+    return NULL;
+}
+
+static bool port_coalesces(httpd_ws_type_t type, const uint8_t *data, size_t len)
+{
+    if (type != HTTPD_WS_TYPE_BINARY || len < RCP_HEADER_SIZE) {
+        return false;
+    }
+
+    uint8_t port = data[2];
+    return (coalesce_ports[port / 32] & (1u << (port % 32))) != 0;
+}
+
+/**
+ * @brief Remove the frame at a position of the send order, returns its slot
+ */
+static uint8_t order_remove(ws_outbox_client_t *client, int position)
+{
+    uint8_t slot = client->order[position];
+    memmove(&client->order[position], &client->order[position + 1], client->count - position - 1);
+    client->count--;
+    return slot;
+}
+
+/**
+ * @brief Reserve the storage slot for a new frame, must be called with outbox_lock held
+ *
+ * A queued frame of the same coalescing port gives up its slot to the new
+ * one. The slot stays out of the send order until publish_slot().
+ *
+ * @return Slot index, -1 if the queue is full
+ */
+static int reserve_slot_locked(ws_outbox_client_t *client, httpd_ws_type_t type,
+                               const uint8_t *data, bool coalesce)
+{
+    int slot = -1;
+
+    if (coalesce) {
+        for (int i = 0; i < client->count; i++) {
+            ws_outbox_entry_t *queued = &client->entries[client->order[i]];
+            if (queued->type == type && queued->len >= RCP_HEADER_SIZE && queued->data[2] == data[2]) {
+                slot = order_remove(client, i);
+                client->stats.coalesced++;
+                break;
+            }
+        }
+    }
+
+    if (slot < 0) {
+        for (int i = 0; i < WS_OUTBOX_DEPTH; i++) {
+            if (!(client->used & (1u << i))) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            client->stats.dropped++;
+            metrics_inc(METRIC_WS_OUTBOX_DROPPED);
+            return -1;
+        }
+        client->used |= (1u << slot);
+    }
+
+    client->busy++;
+    return slot;
+}
+
+/**
+ * @brief Fill a reserved slot, called without outbox_lock held
+ */
+static void fill_slot(ws_outbox_client_t *client, int slot, httpd_ws_type_t type,
+                      const uint8_t *data, size_t len)
+{
+    ws_outbox_entry_t *entry = &client->entries[slot];
+    entry->type = type;
+    entry->len = (uint16_t)len;
+    memcpy(entry->data, data, len);
+}
+
+/**
+ * @brief Append a filled slot to the send order
+ *
+ * @return true if queued, false if the client went away meanwhile
+ */
+static bool publish_slot(ws_outbox_client_t *client, int slot)
+{
+    bool queued = false;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    client->busy--;
+    if (client->active) {
+        client->order[client->count++] = (uint8_t)slot;
+        client->stats.enqueued++;
+        client->stats.depth = client->count;
+        if (client->count > client->stats.max_depth) {
+            client->stats.max_depth = client->count;
+        }
+        queued = true;
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    return queued;
+}
+
+/**
+ * @brief Take the oldest frame of a client out of the send order
+ *
+ * The slot stays allocated until release_slot(), so the frame can be sent
+ * straight from storage.
+ *
+ * @return Slot index, -1 if nothing is queued for @p fd
+ */
+static int claim_oldest(int index, int fd)
+{
+    int slot = -1;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    ws_outbox_client_t *client = &clients[index];
+    if (client->active && client->stats.fd == fd && client->count > 0) {
+        slot = order_remove(client, 0);
+        client->stats.depth = client->count;
+        client->busy++;
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    return slot;
+}
+
+/**
+ * @brief Free a slot taken by claim_oldest()
+ */
+static void release_slot(ws_outbox_client_t *client, int slot)
+{
+    taskENTER_CRITICAL(&outbox_lock);
+    client->busy--;
+    if (client->active) {
+        client->used &= ~(1u << slot);
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+}
+
+/**
+ * @brief Check whether a socket can take a frame without blocking
+ */
+static bool socket_writable(int fd)
+{
+    fd_set write_fds;
+    FD_ZERO(&write_fds);
+    FD_SET(fd, &write_fds);
+    struct timeval timeout = { 0, 0 };
+
+    return select(fd + 1, NULL, &write_fds, NULL, &timeout) > 0;
+}
+
+/**
+ * @brief Outbox task
+ *
+ * Sends one frame per client per pass, round robin, and skips clients
+ * whose socket is full. Their queue keeps coalescing meanwhile, so a slow
+ * client receives fewer, newer frames instead of a growing backlog.
+ */
+static void ws_outbox_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "WebSocket outbox task started");
+
+    while (outbox_task_running) {
+        bool blocked = false;
+        bool progress;
+
+        do {
+            progress = false;
+
+            for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+                taskENTER_CRITICAL(&outbox_lock);
+                bool pending = clients[i].active && clients[i].count > 0;
+                int fd = clients[i].stats.fd;
+                taskEXIT_CRITICAL(&outbox_lock);
+
+                if (!pending) {
+                    continue;
+                }
+
+                if (!socket_writable(fd)) {
+                    taskENTER_CRITICAL(&outbox_lock);
+                    clients[i].stats.blocked++;
+                    taskEXIT_CRITICAL(&outbox_lock);
+                    blocked = true;
+                    continue;
+                }
+
+                int slot = claim_oldest(i, fd);
+                if (slot < 0) {
+                    continue;
+                }
+
+                ws_outbox_entry_t *frame = &clients[i].entries[slot];
+                httpd_ws_frame_t ws_pkt;
+                memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+                ws_pkt.payload = frame->data;
+                ws_pkt.len = frame->len;
+                ws_pkt.type = frame->type;
+
+                esp_err_t ret = httpd_ws_send_frame_async(outbox_server, fd, &ws_pkt);
+                release_slot(&clients[i], slot);
+                if (ret == ESP_OK) {
+                    taskENTER_CRITICAL(&outbox_lock);
+                    if (clients[i].active && clients[i].stats.fd == fd) {
+                        clients[i].stats.sent++;
+                    }
+                    taskEXIT_CRITICAL(&outbox_lock);
+                    progress = true;
+                } else {
+                    metrics_inc(METRIC_WS_SEND_FAILURES);
+                    ESP_LOGW(TAG, "Failed to send to client %d: %s - dropping queue",
+                             fd, esp_err_to_name(ret));
+                    ws_outbox_remove_client(fd);
+                    if (outbox_error_cb != NULL) {
+                        outbox_error_cb(fd);
+                    }
+                }
+            }
+        } while (progress && outbox_task_running);
+
+        ulTaskNotifyTake(pdTRUE, blocked ? pdMS_TO_TICKS(WS_OUTBOX_RETRY_MS) : portMAX_DELAY);
+    }
+
+    // outbox_task_handle is cleared by ws_outbox_deinit(), which may already
+    // be waiting to start the next task
+    ESP_LOGI(TAG, "WebSocket outbox task stopped");
+    xSemaphoreGive(outbox_task_stopped);
+    vTaskDelete(NULL);
+}
+
+static void wake_task(void)
+{
+    if (outbox_task_handle != NULL) {
+        xTaskNotifyGive(outbox_task_handle);
+    }
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+esp_err_t ws_outbox_init(httpd_handle_t server, ws_outbox_error_cb_t on_error)
+{
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (outbox_task_running) {
+        ESP_LOGW(TAG, "WebSocket outbox already running");
+        return ESP_OK;
+    }
+
+    // Reused across deinit/init, ws_outbox_deinit() leaves it empty
+    if (outbox_task_stopped == NULL) {
+        outbox_task_stopped = xSemaphoreCreateBinary();
+        if (outbox_task_stopped == NULL) {
+            ESP_LOGE(TAG, "Failed to create WebSocket outbox stop semaphore");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Client queues were deactivated by ws_outbox_deinit() and are reset by
+    // ws_outbox_add_client(), a sender may still be filling one of them
+    outbox_server = server;
+    outbox_error_cb = on_error;
+    outbox_task_running = true;
+
+    BaseType_t ret = xTaskCreate(
+        ws_outbox_task,
+        "ws_outbox",
+        WS_OUTBOX_TASK_STACK_SIZE,  // Stack size
+        NULL,                       // Parameters
+        WS_OUTBOX_TASK_PRIORITY,    // Priority
+        &outbox_task_handle         // Task handle
+    );
+
+    if (ret != pdPASS) {
+        outbox_task_running = false;
+        outbox_task_handle = NULL;
+        ESP_LOGE(TAG, "Failed to create WebSocket outbox task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+void ws_outbox_deinit(void)
+{
+    taskENTER_CRITICAL(&outbox_lock);
+    for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+        clients[i].active = false;
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    if (outbox_task_running) {
+        ESP_LOGI(TAG, "Stopping WebSocket outbox task");
+        outbox_task_running = false;
+        wake_task();
+
+        // The task may be inside httpd_ws_send_frame_async(): wait for it
+        // to exit before the caller stops the server
+        xSemaphoreTake(outbox_task_stopped, portMAX_DELAY);
+        outbox_task_handle = NULL;
+    }
+}
+
+esp_err_t ws_outbox_add_client(int fd)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    if (find_client(fd) != NULL) {
+        ret = ESP_OK;
+    } else {
+        for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+            // A sender still filling a slot of a closed client keeps it
+            if (!clients[i].active && clients[i].busy == 0) {
+                memset(&clients[i], 0, sizeof(ws_outbox_client_t));
+                clients[i].active = true;
+                clients[i].stats.fd = fd;
+                ret = ESP_OK;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    return ret;
+}
+
+void ws_outbox_remove_client(int fd)
+{
+    taskENTER_CRITICAL(&outbox_lock);
+    ws_outbox_client_t *client = find_client(fd);
+    if (client != NULL) {
+        client->active = false;
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+}
+
+void ws_outbox_set_coalesce(uint8_t port, bool coalesce)
+{
+    taskENTER_CRITICAL(&outbox_lock);
+    if (coalesce) {
+        coalesce_ports[port / 32] |= (1u << (port % 32));
+    } else {
+        coalesce_ports[port / 32] &= ~(1u << (port % 32));
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+}
+
+esp_err_t ws_outbox_send(int fd, httpd_ws_type_t type, const void *data, size_t len)
+{
+    if (data == NULL || len == 0 || len > WS_OUTBOX_FRAME_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bool coalesce = port_coalesces(type, data, len);
+    int slot = -1;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    ws_outbox_client_t *client = find_client(fd);
+    if (client != NULL) {
+        slot = reserve_slot_locked(client, type, data, coalesce);
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    if (client == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (slot < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    fill_slot(client, slot, type, data, len);
+    if (!publish_slot(client, slot)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    wake_task();
+    return ESP_OK;
+}
+
+int ws_outbox_broadcast(httpd_ws_type_t type, const void *data, size_t len)
+{
+    if (data == NULL || len == 0 || len > WS_OUTBOX_FRAME_MAX) {
+        return 0;
+    }
+
+    bool coalesce = port_coalesces(type, data, len);
+    int slots[WS_OUTBOX_MAX_CLIENTS];
+    int queued = 0;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+        slots[i] = clients[i].active ? reserve_slot_locked(&clients[i], type, data, coalesce) : -1;
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS; i++) {
+        if (slots[i] < 0) {
+            continue;
+        }
+        fill_slot(&clients[i], slots[i], type, data, len);
+        if (publish_slot(&clients[i], slots[i])) {
+            queued++;
+        }
+    }
+
+    if (queued > 0) {
+        wake_task();
+    }
+
+    return queued;
+}
+
+int ws_outbox_get_stats(ws_outbox_stats_t *stats, int max)
+{
+    int count = 0;
+
+    taskENTER_CRITICAL(&outbox_lock);
+    for (int i = 0; i < WS_OUTBOX_MAX_CLIENTS && count < max; i++) {
+        if (clients[i].active) {
+            stats[count++] = clients[i].stats;
+        }
+    }
+    taskEXIT_CRITICAL(&outbox_lock);
+
+    return count;
+}